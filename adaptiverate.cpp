@@ -0,0 +1,69 @@
+#include "adaptiverate.h"
+
+#include <algorithm>
+#include <cmath>
+
+AdaptiveRate::AdaptiveRate(const Config &config): settings{config} {
+    if (settings.fastest.count() < 1)
+        settings.fastest = std::chrono::milliseconds(1);
+    settings.slowest = std::max(settings.slowest, settings.fastest);
+    settings.backoff = std::max(settings.backoff, 1.0);
+    reset();
+}
+
+AdaptiveRate::AdaptiveRate(): AdaptiveRate(Config{}) {}
+
+void AdaptiveRate::reset() {
+    std::fill(levels, levels + SIGNAL_COUNT, 0.0);
+    has_levels = false;
+    hold = settings.hold_ticks;
+    was_active = true;
+    interval_ms = static_cast<double>(settings.fastest.count());
+}
+
+std::chrono::milliseconds AdaptiveRate::next(const RateSignal &signal, double elapsed_ms, double threshold) {
+    const double values[SIGNAL_COUNT] = {
+        signal.cpu_use, signal.cpu_proc_use, signal.gpu_proc_use, signal.mem_used,
+    };
+
+    // Short intervals read coarser counters, don't mistake that for movement; long ones average a short burst away
+    const double reference_ms = static_cast<double>(REFERENCE_INTERVAL.count());
+    const double tolerance = settings.change * std::sqrt(reference_ms / std::max(elapsed_ms, 1.0));
+    const double weight = has_levels ?
+        1.0 - std::exp(-std::max(elapsed_ms, 0.0) / static_cast<double>(settings.smoothing.count())) : 1.0;
+
+    bool changed = false;
+    for (unsigned i = 0; i < SIGNAL_COUNT; i++) {
+        if (has_levels && std::fabs(values[i] - levels[i]) > tolerance)
+            changed = true;
+        levels[i] += (values[i] - levels[i]) * weight;
+    }
+    has_levels = true;
+
+    const bool near_threshold = signal.core_max_use >= threshold - settings.margin;
+    was_active = changed || near_threshold;
+
+    const double fastest_ms = static_cast<double>(settings.fastest.count());
+    if (was_active) {
+        hold = settings.hold_ticks;
+        interval_ms = fastest_ms;
+    } else if (hold > 0) {
+        hold--;
+        interval_ms = fastest_ms;
+    } else {
+        interval_ms = std::min(interval_ms * settings.backoff, static_cast<double>(settings.slowest.count()));
+    }
+    return interval();
+}
+
+std::chrono::milliseconds AdaptiveRate::interval() const {
+    return std::chrono::milliseconds(static_cast<long long>(interval_ms));
+}
+
+bool AdaptiveRate::active() const {
+    return was_active;
+}
+
+const AdaptiveRate::Config& AdaptiveRate::config() const {
+    return settings;
+}
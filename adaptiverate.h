@@ -0,0 +1,87 @@
+#ifndef ADAPTIVERATE_H
+#define ADAPTIVERATE_H
+
+#include <chrono>
+
+/** The metrics of one tick `AdaptiveRate` watches, every one in `[0, 1]`. */
+struct RateSignal {
+    double cpu_use;
+    /** Foreground CPU as a share of the whole machine, its share of busy time is erratic on an idle machine. */
+    double cpu_proc_use;
+    double gpu_proc_use;
+    double mem_used;
+    /** Only compared against the threshold, a single core is too coarse over a short interval to track changes. */
+    double core_max_use;
+};
+
+/**
+ * Picks the sampling interval from what the metrics are doing.
+ * While anything moves, or the busiest core is near the configured threshold, ticks come every `fastest` and stay
+ * there for `hold_ticks` so a transient is followed at full resolution. Once everything is flat the interval grows by
+ * `backoff` per tick up to `slowest`, so an idle machine is barely sampled at all.
+ *
+ * A change is a metric moving away from its smoothed level by more than `change`, scaled by the square root of
+ * `REFERENCE_INTERVAL` over the measured interval: utilization over a very short interval is coarse (procfs counts in
+ * 10 ms jiffies) and must not read as movement, while over a long one a short burst is averaged down and has to
+ * count all the same. The smoothing follows time rather than ticks.
+ */
+class AdaptiveRate {
+public:
+    /** Interval `change` is meant for, the old fixed refresh interval. */
+    static constexpr std::chrono::milliseconds REFERENCE_INTERVAL {250};
+
+    struct Config {
+        /** procfs counts CPU time in 10 ms jiffies, much faster than this only samples quantization. */
+        std::chrono::milliseconds fastest {50};
+        std::chrono::milliseconds slowest {5000};
+        /** Distance from the smoothed level that counts as a change at `REFERENCE_INTERVAL`. */
+        double change = 0.05;
+        /** The busiest core within this of the threshold keeps the fast rate. */
+        double margin = 0.1;
+        /** Interval growth per flat tick. */
+        double backoff = 1.5;
+        /** Ticks kept at `fastest` after the last change. */
+        unsigned hold_ticks = 10;
+        /** Time constant of the smoothed levels. */
+        std::chrono::milliseconds smoothing {250};
+    };
+
+    explicit AdaptiveRate(const Config &config);
+    AdaptiveRate();
+
+    /** Forget the smoothed levels and start over at `fastest`, for a new source. */
+    void reset();
+
+    /**
+     * Take in one tick and pick the interval until the next.
+     * @param elapsed_ms Measured time since the previous tick, the levels are smoothed over it.
+     * @param threshold Busy ratio at which a core counts as saturated.
+     */
+    std::chrono::milliseconds next(const RateSignal &signal, double elapsed_ms, double threshold);
+
+    /** Interval picked by the last `next`, `fastest` before the first. */
+    std::chrono::milliseconds interval() const;
+
+    /** True if the last `next` saw a change or the threshold close by. */
+    bool active() const;
+
+    const Config& config() const;
+
+private:
+    /** Every field of `RateSignal` but `core_max_use`. */
+    static constexpr unsigned SIGNAL_COUNT = 4;
+
+    Config settings;
+
+    /** Smoothed level of every tracked metric, in `RateSignal` order. */
+    double levels[SIGNAL_COUNT];
+    bool has_levels;
+
+    /** Flat ticks left before backing off. */
+    unsigned hold;
+
+    bool was_active;
+    double interval_ms;
+};
+
+#endif // ADAPTIVERATE_H
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <sys/stat.h>
+
+#include "cgrouptable.h"
+#include "testfixture.h"
+
+/*
+ * cgroup refresh against a systemd-shaped fixture hierarchy of N service groups in a handful of slices.
+ * BM_CgroupTableRefresh is a 250 ms tick: two `pread`s per leaf plus the details of the reported groups, and the
+ * hierarchy walk of every 20th tick amortized over the others. BM_CgroupTableScan walks the hierarchy on every
+ * iteration, what the tick that rescans costs.
+ */
+
+namespace {
+
+constexpr int SLICES = 4;
+
+class CgroupFixture {
+    FixtureDir dir {"bench_cgrouptable"};
+
+public:
+    explicit CgroupFixture(int services) {
+        const std::string &root = dir.path();
+        if (root.empty())
+            return;
+        writeFile(root + "/cgroup.controllers", "cpuset cpu io memory pids\n");
+
+        for (int slice = 0; slice < SLICES; slice++)
+            mkdir((root + "/slice-" + std::to_string(slice) + ".slice").c_str(), 0755);
+        for (int service = 0; service < services; service++) {
+            const std::string group = root + "/slice-" + std::to_string(service % SLICES) + ".slice/service-" +
+                std::to_string(service) + ".service";
+            mkdir(group.c_str(), 0755);
+            writeFile(group + "/cpu.stat", "usage_usec " + std::to_string(service * 1000) + "\nuser_usec 0\n"
+                      "system_usec 0\nnr_periods 0\nnr_throttled 0\nthrottled_usec 0\n");
+            writeFile(group + "/memory.current", std::to_string(service * 4096) + "\n");
+            writeFile(group + "/memory.max", "max\n");
+            writeFile(group + "/cpu.max", "max 100000\n");
+            writeFile(group + "/memory.stat", "anon 1048576\nfile 2097152\nkernel 65536\nshmem 0\n");
+            writeFile(group + "/io.stat", "8:0 rbytes=4096 wbytes=8192 rios=1 wios=2 dbytes=0 dios=0\n");
+        }
+    }
+
+    const std::string& path() const {
+        return dir.path();
+    }
+};
+
+} // namespace
+
+static void BM_CgroupTableRefresh(benchmark::State &state) {
+    CgroupFixture fixture(static_cast<int>(state.range(0)));
+    CgroupTable table(fixture.path().c_str());
+    if (!table.refresh(0.0)) {
+        state.SkipWithError("could not create the fixture tree");
+        return;
+    }
+
+    for (auto _ : state) {
+        table.refresh(0.25);
+        benchmark::DoNotOptimize(table.reported().data());
+    }
+    state.counters["groups"] = static_cast<double>(table.groupCount());
+    state.counters["scans"] = static_cast<double>(table.scanCount());
+}
+BENCHMARK(BM_CgroupTableRefresh)->Arg(64)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+static void BM_CgroupTableScan(benchmark::State &state) {
+    CgroupFixture fixture(static_cast<int>(state.range(0)));
+    CgroupTable table(fixture.path().c_str());
+
+    for (auto _ : state) {
+        table.refresh(CgroupTable::RESCAN_INTERVAL_SECONDS);
+        benchmark::DoNotOptimize(table.reported().data());
+    }
+    state.counters["groups"] = static_cast<double>(table.groupCount());
+}
+BENCHMARK(BM_CgroupTableScan)->Arg(64)->Arg(512)->Unit(benchmark::kMicrosecond);
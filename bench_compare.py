@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Compare two Google Benchmark JSON reports of bench_sampling and fail on regressions.
+
+    bench_sampling --benchmark_out=current.json --benchmark_out_format=json --benchmark_repetitions=5
+    bench_compare.py baseline.json current.json --threshold 10
+
+Benchmarks are matched by name. With repetitions the median aggregate is compared, otherwise the mean of the
+iterations. Exits with 1 if any benchmark got slower by more than the threshold, benchmarks present in only one
+report are listed but do not fail the comparison.
+"""
+
+import argparse
+import json
+import sys
+
+NANOSECONDS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path) as report:
+        benchmarks = json.load(report)["benchmarks"]
+
+    medians = {}
+    runs = {}
+    for entry in benchmarks:
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        time = entry[metric] * NANOSECONDS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = time
+        else:
+            runs.setdefault(name, []).append(time)
+
+    times = {name: sum(values) / len(values) for name, values in runs.items()}
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slowdown that counts as a regression (default: %(default)s)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="cpu_time",
+                        help="time to compare (default: %(default)s)")
+    options = parser.parse_args()
+
+    baseline = load(options.baseline, options.metric)
+    current = load(options.current, options.metric)
+
+    regressions = []
+    width = max((len(name) for name in baseline.keys() | current.keys()), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline ns':>12}  {'current ns':>12}  {'change':>8}")
+    for name in sorted(baseline.keys() & current.keys()):
+        before = baseline[name]
+        after = current[name]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        flag = ""
+        if change > options.threshold:
+            regressions.append(name)
+            flag = "  REGRESSION"
+        print(f"{name:<{width}}  {before:>12.4g}  {after:>12.4g}  {change:>+7.1f}%{flag}")
+
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<{width}}  only in the baseline")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<{width}}  new")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) regressed by more than {options.threshold:g}%", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
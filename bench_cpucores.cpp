@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "cpucores.h"
+
+/*
+ * Per-tick cost of the per-core CPU engine: one parse of the `cpu` block of /proc/stat plus the delta and ratio pass.
+ * The argument is the number of simulated logical cores. Two synthetic snapshots are alternated so every tick
+ * produces real deltas, their text is shaped like a busy server's (large counters, all ten columns).
+ */
+
+namespace {
+
+std::string syntheticStat(int cores, unsigned long long base) {
+    std::string text = "cpu  ";
+    for (int field = 0; field < 10; field++)
+        text += std::to_string(base * static_cast<unsigned long long>(cores) + field) + " ";
+    text += "\n";
+
+    for (int i = 0; i < cores; i++) {
+        unsigned long long core_base = base + static_cast<unsigned long long>(i) * 7919;
+        text += "cpu" + std::to_string(i);
+        text += " " + std::to_string(core_base * 3);
+        text += " " + std::to_string(core_base / 50);
+        text += " " + std::to_string(core_base);
+        text += " " + std::to_string(core_base * 5);
+        text += " " + std::to_string(core_base / 20);
+        text += " 0 " + std::to_string(core_base / 100);
+        text += " 0 0 0\n";
+    }
+    text += "intr 1234567890 0 0 0\nctxt 987654321\nbtime 1700000000\n";
+    return text;
+}
+
+} // namespace
+
+static void BM_CpuCoresTick(benchmark::State &state) {
+    const int cores = static_cast<int>(state.range(0));
+    const std::string snapshots[2] = {
+        syntheticStat(cores, 123456789),
+        syntheticStat(cores, 123456789 + 25),
+    };
+
+    CpuCoreStats stats;
+    stats.parse(snapshots[1].data(), snapshots[1].size());
+
+    size_t tick = 0;
+    for (auto _ : state) {
+        const std::string &text = snapshots[tick++ & 1];
+        stats.parse(text.data(), text.size());
+        benchmark::DoNotOptimize(stats.maxBusy());
+        benchmark::DoNotOptimize(stats.coresAbove(0.9f));
+    }
+
+    state.counters["cores"] = cores;
+    state.counters["bytes_per_tick"] = static_cast<double>(snapshots[0].size());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(snapshots[0].size()));
+}
+BENCHMARK(BM_CpuCoresTick)->Arg(8)->Arg(64)->Arg(256);
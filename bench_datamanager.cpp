@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <QCoreApplication>
+
+#include "datamanager.h"
+#include "replaysource.h"
+
+#ifndef _WIN32
+#include "bench_proctree.h"
+#include "proctable.h"
+#endif
+
+/*
+ * DataManager's own share of a tick. The update thread is stopped and the benchmark thread calls `update` directly,
+ * draining the queued history appends every HISTORY_DRAIN_TICKS ticks inside the timing, as the GUI thread would.
+ *
+ * BM_DataManagerUiDelivery is the GUI thread's side: ticks published from another thread while the GUI thread is busy,
+ * then the time it takes to catch up, with a `frameReady` handler reading the properties a QML window binds. However
+ * many ticks piled up, one delivery is waiting, so a drain stays around a microsecond at 1, 16 and 256 ticks. With a
+ * queued notify signal per property group and tick it took about 1, 8 and 120 us, 7 deliveries a tick.
+ *
+ * BM_FullTick is the macro view: a whole tick at a given core count (synthetic `/proc/stat` through the real
+ * parser) and process count (a procfs-shaped fixture through the real process table). The source steps 10 ms a tick,
+ * so one tick in a hundred rescans the tables, see `DataManager::SCAN_INTERVAL_MS`.
+ */
+
+struct DataManagerProbe {
+    static void stopUpdates(DataManager &manager) {
+        manager.stopUpdates();
+    }
+
+    static bool update(DataManager &manager) {
+        return manager.update();
+    }
+
+    static void sampleCpuTimes(DataManager &manager, int64_t sample_us) {
+        manager.sampler.sampleCpuTimes(sample_us);
+    }
+};
+
+namespace {
+
+constexpr uint64_t HISTORY_DRAIN_TICKS = 64;
+
+void runTicks(benchmark::State &state, DataManager &manager) {
+    DataManagerProbe::stopUpdates(manager);
+
+    uint64_t ticks = 0;
+    for (auto _ : state) {
+        DataManagerProbe::update(manager);
+        if (++ticks % HISTORY_DRAIN_TICKS == 0)
+            QCoreApplication::processEvents();
+    }
+    QCoreApplication::processEvents();
+}
+
+#ifndef _WIN32
+/** Synthetic CPU and memory, with the process table of a fixture tree instead of the generated top lists. */
+class FixtureTickSource: public SyntheticSampleSource {
+    ProcessTable table;
+
+public:
+    FixtureTickSource(unsigned cores, const std::string &proc_root):
+        SyntheticSampleSource(SyntheticPattern::Spikes, cores, std::chrono::milliseconds(10), 0,
+                              ReplaySpeed::AsFastAsPossible),
+        table(proc_root.c_str())
+    {
+    }
+
+    bool updateProcessTable(double elapsed_seconds) override {
+        return table.refresh(elapsed_seconds);
+    }
+
+    size_t processCount() const override {
+        return table.processCount();
+    }
+
+    const std::vector<ProcessInfo>& topCpuProcesses() const override {
+        return table.topByCpu();
+    }
+
+    const std::vector<ProcessInfo>& topMemoryProcesses() const override {
+        return table.topByMemory();
+    }
+};
+#endif
+
+} // namespace
+
+static void BM_DataManagerUpdateLive(benchmark::State &state) {
+    DataManager manager;
+    runTicks(state, manager);
+}
+BENCHMARK(BM_DataManagerUpdateLive)->Unit(benchmark::kMicrosecond);
+
+static void BM_DataManagerUpdateSynthetic(benchmark::State &state) {
+    DataManager manager(nullptr, std::make_unique<SyntheticSampleSource>(
+        SyntheticPattern::Spikes, static_cast<unsigned>(state.range(0)), std::chrono::milliseconds(10), 0,
+        ReplaySpeed::AsFastAsPossible));
+    runTicks(state, manager);
+}
+BENCHMARK(BM_DataManagerUpdateSynthetic)->Arg(8)->Arg(64)->Arg(256)->Unit(benchmark::kMicrosecond);
+
+static void BM_DataManagerUiDelivery(benchmark::State &state) {
+    DataManager manager(nullptr, std::make_unique<SyntheticSampleSource>(
+        SyntheticPattern::Spikes, 8, std::chrono::milliseconds(10), 0, ReplaySpeed::AsFastAsPossible));
+    DataManagerProbe::stopUpdates(manager);
+    QCoreApplication::processEvents();
+
+    uint64_t deliveries = 0;
+    double bound = 0.0;
+    QObject receiver;
+    QObject::connect(&manager, &DataManager::frameReady, &receiver, [&]() {
+        deliveries++;
+        bound += manager.MemUsedPercent() + manager.MemProcPercent() + manager.CpuTotal() + manager.CpuProcUse() +
+            manager.GpuProcUse() + manager.CoreMaxUse() + manager.SampleTimeMs() + manager.CoreUse().size();
+    });
+
+    const int ticks_per_drain = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        // Published from another thread, as the update thread would
+        std::thread producer([&]() {
+            for (int i = 0; i < ticks_per_drain; i++)
+                DataManagerProbe::update(manager);
+        });
+        producer.join();
+
+        const auto start = std::chrono::steady_clock::now();
+        QCoreApplication::processEvents();
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    benchmark::DoNotOptimize(bound);
+    state.counters["deliveries_per_drain"] = static_cast<double>(deliveries) / static_cast<double>(state.iterations());
+    state.counters["coalesced"] = static_cast<double>(manager.CoalescedFrames());
+}
+BENCHMARK(BM_DataManagerUiDelivery)->Arg(1)->Arg(16)->Arg(256)->UseManualTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_DataManagerSampleCpuTimes(benchmark::State &state) {
+    DataManager manager;
+    DataManagerProbe::stopUpdates(manager);
+
+    int64_t sample_us = 0;
+    for (auto _ : state) {
+        sample_us += 10000;
+        DataManagerProbe::sampleCpuTimes(manager, sample_us);
+    }
+    QCoreApplication::processEvents();
+}
+BENCHMARK(BM_DataManagerSampleCpuTimes);
+
+#ifndef _WIN32
+static void BM_FullTick(benchmark::State &state) {
+    const unsigned cores = static_cast<unsigned>(state.range(0));
+    ProcFixtureTree tree(static_cast<int>(state.range(1)));
+
+    DataManager manager(nullptr, std::make_unique<FixtureTickSource>(cores, tree.path()));
+    runTicks(state, manager);
+    state.counters["processes"] = static_cast<double>(manager.ProcessCount());
+    // The median tick skips the table scans, the slowest one runs them
+    const LatencyHistogram &tick = manager.phaseLatency(DataManager::UpdatePhase::Tick);
+    state.counters["tick_p50_us"] = static_cast<double>(tick.percentile(0.5)) / 1000.0;
+    state.counters["tick_max_us"] = static_cast<double>(tick.max()) / 1000.0;
+    state.counters["scans"] = static_cast<double>(
+        manager.phaseLatency(DataManager::UpdatePhase::Processes).count());
+}
+BENCHMARK(BM_FullTick)
+    ->Args({8, 500})
+    ->Args({64, 5000})
+    ->Args({256, 20000})
+    ->Unit(benchmark::kMillisecond);
+#endif
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+
+#include "drmclients.h"
+#include "testfixture.h"
+
+/*
+ * GPU utilization of one process from its DRM fdinfo, against a fixture process with 256 descriptors of which 4 are
+ * DRM clients. BM_DrmClientUpdate is an ordinary tick, re-reading the known clients only. BM_DrmClientScan forces the
+ * fd directory scan every iteration, what a tick costs when the foreground process changes.
+ */
+
+namespace {
+
+constexpr int PID = 4242;
+constexpr int DESCRIPTORS = 256;
+constexpr int DRM_EVERY = DESCRIPTORS / 4;
+
+class DrmFixture {
+    FixtureDir dir {"bench_drmclients"};
+
+public:
+    DrmFixture() {
+        if (dir.path().empty())
+            return;
+        const std::string fdinfo = dir.path() + "/" + std::to_string(PID) + "/fdinfo";
+        makeDirs(fdinfo);
+
+        for (int fd = 0; fd < DESCRIPTORS; fd++) {
+            FILE *file = std::fopen((fdinfo + "/" + std::to_string(fd)).c_str(), "w");
+            if (file == nullptr)
+                continue;
+            std::fputs("pos:\t0\nflags:\t02100002\nmnt_id:\t24\nino:\t1029\n", file);
+            if (fd % DRM_EVERY == DRM_EVERY - 1) {
+                std::fprintf(file, "drm-driver:\tamdgpu\ndrm-client-id:\t%d\ndrm-pdev:\t0000:03:00.0\n"
+                             "drm-engine-gfx:\t%d ns\ndrm-engine-compute:\t0 ns\ndrm-engine-dma:\t0 ns\n"
+                             "drm-engine-dec:\t0 ns\ndrm-engine-enc:\t0 ns\ndrm-memory-vram:\t524288 KiB\n",
+                             fd, fd * 1000);
+            }
+            std::fclose(file);
+        }
+    }
+
+    const std::string& path() const {
+        return dir.path();
+    }
+};
+
+} // namespace
+
+static void BM_DrmClientUpdate(benchmark::State &state) {
+    DrmFixture fixture;
+    DrmClientTable table(fixture.path().c_str());
+
+    int64_t time_us = 0;
+    table.update(PID, time_us);
+    for (auto _ : state) {
+        time_us += 1;
+        benchmark::DoNotOptimize(table.update(PID, time_us));
+    }
+    state.counters["clients"] = static_cast<double>(table.clientCount());
+    state.counters["scans"] = static_cast<double>(table.scanCount());
+}
+BENCHMARK(BM_DrmClientUpdate);
+
+static void BM_DrmClientScan(benchmark::State &state) {
+    DrmFixture fixture;
+    DrmClientTable table(fixture.path().c_str());
+
+    int64_t time_us = 0;
+    for (auto _ : state) {
+        time_us += DrmClientTable::RESCAN_INTERVAL_US;
+        benchmark::DoNotOptimize(table.update(PID, time_us));
+    }
+    state.counters["clients"] = static_cast<double>(table.clientCount());
+}
+BENCHMARK(BM_DrmClientScan)->Unit(benchmark::kMicrosecond);
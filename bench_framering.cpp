@@ -0,0 +1,132 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "framering.h"
+
+/*
+ * Shared-memory frame ring throughput. The writer side is what hw_overlayd pays per tick on top of sampling, the
+ * reader side what a poller such as hw_overlay_tail pays per frame. The contended runs keep a writer thread
+ * publishing as fast as it can, far beyond any real refresh rate, so readers retry on nearly every copy.
+ */
+
+namespace {
+
+std::string benchRing(const char *name) {
+    return "/bench_framering." + std::to_string(getpid()) + "." + name;
+}
+
+MetricFrame benchFrame(uint64_t tick) {
+    MetricFrame frame {};
+    frame.tick = tick;
+    frame.timestamp_ms = static_cast<double>(tick) * 10.0;
+    frame.mem_total = 16ll << 30;
+    frame.mem_used = static_cast<int64_t>(tick);
+    frame.cpu_use = 0.5;
+    return frame;
+}
+
+/** Publishes into `writer` until destroyed. */
+class BusyWriter {
+    std::atomic<bool> running;
+    std::thread thread;
+
+public:
+    explicit BusyWriter(FrameRingWriter &writer): running{true} {
+        thread = std::thread([this, &writer]() {
+            uint64_t tick = writer.published();
+            while (running.load(std::memory_order_relaxed))
+                writer.publish(benchFrame(++tick));
+        });
+    }
+
+    ~BusyWriter() {
+        running = false;
+        thread.join();
+    }
+};
+
+} // namespace
+
+static void BM_FrameRingPublish(benchmark::State &state) {
+    FrameRingWriter writer;
+    if (!writer.open(benchRing("publish"), static_cast<uint32_t>(state.range(0)))) {
+        state.SkipWithError("could not create the ring");
+        return;
+    }
+
+    uint64_t tick = 0;
+    for (auto _ : state)
+        writer.publish(benchFrame(++tick));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameRingPublish)->Arg(64)->Arg(4096);
+
+static void BM_FrameRingLatest(benchmark::State &state) {
+    const std::string name = benchRing("latest");
+    FrameRingWriter writer;
+    FrameRingReader reader;
+    if (!writer.open(name, FrameRingWriter::DEFAULT_CAPACITY) || !reader.open(name)) {
+        state.SkipWithError("could not create the ring");
+        return;
+    }
+    writer.publish(benchFrame(1));
+
+    MetricFrame frame;
+    for (auto _ : state) {
+        reader.latest(frame);
+        benchmark::DoNotOptimize(frame);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameRingLatest);
+
+static void BM_FrameRingLatestContended(benchmark::State &state) {
+    const std::string name = benchRing("contended");
+    FrameRingWriter writer;
+    FrameRingReader reader;
+    if (!writer.open(name, FrameRingWriter::DEFAULT_CAPACITY) || !reader.open(name)) {
+        state.SkipWithError("could not create the ring");
+        return;
+    }
+    writer.publish(benchFrame(1));
+    BusyWriter busy(writer);
+
+    MetricFrame frame;
+    for (auto _ : state) {
+        reader.latest(frame);
+        benchmark::DoNotOptimize(frame);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameRingLatestContended)->UseRealTime();
+
+// A follower reading every frame in order while the writer laps it, reports how many it could not keep up with
+static void BM_FrameRingFollowContended(benchmark::State &state) {
+    const std::string name = benchRing("follow");
+    FrameRingWriter writer;
+    FrameRingReader reader;
+    if (!writer.open(name, static_cast<uint32_t>(state.range(0))) || !reader.open(name)) {
+        state.SkipWithError("could not create the ring");
+        return;
+    }
+    writer.publish(benchFrame(1));
+    BusyWriter busy(writer);
+
+    uint64_t cursor = 0;
+    uint64_t skipped = 0;
+    int64_t frames = 0;
+    MetricFrame frame;
+    for (auto _ : state) {
+        if (reader.next(cursor, frame, &skipped))
+            frames++;
+        benchmark::DoNotOptimize(frame);
+    }
+    state.SetItemsProcessed(frames);
+    state.counters["skipped_share"] = static_cast<double>(skipped) / static_cast<double>(skipped + frames + 1);
+}
+BENCHMARK(BM_FrameRingFollowContended)->Arg(64)->Arg(4096)->UseRealTime();
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "gpuinstances.h"
+
+/*
+ * The GPU engine instance index against synthetic lists shaped like the one `PdhEnumObjectItemsW` returns,
+ * five engines per process. The argument is the number of processes.
+ * BM_GpuIndexRebuild is the cost when the enumeration changed, BM_GpuIndexUnchanged the usual tick where it did not.
+ */
+
+namespace {
+
+constexpr int FIRST_PID = 1000;
+
+/** Double-null separated instance names, `pid_<pid>_luid_..._engtype_<type>` for `processes` processes. */
+std::vector<wchar_t> gpuInstanceList(int processes, int first_pid = FIRST_PID) {
+    const wchar_t *engines[] = {L"3D", L"Copy", L"VideoDecode", L"VideoProcessing", L"Compute_0"};
+    std::wstring list;
+    for (int pid = first_pid; pid < first_pid + processes; pid++) {
+        for (const wchar_t *engine : engines) {
+            list += L"pid_" + std::to_wstring(pid) + L"_luid_0x00000000_0x0000D1C5_phys_0_eng_0_engtype_" + engine;
+            list.push_back(L'\0');
+        }
+    }
+    list.push_back(L'\0');
+    return std::vector<wchar_t>(list.begin(), list.end());
+}
+
+} // namespace
+
+static void BM_GpuIndexRebuild(benchmark::State &state) {
+    const int processes = static_cast<int>(state.range(0));
+    // Alternate between two lists so every update rebuilds
+    const std::vector<wchar_t> lists[] = {gpuInstanceList(processes), gpuInstanceList(processes, FIRST_PID + 1)};
+
+    GpuInstanceIndex index;
+    size_t turn = 0;
+    for (auto _ : state) {
+        const auto &list = lists[turn++ & 1];
+        index.update(list.data(), list.size());
+        benchmark::DoNotOptimize(index.find(FIRST_PID + processes / 2).data());
+    }
+    state.counters["instances"] = static_cast<double>(index.instanceCount());
+}
+BENCHMARK(BM_GpuIndexRebuild)->Arg(50)->Arg(400)->Arg(2000);
+
+static void BM_GpuIndexUnchanged(benchmark::State &state) {
+    const int processes = static_cast<int>(state.range(0));
+    const std::vector<wchar_t> list = gpuInstanceList(processes);
+
+    GpuInstanceIndex index;
+    index.update(list.data(), list.size());
+    for (auto _ : state) {
+        index.update(list.data(), list.size());
+        benchmark::DoNotOptimize(index.find(FIRST_PID + processes / 2).data());
+    }
+}
+BENCHMARK(BM_GpuIndexUnchanged)->Arg(50)->Arg(400)->Arg(2000);
+
+static void BM_GpuIndexFind(benchmark::State &state) {
+    const std::vector<wchar_t> list = gpuInstanceList(2000);
+    GpuInstanceIndex index;
+    index.update(list.data(), list.size());
+
+    uint32_t pid = FIRST_PID;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.find(pid).data());
+        pid = pid + 1 < FIRST_PID + 2000 ? pid + 1 : FIRST_PID;
+    }
+}
+BENCHMARK(BM_GpuIndexFind);
+
+static void BM_GpuParsePid(benchmark::State &state) {
+    const std::wstring name = L"pid_123456_luid_0x00000000_0x0000D1C5_phys_0_eng_0_engtype_3D";
+    uint32_t pid = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(GpuInstanceIndex::parsePid(name, pid));
+        benchmark::DoNotOptimize(GpuInstanceIndex::engineType(name).size());
+    }
+}
+BENCHMARK(BM_GpuParsePid);
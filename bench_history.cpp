@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include <QJSValue>
+#include <QQmlEngine>
+#include <QtGraphs/QLineSeries>
+
+#include "historyseries.h"
+
+/*
+ * Per-tick cost of keeping one graph's 60 s history, the old JavaScript path from Main.qml against HistorySeries.
+ * The argument is the refresh interval in ms, the window holds 60000 / interval points.
+ *
+ * The JS engine has no public GC counter, so GC pauses show up here as `slow_ticks` (ticks over 1 ms) and
+ * `max_tick_us`. Run with QV4_MM_STATS=1 to have the engine itself print every collection.
+ */
+
+namespace {
+
+constexpr double WINDOW_MS = 60 * 1000;
+constexpr auto SLOW_TICK = std::chrono::milliseconds(1);
+
+// Verbatim logic of the handlers that used to live in Main.qml
+const char *LEGACY_JS_TICK = R"(
+(function(series, window_ms) {
+    let history = [];
+    return function(now_ms, value) {
+        for (let datapoint of history) {
+            datapoint.x = datapoint.timestamp_ms - now_ms;
+        }
+        let oldest = history[0];
+        if (oldest && oldest.x < window_ms) {
+            history.shift();
+        }
+        history.push({x: 0, y: value, timestamp_ms: now_ms});
+        series.replace(history);
+    };
+})
+)";
+
+// Tracks the tick-time outliers that GC pauses produce.
+struct TickOutliers {
+    std::chrono::steady_clock::duration max {};
+    long long slow = 0;
+
+    template <typename Fn>
+    void time(Fn &&tick) {
+        auto start = std::chrono::steady_clock::now();
+        tick();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed > max)
+            max = elapsed;
+        if (elapsed > SLOW_TICK)
+            slow++;
+    }
+
+    void report(benchmark::State &state) const {
+        state.counters["max_tick_us"] = std::chrono::duration<double, std::micro>(max).count();
+        state.counters["slow_ticks"] = static_cast<double>(slow);
+    }
+};
+
+double sample_value(long long tick) {
+    return static_cast<double>(tick % 100);
+}
+
+}
+
+static void BM_HistoryLegacyJsTick(benchmark::State &state) {
+    const double interval_ms = static_cast<double>(state.range(0));
+    const long long window_points = static_cast<long long>(WINDOW_MS / interval_ms);
+
+    QQmlEngine engine;
+    QLineSeries series;
+    QQmlEngine::setObjectOwnership(&series, QQmlEngine::CppOwnership);
+    QJSValue factory = engine.evaluate(QString::fromUtf8(LEGACY_JS_TICK));
+    QJSValue tick_fn = factory.call({engine.newQObject(&series), QJSValue(-WINDOW_MS)});
+
+    double now_ms = 0;
+    long long tick = 0;
+    for (; tick < window_points; tick++, now_ms += interval_ms)
+        tick_fn.call({QJSValue(now_ms), QJSValue(sample_value(tick))});
+
+    TickOutliers outliers;
+    for (auto _ : state) {
+        outliers.time([&]() {
+            tick_fn.call({QJSValue(now_ms), QJSValue(sample_value(tick))});
+        });
+        now_ms += interval_ms;
+        tick++;
+    }
+    outliers.report(state);
+    state.counters["points"] = static_cast<double>(series.count());
+}
+BENCHMARK(BM_HistoryLegacyJsTick)->Arg(250)->Arg(50)->Arg(10)->Unit(benchmark::kMicrosecond);
+
+static void BM_HistorySeriesTick(benchmark::State &state) {
+    const double interval_ms = static_cast<double>(state.range(0));
+    const size_t window_points = static_cast<size_t>(WINDOW_MS / interval_ms);
+
+    QLineSeries series;
+    HistorySeries history(window_points + 2, WINDOW_MS);
+    history.bindSeries(&series);
+
+    double now_ms = 0;
+    long long tick = 0;
+    for (; tick < static_cast<long long>(window_points); tick++, now_ms += interval_ms)
+        history.append(now_ms, sample_value(tick));
+
+    TickOutliers outliers;
+    for (auto _ : state) {
+        outliers.time([&]() {
+            history.append(now_ms, sample_value(tick));
+        });
+        now_ms += interval_ms;
+        tick++;
+    }
+    outliers.report(state);
+    // Decimated, stays near 2x the default pixel width however fast the refresh
+    state.counters["points"] = static_cast<double>(series.count());
+}
+BENCHMARK(BM_HistorySeriesTick)->Arg(250)->Arg(50)->Arg(10)->Arg(1)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,16 @@
+#include <benchmark/benchmark.h>
+
+#include <QCoreApplication>
+
+// Shared entry point for bench_sampling, some benchmarks need a Qt application object to exist.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
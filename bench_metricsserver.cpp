@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "metricsserver.h"
+
+/*
+ * Prometheus endpoint. BM_MetricsPageRender is what the update thread pays per tick with every collector active on a
+ * 64 core machine. The scrape benchmarks are round trips over loopback as a scraper sees them, on a kept-alive
+ * connection and on a fresh one per scrape, with the server rendering nothing itself.
+ */
+
+namespace {
+
+struct FullSnapshot {
+    MetricFrame frame {};
+    CoreFrame cores {};
+    ProcessFrame processes {};
+    WatchFrame watches {};
+    CgroupFrame cgroups {};
+    OverheadFrame overhead {};
+    MetricsSnapshot snapshot;
+
+    FullSnapshot() {
+        frame.tick = 1;
+        frame.cpu_use = 0.37;
+        frame.mem_total = 64ll << 30;
+        frame.mem_used = 23ll << 30;
+        cores.count = 64;
+        for (uint32_t core = 0; core < cores.count; core++)
+            cores.busy[core] = static_cast<float>(core) / cores.count;
+        processes.process_count = 412;
+        processes.top_cpu_count = ProcessFrame::MAX_TOP;
+        processes.top_memory_count = ProcessFrame::MAX_TOP;
+        for (uint32_t i = 0; i < ProcessFrame::MAX_TOP; i++) {
+            processes.top_cpu[i] = ProcessInfo{static_cast<int32_t>(1000 + i), "worker", 0.5f, 1ull << 28};
+            processes.top_memory[i] = processes.top_cpu[i];
+        }
+        watches.count = 4;
+        for (uint32_t i = 0; i < watches.count; i++)
+            std::snprintf(watches.watches[i].name, sizeof(watches.watches[i].name), "service-%u", i);
+        cgroups.count = CgroupFrame::MAX_CGROUPS;
+        for (uint32_t i = 0; i < cgroups.count; i++)
+            std::snprintf(cgroups.groups[i].path, sizeof(cgroups.groups[i].path), "/system.slice/unit-%u.service", i);
+        overhead.tick = 1;
+
+        snapshot.frame = &frame;
+        snapshot.cores = &cores;
+        snapshot.processes = &processes;
+        snapshot.watches = &watches;
+        snapshot.cgroups = &cgroups;
+        snapshot.overhead = &overhead;
+        snapshot.foreground_name = "game";
+    }
+};
+
+int connectTo(uint16_t port) {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return fd;
+}
+
+/** Send one scrape and read its response, whose size is known up front. */
+bool scrape(int fd, std::string &buffer, size_t response_size) {
+    static const char request[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request) - 1))
+        return false;
+    size_t received = 0;
+    while (received < response_size) {
+        const ssize_t chunk = recv(fd, &buffer[received], buffer.size() - received, 0);
+        if (chunk <= 0)
+            return false;
+        received += static_cast<size_t>(chunk);
+    }
+    return true;
+}
+
+} // namespace
+
+static void BM_MetricsPageRender(benchmark::State &state) {
+    FullSnapshot full;
+    MetricsPage page;
+
+    for (auto _ : state) {
+        full.frame.tick++;
+        page.render(full.snapshot);
+    }
+    state.counters["response_bytes"] = static_cast<double>(page.acquire().size());
+}
+BENCHMARK(BM_MetricsPageRender)->Unit(benchmark::kMicrosecond);
+
+static void BM_MetricsScrapeKeepAlive(benchmark::State &state) {
+    FullSnapshot full;
+    MetricsPage page;
+    page.render(full.snapshot);
+    const size_t response_size = page.acquire().size();
+    MetricsServer server(page);
+    if (!server.start(0)) {
+        state.SkipWithError("could not listen on loopback");
+        return;
+    }
+    const int fd = connectTo(server.port());
+    std::string buffer(response_size, '\0');
+
+    for (auto _ : state) {
+        if (!scrape(fd, buffer, response_size)) {
+            state.SkipWithError("scrape failed");
+            break;
+        }
+    }
+    close(fd);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricsScrapeKeepAlive)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_MetricsScrapeNewConnection(benchmark::State &state) {
+    FullSnapshot full;
+    MetricsPage page;
+    page.render(full.snapshot);
+    const size_t response_size = page.acquire().size();
+    MetricsServer server(page);
+    if (!server.start(0)) {
+        state.SkipWithError("could not listen on loopback");
+        return;
+    }
+    std::string buffer(response_size, '\0');
+
+    for (auto _ : state) {
+        const int fd = connectTo(server.port());
+        const bool scraped = fd >= 0 && scrape(fd, buffer, response_size);
+        close(fd);
+        if (!scraped) {
+            state.SkipWithError("scrape failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricsScrapeNewConnection)->UseRealTime()->Unit(benchmark::kMicrosecond);
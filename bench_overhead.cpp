@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "latencyhistogram.h"
+#include "selfmonitor.h"
+
+/*
+ * What DataManager's self-instrumentation adds to a tick. BM_PhaseTiming is one phase as `update` records it: a
+ * clock read and a histogram record, so a tick pays it once per `DataManager::UpdatePhase` plus one clock read.
+ * BM_SelfMonitorRead runs about once a second, not per tick.
+ */
+
+static void BM_HistogramRecord(benchmark::State &state) {
+    LatencyHistogram histogram;
+    uint64_t value = 1;
+    for (auto _ : state) {
+        // Spread over the buckets a tick's phases land in, 1 µs to 1 ms
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+        histogram.record(1000 + (value >> 44));
+    }
+    benchmark::DoNotOptimize(histogram.count());
+}
+BENCHMARK(BM_HistogramRecord);
+
+static void BM_PhaseTiming(benchmark::State &state) {
+    LatencyHistogram histogram;
+    auto phase_start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        const auto now = std::chrono::steady_clock::now();
+        histogram.record(static_cast<uint64_t>(std::chrono::nanoseconds(now - phase_start).count()));
+        phase_start = now;
+    }
+    benchmark::DoNotOptimize(histogram.count());
+}
+BENCHMARK(BM_PhaseTiming);
+
+static void BM_HistogramPercentile(benchmark::State &state) {
+    LatencyHistogram histogram;
+    for (uint64_t i = 0; i < 100000; i++)
+        histogram.record(1000 + i * 37 % 500000);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(histogram.percentile(0.99));
+}
+BENCHMARK(BM_HistogramPercentile);
+
+static void BM_SelfMonitorRead(benchmark::State &state) {
+    SelfMonitor monitor;
+    SelfUsage usage {};
+    for (auto _ : state) {
+        monitor.read(usage);
+        benchmark::DoNotOptimize(usage.rss_bytes);
+    }
+}
+BENCHMARK(BM_SelfMonitorRead);
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "procdata.h"
+
+/*
+ * Cost of each ProcData call against the live OS, one call per iteration, plus `sample` which gathers all of them
+ * in one pass. The tracked process is this one, so the numbers do not depend on what else runs on the machine.
+ * The GPU counter path parser is portable and measured in bench_gpuinstances.cpp.
+ */
+
+namespace {
+
+ProcData& procData() {
+    static ProcData data_source;
+    return data_source;
+}
+
+} // namespace
+
+static void BM_ProcDataTotalCpuTime(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(data_source.getTotalCpuTime());
+}
+BENCHMARK(BM_ProcDataTotalCpuTime);
+
+static void BM_ProcDataTotalProcessTime(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(data_source.getTotalProcessTime());
+}
+BENCHMARK(BM_ProcDataTotalProcessTime);
+
+static void BM_ProcDataFgProcessMemory(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(data_source.getFgProcessMemory());
+}
+BENCHMARK(BM_ProcDataFgProcessMemory);
+
+static void BM_ProcDataFgProcessName(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state) {
+        std::string name = data_source.getFgProcessName();
+        benchmark::DoNotOptimize(name.data());
+    }
+}
+BENCHMARK(BM_ProcDataFgProcessName);
+
+static void BM_ProcDataFgProcHandle(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(data_source.getFgProcHandle());
+}
+BENCHMARK(BM_ProcDataFgProcHandle);
+
+static void BM_ProcDataFgProcessGpuUsage(benchmark::State &state) {
+    ProcData &data_source = procData();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(data_source.getFgProcessGpuUsage());
+}
+BENCHMARK(BM_ProcDataFgProcessGpuUsage);
+
+static void BM_ProcDataSample(benchmark::State &state) {
+    ProcData &data_source = procData();
+    SampleFrame frame {};
+    for (auto _ : state) {
+        data_source.sample(frame);
+        benchmark::DoNotOptimize(frame.cpu_time);
+    }
+}
+BENCHMARK(BM_ProcDataSample);
+
+#ifndef _WIN32
+
+/*
+ * `sample` while the target flips between this process and its parent every tick, which used to close and reopen
+ * the procfs descriptors each time. With Arg 1 both are on the watch list as well, so every switch also has a delta.
+ */
+static void BM_ProcDataFocusSwitch(benchmark::State &state) {
+    ProcData data_source;
+    const pid_t targets[2] = {getpid(), getppid()};
+    if (state.range(0) != 0)
+        data_source.setWatchTargets({WatchTarget::byPid(targets[0]), WatchTarget::byPid(targets[1])});
+
+    SampleFrame frame {};
+    size_t tick = 0;
+    for (auto _ : state) {
+        data_source.setTargetPid(targets[tick++ % 2]);
+        data_source.sample(frame);
+        benchmark::DoNotOptimize(frame.process_time_delta);
+    }
+}
+BENCHMARK(BM_ProcDataFocusSwitch)->Arg(0)->Arg(1);
+
+#else
+
+static void BM_GetLastPathItem(benchmark::State &state) {
+    std::wstring path = L"C:\\Program Files\\Some Vendor\\Some Product\\bin\\x64\\application.exe";
+    for (auto _ : state) {
+        std::string item = ProcData::getLastPathItem(path.data(), static_cast<DWORD>(path.size()));
+        benchmark::DoNotOptimize(item.data());
+    }
+}
+BENCHMARK(BM_GetLastPathItem);
+
+#endif
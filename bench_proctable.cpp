@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_proctree.h"
+#include "proctable.h"
+
+/*
+ * Per-tick cost of a whole-system process table refresh against a synthetic procfs tree of N processes, of which
+ * the given percentage runs on every tick. The fixture lives on a regular file system, so this measures the
+ * enumeration, syscall pattern and bookkeeping; real procfs additionally formats every stat file in the kernel,
+ * compare with BM_ProcessTableLive on a loaded machine. `stat_reads` is how many files a refresh read on average,
+ * the busy processes plus a 16th of the idle ones.
+ *
+ * 5 ms per tick at 20000 processes is out of reach while every tick lists every PID: `getdents64` alone costs about
+ * a microsecond per entry of `/proc`, some 20 ms at 20000 before any stat is read. What is bounded is the rest, about
+ * a 16th of the reads a full pass makes. That is why DataManager refreshes the table once a second rather than on
+ * every tick, see `SCAN_INTERVAL_MS`.
+ */
+
+static void BM_ProcessTableFixture(benchmark::State &state) {
+    const int processes = static_cast<int>(state.range(0));
+    const int busy_every = 100 / static_cast<int>(state.range(1));
+    ProcFixtureTree tree(processes);
+    ProcessTable table(tree.path().c_str());
+    if (!table.refresh(0.0)) {
+        state.SkipWithError("could not create the fixture tree");
+        return;
+    }
+    // Every process is new to the first two refreshes, from the third on the idle ones are read in their slot only
+    table.refresh(0.25);
+
+    unsigned long long ticks = 0;
+    size_t stat_reads = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ticks++;
+        for (int pid = busy_every; pid <= processes; pid += busy_every)
+            tree.run(pid, ticks);
+        state.ResumeTiming();
+
+        table.refresh(0.25);
+        benchmark::DoNotOptimize(table.topByCpu().data());
+        stat_reads += table.statReads();
+    }
+
+    state.counters["processes"] = static_cast<double>(table.processCount());
+    state.counters["cached_fds"] = static_cast<double>(table.cachedDescriptors());
+    state.counters["stat_reads"] = benchmark::Counter(static_cast<double>(stat_reads),
+                                                      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ProcessTableFixture)->Args({1000, 1})->Args({20000, 1})->Args({20000, 5})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ProcessTableLive(benchmark::State &state) {
+    ProcessTable table;
+    table.refresh(0.0);
+
+    for (auto _ : state) {
+        table.refresh(0.25);
+        benchmark::DoNotOptimize(table.topByCpu().data());
+    }
+
+    state.counters["processes"] = static_cast<double>(table.processCount());
+}
+BENCHMARK(BM_ProcessTableLive)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,55 @@
+#ifndef BENCH_PROCTREE_H
+#define BENCH_PROCTREE_H
+
+#include <cstdio>
+#include <string>
+
+#include <sys/stat.h>
+
+#include "testfixture.h"
+
+/**
+ * A procfs-shaped directory of N processes with one `stat` file each, in a temporary directory that is removed
+ * again on destruction. Shared by the benchmarks that need a process population of a given size.
+ */
+class ProcFixtureTree {
+    FixtureDir dir {"bench_proctable"};
+
+    std::string statPath(int pid) const {
+        return dir.path() + "/" + std::to_string(pid) + "/stat";
+    }
+
+    static std::string statLine(int pid, unsigned long long utime) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%d (worker-%d) S 1 %d %d 0 -1 4194560 1523 0 12 0 %llu %d 0 0 20 0 4 0 %d "
+                      "104857600 %d 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 %d 0 0 0 0 0\n",
+                      pid, pid, pid, pid, utime, pid * 7 % 50000, 1000 + pid, pid * 31 % 65536, pid % 64);
+        return line;
+    }
+
+public:
+    explicit ProcFixtureTree(int processes) {
+        const std::string &root = dir.path();
+        if (root.empty())
+            return;
+
+        for (int pid = 1; pid <= processes; pid++) {
+            mkdir((root + "/" + std::to_string(pid)).c_str(), 0755);
+            writeFile(statPath(pid), statLine(pid, static_cast<unsigned long long>(pid * 13 % 100000)));
+        }
+        // A few of the non-PID entries a real /proc has
+        mkdir((root + "/self").c_str(), 0755);
+        mkdir((root + "/sys").c_str(), 0755);
+    }
+
+    const std::string& path() const {
+        return dir.path();
+    }
+
+    /** Give `pid` `ticks` more user time than it started with, as if it had been running. */
+    bool run(int pid, unsigned long long ticks) {
+        return writeFile(statPath(pid), statLine(pid, static_cast<unsigned long long>(pid * 13 % 100000) + ticks));
+    }
+};
+
+#endif // BENCH_PROCTREE_H
@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "procwatch.h"
+
+/*
+ * Process lifetime tracking with pidfds in one epoll set, against a range of live watched processes.
+ * BM_ProcessWatcherIdle is what the sampling thread pays when nothing exited, which must not grow with the number of
+ * processes; BM_ProcessWatcherWatch adds and drops one process, as when the foreground process changes.
+ * BM_ProcessLivenessPoll is the per-tick kill(pid, 0) check the watcher replaces, one syscall per process.
+ */
+
+namespace {
+
+class HeldChildren {
+    std::vector<pid_t> children;
+
+public:
+    explicit HeldChildren(int count) {
+        for (int i = 0; i < count; i++) {
+            pid_t child = fork();
+            if (child == 0) {
+                pause();
+                _exit(0);
+            }
+            if (child > 0)
+                children.push_back(child);
+        }
+    }
+
+    ~HeldChildren() {
+        for (pid_t child : children)
+            kill(child, SIGKILL);
+        for (pid_t child : children)
+            waitpid(child, nullptr, 0);
+    }
+
+    const std::vector<pid_t>& pids() const {
+        return children;
+    }
+};
+
+} // namespace
+
+static void BM_ProcessWatcherIdle(benchmark::State &state) {
+    HeldChildren children(static_cast<int>(state.range(0)));
+    ProcessWatcher watcher;
+    for (pid_t child : children.pids())
+        watcher.watch(child);
+    if (!watcher.isOpen()) {
+        state.SkipWithError("pidfds are not supported");
+        return;
+    }
+
+    std::vector<int32_t> exited;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(watcher.collectExits(exited));
+    }
+    state.counters["watched"] = static_cast<double>(watcher.watchedCount());
+}
+BENCHMARK(BM_ProcessWatcherIdle)->Arg(1)->Arg(64)->Arg(1024);
+
+static void BM_ProcessLivenessPoll(benchmark::State &state) {
+    HeldChildren children(static_cast<int>(state.range(0)));
+
+    for (auto _ : state) {
+        int alive = 0;
+        for (pid_t child : children.pids())
+            alive += kill(child, 0) == 0;
+        benchmark::DoNotOptimize(alive);
+    }
+}
+BENCHMARK(BM_ProcessLivenessPoll)->Arg(1)->Arg(64)->Arg(1024);
+
+static void BM_ProcessWatcherWatch(benchmark::State &state) {
+    HeldChildren children(1);
+    ProcessWatcher watcher;
+    if (!watcher.isOpen() || children.pids().empty()) {
+        state.SkipWithError("pidfds are not supported");
+        return;
+    }
+
+    const pid_t child = children.pids()[0];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(watcher.watch(child));
+        watcher.unwatch(child);
+    }
+}
+BENCHMARK(BM_ProcessWatcherWatch);
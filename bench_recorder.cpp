@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "telemetryrecorder.h"
+
+/*
+ * Cost of recording one tick: the same column set DataManager records, fed with synthetic but realistically noisy
+ * values at a 10 ms refresh with scheduler jitter. Includes the periodic block write and flush. The budget is 1% of
+ * the refresh interval, 100 us per tick.
+ */
+
+namespace {
+
+const std::vector<TelemetryColumn> COLUMNS = {
+    {"cpu_use", TelemetryColumnKind::Gauge},
+    {"cpu_proc_use", TelemetryColumnKind::Gauge},
+    {"core_max_use", TelemetryColumnKind::Gauge},
+    {"elapsed_ms", TelemetryColumnKind::Gauge},
+    {"mem_total", TelemetryColumnKind::Counter},
+    {"mem_used", TelemetryColumnKind::Counter},
+    {"mem_proc", TelemetryColumnKind::Counter},
+    {"missed_deadlines", TelemetryColumnKind::Counter},
+    {"cores_above_threshold", TelemetryColumnKind::Counter},
+};
+
+constexpr size_t GAUGES = 4;
+constexpr size_t COUNTERS = 5;
+
+struct Tick {
+    int64_t timestamp;
+    double gauges[GAUGES];
+    uint64_t counters[COUNTERS];
+};
+
+std::vector<Tick> syntheticTicks(size_t count) {
+    std::mt19937_64 random(7);
+    std::uniform_int_distribution<int> jitter(-50, 50);
+    std::uniform_real_distribution<double> load(0.0, 1.0);
+
+    std::vector<Tick> ticks(count);
+    uint64_t mem_used = 6ull << 30;
+    uint64_t mem_proc = 200ull << 20;
+    for (size_t i = 0; i < count; i++) {
+        Tick &tick = ticks[i];
+        tick.timestamp = static_cast<int64_t>(i) * 10000 + jitter(random);
+        // Loads are ratios of integer tick counts, so they carry full mantissas like the real ones
+        tick.gauges[0] = static_cast<double>(static_cast<int>(load(random) * 100 + 1000)) / 4000;
+        tick.gauges[1] = static_cast<double>(random() % 8) / 800;
+        tick.gauges[2] = static_cast<double>(static_cast<float>(load(random)));
+        tick.gauges[3] = 10.0 + jitter(random) / 1000.0;
+        mem_used += (random() % 64) * 4096 - 32 * 4096;
+        mem_proc += (random() % 4 == 0) ? 4096 : 0;
+        tick.counters[0] = 16ull << 30;
+        tick.counters[1] = mem_used;
+        tick.counters[2] = mem_proc;
+        tick.counters[3] = i / 5000;
+        tick.counters[4] = random() % 3;
+    }
+    return ticks;
+}
+
+} // namespace
+
+static void BM_RecorderAppend(benchmark::State &state) {
+    const auto ticks = syntheticTicks(1 << 16);
+    const std::string path = "/tmp/bench_recorder.hwrec";
+
+    TelemetryRecorder recorder;
+    if (!recorder.open(path, COLUMNS, 0)) {
+        state.SkipWithError("cannot create the recording file");
+        return;
+    }
+
+    size_t appended = 0;
+    int64_t wrap_offset = 0;
+    for (auto _ : state) {
+        const Tick &tick = ticks[appended & (ticks.size() - 1)];
+        if ((appended & (ticks.size() - 1)) == 0 && appended != 0)
+            wrap_offset += static_cast<int64_t>(ticks.size()) * 10000;
+        recorder.append(tick.timestamp + wrap_offset, tick.gauges, tick.counters);
+        appended++;
+    }
+    recorder.close();
+
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file != nullptr) {
+        std::fseek(file, 0, SEEK_END);
+        double bytes = static_cast<double>(std::ftell(file));
+        std::fclose(file);
+        state.counters["bytes_per_value"] = bytes / static_cast<double>(appended * COLUMNS.size());
+        state.counters["bytes_per_tick"] = bytes / static_cast<double>(appended);
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(static_cast<int64_t>(appended));
+}
+BENCHMARK(BM_RecorderAppend);
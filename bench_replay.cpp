@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+
+#include <QEventLoop>
+#include <QObject>
+
+#include "datamanager.h"
+#include "replaysource.h"
+
+/*
+ * Ticks per second the model and signal path absorb: DataManager plays a synthetic trace as fast as possible while
+ * this thread drains the queued history appends, like the GUI thread would. The argument is the simulated core count,
+ * every tick renders and parses a `/proc/stat` of that size.
+ */
+
+static void BM_DataManagerReplay(benchmark::State &state) {
+    constexpr uint64_t TICKS = 2000;
+    const unsigned cores = static_cast<unsigned>(state.range(0));
+
+    uint64_t ticks = 0;
+    for (auto _ : state) {
+        DataManager manager(nullptr, std::make_unique<SyntheticSampleSource>(
+            SyntheticPattern::Spikes, cores, std::chrono::milliseconds(10), TICKS, ReplaySpeed::AsFastAsPossible));
+
+        QEventLoop loop;
+        QObject::connect(&manager, &DataManager::replayFinished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+        loop.exec();
+        ticks += TICKS;
+    }
+    state.counters["ticks_per_second"] = benchmark::Counter(static_cast<double>(ticks), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DataManagerReplay)->Arg(8)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "testfixture.h"
+#include "threadtable.h"
+
+/*
+ * Per-refresh cost of the thread table for one process of N threads, the size of a large JVM or thread-pool server,
+ * against a synthetic procfs tree. Like BM_ProcessTableFixture this measures the syscall pattern and bookkeeping, real
+ * procfs additionally formats every schedstat in the kernel. A full pass should cost about a microsecond per thread
+ * while the descriptors fit the budget; a refresh that finds the process idle reads nothing, so BM_ThreadTableIdle only
+ * grows with N through the one full pass a second it still makes.
+ */
+
+namespace {
+
+constexpr int PID = 1000;
+
+/** One process with N threads under `<pid>/task`, removed again on destruction. */
+class ThreadFixtureTree {
+    FixtureDir dir {"bench_threadtable"};
+
+public:
+    explicit ThreadFixtureTree(int threads) {
+        const std::string &root = dir.path();
+        if (root.empty())
+            return;
+
+        const std::string process = root + "/" + std::to_string(PID);
+        makeDirs(process + "/task");
+        writeFile(process + "/stat", std::to_string(PID) + " (java) S 1 1 1 0 -1 4194560 0 0 0 0 123456 7890 0 0 20 0 " +
+                  std::to_string(threads) + " 0 100 104857600 25600 0 0 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n");
+
+        for (int i = 0; i < threads; i++) {
+            const int tid = PID + i;
+            const std::string task = process + "/task/" + std::to_string(tid);
+            mkdir(task.c_str(), 0755);
+            writeFile(task + "/schedstat", std::to_string(tid * 7919ull % 1000000000ull) + " 1234 56\n");
+            writeFile(task + "/comm", "pool-" + std::to_string(i % 64) + "\n");
+        }
+    }
+
+    const std::string& path() const {
+        return dir.path();
+    }
+};
+
+} // namespace
+
+// A whole second between refreshes is past the idle allowance, so every one is a full pass over the threads
+static void BM_ThreadTableFixture(benchmark::State &state) {
+    const int threads = static_cast<int>(state.range(0));
+    ThreadFixtureTree tree(threads);
+    ThreadTable table(tree.path().c_str());
+    if (!table.refresh(PID, 0.0)) {
+        state.SkipWithError("could not create the fixture tree");
+        return;
+    }
+
+    for (auto _ : state) {
+        table.refresh(PID, 1.0);
+        benchmark::DoNotOptimize(table.topByCpu().data());
+    }
+
+    state.counters["threads"] = static_cast<double>(table.threadCount());
+    state.counters["cached_fds"] = static_cast<double>(table.cachedDescriptors());
+}
+BENCHMARK(BM_ThreadTableFixture)->Arg(200)->Arg(2000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// The fixture's counters never move, so at a 1 ms tick every refresh but one a second finds the process idle
+static void BM_ThreadTableIdle(benchmark::State &state) {
+    const int threads = static_cast<int>(state.range(0));
+    ThreadFixtureTree tree(threads);
+    ThreadTable table(tree.path().c_str());
+    if (!table.refresh(PID, 0.0)) {
+        state.SkipWithError("could not create the fixture tree");
+        return;
+    }
+
+    for (auto _ : state) {
+        table.refresh(PID, 0.001);
+        benchmark::DoNotOptimize(table.topByCpu().data());
+    }
+
+    state.counters["threads"] = static_cast<double>(table.threadCount());
+}
+BENCHMARK(BM_ThreadTableIdle)->Arg(200)->Arg(2000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+static void BM_ThreadTableLive(benchmark::State &state) {
+    ThreadTable table;
+    table.refresh(getpid(), 0.0);
+
+    for (auto _ : state) {
+        table.refresh(getpid(), 1.0);
+        benchmark::DoNotOptimize(table.topByCpu().data());
+    }
+
+    state.counters["threads"] = static_cast<double>(table.threadCount());
+}
+BENCHMARK(BM_ThreadTableLive)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,381 @@
+#include "cgrouptable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char CONTROLLERS_FILE[] = "cgroup.controllers";
+constexpr char HYBRID_DIRECTORY[] = "unified";
+
+constexpr double MICROSEC_PER_SEC = 1000000.0;
+
+bool startsWith(const char *cur, const char *end, const char *prefix, size_t length) {
+    return static_cast<size_t>(end - cur) >= length && std::memcmp(cur, prefix, length) == 0;
+}
+
+/**
+ * Value of the flat keyed line "`key` <value>" in `[cur, end)`, as in `cpu.stat` and `memory.stat`.
+ * @return false if there is no such line, `out` is left alone then.
+ */
+bool findKey(const char *cur, const char *end, const char *key, unsigned long long &out) {
+    const size_t length = std::strlen(key);
+    while (cur < end) {
+        if (startsWith(cur, end, key, length) && cur + length < end && cur[length] == ' ') {
+            ProcFile::parseUnsigned(cur + length, end, out);
+            return true;
+        }
+        cur = ProcFile::nextLine(cur, end);
+    }
+    return false;
+}
+
+bool isDirectory(int dir_fd, const dirent *entry) {
+    if (entry->d_type != DT_UNKNOWN)
+        return entry->d_type == DT_DIR;
+    struct stat status;
+    return fstatat(dir_fd, entry->d_name, &status, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(status.st_mode);
+}
+
+/** Path of `file` in the group at `path`, relative to the root descriptor. */
+std::string controlPath(const std::string &path, const char *file) {
+    return path.empty() ? std::string(file) : path + "/" + file;
+}
+
+} // namespace
+
+CgroupTable::CgroupTable(const char *root, size_t top_n):
+    root_fd{-1},
+    top_n{top_n},
+    group_count{0},
+    since_scan_seconds{0.0},
+    scan_needed{true},
+    scans{0},
+    refreshes{0}
+{
+    root_fd = ::open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    // systemd's hybrid layout mounts v1 controllers at the root and the v2 hierarchy below it
+    if (root_fd >= 0 && faccessat(root_fd, CONTROLLERS_FILE, F_OK, 0) != 0) {
+        int unified_fd = ::openat(root_fd, HYBRID_DIRECTORY, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (unified_fd >= 0 && faccessat(unified_fd, CONTROLLERS_FILE, F_OK, 0) == 0) {
+            ::close(root_fd);
+            root_fd = unified_fd;
+        } else if (unified_fd >= 0) {
+            ::close(unified_fd);
+        }
+    }
+
+    top_cpu.reserve(top_n);
+    top_memory.reserve(top_n);
+    selected_groups.resize(MAX_SELECTED);
+    last_reported.reserve(MAX_SELECTED + 2 * top_n);
+}
+
+CgroupTable::~CgroupTable() {
+    // Groups close their own descriptors
+    if (root_fd >= 0)
+        ::close(root_fd);
+}
+
+bool CgroupTable::isOpen() const {
+    return root_fd >= 0;
+}
+
+void CgroupTable::select(const std::vector<std::string> &paths) {
+    selection.clear();
+    for (const std::string &path : paths) {
+        if (selection.size() >= MAX_SELECTED)
+            break;
+        const size_t first = path.find_first_not_of('/');
+        const size_t last = path.find_last_not_of('/');
+        selection.push_back(first == std::string::npos ? std::string() : path.substr(first, last - first + 1));
+    }
+    scan_needed = true;
+}
+
+const std::vector<CgroupInfo>& CgroupTable::reported() const {
+    return last_reported;
+}
+
+size_t CgroupTable::groupCount() const {
+    return group_count;
+}
+
+uint64_t CgroupTable::scanCount() const {
+    return scans;
+}
+
+unsigned long long CgroupTable::parseLimit(const char *cur, const char *end) {
+    cur = ProcFile::skipBlanks(cur, end);
+    if (startsWith(cur, end, "max", 3))
+        return 0;
+    unsigned long long value = 0;
+    ProcFile::parseUnsigned(cur, end, value);
+    return value;
+}
+
+void CgroupTable::scan() {
+    scans++;
+    since_scan_seconds = 0.0;
+    scan_needed = false;
+    group_count = 0;
+
+    int dir_fd = ::openat(root_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        std::string path;
+        scanDirectory(dir_fd, path, 0);
+    }
+
+    // Whatever was not carried over is gone, its descriptors close with it
+    groups.swap(scanned);
+    scanned.clear();
+}
+
+void CgroupTable::scanDirectory(int dir_fd, std::string &path, unsigned depth) {
+    DIR *dir = fdopendir(dir_fd);
+    if (dir == nullptr) {
+        ::close(dir_fd);
+        return;
+    }
+    group_count++;
+
+    // Every directory below the root is a child group, the control files are regular files
+    std::vector<std::string> children;
+    while (const dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.' && isDirectory(dirfd(dir), entry))
+            children.emplace_back(entry->d_name);
+    }
+
+    int selection_index = -1;
+    for (size_t i = 0; i < selection.size(); i++) {
+        if (selection[i] == path)
+            selection_index = static_cast<int>(i);
+    }
+
+    struct stat status;
+    const bool leaf = children.empty();
+    if ((leaf || selection_index >= 0) && scanned.size() < MAX_GROUPS && fstat(dirfd(dir), &status) == 0) {
+        const uint64_t inode = static_cast<uint64_t>(status.st_ino);
+        Group group;
+        Group *known = groups.find(inode);
+        if (known != nullptr && known->path == path) {
+            group = std::move(*known);
+        } else {
+            group.path = path;
+            group.cpu_stat.openAt(dirfd(dir), "cpu.stat");
+            group.memory_current.openAt(dirfd(dir), "memory.current");
+        }
+        group.leaf = leaf;
+        group.selection = selection_index;
+
+        const char *shown = path.empty() ? "/" : path.c_str();
+        const size_t length = std::min(std::strlen(shown), CgroupInfo::PATH_SIZE - 1);
+        std::memcpy(group.info.path, shown, length);
+        group.info.path[length] = '\0';
+
+        if (group.cpu_stat.isOpen() || group.memory_current.isOpen())
+            scanned.insert(inode, std::move(group));
+    }
+
+    if (depth < MAX_DEPTH) {
+        for (const std::string &child : children) {
+            int child_fd = ::openat(dirfd(dir), child.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (child_fd < 0)
+                continue;
+            const size_t length = path.size();
+            if (!path.empty())
+                path += '/';
+            path += child;
+            scanDirectory(child_fd, path, depth + 1);
+            path.resize(length);
+        }
+    }
+    closedir(dir);
+}
+
+bool CgroupTable::readCounters(Group &group, double elapsed_seconds) {
+    unsigned long long usage = group.usage_usec;
+    unsigned long long throttled = group.throttled_usec;
+
+    // A removed group's files fail with ENODEV, the descriptors stay bound to it
+    if (group.cpu_stat.isOpen()) {
+        long read_size = group.cpu_stat.readInto(buffer, BUFFER_SIZE);
+        if (read_size < 0)
+            return false;
+        findKey(buffer, buffer + read_size, "usage_usec", usage);
+        findKey(buffer, buffer + read_size, "throttled_usec", throttled);
+    }
+    if (group.memory_current.isOpen()) {
+        long read_size = group.memory_current.readInto(buffer, BUFFER_SIZE);
+        if (read_size < 0)
+            return false;
+        unsigned long long memory = 0;
+        ProcFile::parseUnsigned(buffer, buffer + read_size, memory);
+        group.info.memory_bytes = memory;
+    }
+
+    const double interval_usec = elapsed_seconds * MICROSEC_PER_SEC;
+    group.info.cpu_use = 0.0f;
+    group.info.cpu_throttled = 0.0f;
+    if (group.has_previous && interval_usec > 0.0) {
+        if (usage > group.usage_usec)
+            group.info.cpu_use = static_cast<float>((usage - group.usage_usec) / interval_usec);
+        if (throttled > group.throttled_usec)
+            group.info.cpu_throttled = static_cast<float>(std::min(1.0, (throttled - group.throttled_usec) / interval_usec));
+    }
+    group.usage_usec = usage;
+    group.throttled_usec = throttled;
+    group.has_previous = true;
+    return true;
+}
+
+void CgroupTable::readDetails(Group &group, double elapsed_seconds) {
+    if (!group.details_open) {
+        group.details_open = true;
+        group.cpu_max.openAt(root_fd, controlPath(group.path, "cpu.max").c_str());
+        group.memory_max.openAt(root_fd, controlPath(group.path, "memory.max").c_str());
+        group.memory_stat.openAt(root_fd, controlPath(group.path, "memory.stat").c_str());
+        group.io_stat.openAt(root_fd, controlPath(group.path, "io.stat").c_str());
+    }
+    CgroupInfo &info = group.info;
+
+    // "<quota> <period>" in microseconds, the quota is "max" without a limit
+    info.cpu_limit = 0.0f;
+    long read_size = group.cpu_max.isOpen() ? group.cpu_max.readInto(buffer, BUFFER_SIZE) : -1;
+    if (read_size > 0) {
+        const char *end = buffer + read_size;
+        const unsigned long long quota = parseLimit(buffer, end);
+        unsigned long long period = 0;
+        ProcFile::parseUnsigned(ProcFile::skipFields(buffer, end, 1), end, period);
+        if (quota > 0 && period > 0)
+            info.cpu_limit = static_cast<float>(static_cast<double>(quota) / period);
+    }
+
+    info.memory_max = 0;
+    read_size = group.memory_max.isOpen() ? group.memory_max.readInto(buffer, BUFFER_SIZE) : -1;
+    if (read_size > 0)
+        info.memory_max = parseLimit(buffer, buffer + read_size);
+
+    info.anon_bytes = 0;
+    info.file_bytes = 0;
+    read_size = group.memory_stat.isOpen() ? group.memory_stat.readInto(buffer, BUFFER_SIZE) : -1;
+    if (read_size > 0) {
+        unsigned long long anon = 0;
+        unsigned long long file = 0;
+        findKey(buffer, buffer + read_size, "anon", anon);
+        findKey(buffer, buffer + read_size, "file", file);
+        info.anon_bytes = anon;
+        info.file_bytes = file;
+    }
+
+    // One "<major>:<minor> rbytes=<n> wbytes=<n> rios=<n> ..." line per device
+    info.io_read_rate = 0.0;
+    info.io_write_rate = 0.0;
+    read_size = group.io_stat.isOpen() ? group.io_stat.readInto(buffer, BUFFER_SIZE) : -1;
+    if (read_size >= 0) {
+        unsigned long long io_read = 0;
+        unsigned long long io_write = 0;
+        const char *end = buffer + read_size;
+        for (const char *cur = buffer; cur < end; cur = ProcFile::nextLine(cur, end)) {
+            const char *line_end = static_cast<const char*>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+            if (line_end == nullptr)
+                line_end = end;
+            for (const char *field = ProcFile::skipFields(cur, line_end, 1); field < line_end;
+                 field = ProcFile::skipFields(field, line_end, 1)) {
+                field = ProcFile::skipBlanks(field, line_end);
+                unsigned long long value = 0;
+                if (startsWith(field, line_end, "rbytes=", 7)) {
+                    ProcFile::parseUnsigned(field + 7, line_end, value);
+                    io_read += value;
+                } else if (startsWith(field, line_end, "wbytes=", 7)) {
+                    ProcFile::parseUnsigned(field + 7, line_end, value);
+                    io_write += value;
+                }
+            }
+        }
+
+        if (group.io_read_at != 0 && group.io_read_at + 1 == refreshes && elapsed_seconds > 0.0) {
+            info.io_read_rate = io_read > group.io_read ? (io_read - group.io_read) / elapsed_seconds : 0.0;
+            info.io_write_rate = io_write > group.io_write ? (io_write - group.io_write) / elapsed_seconds : 0.0;
+        }
+        group.io_read = io_read;
+        group.io_write = io_write;
+        group.io_read_at = refreshes;
+    }
+}
+
+void CgroupTable::report(Group &group, double elapsed_seconds) {
+    if (group.reported_at == refreshes)
+        return;
+    group.reported_at = refreshes;
+    readDetails(group, elapsed_seconds);
+    group.info.selected = group.selection >= 0;
+    last_reported.push_back(group.info);
+}
+
+bool CgroupTable::refresh(double elapsed_seconds) {
+    last_reported.clear();
+    top_cpu.clear();
+    top_memory.clear();
+    std::fill(selected_groups.begin(), selected_groups.end(), nullptr);
+    if (root_fd < 0)
+        return false;
+
+    refreshes++;
+    since_scan_seconds += elapsed_seconds;
+    if (scan_needed || since_scan_seconds >= RESCAN_INTERVAL_SECONDS)
+        scan();
+
+    // Min-heaps, the front is the smallest of the N kept
+    const auto moreCpu = [](const Group *a, const Group *b) {
+        return a->info.cpu_use != b->info.cpu_use ? a->info.cpu_use > b->info.cpu_use : a->path < b->path;
+    };
+    const auto moreMemory = [](const Group *a, const Group *b) {
+        return a->info.memory_bytes != b->info.memory_bytes ?
+            a->info.memory_bytes > b->info.memory_bytes : a->path < b->path;
+    };
+    const auto pushBounded = [this](std::vector<Group*> &heap, Group *group, const auto &more) {
+        if (top_n == 0)
+            return;
+        if (heap.size() < top_n) {
+            heap.push_back(group);
+            std::push_heap(heap.begin(), heap.end(), more);
+        } else if (more(group, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), more);
+            heap.back() = group;
+            std::push_heap(heap.begin(), heap.end(), more);
+        }
+    };
+
+    groups.forEach([&](const uint64_t&, Group &group) {
+        if (!readCounters(group, elapsed_seconds)) {
+            scan_needed = true;
+            return;
+        }
+        if (group.selection >= 0) {
+            selected_groups[static_cast<size_t>(group.selection)] = &group;
+        } else if (group.leaf) {
+            pushBounded(top_cpu, &group, moreCpu);
+            pushBounded(top_memory, &group, moreMemory);
+        }
+    });
+
+    std::sort_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+    std::sort_heap(top_memory.begin(), top_memory.end(), moreMemory);
+
+    for (Group *group : selected_groups) {
+        if (group != nullptr)
+            report(*group, elapsed_seconds);
+    }
+    for (Group *group : top_cpu)
+        report(*group, elapsed_seconds);
+    for (Group *group : top_memory)
+        report(*group, elapsed_seconds);
+    return true;
+}
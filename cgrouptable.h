@@ -0,0 +1,202 @@
+#ifndef CGROUPTABLE_H
+#define CGROUPTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flathashmap.h"
+#include "procfile.h"
+
+/** Usage of one cgroup over the last interval. Plain data so it can be published through a `SeqLock`. */
+struct CgroupInfo {
+    /** systemd and container runtimes nest scopes a few levels deep with 64 character ids, this fits them. */
+    static constexpr size_t PATH_SIZE = 256;
+
+    /** Null-terminated path below the hierarchy root, "/" for the root itself. Truncated if longer. */
+    char path[PATH_SIZE];
+
+    /** Reported because it was asked for by `CgroupTable::select`, rather than for ranking in a top list. */
+    bool selected;
+
+    /** CPU time over the last interval as a fraction of one core, from `usage_usec` in `cpu.stat`. */
+    float cpu_use;
+
+    /** Cores `cpu.max` allows, 0 if unlimited. */
+    float cpu_limit;
+
+    /** Share of the last interval the group was held back by `cpu.max`, from `throttled_usec`. */
+    float cpu_throttled;
+
+    /** `memory.current` in bytes, 0 where the memory controller is not enabled. */
+    uint64_t memory_bytes;
+
+    /** `memory.max` in bytes, 0 if unlimited. */
+    uint64_t memory_max;
+
+    /** Anonymous and page cache bytes from `memory.stat`. */
+    uint64_t anon_bytes;
+    uint64_t file_bytes;
+
+    /** Bytes per second read and written over the last interval, every device in `io.stat` summed up. */
+    double io_read_rate;
+    double io_write_rate;
+};
+
+/**
+ * Usage of cgroup v2 groups, for workloads made of many processes like containers and services.
+ * The hierarchy is walked once and then every `RESCAN_INTERVAL_SECONDS`, or sooner when a group disappears. Every
+ * leaf group is ranked on every `refresh` by the growth of `usage_usec` and by `memory.current`; the top N of each and
+ * the groups passed to `select` are reported, with `cpu.max`, `memory.max`, `memory.stat` and `io.stat` read for those
+ * only. Control files are opened once per group and re-read with `pread`. Groups are identified by the inode of their
+ * directory, so a group recreated under the same path starts from a fresh baseline.
+ *
+ * Linux only: the root is a parameter so tests and benchmarks can point it at a fixture tree. A root without
+ * `cgroup.controllers` but with a `unified` directory that has one is a hybrid v1/v2 setup, the latter is used then.
+ */
+class CgroupTable {
+
+    struct Group {
+        /** Path below the root without a leading slash, empty for the root. */
+        std::string path;
+
+        /** `cpu.stat` and `memory.current`, read on every refresh. */
+        ProcFile cpu_stat;
+        ProcFile memory_current;
+
+        /** `cpu.max`, `memory.max`, `memory.stat` and `io.stat`, opened the first time the group is reported. */
+        ProcFile cpu_max;
+        ProcFile memory_max;
+        ProcFile memory_stat;
+        ProcFile io_stat;
+        bool details_open = false;
+
+        /** Has no child groups. Only leaves are ranked, a parent's usage includes that of its children. */
+        bool leaf = false;
+
+        /** Index into the selection, -1 if not selected. */
+        int selection = -1;
+
+        /** Counters of the last refresh, and whether the refresh before read them as well. */
+        unsigned long long usage_usec = 0;
+        unsigned long long throttled_usec = 0;
+        bool has_previous = false;
+
+        /** Refresh that last reported the group, so the top lists don't report it twice. */
+        uint64_t reported_at = 0;
+
+        /** I/O byte counters and the refresh that last read them, rates need the one right before. */
+        unsigned long long io_read = 0;
+        unsigned long long io_write = 0;
+        uint64_t io_read_at = 0;
+
+        /** Usage of the last refresh. */
+        CgroupInfo info {};
+    };
+
+    /** `memory.stat` of a busy group is about 1.5 KiB, `io.stat` a line per device. */
+    static constexpr size_t BUFFER_SIZE = 8192;
+
+    /** Directory descriptor of the hierarchy root, -1 if it could not be opened. */
+    int root_fd;
+
+    size_t top_n;
+
+    /** Paths passed to `select`, without leading or trailing slashes. */
+    std::vector<std::string> selection;
+
+    /** Followed groups by directory inode: every leaf and every selected group of the last scan. */
+    FlatHashMap<uint64_t, Group> groups;
+
+    /** Groups of the scan in progress, swapped with `groups` when it is done. */
+    FlatHashMap<uint64_t, Group> scanned;
+
+    /** Directories seen by the last scan, leaves or not. */
+    size_t group_count;
+
+    double since_scan_seconds;
+    bool scan_needed;
+    uint64_t scans;
+    uint64_t refreshes;
+
+    std::vector<CgroupInfo> last_reported;
+
+    /** Min-heaps of the N largest leaves during a refresh. */
+    std::vector<Group*> top_cpu;
+    std::vector<Group*> top_memory;
+
+    /** Selected groups that could be read during a refresh, by selection index. */
+    std::vector<Group*> selected_groups;
+
+    char buffer[BUFFER_SIZE];
+
+    /** Rebuild `groups` from the hierarchy, keeping the descriptors and counters of groups seen before. */
+    void scan();
+
+    /** Walk the directory `dir_fd` at `path`, then close it. */
+    void scanDirectory(int dir_fd, std::string &path, unsigned depth);
+
+    /** Re-read the counters of `group`. @return false if the group is gone. */
+    bool readCounters(Group &group, double elapsed_seconds);
+
+    /** Read the limits, memory breakdown and I/O of `group` into its `info`. */
+    void readDetails(Group &group, double elapsed_seconds);
+
+    /** Append `group` to `last_reported` unless it is there already. */
+    void report(Group &group, double elapsed_seconds);
+
+public:
+    static constexpr size_t DEFAULT_TOP_N = 5;
+
+    /** Selected groups past this are ignored. */
+    static constexpr size_t MAX_SELECTED = 8;
+
+    /** Walk the hierarchy for new groups at least this often. */
+    static constexpr double RESCAN_INTERVAL_SECONDS = 5.0;
+
+    /** Directories nested deeper than this below the root are not walked. */
+    static constexpr unsigned MAX_DEPTH = 8;
+
+    /** Groups followed at most, two descriptors each. Leaves past this are not ranked. */
+    static constexpr size_t MAX_GROUPS = 1024;
+
+    explicit CgroupTable(const char *root = "/sys/fs/cgroup", size_t top_n = DEFAULT_TOP_N);
+    ~CgroupTable();
+
+    CgroupTable(const CgroupTable&) = delete;
+    CgroupTable& operator=(const CgroupTable&) = delete;
+
+    /** Whether the hierarchy root could be opened. */
+    bool isOpen() const;
+
+    /**
+     * Report the groups at `paths` below the root on every refresh from the next one, ahead of the top lists and
+     * whether they are leaves or not. Only the first `MAX_SELECTED` are used, paths that do not exist are skipped.
+     */
+    void select(const std::vector<std::string> &paths);
+
+    /**
+     * Re-read every followed group and rank the leaves.
+     * @param elapsed_seconds Time since the previous refresh, rates are 0 when this is 0.
+     * @return false if the root could not be opened.
+     */
+    bool refresh(double elapsed_seconds);
+
+    /**
+     * Selected groups in selection order, then the N busiest leaves by CPU, then the N largest by memory that are
+     * not in the list already.
+     */
+    const std::vector<CgroupInfo>& reported() const;
+
+    /** Groups in the hierarchy as of the last scan. */
+    size_t groupCount() const;
+
+    /** Number of hierarchy walks so far, for tests and benchmarks. */
+    uint64_t scanCount() const;
+
+    /** Parse a `memory.max` or `cpu.max` quota field, "max" is returned as 0. */
+    static unsigned long long parseLimit(const char *cur, const char *end);
+};
+
+#endif // CGROUPTABLE_H
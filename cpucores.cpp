@@ -0,0 +1,207 @@
+#include "cpucores.h"
+
+#include <cstring>
+#include <utility>
+
+#include "procfile.h"
+
+void CpuCoreStats::Counters::resize(size_t cores) {
+    user.resize(cores, 0);
+    system.resize(cores, 0);
+    idle.resize(cores, 0);
+    iowait.resize(cores, 0);
+    steal.resize(cores, 0);
+}
+
+CpuCoreStats::CpuCoreStats():
+    core_count{0},
+    aggregate_busy{0},
+    aggregate_total{0},
+    has_previous{false},
+    max_busy{0.0f},
+    max_busy_core{0}
+{
+}
+
+void CpuCoreStats::resize(size_t cores) {
+    current.resize(cores);
+    previous.resize(cores);
+    user_ratio.resize(cores, 0.0f);
+    system_ratio.resize(cores, 0.0f);
+    idle_ratio.resize(cores, 0.0f);
+    iowait_ratio.resize(cores, 0.0f);
+    busy_ratio.resize(cores, 0.0f);
+    present.resize(cores, 0);
+    core_count = cores;
+    // New cores have no baseline yet
+    has_previous = false;
+}
+
+bool CpuCoreStats::parse(const char *text, size_t length) {
+    const char *cur = text;
+    const char *end = text + length;
+
+    if (length < 4 || std::strncmp(cur, "cpu ", 4) != 0)
+        return false;
+
+    // "cpu  user nice system idle iowait irq softirq steal guest guest_nice"
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    cur = ProcFile::parseUnsigned(cur + 3, end, user);
+    cur = ProcFile::parseUnsigned(cur, end, nice);
+    cur = ProcFile::parseUnsigned(cur, end, system);
+    cur = ProcFile::parseUnsigned(cur, end, idle);
+    cur = ProcFile::parseUnsigned(cur, end, iowait);
+    cur = ProcFile::parseUnsigned(cur, end, irq);
+    cur = ProcFile::parseUnsigned(cur, end, softirq);
+    cur = ProcFile::parseUnsigned(cur, end, steal);
+    aggregate_busy = user + nice + system + irq + softirq + steal;
+    aggregate_total = aggregate_busy + idle + iowait;
+    cur = ProcFile::nextLine(cur, end);
+
+    if (!present.empty())
+        std::memset(present.data(), 0, present.size());
+
+    while (end - cur > 3 && cur[0] == 'c' && cur[1] == 'p' && cur[2] == 'u') {
+        unsigned long long core;
+        cur = ProcFile::parseUnsigned(cur + 3, end, core);
+        if (core >= core_count)
+            resize(static_cast<size_t>(core) + 1);
+
+        cur = ProcFile::parseUnsigned(cur, end, user);
+        cur = ProcFile::parseUnsigned(cur, end, nice);
+        cur = ProcFile::parseUnsigned(cur, end, system);
+        cur = ProcFile::parseUnsigned(cur, end, idle);
+        cur = ProcFile::parseUnsigned(cur, end, iowait);
+        cur = ProcFile::parseUnsigned(cur, end, irq);
+        cur = ProcFile::parseUnsigned(cur, end, softirq);
+        cur = ProcFile::parseUnsigned(cur, end, steal);
+
+        // Truncation to 32 bits is intentional, see the class comment
+        current.user[core] = static_cast<uint32_t>(user + nice);
+        current.system[core] = static_cast<uint32_t>(system + irq + softirq);
+        current.idle[core] = static_cast<uint32_t>(idle);
+        current.iowait[core] = static_cast<uint32_t>(iowait);
+        current.steal[core] = static_cast<uint32_t>(steal);
+        present[core] = 1;
+
+        cur = ProcFile::nextLine(cur, end);
+    }
+
+    // Offline cores keep their last counters, which gives them a zero delta
+    for (size_t i = 0; i < core_count; i++) {
+        if (!present[i]) {
+            current.user[i] = previous.user[i];
+            current.system[i] = previous.system[i];
+            current.idle[i] = previous.idle[i];
+            current.iowait[i] = previous.iowait[i];
+            current.steal[i] = previous.steal[i];
+        }
+    }
+
+    if (has_previous)
+        computeRatios();
+
+    // `previous` becomes the baseline for the next parse, the stale columns get overwritten then
+    std::swap(current, previous);
+    has_previous = true;
+    return true;
+}
+
+void CpuCoreStats::computeRatios() {
+    const size_t n = core_count;
+
+    const uint32_t *__restrict cur_user = current.user.data();
+    const uint32_t *__restrict cur_system = current.system.data();
+    const uint32_t *__restrict cur_idle = current.idle.data();
+    const uint32_t *__restrict cur_iowait = current.iowait.data();
+    const uint32_t *__restrict cur_steal = current.steal.data();
+    const uint32_t *__restrict prev_user = previous.user.data();
+    const uint32_t *__restrict prev_system = previous.system.data();
+    const uint32_t *__restrict prev_idle = previous.idle.data();
+    const uint32_t *__restrict prev_iowait = previous.iowait.data();
+    const uint32_t *__restrict prev_steal = previous.steal.data();
+
+    float *__restrict out_user = user_ratio.data();
+    float *__restrict out_system = system_ratio.data();
+    float *__restrict out_idle = idle_ratio.data();
+    float *__restrict out_iowait = iowait_ratio.data();
+    float *__restrict out_busy = busy_ratio.data();
+
+    // Kept free of branches and calls so it vectorizes: wrapping uint32 deltas, clamping in integers (a float compare
+    // would be a possible trap and block if-conversion), then int32 -> float. Deltas are whole ticks, so the clamp
+    // only matters when every delta is 0 and just keeps 0/0 out.
+    for (size_t i = 0; i < n; i++) {
+        int32_t d_user = static_cast<int32_t>(cur_user[i] - prev_user[i]);
+        int32_t d_system = static_cast<int32_t>(cur_system[i] - prev_system[i]);
+        int32_t d_idle = static_cast<int32_t>(cur_idle[i] - prev_idle[i]);
+        int32_t d_iowait = static_cast<int32_t>(cur_iowait[i] - prev_iowait[i]);
+        int32_t d_steal = static_cast<int32_t>(cur_steal[i] - prev_steal[i]);
+
+        int32_t total = d_user + d_system + d_idle + d_iowait + d_steal;
+        float inverse = 1.0f / static_cast<float>(total > 1 ? total : 1);
+
+        out_user[i] = static_cast<float>(d_user) * inverse;
+        out_system[i] = static_cast<float>(d_system) * inverse;
+        out_idle[i] = static_cast<float>(d_idle) * inverse;
+        out_iowait[i] = static_cast<float>(d_iowait) * inverse;
+        out_busy[i] = static_cast<float>(d_user + d_system + d_steal) * inverse;
+    }
+
+    float best = 0.0f;
+    size_t best_core = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (out_busy[i] > best) {
+            best = out_busy[i];
+            best_core = i;
+        }
+    }
+    max_busy = best;
+    max_busy_core = best_core;
+}
+
+size_t CpuCoreStats::coreCount() const {
+    return core_count;
+}
+
+const float* CpuCoreStats::user() const {
+    return user_ratio.data();
+}
+
+const float* CpuCoreStats::system() const {
+    return system_ratio.data();
+}
+
+const float* CpuCoreStats::idle() const {
+    return idle_ratio.data();
+}
+
+const float* CpuCoreStats::iowait() const {
+    return iowait_ratio.data();
+}
+
+const float* CpuCoreStats::busy() const {
+    return busy_ratio.data();
+}
+
+float CpuCoreStats::maxBusy() const {
+    return max_busy;
+}
+
+size_t CpuCoreStats::maxBusyCore() const {
+    return max_busy_core;
+}
+
+size_t CpuCoreStats::coresAbove(float threshold) const {
+    size_t count = 0;
+    for (size_t i = 0; i < core_count; i++)
+        count += busy_ratio[i] >= threshold ? 1 : 0;
+    return count;
+}
+
+unsigned long long CpuCoreStats::aggregateBusyTicks() const {
+    return aggregate_busy;
+}
+
+unsigned long long CpuCoreStats::aggregateTotalTicks() const {
+    return aggregate_total;
+}
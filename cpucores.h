@@ -0,0 +1,94 @@
+#ifndef CPUCORES_H
+#define CPUCORES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Per-logical-core utilization from the `cpu` block of `/proc/stat`.
+ * Counters are kept as structure-of-arrays columns so the per-tick deltas and ratios for every core are one
+ * branch-free pass the compiler turns into SIMD. Columns hold the low 32 bits of each tick counter: unsigned
+ * subtraction stays exact across wrap-around as long as a single delta fits, which at USER_HZ takes over a year.
+ *
+ * The parser works on a caller-supplied buffer, so it can be fed synthetic text in tests and benchmarks.
+ */
+class CpuCoreStats {
+
+    /** One column per counter group, indexed by core number. */
+    struct Counters {
+        std::vector<uint32_t> user;     // user + nice, guest time is already part of user
+        std::vector<uint32_t> system;   // system + irq + softirq
+        std::vector<uint32_t> idle;
+        std::vector<uint32_t> iowait;
+        std::vector<uint32_t> steal;
+
+        void resize(size_t cores);
+    };
+
+    Counters current;
+    Counters previous;
+
+    /** Per-core ratios of the last interval, `[0, 1]`. */
+    std::vector<float> user_ratio;
+    std::vector<float> system_ratio;
+    std::vector<float> idle_ratio;
+    std::vector<float> iowait_ratio;
+    std::vector<float> busy_ratio;
+
+    /** Whether each core had a line in the last parse. Offline cores are missing and read as 0. */
+    std::vector<uint8_t> present;
+
+    size_t core_count;
+
+    /** Aggregate `cpu` line, full 64-bit ticks. */
+    unsigned long long aggregate_busy;
+    unsigned long long aggregate_total;
+
+    /** False until two parses have been made. */
+    bool has_previous;
+
+    float max_busy;
+    size_t max_busy_core;
+
+    void resize(size_t cores);
+
+    /** The SIMD pass: deltas of `current` against `previous` into the ratio columns. */
+    void computeRatios();
+
+public:
+    CpuCoreStats();
+
+    /**
+     * Parse the `cpu` lines of `/proc/stat` into the current counters and compute the deltas against the previous
+     * parse. Stops at the first line that does not start with "cpu". Only allocates when the core count grows.
+     * @return false if the text did not start with the aggregate "cpu" line.
+     */
+    bool parse(const char *text, size_t length);
+
+    /** Highest logical core number seen plus one. */
+    size_t coreCount() const;
+
+    const float* user() const;
+    const float* system() const;
+    const float* idle() const;
+    const float* iowait() const;
+
+    /** Everything but idle and iowait. */
+    const float* busy() const;
+
+    /** Busiest core of the last interval. */
+    float maxBusy() const;
+    size_t maxBusyCore() const;
+
+    /** Number of cores whose busy ratio is at or above `threshold`. */
+    size_t coresAbove(float threshold) const;
+
+    /** Busy ticks of the aggregate line, same meaning as `ProcData::getTotalCpuTime`. */
+    unsigned long long aggregateBusyTicks() const;
+
+    /** All ticks of the aggregate line. */
+    unsigned long long aggregateTotalTicks() const;
+};
+
+#endif // CPUCORES_H
@@ -0,0 +1,158 @@
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <getopt.h>
+#include <pthread.h>
+
+#include "framering.h"
+#include "metricsampler.h"
+#include "samplesource.h"
+#include "scheduler.h"
+
+/*
+ * hw_overlayd: the sampling core of the overlay without any UI. Samples this machine on the scheduler's grid and
+ * publishes every frame into a shared-memory ring (see framering.h) for local readers such as hw_overlay_tail.
+ */
+
+namespace {
+
+constexpr const char *DEFAULT_RING = "/hw_overlay";
+constexpr long DEFAULT_INTERVAL_MS = 250;
+constexpr float DEFAULT_CORE_THRESHOLD = 0.9f;
+
+struct Options {
+    std::string ring = DEFAULT_RING;
+    long interval_ms = DEFAULT_INTERVAL_MS;
+    unsigned long slots = FrameRingWriter::DEFAULT_CAPACITY;
+    float core_threshold = DEFAULT_CORE_THRESHOLD;
+
+    /** Foreground process, 0 for the daemon itself. */
+    long pid = 0;
+};
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n, --name NAME          Shared-memory ring to publish to (default %s)\n"
+        "  -i, --interval-ms MS     Sampling interval (default %ld)\n"
+        "  -s, --slots COUNT        Frames the ring holds (default %u)\n"
+        "  -t, --core-threshold R   Busy ratio a core counts as loaded from (default %.2f)\n"
+        "  -p, --pid PID            Process to report as the foreground (default the daemon itself)\n"
+        "  -h, --help               Show this help\n",
+        program, DEFAULT_RING, DEFAULT_INTERVAL_MS, FrameRingWriter::DEFAULT_CAPACITY, DEFAULT_CORE_THRESHOLD);
+}
+
+/** @return false if the arguments are invalid or help was asked for. */
+bool parseOptions(int argc, char *argv[], Options &options) {
+    static const option long_options[] = {
+        {"name", required_argument, nullptr, 'n'},
+        {"interval-ms", required_argument, nullptr, 'i'},
+        {"slots", required_argument, nullptr, 's'},
+        {"core-threshold", required_argument, nullptr, 't'},
+        {"pid", required_argument, nullptr, 'p'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "n:i:s:t:p:h", long_options, nullptr)) != -1) {
+        char *end = nullptr;
+        switch (option) {
+        case 'n':
+            options.ring = optarg;
+            break;
+        case 'i':
+            options.interval_ms = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || options.interval_ms <= 0)
+                return false;
+            break;
+        case 's':
+            options.slots = std::strtoul(optarg, &end, 10);
+            if (*end != '\0' || options.slots == 0 || options.slots > UINT32_MAX)
+                return false;
+            break;
+        case 't':
+            options.core_threshold = std::strtof(optarg, &end);
+            if (*end != '\0' || options.core_threshold < 0.0f || options.core_threshold > 1.0f)
+                return false;
+            break;
+        case 'p':
+            options.pid = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || options.pid <= 0 || options.pid > INT32_MAX)
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    // A POSIX shared-memory name is one leading slash and no other
+    if (options.ring.empty() || options.ring.find('/', 1) != std::string::npos)
+        return false;
+    if (options.ring[0] != '/')
+        options.ring.insert(0, 1, '/');
+    return optind == argc;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // Block the shutdown signals before any thread starts so only the waiter below receives them
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    sigaddset(&shutdown_signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &shutdown_signals, nullptr);
+
+    FrameRingWriter ring;
+    if (!ring.open(options.ring, static_cast<uint32_t>(options.slots))) {
+        std::fprintf(stderr, "Could not create %s: %s\n", options.ring.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    LiveSampleSource source;
+    source.setTargetProcess(static_cast<int>(options.pid));
+    MetricSampler sampler(&source, MetricSampler::machineCores());
+    SampleScheduler scheduler{std::chrono::milliseconds(options.interval_ms)};
+    scheduler.setEventHandler(source.eventDescriptor(), [&source]() {
+        source.handleEvents();
+    });
+
+    std::thread signal_waiter([&scheduler, &shutdown_signals]() {
+        int signal_number = 0;
+        sigwait(&shutdown_signals, &signal_number);
+        scheduler.stop();
+    });
+
+    std::fprintf(stderr, "Publishing to %s every %lld ms, %lu frames\n", options.ring.c_str(),
+                 static_cast<long long>(scheduler.interval().count()), options.slots);
+
+    MetricFrame frame;
+    while (scheduler.wait()) {
+        if (!sampler.sample())
+            break;
+        sampler.derive(frame, options.core_threshold, scheduler.missedDeadlines());
+        ring.publish(frame);
+    }
+
+    // The loop also ends when the source fails to sample, the waiter is still blocked in sigwait then
+    if (!scheduler.stopped())
+        pthread_kill(signal_waiter.native_handle(), SIGTERM);
+    signal_waiter.join();
+    ring.close();
+    return 0;
+}
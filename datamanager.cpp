@@ -1,134 +1,1172 @@
 #include "datamanager.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include <QVariantMap>
+
+#include "replaysource.h"
 
 const QString DataManager::PERCENT_POSTFIX = QString::fromUtf8(" %");
 
-DataManager::DataManager(QObject *parent):
+DataManager::DataManager(QObject *parent, std::unique_ptr<SampleSource> replay):
     QObject{parent},
-    data_source{}
+    live_source{},
+    replay_source{std::move(replay)},
+    sampler{replay_source ? replay_source.get() : &live_source, MetricSampler::machineCores()},
+    scheduler{std::chrono::milliseconds(DEFAULT_INTERVAL_MS)},
+    fixed_interval_ms{DEFAULT_INTERVAL_MS},
+    adaptive_sampling{false},
+    core_threshold{DEFAULT_CORE_THRESHOLD},
+    io_peak{HISTORY_WINDOW_MS}
 {
-    m_interval = DEFAULT_INTERVAL_MS;
-    m_cpus = hwinfo::getAllCPUs();
-    m_MemTotal = hwinfo::Memory().total_Bytes();
+    source_pending = false;
+    source_name = QString::fromStdString(sampler.currentSource()->name());
+    name_stale = false;
+    pending_generation = 0;
+    watches_pending = false;
+    target_pid = 0;
+    pending_target_pid = TARGET_UNCHANGED;
+    active_generation = 0;
+    watch_generation = 0;
+    cgroups_pending = false;
+
+    // Tracked processes exit between ticks, the live source drops their state then. A replay paced in real time
+    // waits on the scheduler too, one played as fast as possible leaves the exits queued until live sampling resumes
+    scheduler.setEventHandler(live_source.eventDescriptor(), [this]() {
+        live_source.handleEvents();
+    });
+    if (replay_source)
+        replay_source->setScheduler(&scheduler);
 
-    last_cpu_measurement = -1;
-    last_proc_measurement = -1;
-    calculated_use = 0.0;
-    calculated_proc_use = 0.0;
+    last_missed_deadlines = 0;
+    recorded_tick = 0;
+    m_SampleTimeMs = 0.0;
+    last_self_usage = SelfUsage{};
+    has_self_usage = false;
+    // The first tick scans, so the tables are filled from the start
+    scan_elapsed_ms = SCAN_INTERVAL_MS;
+    adapting = false;
 
-    core_time_interval = m_interval *
-        MILI_TO_MICROSEC *
-        m_cpus[0].numLogicalCores();
+    // One spare slot for the sample kept past the left edge of the window
+    history_capacity = HISTORY_WINDOW_MS / DEFAULT_INTERVAL_MS + 2;
+    mem_used_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    mem_proc_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    mem_proc_rss_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    mem_proc_uss_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    mem_proc_swap_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    cpu_used_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    cpu_proc_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    gpu_proc_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    io_read_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    io_write_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    disk_io_history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
+    for (auto &history : watch_histories)
+        history = new HistorySeries(history_capacity, HISTORY_WINDOW_MS, this);
 
+    frame_pending = false;
+    coalesced_frames = 0;
+    metrics_enabled = false;
+
+    // Every graphed metric is a percentage
+    rolling_stats.reserve(StatsFrame::METRICS);
+    for (unsigned i = 0; i < StatsFrame::METRICS; i++)
+        rolling_stats.emplace_back(std::initializer_list<double>{
+            STATS_WINDOWS_MS[0], STATS_WINDOWS_MS[1], STATS_WINDOWS_MS[2]}, 0.0, 100.0);
 
     update();
-    update_thread = std::thread(&DataManager::updateLoop, this);
+    update_thread = QThread::create(&DataManager::updateLoop, this);
+    update_thread->setObjectName(QStringLiteral("sampler"));
+    update_thread->start();
 }
 
+DataManager::DataManager(QObject *parent): DataManager(parent, nullptr) {}
+
 DataManager::DataManager(): DataManager(nullptr) {}
 
-void DataManager::update() {
+bool DataManager::update() {
+    const auto tick_start = std::chrono::steady_clock::now();
+    auto phase_start = tick_start;
 
-    const hwinfo::Memory mem;
-    m_MemUsed = m_MemTotal - mem.available_Bytes();
-    m_MemProc = data_source.getFgProcessMemory();
+    // One pass over the source, everything below works on the gathered frame
+    if (!sampler.sample())
+        return false;
+    recordPhase(UpdatePhase::Sample, phase_start);
+
+    MetricFrame frame {};
+    sampler.derive(frame, core_threshold.load(std::memory_order_relaxed), scheduler.missedDeadlines());
+    published_cores.store(sampler.coreFrame());
+    const double elapsed_ms = frame.elapsed_ms;
+    recordPhase(UpdatePhase::Cpu, phase_start);
 
-    sampleCpuTimes();
     sampleProcHandle();
-    
-    emit notifyMemUsedKb();
-    emit notifyMemProcKb();
-    emit notifyCpuTotal();
-    emit notifyCpuProcUse();
+    // Before the watches, they carry the I/O of their processes as of this tick
+    publishIo(frame);
+    publishWatches(frame.tick, elapsed_ms);
+    recordPhase(UpdatePhase::Foreground, phase_start);
+
+    // Rates over the whole span since the last scan, the published tables stay as they are in between
+    scan_elapsed_ms += elapsed_ms;
+    if (scan_elapsed_ms >= SCAN_INTERVAL_MS) {
+        publishProcesses(frame.tick, scan_elapsed_ms);
+        publishCgroups(frame.tick, scan_elapsed_ms);
+        publishThreads(frame.tick, scan_elapsed_ms);
+        scan_elapsed_ms = 0.0;
+        recordPhase(UpdatePhase::Processes, phase_start);
+    }
+
+    publishStats(frame);
+    published_frame.store(frame);
+    recordTelemetry(frame);
+    if (metrics_enabled.load(std::memory_order_relaxed))
+        renderMetrics(frame);
+    recordPhase(UpdatePhase::Publish, phase_start);
+
+    // One queued delivery at a time, a frame published while it waits is picked up by it instead of queueing another
+    if (frame_pending.exchange(true, std::memory_order_acq_rel))
+        coalesced_frames.fetch_add(1, std::memory_order_relaxed);
+    else
+        QMetaObject::invokeMethod(this, &DataManager::deliverFrame, Qt::QueuedConnection);
+    recordPhase(UpdatePhase::Signals, phase_start);
+
+    if (!sampler.currentSource()->selfPaced())
+        adaptInterval(frame);
+
+    phase_latency[static_cast<unsigned>(UpdatePhase::Tick)].record(
+        static_cast<uint64_t>(std::chrono::nanoseconds(phase_start - tick_start).count()));
+    updateSelfUsage(frame.tick);
+    return true;
+}
+
+void DataManager::adaptInterval(const MetricFrame &frame) {
+    std::chrono::milliseconds interval;
+    if (adaptive_sampling.load(std::memory_order_relaxed)) {
+        const RateSignal signal {
+            frame.cpu_use,
+            frame.cpu_proc_use * frame.cpu_use,
+            frame.gpu_proc_use,
+            memUsedPercent(frame) / 100.0,
+            frame.core_max_use,
+        };
+        interval = adaptive_rate.next(signal, frame.elapsed_ms, core_threshold.load(std::memory_order_relaxed));
+        adapting = true;
+    } else if (adapting) {
+        interval = std::chrono::milliseconds(fixed_interval_ms.load(std::memory_order_relaxed));
+        adapting = false;
+    } else {
+        return;
+    }
+
+    // Restarts the grid, only worth a syscall when the interval actually moves
+    if (interval != scheduler.interval())
+        scheduler.setInterval(interval);
+}
+
+void DataManager::recordPhase(UpdatePhase phase, std::chrono::steady_clock::time_point &phase_start) {
+    const auto now = std::chrono::steady_clock::now();
+    phase_latency[static_cast<unsigned>(phase)].record(
+        static_cast<uint64_t>(std::chrono::nanoseconds(now - phase_start).count()));
+    phase_start = now;
+}
+
+void DataManager::updateSelfUsage(uint64_t tick) {
+    const auto now = std::chrono::steady_clock::now();
+    if (has_self_usage && now - last_self_check < std::chrono::milliseconds(SELF_USAGE_INTERVAL_MS))
+        return;
+
+    SelfUsage usage;
+    if (!self_monitor.read(usage))
+        return;
+
+    OverheadFrame overhead {};
+    overhead.tick = tick;
+    overhead.rss_bytes = usage.rss_bytes;
+    overhead.threads = usage.threads;
+    if (has_self_usage) {
+        const double wall_us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - last_self_check).count());
+        const uint64_t cpu_us = usage.cpu_time_us > last_self_usage.cpu_time_us ?
+            usage.cpu_time_us - last_self_usage.cpu_time_us : 0;
+        overhead.cpu_use = wall_us > 0.0 ? cpu_us / wall_us : 0.0;
+    }
+
+    last_self_usage = usage;
+    last_self_check = now;
+    has_self_usage = true;
+    published_overhead.store(overhead);
+    emit notifyOverhead();
+}
+
+const char* DataManager::phaseName(UpdatePhase phase) {
+    switch (phase) {
+    case UpdatePhase::Sample: return "sample";
+    case UpdatePhase::Cpu: return "cpu";
+    case UpdatePhase::Foreground: return "foreground";
+    case UpdatePhase::Processes: return "processes";
+    case UpdatePhase::Publish: return "publish";
+    case UpdatePhase::Signals: return "signals";
+    case UpdatePhase::Tick: return "tick";
+    }
+    return "";
+}
+
+const LatencyHistogram& DataManager::phaseLatency(UpdatePhase phase) const {
+    return phase_latency[static_cast<unsigned>(phase)];
+}
+
+QVariantList DataManager::OverheadPhases() const {
+    QVariantList rows;
+    rows.reserve(PHASE_COUNT);
+    for (unsigned i = 0; i < PHASE_COUNT; i++) {
+        const LatencyHistogram &latency = phase_latency[i];
+        rows.append(QVariantMap {
+            {"phase", QString::fromLatin1(phaseName(static_cast<UpdatePhase>(i)))},
+            {"count", static_cast<double>(latency.count())},
+            {"p50Us", latency.percentile(0.5) / 1000.0},
+            {"p99Us", latency.percentile(0.99) / 1000.0},
+            {"maxUs", latency.max() / 1000.0},
+        });
+    }
+    return rows;
+}
+
+double DataManager::SelfCpuUse() const {
+    return published_overhead.load().cpu_use * 100.0;
+}
+
+unsigned DataManager::SelfRssKb() const {
+    return static_cast<unsigned>(published_overhead.load().rss_bytes / BYTES_PER_KIB);
+}
+
+int DataManager::SelfThreads() const {
+    return static_cast<int>(published_overhead.load().threads);
+}
+
+QString DataManager::overheadReport() const {
+    QString report = QString::fromLatin1("%1 %2 %3 %4 %5\n")
+        .arg(QString::fromLatin1("phase"), -12)
+        .arg(QString::fromLatin1("count"), 10)
+        .arg(QString::fromLatin1("p50 us"), 10)
+        .arg(QString::fromLatin1("p99 us"), 10)
+        .arg(QString::fromLatin1("max us"), 10);
+    for (unsigned i = 0; i < PHASE_COUNT; i++) {
+        const LatencyHistogram &latency = phase_latency[i];
+        report += QString::fromLatin1("%1 %2 %3 %4 %5\n")
+            .arg(QString::fromLatin1(phaseName(static_cast<UpdatePhase>(i))), -12)
+            .arg(latency.count(), 10)
+            .arg(latency.percentile(0.5) / 1000.0, 10, 'f', 1)
+            .arg(latency.percentile(0.99) / 1000.0, 10, 'f', 1)
+            .arg(latency.max() / 1000.0, 10, 'f', 1);
+    }
+
+    const OverheadFrame overhead = published_overhead.load();
+    report += QString::fromLatin1("self: cpu %1 % of one core, rss %2 KiB, %3 threads\n")
+        .arg(overhead.cpu_use * 100.0, 0, 'f', 2)
+        .arg(overhead.rss_bytes / BYTES_PER_KIB)
+        .arg(overhead.threads);
+    return report;
+}
+
+void DataManager::deliverFrame() {
+    // Cleared before loading, a frame published from here on queues a delivery of its own
+    frame_pending.store(false, std::memory_order_release);
+    MetricFrame frame = published_frame.load();
+
+    if (frame.tick == recorded_tick)
+        return;
+    recorded_tick = frame.tick;
+    m_SampleTimeMs = frame.timestamp_ms;
+
+    mem_used_history->append(frame.timestamp_ms, memUsedPercent(frame));
+    mem_proc_history->append(frame.timestamp_ms, memProcPercent(frame));
+    mem_proc_rss_history->append(frame.timestamp_ms, percentOfUsed(frame, frame.mem_proc_rss));
+    mem_proc_uss_history->append(frame.timestamp_ms, percentOfUsed(frame, frame.mem_proc_uss));
+    mem_proc_swap_history->append(frame.timestamp_ms, percentOfUsed(frame, frame.mem_proc_swap));
+    cpu_used_history->append(frame.timestamp_ms, frame.cpu_use * 100.0);
+    cpu_proc_history->append(frame.timestamp_ms, frame.cpu_proc_use * 100.0);
+    gpu_proc_history->append(frame.timestamp_ms, frame.gpu_proc_use * 100.0);
+
+    // Published with the frame just loaded or after it, a newer one only moves the I/O graph ahead by a tick
+    const IoFrame io = published_io.load();
+    io_read_history->append(frame.timestamp_ms, io.foreground.read_rate / BYTES_PER_KIB);
+    io_write_history->append(frame.timestamp_ms, io.foreground.write_rate / BYTES_PER_KIB);
+    disk_io_history->append(frame.timestamp_ms, (io.disk_total.read_rate + io.disk_total.write_rate) / BYTES_PER_KIB);
+
+    // A frame of an older watch list would land in the histories of whatever targets moved into its slots
+    const WatchFrame watches = published_watches.load();
+    if (watches.generation == watch_generation) {
+        for (uint32_t i = 0; i < watches.count && i < watch_targets.size(); i++)
+            watch_histories[i]->append(frame.timestamp_ms, watches.watches[i].cpu_use * 100.0);
+    }
+
+    emit frameReady();
+    if (frame.missed_deadlines != last_missed_deadlines) {
+        last_missed_deadlines = frame.missed_deadlines;
+        emit notifyMissedDeadlines();
+    }
+}
+
+std::vector<TelemetryColumn> DataManager::telemetryColumns() {
+    return {
+        {"cpu_use", TelemetryColumnKind::Gauge},
+        {"cpu_proc_use", TelemetryColumnKind::Gauge},
+        {"gpu_proc_use", TelemetryColumnKind::Gauge},
+        {"core_max_use", TelemetryColumnKind::Gauge},
+        {"elapsed_ms", TelemetryColumnKind::Gauge},
+        {"mem_total", TelemetryColumnKind::Counter},
+        {"mem_used", TelemetryColumnKind::Counter},
+        {"mem_proc", TelemetryColumnKind::Counter},
+        {"missed_deadlines", TelemetryColumnKind::Counter},
+        {"cores_above_threshold", TelemetryColumnKind::Counter},
+    };
+}
+
+void DataManager::recordTelemetry(const MetricFrame &frame) {
+    std::lock_guard<std::mutex> lock(recorder_mutex);
+    if (!recorder.isOpen())
+        return;
+
+    const double gauges[] = {
+        frame.cpu_use, frame.cpu_proc_use, frame.gpu_proc_use, frame.core_max_use, frame.elapsed_ms,
+    };
+    const uint64_t counters[] = {
+        static_cast<uint64_t>(frame.mem_total),
+        static_cast<uint64_t>(frame.mem_used),
+        static_cast<uint64_t>(frame.mem_proc),
+        frame.missed_deadlines,
+        frame.cores_above_threshold,
+    };
+    int64_t timestamp_us = static_cast<int64_t>(frame.timestamp_ms * MILI_TO_MICROSEC);
+    if (!recorder.append(timestamp_us, gauges, counters))
+        QMetaObject::invokeMethod(this, &DataManager::recordingChanged, Qt::QueuedConnection);
+}
+
+bool DataManager::startRecording(const QString &path) {
+    using namespace std::chrono;
+
+    // Wall-clock time of timestamp 0, taking the newest frame as now, so readers can place the timestamps
+    const double since_start_ms = published_frame.load().timestamp_ms;
+    const int64_t origin_unix_us = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count() -
+        static_cast<int64_t>(since_start_ms * MILI_TO_MICROSEC);
+
+    bool opened;
+    {
+        std::lock_guard<std::mutex> lock(recorder_mutex);
+        opened = recorder.open(path.toStdString(), telemetryColumns(), origin_unix_us);
+    }
+    emit recordingChanged();
+    return opened;
+}
+
+void DataManager::stopRecording() {
+    {
+        std::lock_guard<std::mutex> lock(recorder_mutex);
+        if (!recorder.isOpen())
+            return;
+        recorder.close();
+    }
+    emit recordingChanged();
+}
+
+bool DataManager::Recording() {
+    std::lock_guard<std::mutex> lock(recorder_mutex);
+    return recorder.isOpen();
+}
+
+void DataManager::renderMetrics(const MetricFrame &frame) {
+    // Everything below was published by this thread, this tick or at the last table scan, the loads cannot retry
+    const CoreFrame cores = published_cores.load();
+    const ProcessFrame processes = published_processes.load();
+    const WatchFrame watches = published_watches.load();
+    const CgroupFrame cgroups = published_cgroups.load();
+    const ThreadFrame threads = published_threads.load();
+    const IoFrame io = published_io.load();
+    const OverheadFrame overhead = published_overhead.load();
+    const auto name = published_name.load();
+
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.cores = &cores;
+    snapshot.processes = &processes;
+    snapshot.watches = &watches;
+    snapshot.cgroups = &cgroups;
+    snapshot.threads = &threads;
+    snapshot.io = &io;
+    snapshot.overhead = &overhead;
+    snapshot.foreground_name = name.data();
+    metrics_page.render(snapshot);
+}
+
+bool DataManager::serveMetrics(int port) {
+#ifdef _WIN32
+    Q_UNUSED(port);
+    return false;
+#else
+    if (port < 0 || port > 0xffff)
+        return false;
+    stopMetrics();
+
+    auto server = std::make_unique<MetricsServer>(metrics_page);
+    if (!server->start(static_cast<uint16_t>(port)))
+        return false;
+    metrics_server = std::move(server);
+    metrics_enabled.store(true, std::memory_order_relaxed);
+    emit metricsPortChanged();
+    return true;
+#endif
+}
+
+void DataManager::stopMetrics() {
+#ifndef _WIN32
+    if (!metrics_server)
+        return;
+    metrics_enabled.store(false, std::memory_order_relaxed);
+    metrics_server.reset();
+    emit metricsPortChanged();
+#endif
+}
+
+int DataManager::MetricsPort() const {
+#ifdef _WIN32
+    return 0;
+#else
+    return metrics_server ? metrics_server->port() : 0;
+#endif
 }
 
 DataManager::~DataManager() {
-    update_thread.detach();
-    update_thread.~thread();
-    data_source.~ProcData();
+    stopUpdates();
+    delete update_thread;
+}
+
+void DataManager::stopUpdates() {
+    // The loop checks both between ticks, the scheduler also wakes it from a wait, a paced replay's included
+    update_thread->requestInterruption();
+    scheduler.stop();
+    update_thread->wait();
 }
 
 void DataManager::updateLoop() {
+    QThread *worker = QThread::currentThread();
+
+    while (!scheduler.stopped() && !worker->isInterruptionRequested()) {
+        adoptPendingSource();
+        adoptPendingWatches();
+        adoptPendingCgroups();
+        adoptPendingTarget();
 
-    while (true) {
-        update();
-        std::this_thread::sleep_for(std::chrono::milliseconds(m_interval));
+        if (!sampler.currentSource()->selfPaced()) {
+            if (!scheduler.wait())
+                break;
+            update();
+        } else if (!update() && !scheduler.stopped()) {
+            // Back to live, unless another source was handed over meanwhile
+            {
+                std::lock_guard<std::mutex> lock(source_mutex);
+                source_pending = true;
+            }
+            emit replayFinished();
+        }
     }
 }
 
+void DataManager::switchSource(std::unique_ptr<SampleSource> next) {
+    std::lock_guard<std::mutex> lock(source_mutex);
+    pending_source = std::move(next);
+    source_pending = true;
+}
+
+void DataManager::adoptPendingSource() {
+    std::unique_ptr<SampleSource> next;
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        if (!source_pending)
+            return;
+        source_pending = false;
+        next = std::move(pending_source);
+        source_name = QString::fromStdString(next ? next->name() : live_source.name());
+    }
+
+    replay_source = std::move(next);
+    if (replay_source)
+        replay_source->setScheduler(&scheduler);
+    adaptive_rate.reset();
+
+    // The new source has its own clock and counters: continue the timeline one interval on, take fresh baselines
+    sampler.setSource(replay_source ? replay_source.get() : &live_source,
+                      published_frame.load().timestamp_ms + scheduler.interval().count());
+    name_stale = true;
+    scan_elapsed_ms = SCAN_INTERVAL_MS;
+    emit sourceChanged();
+}
+
+bool DataManager::replayRecording(const QString &path, bool as_fast_as_possible) {
+    auto trace = std::make_unique<TraceSampleSource>(
+        as_fast_as_possible ? ReplaySpeed::AsFastAsPossible : ReplaySpeed::Realtime);
+    if (!trace->open(path.toStdString()))
+        return false;
+    switchSource(std::move(trace));
+    return true;
+}
+
+bool DataManager::replaySynthetic(const QString &pattern, int cores, bool as_fast_as_possible) {
+    SyntheticPattern parsed;
+    if (!SyntheticSampleSource::parsePattern(pattern.toStdString(), parsed))
+        return false;
+    switchSource(std::make_unique<SyntheticSampleSource>(
+        parsed, static_cast<unsigned>(std::max(cores, 1)),
+        std::chrono::milliseconds(fixed_interval_ms.load(std::memory_order_relaxed)), 0,
+        as_fast_as_possible ? ReplaySpeed::AsFastAsPossible : ReplaySpeed::Realtime));
+    return true;
+}
+
+void DataManager::sampleLive() {
+    switchSource(nullptr);
+}
+
+QString DataManager::SourceName() {
+    std::lock_guard<std::mutex> lock(source_mutex);
+    return source_name;
+}
+
 unsigned DataManager::MemTotalKb() const {
-    return m_MemTotal / DataManager::KB_DIVISOR;
+    return published_frame.load().mem_total / DataManager::KB_DIVISOR;
 }
 
 unsigned DataManager::MemUsedKb() const {
-    return m_MemUsed / DataManager::KB_DIVISOR;
+    return published_frame.load().mem_used / DataManager::KB_DIVISOR;
 }
 
 unsigned DataManager::MemProcKb() const {
-    return m_MemProc / DataManager::KB_DIVISOR;
+    return published_frame.load().mem_proc / DataManager::KB_DIVISOR;
 }
 
-void DataManager::sampleCpuTimes() {
+unsigned DataManager::MemProcRssKb() const {
+    return published_frame.load().mem_proc_rss / DataManager::BYTES_PER_KIB;
+}
 
-    double core_time_div = static_cast<double>(core_time_interval);
-    unsigned long long total_cpu_time = data_source.getTotalCpuTime();
-    unsigned long long total_proc_time = data_source.getTotalProcessTime();
-    unsigned long long cpu_diff = 0;
-    unsigned long long proc_diff = 0;
+unsigned DataManager::MemProcUssKb() const {
+    return published_frame.load().mem_proc_uss / DataManager::BYTES_PER_KIB;
+}
 
-    if (last_cpu_measurement < 0) {
-        calculated_use = 0.0;
-    } else {
-        cpu_diff = total_cpu_time - last_cpu_measurement;
-        calculated_use = cpu_diff / core_time_div;
+unsigned DataManager::MemProcSwapKb() const {
+    return published_frame.load().mem_proc_swap / DataManager::BYTES_PER_KIB;
+}
+
+bool DataManager::MemProcDetailed() const {
+    return published_frame.load().mem_proc_detailed;
+}
+
+double DataManager::memUsedPercent(const MetricFrame &frame) {
+    if (frame.mem_total <= 0)
+        return 0.0;
+    return static_cast<double>(frame.mem_used) / frame.mem_total * 100.0;
+}
+
+double DataManager::memProcPercent(const MetricFrame &frame) {
+    return percentOfUsed(frame, frame.mem_proc);
+}
+
+double DataManager::percentOfUsed(const MetricFrame &frame, int64_t bytes) {
+    if (frame.mem_used <= 0)
+        return 0.0;
+    return static_cast<double>(bytes) / frame.mem_used * 100.0;
+}
+
+double DataManager::MemUsedPercent() const {
+    return memUsedPercent(published_frame.load());
+}
+
+double DataManager::MemProcPercent() const {
+    return memProcPercent(published_frame.load());
+}
+
+MetricFrame DataManager::snapshot() const {
+    return published_frame.load();
+}
+
+void DataManager::publishProcesses(uint64_t tick, double elapsed_ms) {
+    ProcessFrame processes {};
+    processes.tick = tick;
+
+    SampleSource *source = sampler.currentSource();
+    if (source->updateProcessTable(elapsed_ms / 1000.0)) {
+        const auto &top_cpu = source->topCpuProcesses();
+        const auto &top_memory = source->topMemoryProcesses();
+
+        processes.process_count = static_cast<uint32_t>(source->processCount());
+        processes.top_cpu_count = static_cast<uint32_t>(std::min<size_t>(top_cpu.size(), ProcessFrame::MAX_TOP));
+        processes.top_memory_count = static_cast<uint32_t>(std::min<size_t>(top_memory.size(), ProcessFrame::MAX_TOP));
+        std::copy_n(top_cpu.begin(), processes.top_cpu_count, processes.top_cpu);
+        std::copy_n(top_memory.begin(), processes.top_memory_count, processes.top_memory);
     }
+    published_processes.store(processes);
+}
 
-    if (last_proc_measurement < 0) {
-        calculated_proc_use = 0.0;
-    } else {
-        proc_diff = total_proc_time - last_proc_measurement;
-        // Account for changing foreground process;
-        if (proc_diff < 0)
-            proc_diff = 0;
-        calculated_proc_use = proc_diff / static_cast<double>(cpu_diff);
+void DataManager::publishStats(const MetricFrame &frame) {
+    // Same values the histories get in `deliverFrame`
+    const double values[StatsFrame::METRICS] = {
+        memUsedPercent(frame),
+        memProcPercent(frame),
+        frame.cpu_use * 100.0,
+        frame.cpu_proc_use * 100.0,
+        frame.gpu_proc_use * 100.0,
+    };
+
+    StatsFrame stats {};
+    stats.tick = frame.tick;
+    for (unsigned metric = 0; metric < StatsFrame::METRICS; metric++) {
+        RollingStats &rolling = rolling_stats[metric];
+        rolling.push(frame.timestamp_ms, values[metric]);
+        for (unsigned window = 0; window < StatsFrame::WINDOWS; window++)
+            stats.summaries[metric][window] = rolling.summary(window);
+    }
+    published_stats.store(stats);
+}
 
-        if (calculated_proc_use > 1.0)
-            calculated_proc_use = 1.0;
+QVariantList DataManager::statsRows(StatsMetric metric) const {
+    const StatsFrame stats = published_stats.load();
+
+    QVariantList rows;
+    rows.reserve(StatsFrame::WINDOWS);
+    for (const RollingSummary &summary : stats.summaries[static_cast<unsigned>(metric)]) {
+        rows.append(QVariantMap {
+            {"windowMs", summary.window_ms},
+            {"count", static_cast<int>(summary.count)},
+            {"min", summary.min},
+            {"max", summary.max},
+            {"avg", summary.mean},
+            {"p95", summary.p95},
+            {"p99", summary.p99},
+        });
     }
+    return rows;
+}
+
+QVariantList DataManager::MemUsedStats() const {
+    return statsRows(StatsMetric::MemUsed);
+}
+
+QVariantList DataManager::MemProcStats() const {
+    return statsRows(StatsMetric::MemProc);
+}
+
+QVariantList DataManager::CpuTotalStats() const {
+    return statsRows(StatsMetric::CpuTotal);
+}
+
+QVariantList DataManager::CpuProcStats() const {
+    return statsRows(StatsMetric::CpuProc);
+}
+
+QVariantList DataManager::GpuProcStats() const {
+    return statsRows(StatsMetric::GpuProc);
+}
+
+QVariantList DataManager::processRows(const ProcessInfo *processes, uint32_t count) {
+    QVariantList rows;
+    rows.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const ProcessInfo &process = processes[i];
+        rows.append(QVariantMap {
+            {"pid", process.pid},
+            {"name", QString::fromUtf8(process.name)},
+            {"cpu", process.cpu_use * 100.0},
+            {"memKb", static_cast<double>(process.rss_bytes / BYTES_PER_KIB)},
+        });
+    }
+    return rows;
+}
+
+int DataManager::ProcessCount() const {
+    return static_cast<int>(published_processes.load().process_count);
+}
 
-    last_cpu_measurement = total_cpu_time;
-    last_proc_measurement = total_proc_time;
+QVariantList DataManager::TopCpuProcesses() const {
+    ProcessFrame processes = published_processes.load();
+    return processRows(processes.top_cpu, processes.top_cpu_count);
+}
+
+QVariantList DataManager::TopMemProcesses() const {
+    ProcessFrame processes = published_processes.load();
+    return processRows(processes.top_memory, processes.top_memory_count);
+}
+
+void DataManager::publishCgroups(uint64_t tick, double elapsed_ms) {
+    CgroupFrame cgroups {};
+    cgroups.tick = tick;
+
+    SampleSource *source = sampler.currentSource();
+    if (source->updateCgroups(elapsed_ms / 1000.0)) {
+        const auto &reported = source->cgroups();
+        cgroups.count = static_cast<uint32_t>(std::min<size_t>(reported.size(), CgroupFrame::MAX_CGROUPS));
+        std::copy_n(reported.begin(), cgroups.count, cgroups.groups);
+    }
+    published_cgroups.store(cgroups);
+}
+
+QVariantList DataManager::Cgroups() const {
+    const CgroupFrame cgroups = published_cgroups.load();
+
+    QVariantList rows;
+    rows.reserve(cgroups.count);
+    for (uint32_t i = 0; i < cgroups.count; i++) {
+        const CgroupInfo &group = cgroups.groups[i];
+        const double cpu_limit_percent = group.cpu_limit > 0.0f ? group.cpu_use / group.cpu_limit * 100.0 : 0.0;
+        const double mem_limit_percent = group.memory_max > 0 ?
+            static_cast<double>(group.memory_bytes) / group.memory_max * 100.0 : 0.0;
+        rows.append(QVariantMap {
+            {"path", QString::fromUtf8(group.path)},
+            {"selected", group.selected},
+            {"cpu", group.cpu_use * 100.0},
+            {"cpuLimit", group.cpu_limit},
+            {"cpuLimitPercent", cpu_limit_percent},
+            {"throttled", group.cpu_throttled * 100.0},
+            {"memKb", static_cast<double>(group.memory_bytes / BYTES_PER_KIB)},
+            {"memMaxKb", static_cast<double>(group.memory_max / BYTES_PER_KIB)},
+            {"memLimitPercent", mem_limit_percent},
+            {"anonKb", static_cast<double>(group.anon_bytes / BYTES_PER_KIB)},
+            {"fileKb", static_cast<double>(group.file_bytes / BYTES_PER_KIB)},
+            {"ioReadKbps", group.io_read_rate / BYTES_PER_KIB},
+            {"ioWriteKbps", group.io_write_rate / BYTES_PER_KIB},
+        });
+    }
+    return rows;
+}
+
+void DataManager::publishThreads(uint64_t tick, double elapsed_ms) {
+    ThreadFrame threads {};
+    threads.tick = tick;
+    threads.hot_threshold = core_threshold.load(std::memory_order_relaxed);
+
+    SampleSource *source = sampler.currentSource();
+    if (source->updateThreads(elapsed_ms / 1000.0)) {
+        const auto &top = source->topThreads();
+        threads.thread_count = static_cast<uint32_t>(source->threadCount());
+        threads.top_count = static_cast<uint32_t>(std::min<size_t>(top.size(), ThreadFrame::MAX_TOP));
+        std::copy_n(top.begin(), threads.top_count, threads.top);
+        // Busiest first, so the hot ones are a prefix
+        while (threads.hot_count < threads.top_count && threads.top[threads.hot_count].cpu_use >= threads.hot_threshold)
+            threads.hot_count++;
+    }
+    published_threads.store(threads);
+}
+
+int DataManager::ThreadCount() const {
+    return static_cast<int>(published_threads.load().thread_count);
+}
+
+QVariantList DataManager::TopThreads() const {
+    const ThreadFrame threads = published_threads.load();
+
+    QVariantList rows;
+    rows.reserve(threads.top_count);
+    for (uint32_t i = 0; i < threads.top_count; i++) {
+        const ThreadInfo &thread = threads.top[i];
+        rows.append(QVariantMap {
+            {"tid", thread.tid},
+            {"name", QString::fromUtf8(thread.name)},
+            {"cpu", thread.cpu_use * 100.0},
+            {"hot", i < threads.hot_count},
+        });
+    }
+    return rows;
+}
+
+int DataManager::HotThreads() const {
+    return static_cast<int>(published_threads.load().hot_count);
+}
+
+void DataManager::publishIo(const MetricFrame &frame) {
+    IoFrame io {};
+    io.tick = frame.tick;
+
+    SampleSource *source = sampler.currentSource();
+    source->updateIo(frame.elapsed_ms / 1000.0);
+    io.foreground = source->foregroundIo();
+    const auto &disks = source->disks();
+    io.disk_count = static_cast<uint32_t>(std::min<size_t>(disks.size(), IoFrame::MAX_DISKS));
+    std::copy_n(disks.begin(), io.disk_count, io.disks);
+    for (uint32_t i = 0; i < io.disk_count; i++) {
+        if (!io.disks[i].stacked)
+            addIoRate(io.disk_total, io.disks[i].rate);
+    }
+
+    io_peak.push(frame.timestamp_ms, std::max({io.foreground.read_rate, io.foreground.write_rate,
+                                               io.disk_total.read_rate + io.disk_total.write_rate}));
+    io.peak_rate = io_peak.max();
+    published_io.store(io);
+}
+
+double DataManager::IoReadKbps() const {
+    return published_io.load().foreground.read_rate / BYTES_PER_KIB;
+}
+
+double DataManager::IoWriteKbps() const {
+    return published_io.load().foreground.write_rate / BYTES_PER_KIB;
+}
+
+double DataManager::IoReadOps() const {
+    return published_io.load().foreground.read_ops;
+}
+
+double DataManager::IoWriteOps() const {
+    return published_io.load().foreground.write_ops;
+}
+
+double DataManager::IoPeakKbps() const {
+    return published_io.load().peak_rate / BYTES_PER_KIB;
+}
+
+QVariantList DataManager::Disks() const {
+    const IoFrame io = published_io.load();
+
+    QVariantList rows;
+    rows.reserve(io.disk_count);
+    for (uint32_t i = 0; i < io.disk_count; i++) {
+        const DiskInfo &disk = io.disks[i];
+        rows.append(QVariantMap {
+            {"name", QString::fromUtf8(disk.name)},
+            {"readKbps", disk.rate.read_rate / BYTES_PER_KIB},
+            {"writeKbps", disk.rate.write_rate / BYTES_PER_KIB},
+            {"readOps", disk.rate.read_ops},
+            {"writeOps", disk.rate.write_ops},
+            {"busy", disk.busy * 100.0},
+            {"stacked", disk.stacked},
+        });
+    }
+    return rows;
+}
+
+QStringList DataManager::CgroupSelection() const {
+    return cgroup_selection;
+}
+
+void DataManager::setCgroupSelection(const QStringList &paths) {
+    if (paths == cgroup_selection)
+        return;
+    cgroup_selection = paths;
+    {
+        std::lock_guard<std::mutex> lock(cgroup_mutex);
+        pending_cgroups.clear();
+        for (const QString &path : paths)
+            pending_cgroups.push_back(path.toStdString());
+        cgroups_pending = true;
+    }
+    emit cgroupSelectionChanged();
+}
+
+void DataManager::adoptPendingCgroups() {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(cgroup_mutex);
+        if (!cgroups_pending)
+            return;
+        cgroups_pending = false;
+        paths.swap(pending_cgroups);
+    }
+    live_source.setCgroupSelection(paths);
+    // The new selection shows on the next tick rather than at the next scheduled scan
+    scan_elapsed_ms = SCAN_INTERVAL_MS;
+}
+
+int DataManager::TargetPid() const {
+    return target_pid;
+}
+
+void DataManager::setTargetPid(int pid) {
+    pid = std::max(pid, 0);
+    if (pid == target_pid)
+        return;
+    target_pid = pid;
+    pending_target_pid.store(pid, std::memory_order_release);
+    emit targetPidChanged();
+}
+
+void DataManager::adoptPendingTarget() {
+    const int pid = pending_target_pid.exchange(TARGET_UNCHANGED, std::memory_order_acquire);
+    if (pid == TARGET_UNCHANGED)
+        return;
+    live_source.setTargetProcess(pid);
+    // Its threads show on the next tick rather than at the next scheduled scan
+    scan_elapsed_ms = SCAN_INTERVAL_MS;
+}
+
+void DataManager::publishWatches(uint64_t tick, double elapsed_ms) {
+    WatchFrame watches {};
+    watches.tick = tick;
+    watches.generation = active_generation;
+    const SampleFrame &sample_frame = sampler.sampleFrame();
+    watches.count = std::min<uint32_t>(sample_frame.watch_count, WatchTarget::MAX_TARGETS);
+
+    const double core_time_div = elapsed_ms * MILI_TO_MICROSEC * sampler.logicalCores();
+    const auto &watch_io = sampler.currentSource()->watchIo();
+    for (uint32_t i = 0; i < watches.count; i++) {
+        const WatchSample &sample = sample_frame.watches[i];
+        WatchUse &use = watches.watches[i];
+        use.matches = sample.matches;
+        use.pid = sample.pid;
+        std::memcpy(use.name, sample.name, sizeof(use.name));
+        use.cpu_use = core_time_div > 0.0 ? std::min(1.0, sample.time_delta / core_time_div) : 0.0;
+        use.mem_bytes = sample.memory;
+        if (i < watch_io.size()) {
+            use.io_read_rate = watch_io[i].read_rate;
+            use.io_write_rate = watch_io[i].write_rate;
+        }
+    }
+    published_watches.store(watches);
+}
+
+void DataManager::adoptPendingWatches() {
+    std::vector<WatchTarget> targets;
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        if (!watches_pending)
+            return;
+        watches_pending = false;
+        targets.swap(pending_watches);
+        active_generation = pending_generation;
+    }
+    live_source.setWatchTargets(targets);
+}
+
+void DataManager::switchWatches() {
+    watch_generation++;
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        pending_watches = watch_targets;
+        pending_generation = watch_generation;
+        watches_pending = true;
+    }
+    emit watchesChanged();
+}
+
+int DataManager::addWatch(WatchTarget target) {
+    if (watch_targets.size() >= WatchTarget::MAX_TARGETS)
+        return -1;
+    watch_targets.push_back(std::move(target));
+    switchWatches();
+    return static_cast<int>(watch_targets.size()) - 1;
+}
+
+int DataManager::watchPid(int pid) {
+    if (pid <= 0)
+        return -1;
+    return addWatch(WatchTarget::byPid(pid));
+}
+
+int DataManager::watchName(const QString &pattern) {
+    if (pattern.isEmpty())
+        return -1;
+    return addWatch(WatchTarget::byName(pattern.toStdString()));
+}
+
+int DataManager::watchForeground() {
+    return addWatch(WatchTarget::foreground());
+}
+
+void DataManager::unwatch(int index) {
+    if (index < 0 || static_cast<size_t>(index) >= watch_targets.size())
+        return;
+    watch_targets.erase(watch_targets.begin() + index);
+
+    // The histories follow their targets, the freed one goes to the end for whatever is watched next
+    HistorySeries *freed = watch_histories[index];
+    std::move(watch_histories.begin() + index + 1, watch_histories.end(), watch_histories.begin() + index);
+    watch_histories.back() = freed;
+    freed->reset(history_capacity);
+    switchWatches();
+}
+
+int DataManager::WatchCount() const {
+    return static_cast<int>(watch_targets.size());
+}
+
+QVariantList DataManager::Watches() const {
+    const WatchFrame watches = published_watches.load();
+    const bool current = watches.generation == watch_generation;
+
+    QVariantList rows;
+    rows.reserve(static_cast<qsizetype>(watch_targets.size()));
+    for (size_t i = 0; i < watch_targets.size(); i++) {
+        const WatchUse use = current && i < watches.count ? watches.watches[i] : WatchUse{};
+        rows.append(QVariantMap {
+            {"label", QString::fromStdString(watch_targets[i].label())},
+            {"pid", use.pid},
+            {"name", QString::fromUtf8(use.name)},
+            {"matches", static_cast<int>(use.matches)},
+            {"cpu", use.cpu_use * 100.0},
+            {"memKb", static_cast<double>(use.mem_bytes / BYTES_PER_KIB)},
+            {"ioReadKbps", use.io_read_rate / BYTES_PER_KIB},
+            {"ioWriteKbps", use.io_write_rate / BYTES_PER_KIB},
+        });
+    }
+    return rows;
+}
+
+HistorySeries* DataManager::watchHistory(int index) const {
+    if (index < 0 || static_cast<size_t>(index) >= watch_targets.size())
+        return nullptr;
+    return watch_histories[index];
+}
+
+QList<float> DataManager::CoreUse() const {
+    CoreFrame cores = published_cores.load();
+    return QList<float>(cores.busy, cores.busy + cores.count);
+}
+
+double DataManager::CoreMaxUse() const {
+    return published_frame.load().core_max_use;
+}
+
+int DataManager::CoreMaxIndex() const {
+    return static_cast<int>(published_frame.load().core_max_index);
+}
+
+int DataManager::CoresAboveThreshold() const {
+    return static_cast<int>(published_frame.load().cores_above_threshold);
+}
+
+double DataManager::CoreThreshold() const {
+    return core_threshold.load(std::memory_order_relaxed);
+}
+
+void DataManager::setCoreThreshold(double threshold) {
+    float clamped = static_cast<float>(std::clamp(threshold, 0.0, 1.0));
+    if (clamped == core_threshold.exchange(clamped, std::memory_order_relaxed))
+        return;
+    emit coreThresholdChanged();
 }
 
 double DataManager::CpuProcUse() {
-    return calculated_proc_use;
+    return published_frame.load().cpu_proc_use;
+}
+
+double DataManager::GpuProcUse() const {
+    return published_frame.load().gpu_proc_use;
 }
 
 double DataManager::CpuTotal() {
-    return calculated_use;
+    return published_frame.load().cpu_use;
 }
 
 unsigned DataManager::RefreshIntervalMs() const {
-    return DataManager::m_interval;
+    return static_cast<unsigned>(fixed_interval_ms.load(std::memory_order_relaxed));
 }
 
-bool ProcData::procHandleValid(HANDLE procHandle) {
-    DWORD handleStatus = WaitForSingleObject(procHandle, 0);
-    return handleStatus == WAIT_TIMEOUT;
+void DataManager::setRefreshIntervalMs(unsigned interval_ms) {
+    auto clamped = SampleScheduler::clampInterval(std::chrono::milliseconds(interval_ms));
+    if (clamped.count() == fixed_interval_ms.exchange(clamped.count(), std::memory_order_relaxed))
+        return;
+
+    reserveHistory(static_cast<unsigned>(clamped.count()));
+    if (!adaptive_sampling.load(std::memory_order_relaxed))
+        scheduler.setInterval(clamped);
+    emit refreshIntervalChanged();
 }
 
-QString DataManager::ForegroundProc() {
-    std::string foreground_name_st_string = data_source.getFgProcessName();
-    return QString::fromStdString(foreground_name_st_string);
+bool DataManager::AdaptiveSampling() const {
+    return adaptive_sampling.load(std::memory_order_relaxed);
 }
 
-void DataManager::sampleProcHandle() {
+void DataManager::setAdaptiveSampling(bool enabled) {
+    if (enabled == adaptive_sampling.exchange(enabled, std::memory_order_relaxed))
+        return;
+
+    if (enabled) {
+        reserveHistory(static_cast<unsigned>(adaptive_rate.config().fastest.count()));
+    } else {
+        // Don't sit out a long adaptive interval, the update thread confirms the fixed one on its next tick
+        scheduler.setInterval(std::chrono::milliseconds(fixed_interval_ms.load(std::memory_order_relaxed)));
+    }
+    emit adaptiveSamplingChanged();
+}
+
+quint64 DataManager::MissedDeadlines() const {
+    return published_frame.load().missed_deadlines;
+}
+
+void DataManager::reserveHistory(unsigned interval_ms) {
+    history_capacity = std::max<size_t>(history_capacity, HISTORY_WINDOW_MS / interval_ms + 2);
+    mem_used_history->reserve(history_capacity);
+    mem_proc_history->reserve(history_capacity);
+    mem_proc_rss_history->reserve(history_capacity);
+    mem_proc_uss_history->reserve(history_capacity);
+    mem_proc_swap_history->reserve(history_capacity);
+    cpu_used_history->reserve(history_capacity);
+    cpu_proc_history->reserve(history_capacity);
+    gpu_proc_history->reserve(history_capacity);
+    io_read_history->reserve(history_capacity);
+    io_write_history->reserve(history_capacity);
+    disk_io_history->reserve(history_capacity);
+    for (HistorySeries *history : watch_histories)
+        history->reserve(history_capacity);
+}
+
+quint64 DataManager::CoalescedFrames() const {
+    return coalesced_frames.load(std::memory_order_relaxed);
+}
+
+double DataManager::SampleTimeMs() const {
+    return m_SampleTimeMs;
+}
+
+HistorySeries* DataManager::MemUsedHistory() const {
+    return mem_used_history;
+}
+
+HistorySeries* DataManager::MemProcHistory() const {
+    return mem_proc_history;
+}
+
+HistorySeries* DataManager::MemProcRssHistory() const {
+    return mem_proc_rss_history;
+}
+
+HistorySeries* DataManager::MemProcUssHistory() const {
+    return mem_proc_uss_history;
+}
 
-    auto handle = data_source.getFgProcHandle();
-    HANDLE_INT_T handle_int = reinterpret_cast<HANDLE_INT_T>(handle);
+HistorySeries* DataManager::MemProcSwapHistory() const {
+    return mem_proc_swap_history;
+}
+
+HistorySeries* DataManager::CpuTotalHistory() const {
+    return cpu_used_history;
+}
+
+HistorySeries* DataManager::CpuProcHistory() const {
+    return cpu_proc_history;
+}
+
+HistorySeries* DataManager::GpuProcHistory() const {
+    return gpu_proc_history;
+}
+
+HistorySeries* DataManager::IoReadHistory() const {
+    return io_read_history;
+}
+
+HistorySeries* DataManager::IoWriteHistory() const {
+    return io_write_history;
+}
+
+HistorySeries* DataManager::DiskIoHistory() const {
+    return disk_io_history;
+}
+
+QString DataManager::ForegroundProc() const {
+    return QString::fromUtf8(published_name.load().data());
+}
+
+void DataManager::sampleProcHandle() {
 
-    if (handle_int != last_proc_handle) {
-        emit notifyForegroundProc(ForegroundProc());
-        last_proc_handle = handle_int;
+    const SampleFrame &sample_frame = sampler.sampleFrame();
+    if (sample_frame.process_changed || name_stale) {
+        name_stale = false;
+        std::array<char, SampleFrame::NAME_SIZE> name;
+        std::memcpy(name.data(), sample_frame.process_name, name.size());
+        published_name.store(name);
+        emit notifyForegroundProc(QString::fromUtf8(name.data()));
     }
 }
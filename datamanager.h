@@ -1,26 +1,54 @@
 #ifndef DATAMANAGER_H
 #define DATAMANAGER_H
 
-#include <thread>
 #include <chrono>
 #include <cstdint>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QList>
+#include <QThread>
+#include <QVariantList>
 
-#include "hwinfo/hwinfo.h"
 #include "procdata.h"
-
-// Word size check macro courtesy of alex tingle @ https://stackoverflow.com/questions/1505582/determining-32-vs-64-bit-in-c
-#if (INTPTR_MAX == INT32_MAX)
-    #define HANDLE_INT_T int32_t
-#else
-    #define HANDLE_INT_T int64_t
+#include "metricframe.h"
+#include "seqlock.h"
+#include "historyseries.h"
+#include "scheduler.h"
+#include "telemetryrecorder.h"
+#include "samplesource.h"
+#include "latencyhistogram.h"
+#include "selfmonitor.h"
+#include "adaptiverate.h"
+#include "metricsampler.h"
+#include "metricspage.h"
+#ifndef _WIN32
+#include "metricsserver.h"
 #endif
 
 /**
  * Preferred interface for accessing hardware utilization metrics.
  * The class will store the last measurements recorded due to how CPU utilization needs to be calculated.
+ * Measurements are taken on the update thread and published once per tick as a `MetricFrame`,
+ * the property getters only ever read the last published frame.
+ * The GUI thread hears of new frames through `frameReady`, queued at most once: while a delivery is still waiting, newer
+ * frames ride along with it instead of queueing their own, so a busy UI skips frames rather than falling behind.
+ * Each graphed metric also keeps its recent history in a `HistorySeries`, appended on the GUI thread, and rolling
+ * min, max, mean and percentiles over several windows, kept by the update thread so that no tick is left out.
+ * Ticks normally come from the OS; a recorded or synthetic trace can be played instead through the same
+ * properties and signals, see `replayRecording` and `replaySynthetic`.
+ * Live ticks come every `RefreshIntervalMs`, or with `AdaptiveSampling` as fast as the metrics move, see `AdaptiveRate`.
+ * Besides the foreground, a watch list of processes by PID or name pattern is followed every tick, each with its own
+ * CPU history, see `watchPid`.
+ * On Linux the busiest and largest cgroup v2 groups are reported as well, next to any selected through
+ * `CgroupSelection`, so services and containers made of many processes show up as one.
+ * On Linux every tick can also be served to a local Prometheus on `/metrics`, see `serveMetrics`.
  */
 class DataManager: public QObject {
     Q_OBJECT
@@ -31,73 +59,421 @@ class DataManager: public QObject {
     static constexpr unsigned MILI_TO_MICROSEC = 1000;
     // with 4 billion KB capping out at ~4000 GB we should be okay
     static constexpr long long KB_DIVISOR = 0b10 << 10;
+    /** Bytes and bytes per second become the KiB and KiB/s the properties and model roles are documented in. */
+    static constexpr long long BYTES_PER_KIB = 1024;
+    /** Must match `default_window_ms` in CommonGraph.qml. */
+    static constexpr unsigned HISTORY_WINDOW_MS = 60 * 1000;
+    static constexpr float DEFAULT_CORE_THRESHOLD = 0.9f;
     static const QString PERCENT_POSTFIX;
+    /** The overlay's own CPU time, memory and threads are read at most this often. */
+    static constexpr unsigned SELF_USAGE_INTERVAL_MS = 1000;
+    /**
+     * The process, cgroup and thread tables are rescanned at most this often rather than every tick. A scan lists
+     * every process of the machine, about 50 ms at 20000 processes, which at short intervals costs more than the tick
+     * it runs in; per-tick scanning under 5 ms at that size is not reached, see bench_proctable.cpp.
+     */
+    static constexpr unsigned SCAN_INTERVAL_MS = 1000;
+
+public:
+    /**
+     * Steps of `update`, each timed into its own histogram.
+     * The memory query, CPU counters and foreground resolve are one pass over the OS since `ProcData::sample`,
+     * so `Sample` covers all three and the later phases cover what is derived from them.
+     */
+    enum class UpdatePhase: unsigned {
+        /** `SampleSource::sample`: memory, CPU counters and the foreground process. */
+        Sample,
+        /** Utilization from the counters, per-core ratios. */
+        Cpu,
+        /** Foreground name and watch list publication. */
+        Foreground,
+        /** Whole-system process table, cgroups and their top lists, only timed on ticks that rescan them. */
+        Processes,
+        /** Rolling statistics, frame publication and the telemetry recording. */
+        Publish,
+        /** Property change signals and the queued history append. */
+        Signals,
+        /** All of the above, one whole tick. */
+        Tick,
+    };
+    static constexpr unsigned PHASE_COUNT = static_cast<unsigned>(UpdatePhase::Tick) + 1;
+
+    /** Lower case name of `phase` as used in `OverheadPhases` and `overheadReport`. */
+    static const char* phaseName(UpdatePhase phase);
+
+    /** Graphed metrics with rolling statistics, each in the unit of its history. Indexes `StatsFrame::summaries`. */
+    enum class StatsMetric: unsigned {
+        MemUsed,
+        MemProc,
+        CpuTotal,
+        CpuProc,
+        GpuProc,
+    };
+
+    /** Windows of every `StatsMetric`, shortest first. */
+    static constexpr double STATS_WINDOWS_MS[StatsFrame::WINDOWS] = {1000.0, 10000.0, HISTORY_WINDOW_MS};
+
+private:
+
+    /** Interface for OS APIs, sampled unless a replay is running. */
+    LiveSampleSource live_source;
+
+    /** Trace played instead of `live_source`, null when sampling live. Only touched by the update thread. */
+    std::unique_ptr<SampleSource> replay_source;
+
+    /** Samples `live_source` or `replay_source` and derives the frames. Only touched by the update thread. */
+    MetricSampler sampler;
+
+    /** Guards the hand-over of a new source to the update thread, and `source_name`. */
+    std::mutex source_mutex;
+
+    /** Source to switch to at the start of the next tick when `source_pending`, null for `live_source`. */
+    std::unique_ptr<SampleSource> pending_source;
+    bool source_pending;
+
+    /** Name of the source being sampled. */
+    QString source_name;
+
+    /** Republish the foreground name on the next tick even if the source reports no change. Update thread only. */
+    bool name_stale;
+
+    /** Guards the hand-over of a new watch list to the update thread. */
+    std::mutex watch_mutex;
+
+    /** Watch list to follow from the next tick when `watches_pending`, and its generation. */
+    std::vector<WatchTarget> pending_watches;
+    uint32_t pending_generation;
+    bool watches_pending;
+
+    /** Foreground process as set through `setTargetPid`, 0 for the default. Only touched by the GUI thread. */
+    int target_pid;
+
+    /** `target_pid` for the update thread to hand to `live_source`, `TARGET_UNCHANGED` once it did. */
+    std::atomic<int> pending_target_pid;
+    static constexpr int TARGET_UNCHANGED = -1;
+
+    /** Generation of the watch list `live_source` follows. Only touched by the update thread. */
+    uint32_t active_generation;
+
+    /** Watch list as edited through `watchPid` and the like. Only touched by the GUI thread. */
+    std::vector<WatchTarget> watch_targets;
+
+    /** Bumped on every edit of `watch_targets`. Only touched by the GUI thread. */
+    uint32_t watch_generation;
+
+    /** Guards the hand-over of a new cgroup selection to the update thread. */
+    std::mutex cgroup_mutex;
+
+    /** cgroup paths to report from the next tick when `cgroups_pending`. */
+    std::vector<std::string> pending_cgroups;
+    bool cgroups_pending;
+
+    /** Selection as set through `setCgroupSelection`. Only touched by the GUI thread. */
+    QStringList cgroup_selection;
+
+    /** Wakes the update thread on an absolute deadline grid, owns the interval in effect. */
+    SampleScheduler scheduler;
+
+    /** Interval set through `setRefreshIntervalMs`, in effect unless `adaptive_sampling`. */
+    std::atomic<long long> fixed_interval_ms;
+
+    /** Let `adaptive_rate` pick the interval of live ticks. */
+    std::atomic<bool> adaptive_sampling;
+
+    /** Picks the interval from the metrics while `adaptive_sampling`. Only touched by the update thread. */
+    AdaptiveRate adaptive_rate;
+
+    /** The scheduler runs on an interval of `adaptive_rate`'s. Only touched by the update thread. */
+    bool adapting;
+
+    /** Last complete frame, written by the update thread and read lock-free by the getters. */
+    SeqLock<MetricFrame> published_frame;
+
+    /** Per-core busy ratios of the last tick, published right before `published_frame`. */
+    SeqLock<CoreFrame> published_cores;
+
+    /** Name of the tracked process, republished only when it changes. */
+    SeqLock<std::array<char, SampleFrame::NAME_SIZE>> published_name;
+
+    /** Top processes of the last tick, published right before `published_frame`. */
+    SeqLock<ProcessFrame> published_processes;
+
+    /** Watch list usage of the last tick, published right before `published_frame`. */
+    SeqLock<WatchFrame> published_watches;
+
+    /** Selected and top cgroups of the last tick, published right before `published_frame`. */
+    SeqLock<CgroupFrame> published_cgroups;
+
+    /** Busiest threads of the foreground process of the last tick, published right before `published_frame`. */
+    SeqLock<ThreadFrame> published_threads;
+
+    /** Storage I/O of the last tick, published right before `published_frame`. */
+    SeqLock<IoFrame> published_io;
+
+    /** Busy ratio at which a core counts towards `CoresAboveThreshold`. */
+    std::atomic<float> core_threshold;
+
+    /** Guards `recorder`: the update thread appends, the GUI thread starts and stops recordings. */
+    std::mutex recorder_mutex;
+
+    /** Optional on-disk trace of every published frame. */
+    TelemetryRecorder recorder;
 
-    /** Interface for OS APIs. */
-    ProcData data_source;
+    /** Time spent in every `UpdatePhase`, written by the update thread and read by anyone. */
+    LatencyHistogram phase_latency[PHASE_COUNT];
 
-    /** Refresh interval. */
-    unsigned m_interval;
+    /** Reads the overlay's own footprint. Only touched by the update thread. */
+    SelfMonitor self_monitor;
 
-    /** Bytes of available system memory. */
-    int64_t m_MemTotal;
+    /** Previous reading of `self_monitor` and when it was taken, to turn CPU time into a share. Update thread only. */
+    SelfUsage last_self_usage;
+    std::chrono::steady_clock::time_point last_self_check;
+    bool has_self_usage;
 
-    /** Bytes of allocated system memory. */
-    int64_t m_MemUsed;
+    /** Source time since the tables were last scanned, see `SCAN_INTERVAL_MS`. Update thread only. */
+    double scan_elapsed_ms;
 
-    /** Bytes of memory used by current process. */
-    int64_t m_MemProc;
+    /** Last footprint of the overlay itself. */
+    SeqLock<OverheadFrame> published_overhead;
 
-    /** Thread-UNSAFE container of CPU state. */
-    std::vector<hwinfo::CPU> m_cpus;
+    /** Rolling statistics of every `StatsMetric`, in that order. Only touched by the update thread. */
+    std::vector<RollingStats> rolling_stats;
 
-    /** Separate thread that updates measurements according to `m_interval`. */
-    std::thread update_thread;
+    /** Summaries of `rolling_stats` as of the last tick, published right before `published_frame`. */
+    SeqLock<StatsFrame> published_stats;
 
-    /** Last measurement of total kernal and user time spent by the CPU. */
-    unsigned long long last_cpu_measurement;
+    /** Largest graphed I/O rate over the history window in bytes/s, `IoFrame::peak_rate`. Update thread only. */
+    RollingMax io_peak;
+
+    /** Render every tick into `metrics_page`, set while `metrics_server` runs. */
+    std::atomic<bool> metrics_enabled;
+
+    /** Scrape response of the last tick, rendered by the update thread. */
+    MetricsPage metrics_page;
+
+#ifndef _WIN32
+    /** Serves `metrics_page`, null until `serveMetrics`. Declared after the page so it stops serving first. */
+    std::unique_ptr<MetricsServer> metrics_server;
+#endif
+
+    /** Tick of the last frame appended to the histories. Only touched by the GUI thread. */
+    uint64_t recorded_tick;
+
+    /** Timestamp of the last frame appended to the histories. Only touched by the GUI thread. */
+    double m_SampleTimeMs;
+
+    /** Used memory, % of total. */
+    HistorySeries *mem_used_history;
+
+    /** Foreground memory, % of used. */
+    HistorySeries *mem_proc_history;
+
+    /** Foreground resident, unique and swapped memory, % of used memory like `mem_proc_history`. */
+    HistorySeries *mem_proc_rss_history;
+    HistorySeries *mem_proc_uss_history;
+    HistorySeries *mem_proc_swap_history;
+
+    /** Total CPU utilization, %. */
+    HistorySeries *cpu_used_history;
+
+    /** Foreground CPU utilization, % of busy time. */
+    HistorySeries *cpu_proc_history;
+
+    /** Foreground GPU utilization, % of its busiest engine. */
+    HistorySeries *gpu_proc_history;
+
+    /** Foreground storage reads and writes and the throughput of every disk together, KiB/s. */
+    HistorySeries *io_read_history;
+    HistorySeries *io_write_history;
+    HistorySeries *disk_io_history;
+
+    /** CPU utilization of every watched target, % of the machine, in watch list order. */
+    std::array<HistorySeries*, WatchTarget::MAX_TARGETS> watch_histories;
+
+    /** Samples every history is sized for at the current interval. Only touched by the GUI thread. */
+    size_t history_capacity;
+
+    /** Worker running `updateLoop`, stopped cooperatively and joined by `stopUpdates`. */
+    QThread *update_thread;
+
+    /** A `deliverFrame` is queued and has not started yet, newer frames are picked up by it. */
+    std::atomic<bool> frame_pending;
+
+    /** Frames published while a delivery was already pending, so the GUI thread never saw them on their own. */
+    std::atomic<uint64_t> coalesced_frames;
+
+    /** Missed deadline count of the last delivered frame. Only touched by the GUI thread. */
+    uint64_t last_missed_deadlines;
 
     /**
-     *  Least measurement of total time scheduled by the foreground process.
-     *  This measurement will jump around if the user tabs through applications in between updates.
+     * Refresh function. Publishes one frame per call.
+     * @return false if the source ran out, nothing is published then.
      */
-    unsigned long long last_proc_measurement;
+    bool update();
 
-    /** Total time available to the CPU, for purposes of calculating utilization. */
-    unsigned long long core_time_interval;
+    /** Loop executed by the update thread. Live ticks wait for the scheduler, replayed ones keep their own time. */
+    void updateLoop();
 
-    /** Total CPU utiliztion. */
-    double calculated_use;
+    /** Stop the update thread between ticks and join it. Idempotent. */
+    void stopUpdates();
 
-    /** Foreground CPU utilization. */
-    double calculated_proc_use;
+    /** Switch to the source handed over by `switchSource`, if any. Called by the update thread between ticks. */
+    void adoptPendingSource();
 
-    /** Last foreground process recorded. */
-    HANDLE_INT_T last_proc_handle;
+    /** Follow the watch list handed over by `switchWatches`, if any. Called by the update thread between ticks. */
+    void adoptPendingWatches();
 
-    /** Refresh function. */
-    void update();
+    /** Report the cgroups handed over by `setCgroupSelection`, if any. Called by the update thread between ticks. */
+    void adoptPendingCgroups();
 
-    /** Loop executed by the update thread. */
-    void updateLoop();
+    /** Hand a target set through `setTargetPid` to `live_source`. Called by the update thread between ticks. */
+    void adoptPendingTarget();
+
+    /** Hand `watch_targets` to the update thread under a new generation and notify. */
+    void switchWatches();
+
+    /** Append `target` to the watch list. @return Its index, -1 if the list is full. */
+    int addWatch(WatchTarget target);
+
+    /** Publish the watch list usage of `sample_frame` for `tick`, `elapsed_ms` after the previous sample. */
+    void publishWatches(uint64_t tick, double elapsed_ms);
+
+    /** Hand `next` to the update thread, null to go back to `live_source`. */
+    void switchSource(std::unique_ptr<SampleSource> next);
+
+    /** Reschedule from `frame` if adaptive sampling is on, or go back to the fixed interval once it was turned off. */
+    void adaptInterval(const MetricFrame &frame);
+
+    /** Count the time since `phase_start` towards `phase` and restart `phase_start` from now. */
+    void recordPhase(UpdatePhase phase, std::chrono::steady_clock::time_point &phase_start);
+
+    /** Refresh the overlay's own footprint if `SELF_USAGE_INTERVAL_MS` passed since the last one. */
+    void updateSelfUsage(uint64_t tick);
+
+    /**
+     * Append the newest published frame to every history and emit `frameReady`.
+     * Queued onto the GUI thread by `update`, once for however many frames were published meanwhile.
+     */
+    void deliverFrame();
+
+    /** Refresh the whole-system process table and publish its top lists for `tick`. */
+    void publishProcesses(uint64_t tick, double elapsed_ms);
+
+    /** Refresh the cgroups and publish the reported ones for `tick`. */
+    void publishCgroups(uint64_t tick, double elapsed_ms);
+
+    /** Refresh the threads of the foreground process and publish the busiest ones for `tick`. */
+    void publishThreads(uint64_t tick, double elapsed_ms);
+
+    /** Re-read the I/O counters and publish the foreground's and every disk's throughput for `frame`. */
+    void publishIo(const MetricFrame &frame);
+
+    /** Push the graphed metrics of `frame` into `rolling_stats` and publish their summaries. */
+    void publishStats(const MetricFrame &frame);
+
+    /** QML rows of `metric`, one per window: windowMs, count, min, max, avg, p95 and p99. */
+    QVariantList statsRows(StatsMetric metric) const;
+
+    /** QML rows for `count` processes: pid, name, cpu (% of one core) and memKb. */
+    static QVariantList processRows(const ProcessInfo *processes, uint32_t count);
+
+    /** Append `frame` to the recording, if one is running. Called by the update thread. */
+    void recordTelemetry(const MetricFrame &frame);
+
+    /** Render `frame` and the collectors published with it into `metrics_page`. Called by the update thread. */
+    void renderMetrics(const MetricFrame &frame);
+
+    /** Columns of a recording, see `recordTelemetry` for the values. */
+    static std::vector<TelemetryColumn> telemetryColumns();
+
+    /** Grow every history so the 60 s window fits at `interval_ms`. */
+    void reserveHistory(unsigned interval_ms);
+
+    /** Used memory as a percentage of total memory. */
+    static double memUsedPercent(const MetricFrame&);
+
+    /** Foreground memory as a percentage of used memory. */
+    static double memProcPercent(const MetricFrame&);
 
-    /** Helper function to update CPU measurements. */
-    void sampleCpuTimes();
+    /** `bytes` as a percentage of the used memory of `frame`. */
+    static double percentOfUsed(const MetricFrame &frame, int64_t bytes);
 
-    /** Checks the underlying datasource for the current handle to the foreground application. Notify if it's different from the last one. */
+    /** Publish the name of the tracked process and notify if the process changed since the last tick. */
     void sampleProcHandle();
 
+    /** Benchmarks stop the update thread and drive `update` and `MetricSampler::sampleCpuTimes` themselves. */
+    friend struct DataManagerProbe;
+
 public:
-    Q_PROPERTY(unsigned RefreshIntervalMs READ RefreshIntervalMs)
+    Q_PROPERTY(unsigned RefreshIntervalMs READ RefreshIntervalMs WRITE setRefreshIntervalMs NOTIFY refreshIntervalChanged)
+    Q_PROPERTY(bool AdaptiveSampling READ AdaptiveSampling WRITE setAdaptiveSampling NOTIFY adaptiveSamplingChanged)
+    Q_PROPERTY(quint64 MissedDeadlines READ MissedDeadlines NOTIFY notifyMissedDeadlines)
+    Q_PROPERTY(quint64 CoalescedFrames READ CoalescedFrames NOTIFY frameReady)
     Q_PROPERTY(unsigned MemTotalKb READ MemTotalKb)
-    Q_PROPERTY(unsigned MemUsedKb READ MemUsedKb NOTIFY notifyMemUsedKb)
-    Q_PROPERTY(unsigned MemProcKb READ MemProcKb NOTIFY notifyMemProcKb)
-    Q_PROPERTY(double CpuTotalUse READ CpuTotal NOTIFY notifyCpuTotal)
-    Q_PROPERTY(double CpuProcUse READ CpuProcUse NOTIFY notifyCpuProcUse)
+    Q_PROPERTY(unsigned MemUsedKb READ MemUsedKb NOTIFY frameReady)
+    Q_PROPERTY(unsigned MemProcKb READ MemProcKb NOTIFY frameReady)
+    Q_PROPERTY(unsigned MemProcRssKb READ MemProcRssKb NOTIFY frameReady)
+    Q_PROPERTY(unsigned MemProcUssKb READ MemProcUssKb NOTIFY frameReady)
+    Q_PROPERTY(unsigned MemProcSwapKb READ MemProcSwapKb NOTIFY frameReady)
+    Q_PROPERTY(bool MemProcDetailed READ MemProcDetailed NOTIFY frameReady)
+    Q_PROPERTY(double MemUsedPercent READ MemUsedPercent NOTIFY frameReady)
+    Q_PROPERTY(double MemProcPercent READ MemProcPercent NOTIFY frameReady)
+    Q_PROPERTY(double CpuTotalUse READ CpuTotal NOTIFY frameReady)
+    Q_PROPERTY(double CpuProcUse READ CpuProcUse NOTIFY frameReady)
+    Q_PROPERTY(double GpuProcUse READ GpuProcUse NOTIFY frameReady)
+    Q_PROPERTY(QList<float> CoreUse READ CoreUse NOTIFY frameReady)
+    Q_PROPERTY(double CoreMaxUse READ CoreMaxUse NOTIFY frameReady)
+    Q_PROPERTY(int CoreMaxIndex READ CoreMaxIndex NOTIFY frameReady)
+    Q_PROPERTY(int CoresAboveThreshold READ CoresAboveThreshold NOTIFY frameReady)
+    Q_PROPERTY(double CoreThreshold READ CoreThreshold WRITE setCoreThreshold NOTIFY coreThresholdChanged)
+    Q_PROPERTY(int ProcessCount READ ProcessCount NOTIFY frameReady)
+    Q_PROPERTY(QVariantList TopCpuProcesses READ TopCpuProcesses NOTIFY frameReady)
+    Q_PROPERTY(QVariantList TopMemProcesses READ TopMemProcesses NOTIFY frameReady)
+    Q_PROPERTY(QVariantList Watches READ Watches NOTIFY frameReady)
+    Q_PROPERTY(int WatchCount READ WatchCount NOTIFY watchesChanged)
+    Q_PROPERTY(int TargetPid READ TargetPid WRITE setTargetPid NOTIFY targetPidChanged)
+    Q_PROPERTY(QVariantList Cgroups READ Cgroups NOTIFY frameReady)
+    Q_PROPERTY(QStringList CgroupSelection READ CgroupSelection WRITE setCgroupSelection NOTIFY cgroupSelectionChanged)
+    Q_PROPERTY(int ThreadCount READ ThreadCount NOTIFY frameReady)
+    Q_PROPERTY(QVariantList TopThreads READ TopThreads NOTIFY frameReady)
+    Q_PROPERTY(int HotThreads READ HotThreads NOTIFY frameReady)
+    Q_PROPERTY(double IoReadKbps READ IoReadKbps NOTIFY frameReady)
+    Q_PROPERTY(double IoWriteKbps READ IoWriteKbps NOTIFY frameReady)
+    Q_PROPERTY(double IoReadOps READ IoReadOps NOTIFY frameReady)
+    Q_PROPERTY(double IoWriteOps READ IoWriteOps NOTIFY frameReady)
+    Q_PROPERTY(double IoPeakKbps READ IoPeakKbps NOTIFY frameReady)
+    Q_PROPERTY(QVariantList Disks READ Disks NOTIFY frameReady)
+    Q_PROPERTY(bool Recording READ Recording NOTIFY recordingChanged)
+    Q_PROPERTY(QString SourceName READ SourceName NOTIFY sourceChanged)
+    Q_PROPERTY(int MetricsPort READ MetricsPort NOTIFY metricsPortChanged)
+    Q_PROPERTY(QVariantList OverheadPhases READ OverheadPhases NOTIFY notifyOverhead)
+    Q_PROPERTY(double SelfCpuUse READ SelfCpuUse NOTIFY notifyOverhead)
+    Q_PROPERTY(unsigned SelfRssKb READ SelfRssKb NOTIFY notifyOverhead)
+    Q_PROPERTY(int SelfThreads READ SelfThreads NOTIFY notifyOverhead)
     Q_PROPERTY(QString ForegroundProc READ ForegroundProc NOTIFY notifyForegroundProc)
+    Q_PROPERTY(double SampleTimeMs READ SampleTimeMs NOTIFY frameReady)
+    Q_PROPERTY(QVariantList MemUsedStats READ MemUsedStats NOTIFY frameReady)
+    Q_PROPERTY(QVariantList MemProcStats READ MemProcStats NOTIFY frameReady)
+    Q_PROPERTY(QVariantList CpuTotalStats READ CpuTotalStats NOTIFY frameReady)
+    Q_PROPERTY(QVariantList CpuProcStats READ CpuProcStats NOTIFY frameReady)
+    Q_PROPERTY(QVariantList GpuProcStats READ GpuProcStats NOTIFY frameReady)
+    Q_PROPERTY(HistorySeries* MemUsedHistory READ MemUsedHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* MemProcHistory READ MemProcHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* MemProcRssHistory READ MemProcRssHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* MemProcUssHistory READ MemProcUssHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* MemProcSwapHistory READ MemProcSwapHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* CpuTotalHistory READ CpuTotalHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* CpuProcHistory READ CpuProcHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* GpuProcHistory READ GpuProcHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* IoReadHistory READ IoReadHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* IoWriteHistory READ IoWriteHistory CONSTANT)
+    Q_PROPERTY(HistorySeries* DiskIoHistory READ DiskIoHistory CONSTANT)
 
     explicit DataManager(QObject*);
     explicit DataManager();
+
+    /** Play `replay` from the first tick instead of sampling the OS, falling back to the OS when it runs out. */
+    DataManager(QObject *parent, std::unique_ptr<SampleSource> replay);
     ~DataManager();
 
     /** Return total memory available. */
@@ -106,9 +482,35 @@ public:
     /** Return total memory used. */
     unsigned MemUsedKb() const;
 
-    /** Return memory used by current foreground process. */
+    /**
+     * Return memory used by current foreground process: its proportional set where `MemProcDetailed`, so pages shared
+     * with other processes count only in part, otherwise its resident set.
+     */
     unsigned MemProcKb() const;
 
+    /** Resident set of the foreground process, shared pages counted in full. */
+    unsigned MemProcRssKb() const;
+
+    /** Memory only the foreground process maps, what closing it would give back. 0 unless `MemProcDetailed`. */
+    unsigned MemProcUssKb() const;
+
+    /** Swapped out memory of the foreground process. 0 unless `MemProcDetailed`. */
+    unsigned MemProcSwapKb() const;
+
+    /**
+     * Whether the breakdown of the foreground's memory is known, Linux only. It is read about once a second, so a
+     * process that just came into focus may go without for up to that long.
+     */
+    bool MemProcDetailed() const;
+
+    /** Used memory as a percentage of total memory, both taken from the same frame. */
+    double MemUsedPercent() const;
+
+    /** Foreground memory as a percentage of used memory, both taken from the same frame. */
+    double MemProcPercent() const;
+
+    /** Copy of the last published frame. Lock-free, safe to call from any thread. */
+    MetricFrame snapshot() const;
 
     /** Return total CPU utilization. */
     double CpuTotal();
@@ -116,18 +518,244 @@ public:
     /** CPU utilization by the current foreground process. */
     double CpuProcUse();
 
+    /** GPU utilization by the current foreground process, busy share of its busiest engine in `[0, 1]`. */
+    double GpuProcUse() const;
+
+    /** Busy ratio of every logical core in `[0, 1]`, indexed by core number. Empty where unsupported. */
+    QList<float> CoreUse() const;
+
+    /** Busy ratio of the busiest core. */
+    double CoreMaxUse() const;
+
+    /** Core number of the busiest core. */
+    int CoreMaxIndex() const;
+
+    /** Number of cores at or above `CoreThreshold`. */
+    int CoresAboveThreshold() const;
+
+    /** Busy ratio in `[0, 1]` at which a core counts as saturated, applied from the next tick. */
+    double CoreThreshold() const;
+    void setCoreThreshold(double threshold);
+
+    /** Number of processes on the system. */
+    int ProcessCount() const;
+
+    /** Busiest processes on the whole system, as rows of pid, name, cpu and memKb. */
+    QVariantList TopCpuProcesses() const;
+
+    /** Processes with the largest resident sets, same rows as `TopCpuProcesses`. */
+    QVariantList TopMemProcesses() const;
+
+    /**
+     * Process every foreground metric measures from the next tick on: CPU, memory and its breakdown, GPU, threads and
+     * I/O. 0, the default, is the overlay itself on Linux, which has no foreground window to follow across X11,
+     * Wayland and headless machines; Win32 follows the foreground window and ignores it for now.
+     */
+    int TargetPid() const;
+    void setTargetPid(int pid);
+
+    /**
+     * Watch the process `pid` from the next tick on, with a CPU history of its own. The process is told apart from a
+     * later one reusing its PID by its start time, the target stays empty once it exited.
+     * @return Index of the target in `Watches` and `watchHistory`, -1 if `WatchTarget::MAX_TARGETS` are watched already.
+     */
+    Q_INVOKABLE int watchPid(int pid);
+
+    /**
+     * Watch every process whose name matches `pattern`, `*` and `?` as in a shell, summed up into one target.
+     * Linux matches the comm of up to `WatchTarget::MAX_MATCHES` processes; Win32 only the foreground process so far.
+     */
+    Q_INVOKABLE int watchName(const QString &pattern);
+
+    /** Watch whatever process is in the foreground, the same as the foreground metrics but as a watch list entry. */
+    Q_INVOKABLE int watchForeground();
+
+    /** Stop watching target `index`, later targets and their histories move up by one. */
+    Q_INVOKABLE void unwatch(int index);
+
+    /** Number of watched targets. */
+    int WatchCount() const;
+
+    /**
+     * One row per watched target: label, pid, name and matches, cpu (% of the machine), memKb, ioReadKbps and
+     * ioWriteKbps.
+     * Targets added or moved since the last tick report no usage yet.
+     */
+    QVariantList Watches() const;
+
+    /** CPU history of watched target `index`, % of the machine. Null past the end of the list. */
+    Q_INVOKABLE HistorySeries* watchHistory(int index) const;
+
+    /**
+     * Selected cgroups first, then the busiest and the largest leaf groups, see `CgroupTable::reported`. Rows of path,
+     * selected, cpu (% of one core), cpuLimit (cores, 0 if unlimited), cpuLimitPercent, throttled (% of the interval),
+     * memKb, memMaxKb (0 if unlimited), memLimitPercent, anonKb, fileKb, ioReadKbps and ioWriteKbps.
+     * The limit percentages are 0 without a limit. Empty where there is no cgroup v2 hierarchy and during replays.
+     */
+    QVariantList Cgroups() const;
+
+    /** cgroup paths below the hierarchy root to report on every tick, up to `CgroupTable::MAX_SELECTED`. */
+    QStringList CgroupSelection() const;
+    void setCgroupSelection(const QStringList &paths);
+
+    /** Number of threads of the foreground process, 0 on Win32 and during replays. */
+    int ThreadCount() const;
+
+    /**
+     * Busiest threads of the foreground process, as rows of tid, name, cpu (% of one core) and hot. A thread is hot
+     * when it keeps a core busy past `CoreThreshold` on its own, the usual sign of a spinning or serialized thread.
+     */
+    QVariantList TopThreads() const;
+
+    /** Threads of `TopThreads` that are hot. */
+    int HotThreads() const;
+
+    /**
+     * Storage throughput of the foreground process in KiB/s and its read and write system calls per second, 0 on
+     * Win32, during replays and for processes of other users.
+     */
+    double IoReadKbps() const;
+    double IoWriteKbps() const;
+    double IoReadOps() const;
+    double IoWriteOps() const;
+
+    /** Largest rate of the I/O histories over the last minute in KiB/s, the I/O graph scales its axis to it. */
+    double IoPeakKbps() const;
+
+    /**
+     * One row per whole disk: name, readKbps, writeKbps, readOps, writeOps, busy (% of the interval) and stacked,
+     * true for dm and md devices whose I/O the disks below them count as well.
+     */
+    QVariantList Disks() const;
+
+    /**
+     * Record every following frame to a compressed telemetry file at `path`, replacing it.
+     * A running recording is finished first. Readable with `TelemetryReader`.
+     */
+    Q_INVOKABLE bool startRecording(const QString &path);
+
+    /** Finish the recording, writing its index. */
+    Q_INVOKABLE void stopRecording();
+
+    /** True while frames are being recorded. */
+    bool Recording();
+
+    /**
+     * Play a file written by `startRecording` in place of the OS, from the next tick.
+     * @param as_fast_as_possible Deliver ticks back to back instead of at their recorded pace.
+     * @return false if the file is not a readable recording.
+     */
+    Q_INVOKABLE bool replayRecording(const QString &path, bool as_fast_as_possible);
+
+    /**
+     * Play generated load in place of the OS, from the next tick, at the current refresh interval until `sampleLive`.
+     * @param pattern "ramp" or "spikes".
+     * @param cores Logical cores to simulate.
+     * @return false for an unknown pattern.
+     */
+    Q_INVOKABLE bool replaySynthetic(const QString &pattern, int cores, bool as_fast_as_possible);
+
+    /** Go back to sampling the OS from the next tick. */
+    Q_INVOKABLE void sampleLive();
+
+    /**
+     * Serve the Prometheus exposition of every tick on 127.0.0.1:`port`, 0 for a free port, replacing a running server.
+     * The page is rendered by the update thread once per tick, scrapes only copy it out. Linux only.
+     * @return false if the port could not be bound.
+     */
+    Q_INVOKABLE bool serveMetrics(int port);
+
+    /** Stop serving metrics and rendering them. */
+    Q_INVOKABLE void stopMetrics();
+
+    /** Port `/metrics` is served on, 0 when not serving. */
+    int MetricsPort() const;
+
+    /** "live", the recording's file name, or the synthetic pattern and core count. */
+    QString SourceName();
+
+    /** Latency of `phase` over every tick so far. Safe to read from any thread. */
+    const LatencyHistogram& phaseLatency(UpdatePhase phase) const;
+
+    /** One row per `UpdatePhase`: phase, count, and p50Us, p99Us and maxUs in microseconds. */
+    QVariantList OverheadPhases() const;
+
+    /** CPU used by the overlay itself, % of one core, over the last second or so. */
+    double SelfCpuUse() const;
+
+    /** Resident memory of the overlay itself. */
+    unsigned SelfRssKb() const;
+
+    /** Threads of the overlay itself. */
+    int SelfThreads() const;
+
+    /** Plain text table of every phase's latency and the overlay's own footprint, for logs and bug reports. */
+    Q_INVOKABLE QString overheadReport() const;
+
     /** Returns the name of the foreground process. **/
-    QString ForegroundProc();
+    QString ForegroundProc() const;
 
-    /** Get refresh intervale of the the update loop. */
+    /** Get refresh intervale of the the update loop, when not sampling adaptively. */
     unsigned RefreshIntervalMs() const;
 
+    /** Change the refresh interval while running, clamped to 1 ms - 10 s. Takes effect once adaptive sampling is off. */
+    void setRefreshIntervalMs(unsigned interval_ms);
+
+    /**
+     * Whether live ticks follow the metrics instead of `RefreshIntervalMs`: fast while anything changes or the busiest
+     * core nears `CoreThreshold`, backing off to seconds while everything is flat. Replays keep their own pace.
+     * Histories keep their timestamps, so graphs stay true over the uneven spacing.
+     */
+    bool AdaptiveSampling() const;
+    void setAdaptiveSampling(bool enabled);
+
+    /** Number of sampling deadlines skipped because a tick overran. */
+    quint64 MissedDeadlines() const;
+
+    /** Frames the GUI thread skipped because it was still busy with an earlier one. */
+    quint64 CoalescedFrames() const;
+
+    /** Timestamp of the newest point in the histories, graphs use it as "now" for their x axis. */
+    double SampleTimeMs() const;
+
+    /**
+     * Rolling statistics of each graph over the last 1 s, 10 s and 60 s, rows as in `statsRows`. Every tick counts,
+     * including those the GUI thread skipped, in the unit of the matching history.
+     */
+    QVariantList MemUsedStats() const;
+    QVariantList MemProcStats() const;
+    QVariantList CpuTotalStats() const;
+    QVariantList CpuProcStats() const;
+    QVariantList GpuProcStats() const;
+
+    HistorySeries* MemUsedHistory() const;
+    HistorySeries* MemProcHistory() const;
+    HistorySeries* MemProcRssHistory() const;
+    HistorySeries* MemProcUssHistory() const;
+    HistorySeries* MemProcSwapHistory() const;
+    HistorySeries* CpuTotalHistory() const;
+    HistorySeries* CpuProcHistory() const;
+    HistorySeries* GpuProcHistory() const;
+    HistorySeries* IoReadHistory() const;
+    HistorySeries* IoWriteHistory() const;
+    HistorySeries* DiskIoHistory() const;
+
 signals:
-    void notifyMemUsedKb();
-    void notifyMemProcKb();
-    void notifyCpuTotal();
-    void notifyCpuProcUse();
+    /** A newer frame was published, emitted on the GUI thread. Every per-tick property notifies through it. */
+    void frameReady();
+    void coreThresholdChanged();
+    void recordingChanged();
+    void sourceChanged();
+    void metricsPortChanged();
+    void replayFinished();
     void notifyForegroundProc(QString);
+    void refreshIntervalChanged();
+    void adaptiveSamplingChanged();
+    void watchesChanged();
+    void targetPidChanged();
+    void cgroupSelectionChanged();
+    void notifyMissedDeadlines();
+    void notifyOverhead();
 };
 
 #endif // DATAMANAGER_H
@@ -0,0 +1,106 @@
+#include "decimator.h"
+
+#include <cmath>
+
+unsigned MinMaxDecimator::Bucket::pointCount() const {
+    // Flat buckets keep their first sample as both min and max
+    return (min.x == max.x && min.y == max.y) ? 1 : 2;
+}
+
+unsigned MinMaxDecimator::Bucket::points(SeriesPoint out[2]) const {
+    if (pointCount() == 1) {
+        out[0] = min;
+        return 1;
+    }
+    if (min.x <= max.x) {
+        out[0] = min;
+        out[1] = max;
+    } else {
+        out[0] = max;
+        out[1] = min;
+    }
+    return 2;
+}
+
+MinMaxDecimator::MinMaxDecimator(double windowMs, unsigned bucketCount) {
+    reset(windowMs, bucketCount);
+}
+
+void MinMaxDecimator::reset(double windowMs, unsigned bucketCount) {
+    if (bucketCount == 0)
+        bucketCount = 1;
+
+    window_ms = windowMs;
+    bucket_ms = windowMs / bucketCount;
+    // The window straddles a partial bucket at either edge
+    closed.reset(bucketCount + 2);
+    open = Bucket {};
+    has_open = false;
+    point_count = 0;
+}
+
+long long MinMaxDecimator::bucketIndex(double x) const {
+    return static_cast<long long>(std::floor(x / bucket_ms));
+}
+
+MinMaxDecimator::Delta MinMaxDecimator::append(double x, double y) {
+    Delta delta {};
+    const SeriesPoint sample {x, y};
+    const long long index = bucketIndex(x);
+
+    if (has_open && index == open.index) {
+        bool changed = false;
+        unsigned before = open.pointCount();
+
+        if (y < open.min.y) {
+            open.min = sample;
+            changed = true;
+        }
+        if (y > open.max.y) {
+            open.max = sample;
+            changed = true;
+        }
+        open.samples++;
+
+        // Most samples at high refresh rates land inside the current extremes and cost nothing downstream
+        if (changed) {
+            delta.removed_back = before;
+            delta.appended_count = open.points(delta.appended);
+            point_count = point_count - before + delta.appended_count;
+        }
+    } else {
+        if (has_open) {
+            if (closed.full()) {
+                unsigned dropped = closed.front().pointCount();
+                delta.removed_front += dropped;
+                point_count -= dropped;
+                closed.popFront();
+            }
+            closed.push(open);
+        }
+
+        open = Bucket {index, sample, sample, 1};
+        has_open = true;
+        delta.appended_count = open.points(delta.appended);
+        point_count += delta.appended_count;
+    }
+
+    // Keep the newest bucket that is already out of view so the line still reaches the left edge
+    const double cutoff = x - window_ms;
+    while (closed.size() > 1 && static_cast<double>(closed[1].index + 1) * bucket_ms <= cutoff) {
+        unsigned dropped = closed.front().pointCount();
+        delta.removed_front += dropped;
+        point_count -= dropped;
+        closed.popFront();
+    }
+
+    return delta;
+}
+
+size_t MinMaxDecimator::size() const {
+    return point_count;
+}
+
+unsigned MinMaxDecimator::bucketCount() const {
+    return static_cast<unsigned>(closed.capacity() - 2);
+}
@@ -0,0 +1,99 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cstddef>
+
+#include "ringbuffer.h"
+
+/** Plain (x, y) pair so the decimator does not depend on Qt. */
+struct SeriesPoint {
+    double x;
+    double y;
+};
+
+/**
+ * Incremental min/max downsampling of a sliding time window.
+ * The window is cut into `bucket_count` fixed-width buckets aligned to absolute time, so a bucket never changes once
+ * it is closed and the output does not shimmer as the graph scrolls. Each bucket contributes its minimum and maximum
+ * in time order, which keeps single-sample spikes visible while capping the output at about two points per bucket.
+ *
+ * Every `append` returns a `Delta` describing how the output changed, letting a caller mirror it in a graph series
+ * with O(1) edits at either end instead of re-uploading the whole window.
+ */
+class MinMaxDecimator {
+public:
+    /** Output edits, to be applied in order: drop from the front, drop from the back, then append. */
+    struct Delta {
+        size_t removed_front;
+        size_t removed_back;
+        unsigned appended_count;
+        SeriesPoint appended[2];
+    };
+
+private:
+    struct Bucket {
+        /** Index of the bucket on the absolute time grid. */
+        long long index;
+        SeriesPoint min;
+        SeriesPoint max;
+        unsigned samples;
+
+        /** 1 or 2 output points. */
+        unsigned pointCount() const;
+
+        /** Output points in time order, returns how many were written. */
+        unsigned points(SeriesPoint out[2]) const;
+    };
+
+    double window_ms;
+    double bucket_ms;
+
+    /** Buckets that will not receive any more samples, oldest first. */
+    RingBuffer<Bucket> closed;
+
+    /** Bucket the newest sample went into. */
+    Bucket open;
+
+    bool has_open;
+
+    /** Total number of output points. */
+    size_t point_count;
+
+    long long bucketIndex(double x) const;
+
+public:
+    /**
+     * @param windowMs Width of the visible window.
+     * @param bucketCount Number of buckets across the window, usually the graph's width in pixels.
+     */
+    MinMaxDecimator(double windowMs, unsigned bucketCount);
+
+    /** Drop everything and change the bucket layout. */
+    void reset(double windowMs, unsigned bucketCount);
+
+    /** Add a sample. Samples must arrive in non-decreasing `x`. */
+    Delta append(double x, double y);
+
+    /** Number of output points. */
+    size_t size() const;
+
+    unsigned bucketCount() const;
+
+    /** Visit every output point oldest first. O(n), meant for (re)binding a series. */
+    template <typename Fn>
+    void forEachPoint(Fn &&visit) const {
+        SeriesPoint scratch[2];
+        for (size_t i = 0; i < closed.size(); i++) {
+            unsigned count = closed[i].points(scratch);
+            for (unsigned j = 0; j < count; j++)
+                visit(scratch[j]);
+        }
+        if (has_open) {
+            unsigned count = open.points(scratch);
+            for (unsigned j = 0; j < count; j++)
+                visit(scratch[j]);
+        }
+    }
+};
+
+#endif // DECIMATOR_H
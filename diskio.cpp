@@ -0,0 +1,197 @@
+#include "diskio.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+/** `/proc/diskstats` counts in 512 byte sectors whatever the device's own sector size. */
+constexpr unsigned long long SECTOR_SIZE = 512;
+
+constexpr double MILLISEC_PER_SEC = 1000.0;
+
+double perSecond(unsigned long long before, unsigned long long after, double elapsed_seconds) {
+    return after > before ? static_cast<double>(after - before) / elapsed_seconds : 0.0;
+}
+
+bool startsWith(const char *cur, const char *end, const char *key, size_t length) {
+    return static_cast<size_t>(end - cur) >= length && std::memcmp(cur, key, length) == 0;
+}
+
+} // namespace
+
+IoRate ioRate(const IoCounters &before, const IoCounters &after, double elapsed_seconds) {
+    IoRate rate {};
+    if (elapsed_seconds <= 0.0)
+        return rate;
+    rate.read_rate = perSecond(before.read_bytes, after.read_bytes, elapsed_seconds);
+    rate.write_rate = perSecond(before.write_bytes, after.write_bytes, elapsed_seconds);
+    rate.read_ops = perSecond(before.read_ops, after.read_ops, elapsed_seconds);
+    rate.write_ops = perSecond(before.write_ops, after.write_ops, elapsed_seconds);
+    return rate;
+}
+
+bool parseProcessIo(const char *text, size_t size, IoCounters &out) {
+    out = IoCounters{};
+    const char *end = text + size;
+
+    // "rchar: 123" and so on, one key per line in a fixed order. rchar and wchar include page cache hits, skip them.
+    unsigned found = 0;
+    for (const char *cur = text; cur < end; cur = ProcFile::nextLine(cur, end)) {
+        unsigned long long *target = nullptr;
+        size_t length = 0;
+        switch (*cur) {
+        case 'r':
+            if (startsWith(cur, end, "read_bytes:", 11)) {
+                target = &out.read_bytes;
+                length = 11;
+            }
+            break;
+        case 'w':
+            if (startsWith(cur, end, "write_bytes:", 12)) {
+                target = &out.write_bytes;
+                length = 12;
+            }
+            break;
+        case 's':
+            if (startsWith(cur, end, "syscr:", 6)) {
+                target = &out.read_ops;
+                length = 6;
+            } else if (startsWith(cur, end, "syscw:", 6)) {
+                target = &out.write_ops;
+                length = 6;
+            }
+            break;
+        default:
+            break;
+        }
+        if (target != nullptr) {
+            ProcFile::parseUnsigned(cur + length, end, *target);
+            found++;
+        }
+    }
+    return found > 0;
+}
+
+DiskStats::DiskStats(const char *diskstats_path, const char *sys_block_path):
+    sys_block_fd{-1},
+    buffer(INITIAL_LINES * LINE_SIZE),
+    refreshes{0}
+{
+    diskstats.open(diskstats_path);
+    sys_block_fd = ::open(sys_block_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    reported.reserve(MAX_DISKS);
+}
+
+DiskStats::~DiskStats() {
+    if (sys_block_fd >= 0)
+        ::close(sys_block_fd);
+}
+
+bool DiskStats::isOpen() const {
+    return diskstats.isOpen();
+}
+
+bool DiskStats::isWholeDisk(const char *name, size_t length, bool &stacked) const {
+    stacked = false;
+    if (sys_block_fd < 0)
+        return true;
+
+    // sysfs spells the slash of names like "cciss/c0d0" as '!'
+    char entry[DiskInfo::NAME_SIZE + sizeof("/slaves")];
+    length = std::min(length, DiskInfo::NAME_SIZE - 1);
+    std::memcpy(entry, name, length);
+    entry[length] = '\0';
+    std::replace(entry, entry + length, '/', '!');
+    if (faccessat(sys_block_fd, entry, F_OK, 0) != 0)
+        return false;
+
+    // dm and md devices list the devices they are built on, the same I/O shows up on those
+    std::memcpy(entry + length, "/slaves", sizeof("/slaves"));
+    const int slaves_fd = openat(sys_block_fd, entry, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (slaves_fd < 0)
+        return true;
+    DIR *slaves = fdopendir(slaves_fd);
+    if (slaves == nullptr) {
+        ::close(slaves_fd);
+        return true;
+    }
+    while (const dirent *slave = readdir(slaves)) {
+        if (std::strcmp(slave->d_name, ".") != 0 && std::strcmp(slave->d_name, "..") != 0) {
+            stacked = true;
+            break;
+        }
+    }
+    closedir(slaves);
+    return true;
+}
+
+bool DiskStats::refresh(double elapsed_seconds) {
+    reported.clear();
+
+    const long read_size = diskstats.readAll(buffer);
+    if (read_size <= 0)
+        return false;
+    refreshes++;
+
+    const char *end = buffer.data() + read_size;
+    for (const char *cur = buffer.data(); cur < end; cur = ProcFile::nextLine(cur, end)) {
+        // "major minor name reads merged sectors ms writes merged sectors ms in_flight io_ms ..."
+        unsigned long long major = 0, minor = 0;
+        cur = ProcFile::parseUnsigned(cur, end, major);
+        cur = ProcFile::parseUnsigned(cur, end, minor);
+        const char *name = ProcFile::skipBlanks(cur, end);
+        cur = name;
+        while (cur < end && *cur != ' ' && *cur != '\t' && *cur != '\n')
+            cur++;
+        const size_t name_length = static_cast<size_t>(cur - name);
+        if (name_length == 0)
+            continue;
+
+        unsigned long long fields[10] = {};
+        for (unsigned long long &field : fields)
+            cur = ProcFile::parseUnsigned(cur, end, field);
+
+        const uint32_t key = static_cast<uint32_t>(major << 20 | (minor & 0xfffff));
+        Device *device = devices.find(key);
+        if (device == nullptr) {
+            Device fresh;
+            fresh.whole = isWholeDisk(name, name_length, fresh.stacked);
+            device = &devices.insert(key, std::move(fresh));
+        }
+        if (!device->whole)
+            continue;
+
+        IoCounters counters {};
+        counters.read_ops = fields[0];
+        counters.read_bytes = fields[2] * SECTOR_SIZE;
+        counters.write_ops = fields[4];
+        counters.write_bytes = fields[6] * SECTOR_SIZE;
+        const unsigned long long busy_ms = fields[9];
+
+        DiskInfo info {};
+        const size_t copied = std::min(name_length, DiskInfo::NAME_SIZE - 1);
+        std::memcpy(info.name, name, copied);
+        info.stacked = device->stacked;
+        if (device->read_at != 0 && device->read_at + 1 == refreshes && elapsed_seconds > 0.0) {
+            info.rate = ioRate(device->counters, counters, elapsed_seconds);
+            const double busy = perSecond(device->busy_ms, busy_ms, elapsed_seconds) / MILLISEC_PER_SEC;
+            info.busy = static_cast<float>(std::min(1.0, busy));
+        }
+        device->counters = counters;
+        device->busy_ms = busy_ms;
+        device->read_at = refreshes;
+
+        if (counters.read_ops + counters.write_ops > 0 && reported.size() < MAX_DISKS)
+            reported.push_back(info);
+    }
+    return true;
+}
+
+const std::vector<DiskInfo>& DiskStats::disks() const {
+    return reported;
+}
@@ -0,0 +1,138 @@
+#ifndef DISKIO_H
+#define DISKIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flathashmap.h"
+#include "procfile.h"
+
+/** Cumulative I/O counters of a process or a block device. */
+struct IoCounters {
+    unsigned long long read_bytes;
+    unsigned long long write_bytes;
+    unsigned long long read_ops;
+    unsigned long long write_ops;
+};
+
+/** Throughput over the last interval. Plain data so it can be published through a `SeqLock`. */
+struct IoRate {
+    /** Bytes per second read from and written to storage. */
+    double read_rate;
+    double write_rate;
+
+    /** Operations per second: read and write system calls for a process, completed requests for a device. */
+    double read_ops;
+    double write_ops;
+};
+
+/** Rates between two reads of the same counters `elapsed_seconds` apart. A counter that went backwards counts as 0. */
+IoRate ioRate(const IoCounters &before, const IoCounters &after, double elapsed_seconds);
+
+/** Add the rates of `other` to `sum`, for targets made of several processes. Inline so Win32 builds have it too. */
+inline void addIoRate(IoRate &sum, const IoRate &other) {
+    sum.read_rate += other.read_rate;
+    sum.write_rate += other.write_rate;
+    sum.read_ops += other.read_ops;
+    sum.write_ops += other.write_ops;
+}
+
+/**
+ * Fill `out` from the text of `/proc/<pid>/io`: `read_bytes` and `write_bytes`, what actually reached the storage
+ * layer rather than the page cache, and `syscr` and `syscw` for the operations.
+ * @return false if the text has none of them, the process may belong to another user then.
+ */
+bool parseProcessIo(const char *text, size_t size, IoCounters &out);
+
+/** One block device over the last interval. */
+struct DiskInfo {
+    /** Kernel device names are short, dm and nvme ones included. */
+    static constexpr size_t NAME_SIZE = 32;
+
+    /** Null-terminated name as in `/proc/diskstats`. */
+    char name[NAME_SIZE];
+
+    IoRate rate;
+
+    /** Share of the interval the device had requests in flight, from the time spent doing I/O. `[0, 1]`. */
+    float busy;
+
+    /** Built on other devices, like dm and md ones are. Its I/O is counted again on the devices below it. */
+    bool stacked;
+};
+
+/**
+ * Throughput of every whole block device from `/proc/diskstats`, opened once and re-read to the end with `pread` into
+ * a buffer that only grows if the file outgrows it. Lines are parsed in place, and the counters of every device are
+ * kept in a flat hash map keyed by its device number, so a steady-state refresh allocates nothing.
+ *
+ * Partitions would count their I/O a second time on top of their disk, so only devices that `/sys/block` lists are
+ * reported; that is looked up once per device number, along with whether the device is stacked on others. Devices
+ * that have not done any I/O yet, like unused loop and ram devices, are left out as well. Linux only: both paths are
+ * parameters so tests can point them at fixtures.
+ */
+class DiskStats {
+
+    struct Device {
+        IoCounters counters = {};
+
+        /** Milliseconds spent doing I/O. */
+        unsigned long long busy_ms = 0;
+
+        /** `refreshes` of the refresh that last read the counters. */
+        uint64_t read_at = 0;
+
+        /** Listed in `/sys/block`, not a partition. */
+        bool whole = false;
+
+        /** Has entries in `/sys/block/<name>/slaves`. */
+        bool stacked = false;
+    };
+
+    /** Room per line of `/proc/diskstats`: a name and up to twenty counters. */
+    static constexpr size_t LINE_SIZE = 256;
+
+    /** Lines the buffer is sized for at first, machines with more devices grow it once. */
+    static constexpr size_t INITIAL_LINES = 64;
+
+    ProcFile diskstats;
+
+    /** Directory descriptor of `/sys/block`, -1 if it could not be opened. Then every device counts as whole. */
+    int sys_block_fd;
+
+    FlatHashMap<uint32_t, Device> devices;
+
+    std::vector<char> buffer;
+
+    uint64_t refreshes;
+
+    std::vector<DiskInfo> reported;
+
+    /** Whether `/sys/block` lists the device called `name`, and if so whether it is stacked on other devices. */
+    bool isWholeDisk(const char *name, size_t length, bool &stacked) const;
+
+public:
+    /** Devices beyond this are not reported, `IoFrame` has room for this many. */
+    static constexpr size_t MAX_DISKS = 16;
+
+    explicit DiskStats(const char *diskstats_path = "/proc/diskstats", const char *sys_block_path = "/sys/block");
+    ~DiskStats();
+
+    DiskStats(const DiskStats&) = delete;
+    DiskStats& operator=(const DiskStats&) = delete;
+
+    bool isOpen() const;
+
+    /**
+     * Re-read every device and update the rates.
+     * @param elapsed_seconds Time since the previous refresh, rates are 0 when this is 0.
+     * @return false if the file could not be read, nothing is reported then.
+     */
+    bool refresh(double elapsed_seconds);
+
+    /** Whole devices of the last refresh, in the order of `/proc/diskstats`. At most `MAX_DISKS`. */
+    const std::vector<DiskInfo>& disks() const;
+};
+
+#endif // DISKIO_H
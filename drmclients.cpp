@@ -0,0 +1,230 @@
+#include "drmclients.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char CLIENT_ID_KEY[] = "drm-client-id:";
+constexpr char PDEV_KEY[] = "drm-pdev:";
+constexpr char CAPACITY_PREFIX[] = "drm-engine-capacity-";
+constexpr char ENGINE_PREFIX[] = "drm-engine-";
+
+bool startsWith(const char *cur, const char *end, const char *prefix, size_t length) {
+    return static_cast<size_t>(end - cur) >= length && std::memcmp(cur, prefix, length) == 0;
+}
+
+/** Copy `[cur, end)` into `out`, truncated to fit. */
+void copyField(const char *cur, const char *end, char *out, size_t size) {
+    size_t length = std::min(static_cast<size_t>(end - cur), size - 1);
+    std::memcpy(out, cur, length);
+    out[length] = '\0';
+}
+
+} // namespace
+
+DrmClientTable::DrmClientTable(const char *proc_root): last_clients{0}, scans{0} {
+    root_fd = ::open(proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+DrmClientTable::~DrmClientTable() {
+    if (root_fd >= 0)
+        ::close(root_fd);
+}
+
+void DrmClientTable::forget(int32_t pid) {
+    processes.erase(pid);
+}
+
+const std::vector<DrmEngineUse>& DrmClientTable::engines() const {
+    return last_engines;
+}
+
+size_t DrmClientTable::clientCount() const {
+    return last_clients;
+}
+
+uint64_t DrmClientTable::scanCount() const {
+    return scans;
+}
+
+bool DrmClientTable::parse(const char *text, size_t size, Client &client) {
+    const char *cur = text;
+    const char *end = text + size;
+    bool is_drm = false;
+
+    while (cur < end) {
+        const char *line_end = static_cast<const char*>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+        if (line_end == nullptr)
+            line_end = end;
+
+        if (startsWith(cur, line_end, CLIENT_ID_KEY, sizeof(CLIENT_ID_KEY) - 1)) {
+            ProcFile::parseUnsigned(cur + sizeof(CLIENT_ID_KEY) - 1, line_end, client.client_id);
+            is_drm = true;
+        } else if (startsWith(cur, line_end, PDEV_KEY, sizeof(PDEV_KEY) - 1)) {
+            const char *value = ProcFile::skipBlanks(cur + sizeof(PDEV_KEY) - 1, line_end);
+            copyField(value, line_end, client.pdev, sizeof(client.pdev));
+        } else if (startsWith(cur, line_end, ENGINE_PREFIX, sizeof(ENGINE_PREFIX) - 1)) {
+            // Both "drm-engine-<name>: <ns> ns" and "drm-engine-capacity-<name>: <count>"
+            const bool capacity = startsWith(cur, line_end, CAPACITY_PREFIX, sizeof(CAPACITY_PREFIX) - 1);
+            const char *name = cur + (capacity ? sizeof(CAPACITY_PREFIX) : sizeof(ENGINE_PREFIX)) - 1;
+            const char *colon = static_cast<const char*>(std::memchr(name, ':', static_cast<size_t>(line_end - name)));
+            if (colon != nullptr && colon > name) {
+                char engine_name[DrmEngineUse::NAME_SIZE];
+                copyField(name, colon, engine_name, sizeof(engine_name));
+
+                auto engine = std::find_if(client.engines.begin(), client.engines.end(), [&](const Engine &known) {
+                    return std::strcmp(known.name, engine_name) == 0;
+                });
+                if (engine == client.engines.end()) {
+                    client.engines.emplace_back();
+                    engine = client.engines.end() - 1;
+                    std::memcpy(engine->name, engine_name, sizeof(engine_name));
+                }
+
+                unsigned long long value = 0;
+                ProcFile::parseUnsigned(colon + 1, line_end, value);
+                if (capacity)
+                    engine->capacity = std::max(value, 1ull);
+                else
+                    engine->busy_ns = value;
+            }
+        }
+        cur = line_end + 1;
+    }
+    return is_drm;
+}
+
+void DrmClientTable::scan(int32_t pid, Process &process) {
+    scans++;
+
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d/fdinfo", static_cast<int>(pid));
+    std::vector<Client> found;
+
+    int dir_fd = root_fd >= 0 ? ::openat(root_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+    DIR *dir = dir_fd >= 0 ? fdopendir(dir_fd) : nullptr;
+    if (dir == nullptr && dir_fd >= 0)
+        ::close(dir_fd);
+
+    while (dir != nullptr) {
+        const dirent *entry = readdir(dir);
+        if (entry == nullptr)
+            break;
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+            continue;
+
+        Client client;
+        if (!client.fdinfo.openAt(dirfd(dir), entry->d_name))
+            continue;
+        long read_size = client.fdinfo.readInto(buffer, FDINFO_BUFFER_SIZE);
+        if (read_size <= 0 || !parse(buffer, static_cast<size_t>(read_size), client))
+            continue;
+        client.fd_number = std::strtoul(entry->d_name, nullptr, 10);
+
+        // The same client on the same descriptor keeps its baselines
+        for (const Client &known : process.clients) {
+            if (known.fd_number != client.fd_number || known.client_id != client.client_id ||
+                std::strcmp(known.pdev, client.pdev) != 0)
+                continue;
+            for (Engine &engine : client.engines) {
+                for (const Engine &previous : known.engines) {
+                    if (std::strcmp(previous.name, engine.name) == 0) {
+                        engine.has_previous = previous.has_previous;
+                        engine.previous_ns = previous.previous_ns;
+                    }
+                }
+            }
+            break;
+        }
+        found.push_back(std::move(client));
+    }
+    if (dir != nullptr)
+        closedir(dir);
+
+    process.clients = std::move(found);
+}
+
+bool DrmClientTable::readClients(Process &process) {
+    for (Client &client : process.clients) {
+        long read_size = client.fdinfo.readInto(buffer, FDINFO_BUFFER_SIZE);
+        if (read_size <= 0)
+            return false;
+
+        // A reused descriptor number may now be another device or no device at all
+        const unsigned long long client_id = client.client_id;
+        if (!parse(buffer, static_cast<size_t>(read_size), client) || client.client_id != client_id)
+            return false;
+    }
+    return true;
+}
+
+double DrmClientTable::update(int32_t pid, int64_t time_us) {
+    Process *process = processes.find(pid);
+    if (process == nullptr) {
+        if (processes.size() >= MAX_CACHED_PROCESSES)
+            processes.clear();
+        process = &processes.insert(pid, Process{});
+        scan(pid, *process);
+        process->scanned_us = time_us;
+    } else if (time_us - process->scanned_us >= RESCAN_INTERVAL_US || !readClients(*process)) {
+        scan(pid, *process);
+        process->scanned_us = time_us;
+    }
+
+    const double elapsed_ns = process->has_previous ? static_cast<double>(time_us - process->previous_us) * 1000.0 : 0.0;
+    process->previous_us = time_us;
+    process->has_previous = true;
+
+    last_engines.clear();
+    engine_busy_ns.clear();
+    engine_capacity.clear();
+    last_clients = 0;
+
+    const auto &clients = process->clients;
+    for (size_t i = 0; i < clients.size(); i++) {
+        const Client &client = clients[i];
+        const bool duplicate = std::any_of(clients.begin(), clients.begin() + i, [&](const Client &other) {
+            return other.client_id == client.client_id && std::strcmp(other.pdev, client.pdev) == 0;
+        });
+
+        for (Engine &engine : process->clients[i].engines) {
+            const unsigned long long delta = engine.has_previous && engine.busy_ns > engine.previous_ns ?
+                engine.busy_ns - engine.previous_ns : 0;
+            engine.previous_ns = engine.busy_ns;
+            engine.has_previous = true;
+            if (duplicate)
+                continue;
+
+            size_t slot = 0;
+            while (slot < last_engines.size() && std::strcmp(last_engines[slot].name, engine.name) != 0)
+                slot++;
+            if (slot == last_engines.size()) {
+                DrmEngineUse use {};
+                std::memcpy(use.name, engine.name, sizeof(use.name));
+                last_engines.push_back(use);
+                engine_busy_ns.push_back(0);
+                engine_capacity.push_back(1);
+            }
+            engine_busy_ns[slot] += delta;
+            engine_capacity[slot] = std::max(engine_capacity[slot], engine.capacity);
+        }
+        if (!duplicate)
+            last_clients++;
+    }
+
+    double busiest = 0.0;
+    for (size_t slot = 0; slot < last_engines.size(); slot++) {
+        double use = 0.0;
+        if (elapsed_ns > 0.0)
+            use = std::min(1.0, static_cast<double>(engine_busy_ns[slot]) / (elapsed_ns * engine_capacity[slot]));
+        last_engines[slot].use = static_cast<float>(use);
+        busiest = std::max(busiest, use);
+    }
+    return busiest;
+}
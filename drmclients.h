@@ -0,0 +1,126 @@
+#ifndef DRMCLIENTS_H
+#define DRMCLIENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flathashmap.h"
+#include "procfile.h"
+
+/** Utilization of one GPU engine class by one process over the last interval. */
+struct DrmEngineUse {
+    static constexpr size_t NAME_SIZE = 24;
+
+    /** Null-terminated engine name as the driver reports it, "render", "video", "gfx", ... */
+    char name[NAME_SIZE];
+
+    /** Busy share of the engine class in `[0, 1]`, normalized by its capacity. */
+    float use;
+};
+
+/**
+ * Per-process GPU engine utilization from the DRM usage stats in `/proc/<pid>/fdinfo/<fd>`.
+ * Drivers that implement them list a `drm-client-id` and one `drm-engine-<name>: <ns> ns` busy counter per engine
+ * class for every open DRM file; utilization is the growth of those counters over the measured interval.
+ *
+ * Scanning a process's fd directory is one open and read per descriptor, so it is done when a process is first seen,
+ * when one of its known DRM descriptors stops reading as one, and otherwise every `RESCAN_INTERVAL_US` to pick up
+ * newly opened devices. In between only the `fdinfo` files already known to be DRM are re-read, through descriptors
+ * kept open. Descriptors that share a client, e.g. after `dup`, are counted once.
+ *
+ * Drivers that only report `drm-cycles-*` have no nanosecond counters and read as idle.
+ * Linux only: the root is a parameter so tests can point it at a fixture tree.
+ */
+class DrmClientTable {
+public:
+    /** Rescan the fd directory of a tracked process at least this often. */
+    static constexpr int64_t RESCAN_INTERVAL_US = 5 * 1000 * 1000;
+
+    /** Processes whose DRM descriptors are remembered, the cache is dropped as a whole past this. */
+    static constexpr size_t MAX_CACHED_PROCESSES = 16;
+
+    explicit DrmClientTable(const char *proc_root = "/proc");
+    ~DrmClientTable();
+
+    DrmClientTable(const DrmClientTable&) = delete;
+    DrmClientTable& operator=(const DrmClientTable&) = delete;
+
+    /**
+     * Re-read the DRM clients of `pid` and work out its engine utilization since the previous call for it.
+     * @param time_us Monotonic time of the read, the interval is measured against it.
+     * @return Busy share of the busiest engine class in `[0, 1]`, 0 on the first call for a process.
+     */
+    double update(int32_t pid, int64_t time_us);
+
+    /** Drop the descriptors and baselines kept for `pid`, once it has exited. */
+    void forget(int32_t pid);
+
+    /** Per engine class utilization of the last `update`, in the order the driver lists them. */
+    const std::vector<DrmEngineUse>& engines() const;
+
+    /** Open DRM clients of the process of the last `update`, duplicates counted once. */
+    size_t clientCount() const;
+
+    /** Number of fd directory scans so far, for tests and benchmarks. */
+    uint64_t scanCount() const;
+
+private:
+    struct Engine {
+        char name[DrmEngineUse::NAME_SIZE];
+        unsigned long long busy_ns = 0;
+        unsigned long long capacity = 1;
+        /** `busy_ns` was seen on this descriptor's previous read as well, so its delta is valid. */
+        bool has_previous = false;
+        unsigned long long previous_ns = 0;
+    };
+
+    struct Client {
+        /** `<pid>/fdinfo/<fd>`. */
+        ProcFile fdinfo;
+        unsigned long fd_number = 0;
+        unsigned long long client_id = 0;
+        /** PCI address of the device, client ids are only unique per device. */
+        char pdev[DrmEngineUse::NAME_SIZE] = {};
+        std::vector<Engine> engines;
+    };
+
+    struct Process {
+        std::vector<Client> clients;
+        int64_t scanned_us = 0;
+        int64_t previous_us = 0;
+        bool has_previous = false;
+    };
+
+    /** `fdinfo` of a GPU client stays well below this, amdgpu lists the most fields at about 1 KiB. */
+    static constexpr size_t FDINFO_BUFFER_SIZE = 4096;
+
+    int root_fd;
+
+    FlatHashMap<int32_t, Process> processes;
+
+    std::vector<DrmEngineUse> last_engines;
+
+    /** Busy time and capacity per entry of `last_engines`, summed over the clients during an `update`. */
+    std::vector<unsigned long long> engine_busy_ns;
+    std::vector<unsigned long long> engine_capacity;
+
+    size_t last_clients;
+    uint64_t scans;
+
+    char buffer[FDINFO_BUFFER_SIZE];
+
+    /** Rebuild the client list of `process` from `<pid>/fdinfo`, keeping the counters of clients seen before. */
+    void scan(int32_t pid, Process &process);
+
+    /**
+     * Parse one `fdinfo` text into `client`, updating the counters of engines already known.
+     * @return false if the file does not describe a DRM client.
+     */
+    static bool parse(const char *text, size_t size, Client &client);
+
+    /** Re-read the known clients of `process`. @return false if any of them is gone or no longer a DRM file. */
+    bool readClients(Process &process);
+};
+
+#endif // DRMCLIENTS_H
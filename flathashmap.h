@@ -0,0 +1,149 @@
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * Open-addressing hash map with linear probing over one contiguous slot array.
+ * Tables that churn wholesale are rebuilt into a second map each pass and the two are swapped; single elements are
+ * erased by shifting the rest of their probe run back, so probing stays free of tombstones either way.
+ * Storage only grows, so a table that has reached its working size stops allocating.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class FlatHashMap {
+
+    struct Slot {
+        K key;
+        V value;
+        bool used;
+    };
+
+    std::vector<Slot> slots;
+
+    /** `slots.size() - 1`, the size is always a power of two. */
+    size_t mask;
+
+    size_t count;
+
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    size_t home(const K &key) const {
+        // Mix the hash, identity hashes of small integers would otherwise cluster
+        size_t h = Hash{}(key) * static_cast<size_t>(0x9E3779B97F4A7C15ull);
+        return (h ^ (h >> 29)) & mask;
+    }
+
+    size_t probe(const K &key) const {
+        size_t index = home(key);
+        while (slots[index].used && !(slots[index].key == key))
+            index = (index + 1) & mask;
+        return index;
+    }
+
+    void grow() {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        mask = slots.size() - 1;
+        count = 0;
+        for (auto &slot : old) {
+            if (slot.used)
+                insert(slot.key, std::move(slot.value));
+        }
+    }
+
+public:
+    explicit FlatHashMap(size_t expected = 0): count{0} {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /** @return The value for `key`, or nullptr. */
+    V* find(const K &key) {
+        Slot &slot = slots[probe(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    const V* find(const K &key) const {
+        const Slot &slot = slots[probe(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    /** Insert or overwrite. Keeps the load factor at or below one half. */
+    V& insert(const K &key, V &&value) {
+        if ((count + 1) * 2 > slots.size())
+            grow();
+
+        Slot &slot = slots[probe(key)];
+        if (!slot.used) {
+            slot.key = key;
+            slot.used = true;
+            count++;
+        }
+        slot.value = std::move(value);
+        return slot.value;
+    }
+
+    /**
+     * Remove `key`, later members of its probe run move back into the hole.
+     * @return false if `key` was not present.
+     */
+    bool erase(const K &key) {
+        size_t hole = probe(key);
+        if (!slots[hole].used)
+            return false;
+
+        slots[hole].value = V{};
+        slots[hole].used = false;
+        count--;
+
+        for (size_t next = (hole + 1) & mask; slots[next].used; next = (next + 1) & mask) {
+            // An element may fill the hole unless its home lies cyclically in (hole, next]
+            size_t slot_home = home(slots[next].key);
+            bool stays = hole <= next ? (slot_home > hole && slot_home <= next) : (slot_home > hole || slot_home <= next);
+            if (stays)
+                continue;
+            slots[hole] = std::move(slots[next]);
+            slots[next].value = V{};
+            slots[next].used = false;
+            hole = next;
+        }
+        return true;
+    }
+
+    /** Drop every element. Values are reset to `V{}` so resources they hold are released now. */
+    void clear() {
+        for (auto &slot : slots) {
+            if (slot.used) {
+                slot.value = V{};
+                slot.used = false;
+            }
+        }
+        count = 0;
+    }
+
+    /** Call `fn(key, value)` for every element, in slot order. */
+    template <typename Fn>
+    void forEach(Fn &&fn) {
+        for (auto &slot : slots) {
+            if (slot.used)
+                fn(static_cast<const K&>(slot.key), slot.value);
+        }
+    }
+
+    void swap(FlatHashMap &other) {
+        slots.swap(other.slots);
+        std::swap(mask, other.mask);
+        std::swap(count, other.count);
+    }
+};
+
+#endif // FLATHASHMAP_H
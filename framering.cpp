@@ -0,0 +1,234 @@
+#include "framering.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace frame_ring_format;
+
+FrameRingWriter::FrameRingWriter(): mapping{nullptr}, mapping_size{0}, header{nullptr}, slots{nullptr} {}
+
+FrameRingWriter::~FrameRingWriter() {
+    close();
+}
+
+bool FrameRingWriter::open(const std::string &ring_name, uint32_t capacity) {
+    close();
+    if (capacity == 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    // A segment left behind by a crashed writer may have another layout, start over instead of adopting it
+    shm_unlink(ring_name.c_str());
+    int fd = shm_open(ring_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    const size_t size = mappingSize(capacity);
+    void *mapped = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int saved_errno = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(ring_name.c_str());
+        errno = saved_errno;
+        return false;
+    }
+
+    // ftruncate zero-fills: every slot sequence is 0 and the head is 0, only the header needs filling in.
+    // The magic goes last, a reader that maps the ring meanwhile rejects it until then.
+    name = ring_name;
+    mapping = mapped;
+    mapping_size = size;
+    header = static_cast<Header*>(mapped);
+    slots = reinterpret_cast<Slot*>(static_cast<char*>(mapped) + sizeof(Header));
+    header->version = VERSION;
+    header->frame_size = sizeof(MetricFrame);
+    header->capacity = capacity;
+    header->writer_pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    header->magic.store(MAGIC, std::memory_order_release);
+    return true;
+}
+
+void FrameRingWriter::close() {
+    if (mapping == nullptr)
+        return;
+
+    header->writer_pid.store(0, std::memory_order_release);
+    munmap(mapping, mapping_size);
+    shm_unlink(name.c_str());
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    slots = nullptr;
+    name.clear();
+}
+
+bool FrameRingWriter::isOpen() const {
+    return mapping != nullptr;
+}
+
+void FrameRingWriter::publish(const MetricFrame &frame) {
+    uint64_t staged[WORD_COUNT] = {};
+    std::memcpy(staged, &frame, sizeof(MetricFrame));
+
+    const uint64_t index = header->head.load(std::memory_order_relaxed);
+    Slot &slot = slots[index % header->capacity];
+
+    // Same protocol as SeqLock::store, with the publication number in the sequence so readers detect lapping
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    for (size_t i = 0; i < WORD_COUNT; i++)
+        slot.words[i].store(staged[i], std::memory_order_release);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+
+    header->head.store(index + 1, std::memory_order_release);
+}
+
+uint64_t FrameRingWriter::published() const {
+    return header ? header->head.load(std::memory_order_relaxed) : 0;
+}
+
+FrameRingReader::FrameRingReader(): mapping{nullptr}, mapping_size{0}, header{nullptr}, slots{nullptr} {}
+
+FrameRingReader::~FrameRingReader() {
+    close();
+}
+
+bool FrameRingReader::open(const std::string &name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void *mapped = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header)) {
+        size = static_cast<size_t>(info.st_size);
+        mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    const Header *mapped_header = static_cast<const Header*>(mapped);
+    const bool valid = mapped_header->magic.load(std::memory_order_acquire) == MAGIC &&
+        mapped_header->version == VERSION &&
+        mapped_header->frame_size == sizeof(MetricFrame) &&
+        mapped_header->capacity > 0 &&
+        size >= mappingSize(mapped_header->capacity);
+    if (!valid) {
+        munmap(mapped, size);
+        return false;
+    }
+
+    mapping = mapped;
+    mapping_size = size;
+    header = mapped_header;
+    slots = reinterpret_cast<const Slot*>(static_cast<const char*>(mapped) + sizeof(Header));
+    return true;
+}
+
+void FrameRingReader::close() {
+    if (mapping == nullptr)
+        return;
+
+    munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    slots = nullptr;
+}
+
+bool FrameRingReader::isOpen() const {
+    return mapping != nullptr;
+}
+
+uint32_t FrameRingReader::capacity() const {
+    return header ? header->capacity : 0;
+}
+
+uint64_t FrameRingReader::published() const {
+    return header ? header->head.load(std::memory_order_acquire) : 0;
+}
+
+bool FrameRingReader::writerAlive() const {
+    return writerPid() != 0;
+}
+
+int FrameRingReader::writerPid() const {
+    return header ? header->writer_pid.load(std::memory_order_acquire) : 0;
+}
+
+FrameRingReader::SlotState FrameRingReader::copy(uint64_t index, MetricFrame &frame) const {
+    const Slot &slot = slots[index % header->capacity];
+    const uint64_t expected = 2 * (index + 1);
+    uint64_t staged[WORD_COUNT];
+
+    while (true) {
+        // Anything below is an earlier publication or this one in progress, anything above a later one
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before < expected)
+            return SlotState::Pending;
+        if (before > expected)
+            return SlotState::Overwritten;
+
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            staged[i] = slot.words[i].load(std::memory_order_acquire);
+        const uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        if (after == before) {
+            std::memcpy(&frame, staged, sizeof(MetricFrame));
+            return SlotState::Copied;
+        }
+    }
+}
+
+bool FrameRingReader::latest(MetricFrame &frame) const {
+    if (header == nullptr)
+        return false;
+
+    // The newest slot is only overwritten once the writer went round the whole ring, then there is a newer one
+    while (true) {
+        const uint64_t head = header->head.load(std::memory_order_acquire);
+        if (head == 0)
+            return false;
+        if (copy(head - 1, frame) == SlotState::Copied)
+            return true;
+    }
+}
+
+bool FrameRingReader::next(uint64_t &cursor, MetricFrame &frame, uint64_t *skipped) const {
+    if (header == nullptr)
+        return false;
+
+    while (true) {
+        const uint64_t head = header->head.load(std::memory_order_acquire);
+        if (cursor >= head)
+            return false;
+
+        // Publications older than the ring are gone, continue at the oldest one still held
+        if (head - cursor > header->capacity) {
+            const uint64_t lost = head - header->capacity - cursor;
+            cursor += lost;
+            if (skipped)
+                *skipped += lost;
+        }
+
+        switch (copy(cursor, frame)) {
+        case SlotState::Copied:
+            cursor++;
+            return true;
+        case SlotState::Pending:
+            return false;
+        case SlotState::Overwritten:
+            break;
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "metricframe.h"
+
+/**
+ * A ring of `MetricFrame`s in a POSIX shared-memory object, written by one process and read by any number of others.
+ *
+ * Layout: a header (magic, layout version, frame size, slot count, head) followed by the slots, each on its own
+ * cache line. Every slot is a sequence lock like `SeqLock`: its sequence is `2 * (n + 1)` once publication `n` is
+ * complete there and odd while the writer overwrites it. The head counts completed publications, so publication `n`
+ * lives in slot `n % capacity` and a reader tells a finished, a torn and an overwritten slot apart from the sequence
+ * alone. Readers map the object read-only and never make a syscall to read a frame, they cannot disturb the writer.
+ *
+ * The payload is stored as atomic words, as in `SeqLock`. 64-bit atomics are lock-free and address-free on every
+ * platform this builds for, which is what makes them valid in memory mapped by several processes.
+ */
+namespace frame_ring_format {
+    constexpr uint64_t MAGIC = 0x31474E5246564F48;   // "HOVFRNG1"
+    constexpr uint32_t VERSION = 1;
+
+    constexpr size_t WORD_COUNT = (sizeof(MetricFrame) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Header {
+        /** Stored last by the writer, a reader that maps the ring while it is being set up rejects it. */
+        std::atomic<uint64_t> magic;
+
+        uint32_t version;
+
+        /** `sizeof(MetricFrame)` of the writer, a reader built against another layout refuses to map it. */
+        uint32_t frame_size;
+
+        uint32_t capacity;
+
+        /** PID of the writer, 0 once it closed the ring. */
+        std::atomic<int32_t> writer_pid;
+
+        /** Completed publications. */
+        alignas(64) std::atomic<uint64_t> head;
+    };
+
+    struct Slot {
+        /** `2 * (n + 1)` once publication `n` is complete, odd while it is being written, 0 before any. */
+        alignas(64) std::atomic<uint64_t> sequence;
+
+        std::atomic<uint64_t> words[WORD_COUNT];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring is shared between processes");
+    static_assert(std::is_trivially_copyable_v<MetricFrame>, "frames are copied word by word");
+
+    /** Bytes of a ring of `capacity` slots. */
+    constexpr size_t mappingSize(uint32_t capacity) {
+        return sizeof(Header) + static_cast<size_t>(capacity) * sizeof(Slot);
+    }
+}
+
+/**
+ * Creates the ring and publishes frames into it. One writer per ring.
+ * Not thread-safe, the owner serializes access.
+ */
+class FrameRingWriter {
+    std::string name;
+    void *mapping;
+    size_t mapping_size;
+    frame_ring_format::Header *header;
+    frame_ring_format::Slot *slots;
+
+public:
+    /** A few minutes of frames at the default refresh interval. */
+    static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+
+    FrameRingWriter();
+    ~FrameRingWriter();
+
+    FrameRingWriter(const FrameRingWriter&) = delete;
+    FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+    /**
+     * Create the shared-memory object `name` (e.g. "/hw_overlay") with `capacity` slots.
+     * An object left behind by a writer that died is replaced, readers still mapping it see its writer as gone.
+     * @return false with `errno` set if the object could not be created or mapped.
+     */
+    bool open(const std::string &name, uint32_t capacity = DEFAULT_CAPACITY);
+
+    /** Mark the ring closed for readers, unmap and remove it. Safe to call on a closed ring. */
+    void close();
+
+    bool isOpen() const;
+
+    /** Publish `frame` into the next slot, overwriting the oldest one once the ring is full. Never blocks. */
+    void publish(const MetricFrame &frame);
+
+    /** Completed publications. */
+    uint64_t published() const;
+};
+
+/**
+ * Maps a ring read-only and copies frames out of it. Any number of readers, in any number of processes.
+ * Not thread-safe, use one reader per thread; they are cheap.
+ */
+class FrameRingReader {
+    void *mapping;
+    size_t mapping_size;
+    const frame_ring_format::Header *header;
+    const frame_ring_format::Slot *slots;
+
+    enum class SlotState {
+        Copied,
+
+        /** The writer has not completed that publication yet. */
+        Pending,
+
+        /** The writer lapped the reader, the slot already holds a later publication. */
+        Overwritten,
+    };
+
+    /** Copy publication `index` into `frame`, retrying only while the writer overlaps the copy. */
+    SlotState copy(uint64_t index, MetricFrame &frame) const;
+
+public:
+    FrameRingReader();
+    ~FrameRingReader();
+
+    FrameRingReader(const FrameRingReader&) = delete;
+    FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+    /**
+     * Map the ring `name` written by a `FrameRingWriter`.
+     * @return false if it does not exist or was written with another layout (magic, version or frame size differ).
+     */
+    bool open(const std::string &name);
+
+    /** Unmap the ring. Safe to call on a closed reader. */
+    void close();
+
+    bool isOpen() const;
+
+    uint32_t capacity() const;
+
+    /** Completed publications, the cursor after the newest frame. */
+    uint64_t published() const;
+
+    /** False once the writer closed the ring. A writer that crashed is not detected here, see `writerPid`. */
+    bool writerAlive() const;
+
+    /** PID of the writer, 0 once it closed the ring. */
+    int writerPid() const;
+
+    /**
+     * Copy the newest frame.
+     * @return false if nothing was published yet.
+     */
+    bool latest(MetricFrame &frame) const;
+
+    /**
+     * Copy the frame at `cursor` and advance the cursor past it. Start with `cursor` 0 for the oldest frame still
+     * held, or with `published()` for only new ones.
+     * @param skipped Incremented by the frames that were overwritten before they could be read, if not null.
+     * @return false if no frame at or after `cursor` is complete yet.
+     */
+    bool next(uint64_t &cursor, MetricFrame &frame, uint64_t *skipped = nullptr) const;
+};
+
+#endif // FRAMERING_H
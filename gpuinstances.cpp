@@ -0,0 +1,117 @@
+#include "gpuinstances.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::wstring_view PID_PREFIX = L"pid_";
+constexpr std::wstring_view ENGINE_TYPE_MARKER = L"_engtype_";
+
+} // namespace
+
+GpuInstanceIndex::GpuInstanceIndex() {}
+
+bool GpuInstanceIndex::update(const wchar_t *names, size_t size) {
+    if (size == list.size() && std::equal(names, names + size, list.begin()))
+        return false;
+
+    // assign keeps the capacity, only a longer enumeration than any before allocates
+    list.assign(names, names + size);
+    rebuild();
+    return true;
+}
+
+void GpuInstanceIndex::rebuild() {
+    instances.clear();
+    processes.clear();
+
+    const std::wstring_view all(list.data(), list.size());
+    size_t start = 0;
+    while (start < all.size()) {
+        size_t stop = all.find(L'\0', start);
+        if (stop == std::wstring_view::npos)
+            stop = all.size();
+        // An empty name is the second null of the terminator
+        if (stop == start)
+            break;
+
+        const std::wstring_view name = all.substr(start, stop - start);
+        uint32_t pid;
+        if (parsePid(name, pid)) {
+            const uint32_t index = static_cast<uint32_t>(instances.size());
+            instances.push_back({static_cast<uint32_t>(start), static_cast<uint32_t>(name.size()), NO_INSTANCE});
+
+            Process *process = processes.find(pid);
+            if (process == nullptr)
+                process = &processes.insert(pid, Process{});
+            if (process->last != NO_INSTANCE)
+                instances[process->last].next = index;
+            else
+                process->first = index;
+            process->last = index;
+            process->count++;
+        }
+        start = stop + 1;
+    }
+}
+
+size_t GpuInstanceIndex::instanceCount() const {
+    return instances.size();
+}
+
+size_t GpuInstanceIndex::processCount() const {
+    return processes.size();
+}
+
+std::wstring_view GpuInstanceIndex::instance(uint32_t index) const {
+    if (index >= instances.size())
+        return {};
+    return std::wstring_view(list.data() + instances[index].offset, instances[index].length);
+}
+
+std::wstring_view GpuInstanceIndex::find(uint32_t pid, std::wstring_view engine_type) const {
+    const Process *process = processes.find(pid);
+    if (process == nullptr)
+        return {};
+
+    for (uint32_t index = process->first; index != NO_INSTANCE; index = instances[index].next) {
+        std::wstring_view name = instance(index);
+        if (engineType(name) == engine_type)
+            return name;
+    }
+    return {};
+}
+
+uint32_t GpuInstanceIndex::engineCount(uint32_t pid) const {
+    const Process *process = processes.find(pid);
+    return process != nullptr ? process->count : 0;
+}
+
+bool GpuInstanceIndex::parsePid(std::wstring_view name, uint32_t &pid) {
+    if (name.substr(0, PID_PREFIX.size()) != PID_PREFIX)
+        return false;
+
+    uint64_t value = 0;
+    size_t digits = 0;
+    for (size_t i = PID_PREFIX.size(); i < name.size() && name[i] >= L'0' && name[i] <= L'9'; i++) {
+        value = value * 10 + static_cast<uint64_t>(name[i] - L'0');
+        if (value > UINT32_MAX)
+            return false;
+        digits++;
+    }
+
+    // The number has to end the name or be followed by the next field
+    const size_t end = PID_PREFIX.size() + digits;
+    if (digits == 0 || (end < name.size() && name[end] != L'_'))
+        return false;
+
+    pid = static_cast<uint32_t>(value);
+    return true;
+}
+
+std::wstring_view GpuInstanceIndex::engineType(std::wstring_view name) {
+    const size_t marker = name.rfind(ENGINE_TYPE_MARKER);
+    if (marker == std::wstring_view::npos)
+        return {};
+    return name.substr(marker + ENGINE_TYPE_MARKER.size());
+}
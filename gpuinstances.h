@@ -0,0 +1,90 @@
+#ifndef GPUINSTANCES_H
+#define GPUINSTANCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "flathashmap.h"
+
+/**
+ * Index of the "GPU Engine" performance counter instances by process.
+ * `PdhEnumObjectItemsW` lists every engine of every process as a double-null separated buffer of names shaped like
+ * `pid_1234_luid_0x00000000_0x0000D1C5_phys_0_eng_0_engtype_3D`. The index copies one such buffer, maps each PID to
+ * its instances in a single pass and is kept for as long as the enumeration returns the same buffer.
+ *
+ * Pure string logic with no Win32 dependency, so it is built and tested on every platform. Parsing never reads past
+ * the buffer and allocates nothing per instance: instances are views into the copy, and the copy and the map only
+ * grow when a larger enumeration comes in.
+ */
+class GpuInstanceIndex {
+public:
+    /** Ends a chain of instances. */
+    static constexpr uint32_t NO_INSTANCE = ~0u;
+
+    /** Engine type of the 3D rendering engine, the one that stands for "GPU usage" of a process. */
+    static constexpr std::wstring_view ENGINE_3D = L"3D";
+
+    GpuInstanceIndex();
+
+    /**
+     * Index `size` characters of double-null separated names at `list`, unless they equal the list indexed last.
+     * A missing final terminator is tolerated, the last name then ends at `size`.
+     * @return true if the index was rebuilt.
+     */
+    bool update(const wchar_t *list, size_t size);
+
+    /** Instance names in the current list. */
+    size_t instanceCount() const;
+
+    /** Processes with at least one instance. */
+    size_t processCount() const;
+
+    /**
+     * First instance of `pid` with the engine type `engine_type`, empty if there is none.
+     * The view stays valid until the next `update` that rebuilds, and is followed by a null terminator.
+     */
+    std::wstring_view find(uint32_t pid, std::wstring_view engine_type = ENGINE_3D) const;
+
+    /** Number of engine instances of `pid`. */
+    uint32_t engineCount(uint32_t pid) const;
+
+    /** Name of instance `index`, in enumeration order. */
+    std::wstring_view instance(uint32_t index) const;
+
+    /**
+     * Parse the PID of a `pid_<digits>_...` instance name.
+     * @return false if the name does not start that way or the number does not fit.
+     */
+    static bool parsePid(std::wstring_view name, uint32_t &pid);
+
+    /** Text after the last `_engtype_` of an instance name, empty if it has none. */
+    static std::wstring_view engineType(std::wstring_view name);
+
+private:
+    struct Instance {
+        uint32_t offset;
+        uint32_t length;
+        /** Next instance of the same process, `NO_INSTANCE` at the end of the chain. */
+        uint32_t next;
+    };
+
+    struct Process {
+        uint32_t first = NO_INSTANCE;
+        uint32_t last = NO_INSTANCE;
+        uint32_t count = 0;
+    };
+
+    /** Copy of the indexed list, the instances point into it. */
+    std::vector<wchar_t> list;
+
+    std::vector<Instance> instances;
+
+    /** First and last instance of each process, instances of a process are chained through `Instance::next`. */
+    FlatHashMap<uint32_t, Process> processes;
+
+    void rebuild();
+};
+
+#endif // GPUINSTANCES_H
@@ -0,0 +1,101 @@
+#include "historyseries.h"
+
+#include <QList>
+
+HistorySeries::HistorySeries(size_t capacity, double windowMs, QObject *parent):
+    QObject{parent},
+    points{capacity},
+    window_ms{windowMs},
+    pixel_width{DEFAULT_PIXEL_WIDTH},
+    decimated{windowMs, DEFAULT_PIXEL_WIDTH}
+{
+}
+
+void HistorySeries::append(double timestampMs, double value) {
+    if (points.full())
+        points.popFront();
+    points.push(QPointF(timestampMs, value));
+
+    // Keep one sample beyond the left edge so the line still reaches the edge of the graph.
+    const double cutoff = timestampMs - window_ms;
+    while (points.size() > 1 && points[1].x() < cutoff)
+        points.popFront();
+
+    const MinMaxDecimator::Delta delta = decimated.append(timestampMs, value);
+    if (bound_series) {
+        if (delta.removed_front > 0)
+            bound_series->removeMultiple(0, static_cast<qsizetype>(delta.removed_front));
+        if (delta.removed_back > 0) {
+            qsizetype back = static_cast<qsizetype>(delta.removed_back);
+            bound_series->removeMultiple(bound_series->count() - back, back);
+        }
+        for (unsigned i = 0; i < delta.appended_count; i++)
+            bound_series->append(delta.appended[i].x, delta.appended[i].y);
+    }
+
+    emit countChanged();
+}
+
+void HistorySeries::reset(size_t capacity) {
+    points.reset(capacity);
+    decimated.reset(window_ms, static_cast<unsigned>(pixel_width));
+    if (bound_series)
+        bound_series->clear();
+    emit countChanged();
+}
+
+void HistorySeries::reserve(size_t capacity) {
+    points.reserve(capacity);
+}
+
+void HistorySeries::bindSeries(QXYSeries *series) {
+    bound_series = series;
+    uploadAll();
+}
+
+void HistorySeries::redecimate() {
+    decimated.reset(window_ms, static_cast<unsigned>(pixel_width));
+    for (size_t i = 0; i < points.size(); i++)
+        decimated.append(points[i].x(), points[i].y());
+    uploadAll();
+}
+
+void HistorySeries::uploadAll() {
+    if (!bound_series)
+        return;
+
+    QList<QPointF> current;
+    current.reserve(static_cast<qsizetype>(decimated.size()));
+    decimated.forEachPoint([&current](const SeriesPoint &point) {
+        current.append(QPointF(point.x, point.y));
+    });
+    bound_series->replace(current);
+}
+
+int HistorySeries::Count() const {
+    return static_cast<int>(points.size());
+}
+
+double HistorySeries::WindowMs() const {
+    return window_ms;
+}
+
+int HistorySeries::PixelWidth() const {
+    return pixel_width;
+}
+
+void HistorySeries::setPixelWidth(int width) {
+    if (width < 1 || width == pixel_width)
+        return;
+    pixel_width = width;
+    redecimate();
+    emit pixelWidthChanged();
+}
+
+size_t HistorySeries::decimatedCount() const {
+    return decimated.size();
+}
+
+QPointF HistorySeries::at(size_t index) const {
+    return points[index];
+}
@@ -0,0 +1,91 @@
+#ifndef HISTORYSERIES_H
+#define HISTORYSERIES_H
+
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QtGraphs/QXYSeries>
+
+#include "ringbuffer.h"
+#include "decimator.h"
+
+/**
+ * Sliding window of (timestamp, value) samples for one metric.
+ * Points are stored with absolute timestamps and are never rewritten, the graph keeps them relative to "now" by
+ * moving its x axis instead. Appending is O(1) and so is eviction.
+ * A bound `QXYSeries` does not get the raw samples but a min/max decimated copy capped at about two points per
+ * pixel, kept in sync with incremental edits at either end rather than a full `replace()` every tick.
+ */
+class HistorySeries: public QObject {
+    Q_OBJECT
+
+    /** Matches `default_width` in Main.qml until the graph reports its real width. */
+    static constexpr int DEFAULT_PIXEL_WIDTH = 300;
+
+    /** Samples in the window, oldest first. */
+    RingBuffer<QPointF> points;
+
+    /** Width of the window in milliseconds. */
+    double window_ms;
+
+    /** Width of the graph the series is drawn into. */
+    int pixel_width;
+
+    /** What actually goes to the graph. */
+    MinMaxDecimator decimated;
+
+    /** Graph series mirroring `decimated`, if any. */
+    QPointer<QXYSeries> bound_series;
+
+    /** Rebuild the decimated output from the raw samples and push it to the bound series in one go. */
+    void redecimate();
+
+    /** Replace the bound series' points with the current decimated output. */
+    void uploadAll();
+
+public:
+    Q_PROPERTY(int Count READ Count NOTIFY countChanged)
+    Q_PROPERTY(double WindowMs READ WindowMs CONSTANT)
+    Q_PROPERTY(int PixelWidth READ PixelWidth WRITE setPixelWidth NOTIFY pixelWidthChanged)
+
+    /**
+     * @param capacity Most samples ever held, the window length divided by the shortest refresh interval.
+     * @param windowMs Samples older than this relative to the newest one are evicted.
+     */
+    explicit HistorySeries(size_t capacity, double windowMs, QObject *parent = nullptr);
+
+    /** Add the newest sample and evict whatever fell out of the window. */
+    void append(double timestampMs, double value);
+
+    /** Drop every sample and resize the buffer. */
+    void reset(size_t capacity);
+
+    /** Make room for at least `capacity` samples without losing any, for when the refresh interval shrinks. */
+    void reserve(size_t capacity);
+
+    /** Make `series` mirror this history. Its current points are replaced once, later ticks are incremental. */
+    Q_INVOKABLE void bindSeries(QXYSeries *series);
+
+    /** Number of samples in the window. */
+    int Count() const;
+
+    double WindowMs() const;
+
+    /** Width of the graph the series is drawn into, bound from HistoryLine.qml. */
+    int PixelWidth() const;
+
+    /** Re-bucket the graph output for a new width, O(n) once. */
+    void setPixelWidth(int width);
+
+    /** Number of points handed to the graph. */
+    size_t decimatedCount() const;
+
+    /** Sample by age, 0 is the oldest. */
+    QPointF at(size_t index) const;
+
+signals:
+    void countChanged();
+    void pixelWidthChanged();
+};
+
+#endif // HISTORYSERIES_H
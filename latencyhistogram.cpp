@@ -0,0 +1,52 @@
+#include "latencyhistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(): total{0}, maximum{0} {
+    for (auto &bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const {
+    return maximum.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < 2 * SUB_BUCKETS)
+        return index;
+    // Inverse of `bucketIndex`: the top SUB_BUCKET_BITS + 1 bits of the value, shifted back into place
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t mantissa = index - shift * SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    // Counts can move while we walk them, so rank against the sum of what was actually read
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t recorded = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        recorded += counts[i];
+    }
+    if (recorded == 0)
+        return 0;
+
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * recorded)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // The maximum may trail the counts by a tick, so it never pulls the result below the bucket
+            const uint64_t lower = i == 0 ? 0 : bucketUpperBound(i - 1) + 1;
+            return std::min(bucketUpperBound(i), std::max(max(), lower));
+        }
+    }
+    return max();
+}
@@ -0,0 +1,86 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Log-linear histogram of durations in nanoseconds, in the manner of HdrHistogram.
+ * Every power of two is split into `SUB_BUCKETS` linear buckets, so any recorded value is reported within
+ * 1 / `SUB_BUCKETS` (about 3 %) of what was recorded, from 1 ns up to `MAX_VALUE_NS`. Larger values are clamped.
+ *
+ * One thread records, any number of threads read at the same time. Counters are relaxed atomics the writer updates
+ * with plain loads and stores, so `record` is a handful of instructions without a locked read-modify-write, and a
+ * reader may see a tick's count before its maximum, which only ever skews a report by that one tick.
+ */
+class LatencyHistogram {
+public:
+    /** Linear buckets per power of two, as a power of two. */
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+
+    /** Highest exponent tracked, about 18 minutes. */
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr uint64_t MAX_VALUE_NS = (uint64_t{1} << (MAX_EXPONENT + 1)) - 1;
+
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /** Count one duration. Must only ever be called from one thread at a time. */
+    void record(uint64_t value_ns) {
+        if (value_ns > MAX_VALUE_NS)
+            value_ns = MAX_VALUE_NS;
+
+        std::atomic<uint64_t> &bucket = buckets[bucketIndex(value_ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value_ns > maximum.load(std::memory_order_relaxed))
+            maximum.store(value_ns, std::memory_order_relaxed);
+    }
+
+    /** Number of recorded values. */
+    uint64_t count() const;
+
+    /** Largest recorded value, exact. 0 when empty. */
+    uint64_t max() const;
+
+    /**
+     * Smallest value that at least `quantile` of the recorded values are at or below, e.g. 0.99 for p99.
+     * Reported as the upper edge of its bucket, but never above `max`. 0 when empty.
+     */
+    uint64_t percentile(double quantile) const;
+
+    /** Bucket `value_ns` is counted in. Values below `2 * SUB_BUCKETS` get a bucket of their own. */
+    static size_t bucketIndex(uint64_t value_ns) {
+        if (value_ns < SUB_BUCKETS)
+            return static_cast<size_t>(value_ns);
+        const unsigned shift = highestBit(value_ns) - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift * SUB_BUCKETS + (value_ns >> shift));
+    }
+
+    /** Largest value counted in bucket `index`. */
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    static unsigned highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned bit = 0;
+        while (value >>= 1)
+            bit++;
+        return bit;
+#endif
+    }
+
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> maximum;
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+};
+
+#endif // LATENCYHISTOGRAM_H
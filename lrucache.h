@@ -0,0 +1,171 @@
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "flathashmap.h"
+
+/**
+ * Bounded map that evicts its least recently used element once full.
+ * Elements live in one node array allocated up front and are linked into a recency list by index, a `FlatHashMap`
+ * maps keys to nodes. Nothing allocates after construction, `find` and `insert` are a hash probe and a relink.
+ * Evicted and erased values are reset to `V{}` right away, so a value owning descriptors releases them then;
+ * callers that need to do more than that look at `leastRecent` before inserting into a full cache.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Node {
+        K key {};
+        V value {};
+        uint32_t prev = NONE;
+        uint32_t next = NONE;
+    };
+
+    std::vector<Node> nodes;
+
+    /** Node index of every cached key. */
+    FlatHashMap<K, uint32_t, Hash> index;
+
+    /** Most and least recently used node, `NONE` while empty. */
+    uint32_t head;
+    uint32_t tail;
+
+    /** Nodes handed out so far, the rest of `nodes` is unused until then. Erased nodes go to `free_list`. */
+    uint32_t used;
+    std::vector<uint32_t> free_list;
+
+    void unlink(uint32_t node) {
+        Node &n = nodes[node];
+        if (n.prev != NONE)
+            nodes[n.prev].next = n.next;
+        else
+            head = n.next;
+        if (n.next != NONE)
+            nodes[n.next].prev = n.prev;
+        else
+            tail = n.prev;
+        n.prev = NONE;
+        n.next = NONE;
+    }
+
+    void pushFront(uint32_t node) {
+        Node &n = nodes[node];
+        n.prev = NONE;
+        n.next = head;
+        if (head != NONE)
+            nodes[head].prev = node;
+        head = node;
+        if (tail == NONE)
+            tail = node;
+    }
+
+public:
+    explicit LruCache(size_t capacity):
+        nodes(capacity > 0 ? capacity : 1),
+        index(capacity > 0 ? capacity : 1),
+        head{NONE},
+        tail{NONE},
+        used{0}
+    {
+        free_list.reserve(nodes.size());
+    }
+
+    size_t size() const { return index.size(); }
+    size_t capacity() const { return nodes.size(); }
+    bool full() const { return index.size() == nodes.size(); }
+
+    /** @return The value for `key`, now the most recently used, or nullptr. */
+    V* find(const K &key) {
+        uint32_t *node = index.find(key);
+        if (node == nullptr)
+            return nullptr;
+        if (*node != head) {
+            unlink(*node);
+            pushFront(*node);
+        }
+        return &nodes[*node].value;
+    }
+
+    /** Same as `find` without touching the recency order. */
+    const V* peek(const K &key) const {
+        const uint32_t *node = index.find(key);
+        return node != nullptr ? &nodes[*node].value : nullptr;
+    }
+
+    /** Key `insert` would evict next, nullptr unless the cache is full. */
+    const K* leastRecent() const {
+        return full() ? &nodes[tail].key : nullptr;
+    }
+
+    /** Insert or overwrite as the most recently used, evicting the least recently used one if the cache is full. */
+    V& insert(const K &key, V &&value) {
+        uint32_t *known = index.find(key);
+        uint32_t node;
+        if (known != nullptr) {
+            node = *known;
+            unlink(node);
+        } else if (!free_list.empty()) {
+            node = free_list.back();
+            free_list.pop_back();
+            index.insert(key, uint32_t{node});
+        } else if (used < nodes.size()) {
+            node = used++;
+            index.insert(key, uint32_t{node});
+        } else {
+            node = tail;
+            unlink(node);
+            index.erase(nodes[node].key);
+            index.insert(key, uint32_t{node});
+        }
+
+        nodes[node].key = key;
+        nodes[node].value = std::move(value);
+        pushFront(node);
+        return nodes[node].value;
+    }
+
+    /** @return false if `key` was not cached. */
+    bool erase(const K &key) {
+        uint32_t *known = index.find(key);
+        if (known == nullptr)
+            return false;
+        const uint32_t node = *known;
+        index.erase(key);
+        unlink(node);
+        nodes[node].value = V{};
+        free_list.push_back(node);
+        return true;
+    }
+
+    /** Drop every element, values are reset like on `erase`. */
+    void clear() {
+        for (uint32_t node = head; node != NONE;) {
+            const uint32_t next = nodes[node].next;
+            nodes[node].value = V{};
+            nodes[node].prev = NONE;
+            nodes[node].next = NONE;
+            node = next;
+        }
+        index.clear();
+        free_list.clear();
+        head = NONE;
+        tail = NONE;
+        used = 0;
+    }
+
+    /** Call `fn(key, value)` for every element, most recently used first. `fn` must not insert or erase. */
+    template <typename Fn>
+    void forEach(Fn &&fn) {
+        for (uint32_t node = head; node != NONE; node = nodes[node].next)
+            fn(static_cast<const K&>(nodes[node].key), nodes[node].value);
+    }
+};
+
+#endif // LRUCACHE_H
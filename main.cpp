@@ -1,10 +1,57 @@
 #include "datamanager.h"
+#include <QCommandLineParser>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+
+/** The `DataMan` instantiated by the loaded QML, null if none. */
+static DataManager* findDataManager(QQmlApplicationEngine &engine)
+{
+    for (QObject *root : engine.rootObjects()) {
+        DataManager *data_manager = root->findChild<DataManager*>();
+        if (data_manager)
+            return data_manager;
+    }
+    return nullptr;
+}
+
+/** Start the replay asked for on the command line, if any. */
+static bool startReplay(const QCommandLineParser &options, QQmlApplicationEngine &engine)
+{
+    if (!options.isSet("replay") && !options.isSet("synthetic"))
+        return true;
+
+    DataManager *data_manager = findDataManager(engine);
+    if (!data_manager)
+        return false;
+
+    const bool fast = options.isSet("fast");
+    if (options.isSet("replay"))
+        return data_manager->replayRecording(options.value("replay"), fast);
+    return data_manager->replaySynthetic(options.value("synthetic"), options.value("cores").toInt(), fast);
+}
+
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.addHelpOption();
+    options.addOptions({
+        {"replay", "Play a recording instead of sampling this machine.", "file"},
+        {"synthetic", "Play generated load instead of sampling this machine: ramp or spikes.", "pattern"},
+        {"cores", "Logical cores to simulate with --synthetic.", "count", "256"},
+        {"fast", "Play --replay or --synthetic as fast as possible instead of in real time."},
+        {"adaptive", "Sample fast while the metrics move and back off to seconds while they are flat."},
+        {"pid", "Measure this process as the foreground instead of the overlay itself (Linux).", "pid"},
+        {"watch", "Follow a process by PID or name pattern (* and ?) next to the foreground, repeatable.", "target"},
+        {"cgroup", "Report a cgroup v2 group by its path below /sys/fs/cgroup next to the top ones, repeatable.", "path"},
+        {"metrics-port", "Serve Prometheus metrics on 127.0.0.1 at this port, 0 for any free one.", "port"},
+    });
+    options.process(app);
+
     qmlRegisterType<DataManager>("li.morris.DataManager", 1, 0, "DataMan");
+    qmlRegisterUncreatableType<HistorySeries>("li.morris.DataManager", 1, 0, "HistorySeries",
+        QStringLiteral("HistorySeries is owned by DataMan"));
     QQmlApplicationEngine engine;
     QObject::connect(
         &engine,
@@ -14,5 +61,36 @@ int main(int argc, char *argv[])
         Qt::QueuedConnection);
     engine.loadFromModule("hw_overlay", "Main");
 
+    if (!startReplay(options, engine)) {
+        qWarning("Could not start the requested replay");
+        return 1;
+    }
+
+    if (options.isSet("adaptive")) {
+        if (DataManager *data_manager = findDataManager(engine))
+            data_manager->setAdaptiveSampling(true);
+    }
+
+    if (DataManager *data_manager = findDataManager(engine)) {
+        if (options.isSet("pid")) {
+            bool is_pid = false;
+            const int pid = options.value("pid").toInt(&is_pid);
+            if (is_pid && pid > 0)
+                data_manager->setTargetPid(pid);
+            else
+                qWarning("Not a PID: %s", qPrintable(options.value("pid")));
+        }
+        for (const QString &target : options.values("watch")) {
+            bool is_pid = false;
+            const int pid = target.toInt(&is_pid);
+            if ((is_pid ? data_manager->watchPid(pid) : data_manager->watchName(target)) < 0)
+                qWarning("Could not watch %s", qPrintable(target));
+        }
+        if (options.isSet("cgroup"))
+            data_manager->setCgroupSelection(options.values("cgroup"));
+        if (options.isSet("metrics-port") && !data_manager->serveMetrics(options.value("metrics-port").toInt()))
+            qWarning("Could not serve metrics on port %s", qPrintable(options.value("metrics-port")));
+    }
+
     return app.exec();
 }
@@ -0,0 +1,129 @@
+#include "meminfo.h"
+
+#include <cstring>
+
+#include "procfile.h"
+
+namespace {
+
+constexpr unsigned long long BYTES_PER_KB = 1024;
+
+/** Key and colon of every `MemInfoParser::Key`, in that order. */
+constexpr const char *MEMINFO_KEYS[] = {"MemTotal:", "MemFree:", "MemAvailable:"};
+
+bool startsWith(const char *cur, const char *end, const char *key, size_t length) {
+    return static_cast<size_t>(end - cur) >= length && std::memcmp(cur, key, length) == 0;
+}
+
+} // namespace
+
+MemInfoParser::MemInfoParser():
+    offsets{},
+    found{},
+    has_layout{false},
+    scan_count{0}
+{}
+
+bool MemInfoParser::scan(const char *text, const char *end) {
+    scan_count++;
+    for (bool &key_found : found)
+        key_found = false;
+
+    unsigned remaining = KEY_COUNT;
+    for (const char *cur = text; cur < end && remaining > 0; cur = ProcFile::nextLine(cur, end)) {
+        for (unsigned key = 0; key < KEY_COUNT; key++) {
+            if (!found[key] && startsWith(cur, end, MEMINFO_KEYS[key], std::strlen(MEMINFO_KEYS[key]))) {
+                offsets[key] = static_cast<size_t>(cur - text);
+                found[key] = true;
+                remaining--;
+                break;
+            }
+        }
+    }
+    has_layout = found[Total];
+    return has_layout;
+}
+
+bool MemInfoParser::readKnown(const char *text, const char *end, unsigned long long (&kb)[KEY_COUNT]) const {
+    for (unsigned key = 0; key < KEY_COUNT; key++) {
+        kb[key] = 0;
+        if (!found[key])
+            continue;
+        const size_t length = std::strlen(MEMINFO_KEYS[key]);
+        const char *cur = text + offsets[key];
+        if (cur >= end || !startsWith(cur, end, MEMINFO_KEYS[key], length))
+            return false;
+        ProcFile::parseUnsigned(cur + length, end, kb[key]);
+    }
+    return true;
+}
+
+bool MemInfoParser::parse(const char *text, size_t size, SystemMemory &out) {
+    out = SystemMemory{};
+    const char *end = text + size;
+
+    unsigned long long kb[KEY_COUNT];
+    if (!has_layout || !readKnown(text, end, kb)) {
+        if (!scan(text, end) || !readKnown(text, end, kb))
+            return false;
+    }
+
+    out.total = kb[Total] * BYTES_PER_KB;
+    out.available = (found[Available] ? kb[Available] : kb[Free]) * BYTES_PER_KB;
+    return out.total > 0;
+}
+
+unsigned MemInfoParser::scans() const {
+    return scan_count;
+}
+
+bool parseSmapsRollup(const char *text, size_t size, MemoryBreakdown &out) {
+    out = MemoryBreakdown{};
+    const char *end = text + size;
+
+    // The first line names the address range, every other one is "Key:   123 kB"
+    bool has_rss = false;
+    unsigned long long private_clean = 0, private_dirty = 0;
+    for (const char *cur = text; cur < end; cur = ProcFile::nextLine(cur, end)) {
+        unsigned long long *target = nullptr;
+        size_t length = 0;
+        switch (*cur) {
+        case 'R':
+            if (startsWith(cur, end, "Rss:", 4)) {
+                target = &out.rss;
+                length = 4;
+                has_rss = true;
+            }
+            break;
+        case 'P':
+            if (startsWith(cur, end, "Pss:", 4)) {
+                target = &out.pss;
+                length = 4;
+                out.detailed = true;
+            } else if (startsWith(cur, end, "Private_Clean:", 14)) {
+                target = &private_clean;
+                length = 14;
+            } else if (startsWith(cur, end, "Private_Dirty:", 14)) {
+                target = &private_dirty;
+                length = 14;
+            }
+            break;
+        case 'S':
+            if (startsWith(cur, end, "Swap:", 5)) {
+                target = &out.swap;
+                length = 5;
+            }
+            break;
+        default:
+            break;
+        }
+        if (target != nullptr)
+            ProcFile::parseUnsigned(cur + length, end, *target);
+    }
+
+    out.rss *= BYTES_PER_KB;
+    out.pss *= BYTES_PER_KB;
+    out.uss = (private_clean + private_dirty) * BYTES_PER_KB;
+    out.swap *= BYTES_PER_KB;
+    return has_rss;
+}
@@ -0,0 +1,81 @@
+#ifndef MEMINFO_H
+#define MEMINFO_H
+
+#include <cstddef>
+
+/** Physical memory of the whole system in bytes. */
+struct SystemMemory {
+    unsigned long long total;
+
+    /** MemAvailable, or MemFree on kernels before 3.14 which lack it. */
+    unsigned long long available;
+};
+
+/**
+ * Parser for `/proc/meminfo` that remembers where its keys are.
+ * The kernel prints a fixed list of keys with every value padded to the same width, so on a given machine each key
+ * stays at the same offset from one read to the next. The first `parse` scans lines until it has found every key it
+ * needs and skips the rest, later ones check the key at its remembered offset and read the number right after it. A
+ * value outgrowing its padding moves the keys after it, which fails the check and costs one scan to relearn.
+ */
+class MemInfoParser {
+    enum Key {
+        Total,
+        Free,
+        Available,
+        KEY_COUNT,
+    };
+
+    /** Offset of every key's line in the last text that was scanned. */
+    size_t offsets[KEY_COUNT];
+
+    /** Keys the scanned text had, MemAvailable may be missing. */
+    bool found[KEY_COUNT];
+
+    /** `offsets` hold a layout to check. */
+    bool has_layout;
+
+    unsigned scan_count;
+
+    /** Find every key from the start of `text`. */
+    bool scan(const char *text, const char *end);
+
+    /** Read the value at every remembered offset. @return false if a key is not where it was. */
+    bool readKnown(const char *text, const char *end, unsigned long long (&kb)[KEY_COUNT]) const;
+
+public:
+    MemInfoParser();
+
+    /** Read the totals from the text of `/proc/meminfo`. @return false without a MemTotal. */
+    bool parse(const char *text, size_t size, SystemMemory &out);
+
+    /** Full scans so far, one unless the layout moved. */
+    unsigned scans() const;
+};
+
+/** Memory of one process by how its pages are shared with others, in bytes. */
+struct MemoryBreakdown {
+    /** Resident set, shared pages counted in full. The same as `statm` and the Win32 working set. */
+    unsigned long long rss;
+
+    /** Proportional set: every resident page divided by the number of processes mapping it, adds up across processes. */
+    unsigned long long pss;
+
+    /** Unique set: private resident pages only, what ending the process would give back. */
+    unsigned long long uss;
+
+    /** Swapped out pages, shared ones counted in full. */
+    unsigned long long swap;
+
+    /** `pss`, `uss` and `swap` were read. Without smaps_rollup (Linux before 4.14, or no permission) only `rss` is. */
+    bool detailed;
+};
+
+/**
+ * Fill `out` from the text of `/proc/<pid>/smaps_rollup`: Rss, Pss, Private_Clean plus Private_Dirty for the USS, and
+ * Swap. `detailed` is set if there was a Pss line.
+ * @return false if the text has no Rss line.
+ */
+bool parseSmapsRollup(const char *text, size_t size, MemoryBreakdown &out);
+
+#endif // MEMINFO_H
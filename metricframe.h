@@ -0,0 +1,231 @@
+#ifndef METRICFRAME_H
+#define METRICFRAME_H
+
+#include <cstdint>
+
+#include "cgrouptable.h"
+#include "diskio.h"
+#include "proctable.h"
+#include "rollingstats.h"
+#include "threadtable.h"
+#include "watchlist.h"
+
+/**
+ * Every metric `DataManager` derives in one tick.
+ * Frames are built privately by the update thread and published whole, so a reader can never see
+ * the memory numbers of one tick next to the CPU numbers of another.
+ */
+struct MetricFrame {
+    /** Number of the tick that produced this frame, 0 before the first sample. */
+    uint64_t tick;
+
+    /** Monotonic time of the sample in milliseconds since `DataManager` was created. */
+    double timestamp_ms;
+
+    /** Measured time since the previous sample, which utilization is normalized by. 0 on the first tick. */
+    double elapsed_ms;
+
+    /** Sampling deadlines skipped so far because a tick overran. */
+    uint64_t missed_deadlines;
+
+    /** Bytes of available system memory. */
+    int64_t mem_total;
+
+    /** Bytes of allocated system memory. */
+    int64_t mem_used;
+
+    /**
+     * Bytes of memory used by the foreground process: its proportional set where `mem_proc_detailed`, so memory shared
+     * with other processes only counts in part, otherwise its resident set.
+     */
+    int64_t mem_proc;
+
+    /** Resident set of the foreground process, shared pages counted in full. */
+    int64_t mem_proc_rss;
+
+    /** Private resident bytes of the foreground process. 0 unless `mem_proc_detailed`. */
+    int64_t mem_proc_uss;
+
+    /** Swapped out bytes of the foreground process. 0 unless `mem_proc_detailed`. */
+    int64_t mem_proc_swap;
+
+    /** `mem_proc` is the proportional set and `mem_proc_uss` and `mem_proc_swap` are known, see `MemoryBreakdown`. */
+    bool mem_proc_detailed;
+
+    /** Total CPU utilization in `[0, 1]`. */
+    double cpu_use;
+
+    /** Share of the CPU time spent by the foreground process, `[0, 1]`. */
+    double cpu_proc_use;
+
+    /** Busy share of the busiest GPU engine used by the foreground process, `[0, 1]`. 0 where unsupported. */
+    double gpu_proc_use;
+
+    /** Logical cores reported in `CoreFrame`, 0 where the backend has no per-core data. */
+    uint32_t core_count;
+
+    /** Index of the busiest core of the tick. */
+    uint32_t core_max_index;
+
+    /** Busy ratio of the busiest core, `[0, 1]`. */
+    double core_max_use;
+
+    /** Cores at or above the configured busy threshold. */
+    uint32_t cores_above_threshold;
+};
+
+/**
+ * Busy ratio of every logical core for one tick, published next to the `MetricFrame` of the same tick.
+ * Kept apart so readers of the scalar metrics don't copy a few KiB each time.
+ */
+struct CoreFrame {
+    /** Cores beyond this are dropped, the summary fields of `MetricFrame` still cover them. */
+    static constexpr uint32_t MAX_CORES = 1024;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    uint32_t count;
+
+    float busy[MAX_CORES];
+};
+
+/** Top processes of the whole system for one tick, published next to the `MetricFrame` of the same tick. */
+struct ProcessFrame {
+    static constexpr uint32_t MAX_TOP = 10;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    /** Processes on the system, 0 where the backend has no process table. */
+    uint32_t process_count;
+
+    uint32_t top_cpu_count;
+    uint32_t top_memory_count;
+
+    /** Busiest first. */
+    ProcessInfo top_cpu[MAX_TOP];
+
+    /** Largest resident set first. */
+    ProcessInfo top_memory[MAX_TOP];
+};
+
+/** Usage of one watched target for one tick. */
+struct WatchUse {
+    /** Processes that made up the target, 0 if none is running. */
+    uint32_t matches;
+
+    /** First of them, 0 if none. */
+    int32_t pid;
+
+    char name[WatchSample::NAME_SIZE];
+
+    /** CPU time of every match as a share of the whole machine, `[0, 1]`. */
+    double cpu_use;
+
+    /** Resident bytes of every match. */
+    uint64_t mem_bytes;
+
+    /** Bytes per second every match read from and wrote to storage, 0 where the backend does not read I/O. */
+    double io_read_rate;
+    double io_write_rate;
+};
+
+/** The watch list for one tick, published next to the `MetricFrame` of the same tick. */
+struct WatchFrame {
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    /** Watch list the entries belong to, see `DataManager::watchPid`. Entries of an older list are not graphed. */
+    uint32_t generation;
+
+    uint32_t count;
+
+    /** In watch list order. */
+    WatchUse watches[WatchTarget::MAX_TARGETS];
+};
+
+/** Selected and top cgroups for one tick, published next to the `MetricFrame` of the same tick. */
+struct CgroupFrame {
+    static constexpr uint32_t MAX_CGROUPS = CgroupTable::MAX_SELECTED + 2 * CgroupTable::DEFAULT_TOP_N;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    uint32_t count;
+
+    /** Same order as `CgroupTable::reported`, selected groups first. */
+    CgroupInfo groups[MAX_CGROUPS];
+};
+
+/** Busiest threads of the foreground process for one tick, published next to the `MetricFrame` of the same tick. */
+struct ThreadFrame {
+    static constexpr uint32_t MAX_TOP = ThreadTable::DEFAULT_TOP_N;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    /** Threads of the foreground process, 0 where the backend does not enumerate them. */
+    uint32_t thread_count;
+
+    /** Share of one core from which a thread counts as hot, the core threshold of the tick. */
+    float hot_threshold;
+
+    /** Threads of `top` at or above `hot_threshold`, they come first. */
+    uint32_t hot_count;
+
+    uint32_t top_count;
+
+    /** Busiest first. */
+    ThreadInfo top[MAX_TOP];
+};
+
+/** Storage I/O of the foreground process and of every disk for one tick, published next to its `MetricFrame`. */
+struct IoFrame {
+    static constexpr uint32_t MAX_DISKS = DiskStats::MAX_DISKS;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    /** Zero without a foreground process, or one whose counters we may not read. */
+    IoRate foreground;
+
+    /** Throughput summed over `disks` except stacked ones, partitions are not in there either, nothing counts twice. */
+    IoRate disk_total;
+
+    /** Largest of the graphed rates, foreground read and write and disk total, over the last minute. Bytes/s. */
+    double peak_rate;
+
+    uint32_t disk_count;
+
+    /** Same order as `/proc/diskstats`. */
+    DiskInfo disks[MAX_DISKS];
+};
+
+/** The overlay's own footprint, refreshed by the update thread about once a second. */
+struct OverheadFrame {
+    /** Number of the tick the usage was read after. */
+    uint64_t tick;
+
+    /** CPU time of the whole overlay since the previous refresh, as a share of one core. */
+    double cpu_use;
+
+    /** Resident set in bytes. */
+    uint64_t rss_bytes;
+
+    uint32_t threads;
+};
+
+/** Rolling statistics of the graphed metrics for one tick, published next to the `MetricFrame` of the same tick. */
+struct StatsFrame {
+    /** One per graph, in the order of `DataManager::StatsMetric`. */
+    static constexpr unsigned METRICS = 5;
+    static constexpr unsigned WINDOWS = 3;
+
+    /** Same as `MetricFrame::tick`. */
+    uint64_t tick;
+
+    RollingSummary summaries[METRICS][WINDOWS];
+};
+
+#endif // METRICFRAME_H
@@ -0,0 +1,138 @@
+#include "metricsampler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "hwinfo/hwinfo.h"
+
+MetricSampler::MetricSampler(SampleSource *source, unsigned machine_cores):
+    source{source},
+    machine_cores{std::max(machine_cores, 1u)},
+    sample_frame{},
+    mem_total{0},
+    tick_count{0},
+    start_us{0},
+    has_start{false},
+    timeline_base_ms{0.0},
+    last_cpu_measurement{0},
+    has_cpu_baseline{false},
+    last_sample_us{0},
+    calculated_use{0.0},
+    calculated_proc_use{0.0},
+    core_frame{}
+{
+    logical_cores = source->logicalCores() > 0 ? source->logicalCores() : this->machine_cores;
+}
+
+void MetricSampler::setSource(SampleSource *next, double timeline_base_ms) {
+    source = next;
+    logical_cores = source->logicalCores() > 0 ? source->logicalCores() : machine_cores;
+    this->timeline_base_ms = timeline_base_ms;
+    has_start = false;
+    has_cpu_baseline = false;
+}
+
+SampleSource* MetricSampler::currentSource() const {
+    return source;
+}
+
+const SampleFrame& MetricSampler::sampleFrame() const {
+    return sample_frame;
+}
+
+const CoreFrame& MetricSampler::coreFrame() const {
+    return core_frame;
+}
+
+unsigned MetricSampler::logicalCores() const {
+    return logical_cores;
+}
+
+unsigned MetricSampler::machineCores() {
+    unsigned cores = 0;
+    for (const auto &cpu : hwinfo::getAllCPUs())
+        cores += cpu.numLogicalCores();
+    return std::max(cores, 1u);
+}
+
+bool MetricSampler::sample() {
+    return source->sample(sample_frame);
+}
+
+void MetricSampler::derive(MetricFrame &frame, float core_threshold, uint64_t missed_deadlines) {
+    const int64_t sample_us = sample_frame.time_us;
+    if (!has_start) {
+        start_us = sample_us;
+        has_start = true;
+    }
+    const double elapsed_ms = has_cpu_baseline ?
+        static_cast<double>(sample_us - last_sample_us) / MICROSEC_PER_MILLISEC : 0.0;
+
+    if (sample_frame.mem_total > 0)
+        mem_total = static_cast<int64_t>(sample_frame.mem_total);
+
+    sampleCpuTimes(sample_us);
+
+    frame = MetricFrame{};
+    frame.tick = ++tick_count;
+    frame.timestamp_ms = timeline_base_ms + static_cast<double>(sample_us - start_us) / MICROSEC_PER_MILLISEC;
+    frame.elapsed_ms = elapsed_ms;
+    frame.missed_deadlines = missed_deadlines;
+    frame.mem_total = mem_total;
+    frame.mem_used = mem_total - static_cast<int64_t>(sample_frame.mem_available);
+    const MemoryBreakdown &breakdown = sample_frame.process_breakdown;
+    frame.mem_proc_detailed = breakdown.detailed;
+    frame.mem_proc_rss = static_cast<int64_t>(sample_frame.process_memory);
+    frame.mem_proc = breakdown.detailed ? static_cast<int64_t>(breakdown.pss) : frame.mem_proc_rss;
+    frame.mem_proc_uss = breakdown.detailed ? static_cast<int64_t>(breakdown.uss) : 0;
+    frame.mem_proc_swap = breakdown.detailed ? static_cast<int64_t>(breakdown.swap) : 0;
+    frame.cpu_use = calculated_use;
+    frame.cpu_proc_use = calculated_proc_use;
+    frame.gpu_proc_use = sample_frame.process_gpu_use;
+
+    const CpuCoreStats &cores = source->coreStats();
+    frame.core_count = static_cast<uint32_t>(cores.coreCount());
+    frame.core_max_index = static_cast<uint32_t>(cores.maxBusyCore());
+    frame.core_max_use = cores.maxBusy();
+    frame.cores_above_threshold = static_cast<uint32_t>(cores.coresAbove(core_threshold));
+
+    core_frame.tick = frame.tick;
+    core_frame.count = std::min<uint32_t>(frame.core_count, CoreFrame::MAX_CORES);
+    if (core_frame.count > 0)
+        std::memcpy(core_frame.busy, cores.busy(), core_frame.count * sizeof(float));
+}
+
+void MetricSampler::sampleCpuTimes(int64_t sample_us) {
+
+    unsigned long long total_cpu_time = sample_frame.cpu_time;
+    unsigned long long cpu_diff = 0;
+    unsigned long long proc_diff = 0;
+
+    if (!has_cpu_baseline) {
+        calculated_use = 0.0;
+        calculated_proc_use = 0.0;
+    } else {
+        // Normalize by the time that actually passed, a late wake-up must not read as extra load
+        double elapsed_us = static_cast<double>(sample_us - last_sample_us);
+        double core_time_div = elapsed_us * logical_cores;
+
+        if (total_cpu_time > last_cpu_measurement)
+            cpu_diff = total_cpu_time - last_cpu_measurement;
+        calculated_use = core_time_div > 0.0 ? cpu_diff / core_time_div : 0.0;
+        if (calculated_use > 1.0)
+            calculated_use = 1.0;
+
+        // The source knows whether the foreground was read on the previous sample as well, right after a change of
+        // focus to a process it was not following there is no delta, rather than one against another process
+        if (sample_frame.process_delta_valid)
+            proc_diff = sample_frame.process_time_delta;
+        calculated_proc_use = cpu_diff > 0 ? proc_diff / static_cast<double>(cpu_diff) : 0.0;
+
+        if (calculated_proc_use > 1.0)
+            calculated_proc_use = 1.0;
+    }
+
+    has_cpu_baseline = true;
+    last_sample_us = sample_us;
+    last_cpu_measurement = total_cpu_time;
+}
@@ -0,0 +1,107 @@
+#ifndef METRICSAMPLER_H
+#define METRICSAMPLER_H
+
+#include <cstdint>
+
+#include "metricframe.h"
+#include "samplesource.h"
+
+/**
+ * The Qt-free core of a tick: samples a `SampleSource` once and derives the `MetricFrame` from it.
+ * Utilization is a delta of the source's counters normalized by the real time between two samples, so the sampler
+ * keeps the previous counters, and the tick number and timeline continue across source switches.
+ * `DataManager` drives one on its update thread and publishes the frames to QML; the headless daemon drives one on
+ * its main thread and publishes them to shared memory.
+ */
+class MetricSampler {
+    static constexpr double MICROSEC_PER_MILLISEC = 1000.0;
+
+    SampleSource *source;
+
+    /** Logical cores of this machine, used unless the source simulates its own. */
+    unsigned machine_cores;
+
+    /** The capacity CPU time is normalized against: `machine_cores` unless the source simulates its own. */
+    unsigned logical_cores;
+
+    /** Reused every tick for `SampleSource::sample`. */
+    SampleFrame sample_frame;
+
+    /** Bytes of available system memory, kept while a source reports none. */
+    int64_t mem_total;
+
+    /** Number of completed ticks. */
+    uint64_t tick_count;
+
+    /** Source time of the first tick of the current source, in microseconds. */
+    int64_t start_us;
+
+    /** False until the current source delivered its first tick. */
+    bool has_start;
+
+    /** `MetricFrame::timestamp_ms` of the first tick of the current source, so timestamps keep rising across switches. */
+    double timeline_base_ms;
+
+    /** Last measurement of total kernel and user time spent by the CPU. */
+    unsigned long long last_cpu_measurement;
+
+    /** False until the first CPU counters are recorded, there is nothing to take a delta against before that. */
+    bool has_cpu_baseline;
+
+    /** Source time the last CPU counters were read. Utilization is normalized by the real gap, not the nominal interval. */
+    int64_t last_sample_us;
+
+    /** Total and foreground CPU utilization of the last tick. */
+    double calculated_use;
+    double calculated_proc_use;
+
+    /** Per-core ratios of the last tick, kept off the caller's stack. */
+    CoreFrame core_frame;
+
+    /** Update the CPU utilization from the counters of `sample_frame`, taken at `sample_us`. */
+    void sampleCpuTimes(int64_t sample_us);
+
+    /** Benchmarks time `sampleCpuTimes` on its own. */
+    friend struct DataManagerProbe;
+
+public:
+    /** @param machine_cores Logical cores of this machine, see `machineCores`. */
+    MetricSampler(SampleSource *source, unsigned machine_cores);
+
+    MetricSampler(const MetricSampler&) = delete;
+    MetricSampler& operator=(const MetricSampler&) = delete;
+
+    /**
+     * Sample `next` from the next tick on. It has its own clock and counters, so baselines are taken afresh and its
+     * first frame is stamped `timeline_base_ms`.
+     */
+    void setSource(SampleSource *next, double timeline_base_ms);
+
+    SampleSource* currentSource() const;
+
+    /**
+     * Sample the source once, the start of every tick.
+     * @return false if the source ran out, there is no tick to derive then.
+     */
+    bool sample();
+
+    /**
+     * Derive the frame of the tick from the last `sample`, including the per-core summary against `core_threshold`.
+     * @param missed_deadlines Copied into the frame, the sampler does not know the schedule.
+     */
+    void derive(MetricFrame &frame, float core_threshold, uint64_t missed_deadlines);
+
+    /** Everything the source reported for the last tick. */
+    const SampleFrame& sampleFrame() const;
+
+    /** Per-core busy ratios of the last `derive`. */
+    const CoreFrame& coreFrame() const;
+
+    /** Cores CPU time is normalized against for the current source. */
+    unsigned logicalCores() const;
+
+    /** Logical cores across all CPUs of this machine, at least 1. */
+    static unsigned machineCores();
+};
+
+#endif // METRICSAMPLER_H
@@ -0,0 +1,363 @@
+#include "metricspage.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+constexpr const char *UNAVAILABLE_RESPONSE =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/plain; charset=utf-8\r\n"
+    "Content-Length: 19\r\n"
+    "\r\n"
+    "No sample taken yet";
+
+constexpr const char *RESPONSE_HEADER =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Content-Length: ";
+
+/**
+ * Appends exposition lines to a string. A family header is written once, then each of its samples as
+ * `sample(name)`, any number of `label`s and the `value` that ends the line.
+ */
+class Exposition {
+    std::string &out;
+    bool labels_open;
+
+    void closeLabels() {
+        if (labels_open) {
+            out += '}';
+            labels_open = false;
+        }
+    }
+
+public:
+    explicit Exposition(std::string &out): out{out}, labels_open{false} {}
+
+    void family(const char *name, const char *type, const char *help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    Exposition& sample(const char *name) {
+        out += name;
+        return *this;
+    }
+
+    /** `value` is escaped as the format requires and cut at `size` bytes or its terminator, whichever comes first. */
+    Exposition& label(const char *key, const char *value, size_t size) {
+        out += labels_open ? ',' : '{';
+        labels_open = true;
+        out += key;
+        out += "=\"";
+        for (size_t i = 0; i < size && value[i] != '\0'; i++) {
+            switch (value[i]) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += value[i]; break;
+            }
+        }
+        out += '"';
+        return *this;
+    }
+
+    Exposition& label(const char *key, const char *value) {
+        return label(key, value, std::strlen(value));
+    }
+
+    Exposition& label(const char *key, int64_t value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return label(key, digits, static_cast<size_t>(result.ptr - digits));
+    }
+
+    void value(double value) {
+        closeLabels();
+        char digits[32];
+        const int length = std::snprintf(digits, sizeof(digits), " %.9g\n", value);
+        out.append(digits, static_cast<size_t>(length));
+    }
+
+    void value(uint64_t value) {
+        closeLabels();
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out += ' ';
+        out.append(digits, static_cast<size_t>(result.ptr - digits));
+        out += '\n';
+    }
+};
+
+void renderProcesses(Exposition &metrics, const ProcessFrame &processes) {
+    metrics.family("hw_overlay_processes", "gauge", "Processes running on the system.");
+    metrics.sample("hw_overlay_processes").value(static_cast<uint64_t>(processes.process_count));
+
+    metrics.family("hw_overlay_top_process_cpu_usage_ratio", "gauge",
+                   "CPU time of the busiest processes as a share of one core.");
+    for (uint32_t i = 0; i < processes.top_cpu_count; i++) {
+        const ProcessInfo &process = processes.top_cpu[i];
+        metrics.sample("hw_overlay_top_process_cpu_usage_ratio").label("pid", process.pid)
+            .label("name", process.name, sizeof(process.name)).value(static_cast<double>(process.cpu_use));
+    }
+
+    metrics.family("hw_overlay_top_process_resident_bytes", "gauge", "Resident set of the largest processes.");
+    for (uint32_t i = 0; i < processes.top_memory_count; i++) {
+        const ProcessInfo &process = processes.top_memory[i];
+        metrics.sample("hw_overlay_top_process_resident_bytes").label("pid", process.pid)
+            .label("name", process.name, sizeof(process.name)).value(process.rss_bytes);
+    }
+}
+
+void renderWatches(Exposition &metrics, const WatchFrame &watches) {
+    // The index tells apart targets that resolve to the same name, such as two patterns matching nothing
+    metrics.family("hw_overlay_watch_cpu_usage_ratio", "gauge",
+                   "CPU time of every process of a watched target as a share of the whole machine.");
+    for (uint32_t i = 0; i < watches.count; i++) {
+        const WatchUse &watch = watches.watches[i];
+        metrics.sample("hw_overlay_watch_cpu_usage_ratio").label("watch", static_cast<int64_t>(i))
+            .label("name", watch.name, sizeof(watch.name)).value(watch.cpu_use);
+    }
+
+    metrics.family("hw_overlay_watch_resident_bytes", "gauge", "Resident set of every process of a watched target.");
+    for (uint32_t i = 0; i < watches.count; i++) {
+        const WatchUse &watch = watches.watches[i];
+        metrics.sample("hw_overlay_watch_resident_bytes").label("watch", static_cast<int64_t>(i))
+            .label("name", watch.name, sizeof(watch.name)).value(watch.mem_bytes);
+    }
+
+    metrics.family("hw_overlay_watch_processes", "gauge", "Processes that make up a watched target.");
+    for (uint32_t i = 0; i < watches.count; i++) {
+        const WatchUse &watch = watches.watches[i];
+        metrics.sample("hw_overlay_watch_processes").label("watch", static_cast<int64_t>(i))
+            .label("name", watch.name, sizeof(watch.name)).value(static_cast<uint64_t>(watch.matches));
+    }
+
+    metrics.family("hw_overlay_watch_io_bytes_per_second", "gauge",
+                   "Bytes per second every process of a watched target read from or wrote to storage.");
+    for (uint32_t i = 0; i < watches.count; i++) {
+        const WatchUse &watch = watches.watches[i];
+        metrics.sample("hw_overlay_watch_io_bytes_per_second").label("watch", static_cast<int64_t>(i))
+            .label("name", watch.name, sizeof(watch.name)).label("direction", "read").value(watch.io_read_rate);
+        metrics.sample("hw_overlay_watch_io_bytes_per_second").label("watch", static_cast<int64_t>(i))
+            .label("name", watch.name, sizeof(watch.name)).label("direction", "write").value(watch.io_write_rate);
+    }
+}
+
+void renderCgroups(Exposition &metrics, const CgroupFrame &cgroups) {
+    struct Column {
+        const char *name;
+        const char *help;
+        double (*read)(const CgroupInfo&);
+    };
+    static const Column columns[] = {
+        {"hw_overlay_cgroup_cpu_usage_ratio", "CPU time of a cgroup as a share of one core.",
+         [](const CgroupInfo &group) { return static_cast<double>(group.cpu_use); }},
+        {"hw_overlay_cgroup_cpu_throttled_ratio", "Share of the interval a cgroup was held back by cpu.max.",
+         [](const CgroupInfo &group) { return static_cast<double>(group.cpu_throttled); }},
+        {"hw_overlay_cgroup_cpu_limit_cores", "Cores cpu.max allows a cgroup, 0 if unlimited.",
+         [](const CgroupInfo &group) { return static_cast<double>(group.cpu_limit); }},
+        {"hw_overlay_cgroup_memory_bytes", "memory.current of a cgroup.",
+         [](const CgroupInfo &group) { return static_cast<double>(group.memory_bytes); }},
+        {"hw_overlay_cgroup_memory_max_bytes", "memory.max of a cgroup, 0 if unlimited.",
+         [](const CgroupInfo &group) { return static_cast<double>(group.memory_max); }},
+        {"hw_overlay_cgroup_io_read_bytes_per_second", "Bytes per second a cgroup read from every device.",
+         [](const CgroupInfo &group) { return group.io_read_rate; }},
+        {"hw_overlay_cgroup_io_write_bytes_per_second", "Bytes per second a cgroup wrote to every device.",
+         [](const CgroupInfo &group) { return group.io_write_rate; }},
+    };
+
+    for (const Column &column : columns) {
+        metrics.family(column.name, "gauge", column.help);
+        for (uint32_t i = 0; i < cgroups.count; i++) {
+            const CgroupInfo &group = cgroups.groups[i];
+            metrics.sample(column.name).label("path", group.path, sizeof(group.path)).value(column.read(group));
+        }
+    }
+}
+
+void renderThreads(Exposition &metrics, const ThreadFrame &threads) {
+    metrics.family("hw_overlay_foreground_threads", "gauge", "Threads of the foreground process.");
+    metrics.sample("hw_overlay_foreground_threads").value(static_cast<uint64_t>(threads.thread_count));
+    metrics.family("hw_overlay_foreground_hot_threads", "gauge",
+                   "Threads of the foreground process at or above the busy threshold of one core.");
+    metrics.sample("hw_overlay_foreground_hot_threads").value(static_cast<uint64_t>(threads.hot_count));
+
+    metrics.family("hw_overlay_top_thread_cpu_usage_ratio", "gauge",
+                   "CPU time of the busiest threads of the foreground process as a share of one core.");
+    for (uint32_t i = 0; i < threads.top_count; i++) {
+        const ThreadInfo &thread = threads.top[i];
+        metrics.sample("hw_overlay_top_thread_cpu_usage_ratio").label("tid", thread.tid)
+            .label("name", thread.name, sizeof(thread.name)).value(static_cast<double>(thread.cpu_use));
+    }
+}
+
+void renderIo(Exposition &metrics, const IoFrame &io) {
+    metrics.family("hw_overlay_foreground_io_bytes_per_second", "gauge",
+                   "Bytes per second the foreground process read from or wrote to storage.");
+    metrics.sample("hw_overlay_foreground_io_bytes_per_second").label("direction", "read")
+        .value(io.foreground.read_rate);
+    metrics.sample("hw_overlay_foreground_io_bytes_per_second").label("direction", "write")
+        .value(io.foreground.write_rate);
+    metrics.family("hw_overlay_foreground_io_operations_per_second", "gauge",
+                   "Read and write calls per second of the foreground process.");
+    metrics.sample("hw_overlay_foreground_io_operations_per_second").label("direction", "read")
+        .value(io.foreground.read_ops);
+    metrics.sample("hw_overlay_foreground_io_operations_per_second").label("direction", "write")
+        .value(io.foreground.write_ops);
+
+    if (io.disk_count == 0)
+        return;
+    // Stacked devices count the I/O of the disks below them again, summing across disks should leave them out
+    metrics.family("hw_overlay_disk_io_bytes_per_second", "gauge", "Bytes per second read from or written to a disk.");
+    for (uint32_t i = 0; i < io.disk_count; i++) {
+        const DiskInfo &disk = io.disks[i];
+        const char *stacked = disk.stacked ? "true" : "false";
+        metrics.sample("hw_overlay_disk_io_bytes_per_second").label("disk", disk.name, sizeof(disk.name))
+            .label("stacked", stacked).label("direction", "read").value(disk.rate.read_rate);
+        metrics.sample("hw_overlay_disk_io_bytes_per_second").label("disk", disk.name, sizeof(disk.name))
+            .label("stacked", stacked).label("direction", "write").value(disk.rate.write_rate);
+    }
+    metrics.family("hw_overlay_disk_io_operations_per_second", "gauge",
+                   "Completed reads and writes per second of a disk.");
+    for (uint32_t i = 0; i < io.disk_count; i++) {
+        const DiskInfo &disk = io.disks[i];
+        const char *stacked = disk.stacked ? "true" : "false";
+        metrics.sample("hw_overlay_disk_io_operations_per_second").label("disk", disk.name, sizeof(disk.name))
+            .label("stacked", stacked).label("direction", "read").value(disk.rate.read_ops);
+        metrics.sample("hw_overlay_disk_io_operations_per_second").label("disk", disk.name, sizeof(disk.name))
+            .label("stacked", stacked).label("direction", "write").value(disk.rate.write_ops);
+    }
+    metrics.family("hw_overlay_disk_busy_ratio", "gauge", "Share of the interval a disk had requests in flight.");
+    for (uint32_t i = 0; i < io.disk_count; i++) {
+        const DiskInfo &disk = io.disks[i];
+        metrics.sample("hw_overlay_disk_busy_ratio").label("disk", disk.name, sizeof(disk.name))
+            .label("stacked", disk.stacked ? "true" : "false").value(static_cast<double>(disk.busy));
+    }
+}
+
+void renderOverhead(Exposition &metrics, const OverheadFrame &overhead) {
+    metrics.family("hw_overlay_self_cpu_usage_ratio", "gauge", "CPU time of the overlay itself as a share of one core.");
+    metrics.sample("hw_overlay_self_cpu_usage_ratio").value(overhead.cpu_use);
+    metrics.family("hw_overlay_self_resident_bytes", "gauge", "Resident set of the overlay itself.");
+    metrics.sample("hw_overlay_self_resident_bytes").value(overhead.rss_bytes);
+    metrics.family("hw_overlay_self_threads", "gauge", "Threads of the overlay itself.");
+    metrics.sample("hw_overlay_self_threads").value(static_cast<uint64_t>(overhead.threads));
+}
+
+} // namespace
+
+MetricsPage::MetricsPage(): write_index{0}, ready{1}, read_index{2}, render_count{0} {
+    for (auto &buffer : buffers)
+        buffer = UNAVAILABLE_RESPONSE;
+}
+
+void MetricsPage::render(const MetricsSnapshot &snapshot) {
+    body.clear();
+    renderBody(snapshot, body);
+
+    char length[24];
+    const auto result = std::to_chars(length, length + sizeof(length), body.size());
+
+    std::string &response = buffers[write_index];
+    response.clear();
+    response += RESPONSE_HEADER;
+    response.append(length, static_cast<size_t>(result.ptr - length));
+    response += "\r\n\r\n";
+    response += body;
+
+    // Hand the finished buffer over and take back whichever one the reader is not holding
+    write_index = ready.exchange(write_index | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    render_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+const std::string& MetricsPage::acquire() {
+    if ((ready.load(std::memory_order_relaxed) & FRESH) != 0)
+        read_index = ready.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+    return buffers[read_index];
+}
+
+uint64_t MetricsPage::renders() const {
+    return render_count.load(std::memory_order_relaxed);
+}
+
+void MetricsPage::renderBody(const MetricsSnapshot &snapshot, std::string &out) {
+    Exposition metrics(out);
+
+    if (const MetricFrame *frame = snapshot.frame) {
+        metrics.family("hw_overlay_ticks_total", "counter", "Sampling ticks completed.");
+        metrics.sample("hw_overlay_ticks_total").value(frame->tick);
+        metrics.family("hw_overlay_missed_deadlines_total", "counter",
+                       "Sampling deadlines skipped because a tick overran.");
+        metrics.sample("hw_overlay_missed_deadlines_total").value(frame->missed_deadlines);
+        metrics.family("hw_overlay_sample_interval_seconds", "gauge", "Measured time between the last two samples.");
+        metrics.sample("hw_overlay_sample_interval_seconds").value(frame->elapsed_ms / 1000.0);
+
+        metrics.family("hw_overlay_cpu_usage_ratio", "gauge", "CPU utilization of the whole machine.");
+        metrics.sample("hw_overlay_cpu_usage_ratio").value(frame->cpu_use);
+        metrics.family("hw_overlay_memory_total_bytes", "gauge", "Memory of the machine.");
+        metrics.sample("hw_overlay_memory_total_bytes").value(static_cast<uint64_t>(frame->mem_total));
+        metrics.family("hw_overlay_memory_used_bytes", "gauge", "Memory allocated on the machine.");
+        metrics.sample("hw_overlay_memory_used_bytes").value(static_cast<uint64_t>(frame->mem_used));
+
+        metrics.family("hw_overlay_foreground_info", "gauge", "Process in the foreground, always 1.");
+        metrics.sample("hw_overlay_foreground_info")
+            .label("name", snapshot.foreground_name ? snapshot.foreground_name : "")
+            .value(static_cast<uint64_t>(1));
+        metrics.family("hw_overlay_foreground_cpu_share_ratio", "gauge",
+                       "Share of the busy CPU time spent by the foreground process.");
+        metrics.sample("hw_overlay_foreground_cpu_share_ratio").value(frame->cpu_proc_use);
+        metrics.family("hw_overlay_foreground_gpu_usage_ratio", "gauge",
+                       "Busy share of the busiest GPU engine used by the foreground process.");
+        metrics.sample("hw_overlay_foreground_gpu_usage_ratio").value(frame->gpu_proc_use);
+        metrics.family("hw_overlay_foreground_memory_bytes", "gauge",
+                       "Memory used by the foreground process, its proportional set where known.");
+        metrics.sample("hw_overlay_foreground_memory_bytes").value(static_cast<uint64_t>(frame->mem_proc));
+        if (frame->mem_proc_detailed) {
+            metrics.family("hw_overlay_foreground_memory_breakdown_bytes", "gauge",
+                           "Resident, proportional, unique and swapped memory of the foreground process.");
+            const std::pair<const char*, int64_t> kinds[] = {
+                {"rss", frame->mem_proc_rss},
+                {"pss", frame->mem_proc},
+                {"uss", frame->mem_proc_uss},
+                {"swap", frame->mem_proc_swap},
+            };
+            for (const auto &kind : kinds)
+                metrics.sample("hw_overlay_foreground_memory_breakdown_bytes").label("kind", kind.first)
+                    .value(static_cast<uint64_t>(kind.second));
+        }
+
+        metrics.family("hw_overlay_cores_above_threshold", "gauge", "Logical cores at or above the busy threshold.");
+        metrics.sample("hw_overlay_cores_above_threshold").value(static_cast<uint64_t>(frame->cores_above_threshold));
+    }
+
+    if (snapshot.cores && snapshot.cores->count > 0) {
+        metrics.family("hw_overlay_core_usage_ratio", "gauge", "Busy share of a logical core.");
+        for (uint32_t core = 0; core < snapshot.cores->count; core++)
+            metrics.sample("hw_overlay_core_usage_ratio").label("core", static_cast<int64_t>(core))
+                .value(static_cast<double>(snapshot.cores->busy[core]));
+    }
+
+    if (snapshot.processes && snapshot.processes->process_count > 0)
+        renderProcesses(metrics, *snapshot.processes);
+    if (snapshot.watches && snapshot.watches->count > 0)
+        renderWatches(metrics, *snapshot.watches);
+    if (snapshot.cgroups && snapshot.cgroups->count > 0)
+        renderCgroups(metrics, *snapshot.cgroups);
+    if (snapshot.threads && snapshot.threads->thread_count > 0)
+        renderThreads(metrics, *snapshot.threads);
+    if (snapshot.io && snapshot.io->tick > 0)
+        renderIo(metrics, *snapshot.io);
+    if (snapshot.overhead && snapshot.overhead->tick > 0)
+        renderOverhead(metrics, *snapshot.overhead);
+}
@@ -0,0 +1,79 @@
+#ifndef METRICSPAGE_H
+#define METRICSPAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "metricframe.h"
+
+/** The frames of one tick that go into a scrape. Collectors that are off or have nothing to report are null. */
+struct MetricsSnapshot {
+    const MetricFrame *frame = nullptr;
+    const CoreFrame *cores = nullptr;
+    const ProcessFrame *processes = nullptr;
+    const WatchFrame *watches = nullptr;
+    const CgroupFrame *cgroups = nullptr;
+    const ThreadFrame *threads = nullptr;
+    const IoFrame *io = nullptr;
+    const OverheadFrame *overhead = nullptr;
+
+    /** Null-terminated name of the foreground process. */
+    const char *foreground_name = nullptr;
+};
+
+/**
+ * The `/metrics` response in the Prometheus text exposition format, rendered once per tick and served as is.
+ *
+ * Every `render` writes a complete HTTP response, headers included, so serving a scrape is a single write of bytes that
+ * already exist. The responses live in a triple buffer: the writer renders into a buffer of its own and swaps it with
+ * the ready one, the reader swaps the ready one for its own in `acquire`. Neither side ever waits for the other and a
+ * buffer is never written while it is being served. Buffers keep their capacity, so rendering stops allocating after
+ * the first few ticks.
+ *
+ * One writer thread and one reader thread.
+ */
+class MetricsPage {
+    /** Bit of `ready` set when the ready buffer holds a render the reader has not acquired yet. */
+    static constexpr unsigned FRESH = 4;
+    static constexpr unsigned INDEX_MASK = 3;
+
+    std::string buffers[3];
+
+    /** Scratch for the body, the headers need its length first. Only touched by the writer. */
+    std::string body;
+
+    /** Buffer the writer renders into next. Only touched by the writer. */
+    unsigned write_index;
+
+    /** Index of the ready buffer, ORed with `FRESH`. */
+    std::atomic<unsigned> ready;
+
+    /** Buffer last handed out by `acquire`. Only touched by the reader. */
+    unsigned read_index;
+
+    std::atomic<uint64_t> render_count;
+
+public:
+    MetricsPage();
+
+    MetricsPage(const MetricsPage&) = delete;
+    MetricsPage& operator=(const MetricsPage&) = delete;
+
+    /** Render `snapshot` and make it the response of the next `acquire`. Writer thread only. */
+    void render(const MetricsSnapshot &snapshot);
+
+    /**
+     * The complete HTTP response of the newest render, a 503 before the first one. Reader thread only.
+     * Stays valid and unchanged until the next `acquire` of the same reader.
+     */
+    const std::string& acquire();
+
+    /** Completed renders. */
+    uint64_t renders() const;
+
+    /** Append the exposition of `snapshot`, without any HTTP framing, to `out`. */
+    static void renderBody(const MetricsSnapshot &snapshot, std::string &out);
+};
+
+#endif // METRICSPAGE_H
@@ -0,0 +1,283 @@
+#include "metricsserver.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char NOT_FOUND_RESPONSE[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain; charset=utf-8\r\n"
+    "Content-Length: 21\r\n"
+    "\r\n"
+    "Metrics are /metrics\n";
+
+constexpr const char NOT_ALLOWED_RESPONSE[] =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+constexpr const char HEADER_END[] = "\r\n\r\n";
+
+/** Polls wake up at least this often to drop idle connections. */
+constexpr int POLL_TIMEOUT_MS = 1000;
+
+/** `needle` is lower case. */
+bool containsIgnoringCase(const char *begin, const char *end, const char *needle) {
+    const size_t length = std::strlen(needle);
+    const auto matches = [](char text, char lower) {
+        return std::tolower(static_cast<unsigned char>(text)) == lower;
+    };
+    return std::search(begin, end, needle, needle + length, matches) != end;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(MetricsPage &page):
+    page{page},
+    listen_fd{-1},
+    wake_fd{-1},
+    bound_port{0},
+    scrape_count{0}
+{}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(uint16_t port) {
+    stop();
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        return false;
+    const int enable = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_size = sizeof(address);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &address_size) != 0 ||
+        (wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        const int saved_errno = errno;
+        ::close(listen_fd);
+        listen_fd = -1;
+        errno = saved_errno;
+        return false;
+    }
+
+    bound_port = ntohs(address.sin_port);
+    thread = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!thread.joinable())
+        return;
+
+    const uint64_t wake = 1;
+    if (write(wake_fd, &wake, sizeof(wake)) < 0)
+        return;
+    thread.join();
+
+    ::close(wake_fd);
+    ::close(listen_fd);
+    wake_fd = -1;
+    listen_fd = -1;
+    bound_port = 0;
+}
+
+bool MetricsServer::running() const {
+    return thread.joinable();
+}
+
+uint16_t MetricsServer::port() const {
+    return bound_port;
+}
+
+uint64_t MetricsServer::scrapes() const {
+    return scrape_count.load(std::memory_order_relaxed);
+}
+
+void MetricsServer::serve() {
+    std::vector<pollfd> fds;
+
+    while (true) {
+        // The wake descriptor, the listening socket (only while there is room) and every connection, in that order
+        fds.clear();
+        fds.push_back({wake_fd, POLLIN, 0});
+        fds.push_back({connections.size() < MAX_CONNECTIONS ? listen_fd : -1, POLLIN, 0});
+        for (const auto &connection : connections) {
+            const bool pending = connection->unsent_offset < connection->unsent.size();
+            fds.push_back({connection->fd, static_cast<short>(pending ? POLLIN | POLLOUT : POLLIN), 0});
+        }
+
+        if (poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) < 0 && errno != EINTR)
+            break;
+        if (fds[0].revents != 0)
+            break;
+
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < connections.size(); i++) {
+            Connection &connection = *connections[i];
+            const short events = fds[i + 2].revents;
+
+            bool open = true;
+            if ((events & (POLLERR | POLLNVAL)) != 0)
+                open = false;
+            if (open && (events & POLLOUT) != 0)
+                open = flush(connection);
+            if (open && (events & (POLLIN | POLLHUP)) != 0)
+                open = receive(connection);
+            if (open && connection.closing && connection.unsent_offset == connection.unsent.size())
+                open = false;
+            if (open && events == 0 && now - connection.last_active > std::chrono::milliseconds(IDLE_TIMEOUT_MS))
+                open = false;
+
+            if (!open) {
+                ::close(connection.fd);
+                connection.fd = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+            [](const std::unique_ptr<Connection> &connection) { return connection->fd < 0; }), connections.end());
+
+        if ((fds[1].revents & POLLIN) != 0)
+            accept();
+    }
+
+    for (const auto &connection : connections)
+        ::close(connection->fd);
+    connections.clear();
+}
+
+void MetricsServer::accept() {
+    while (connections.size() < MAX_CONNECTIONS) {
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        // Every response goes out in one send, don't let it wait for the ACK of the previous one
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->request_length = 0;
+        connection->unsent_offset = 0;
+        connection->closing = false;
+        connection->last_active = std::chrono::steady_clock::now();
+        connections.push_back(std::move(connection));
+    }
+}
+
+bool MetricsServer::receive(Connection &connection) {
+    while (!connection.closing) {
+        const ssize_t received = recv(connection.fd, connection.request + connection.request_length,
+                                      REQUEST_SIZE - connection.request_length, 0);
+        if (received == 0)
+            return false;
+        if (received < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        connection.request_length += static_cast<size_t>(received);
+        connection.last_active = std::chrono::steady_clock::now();
+
+        // Answer every complete request, pipelined ones included, and keep the start of the next
+        const char *begin = connection.request;
+        const char *end = begin + connection.request_length;
+        const char *request = begin;
+        while (!connection.closing) {
+            const char *header_end = std::search(request, end, HEADER_END, HEADER_END + sizeof(HEADER_END) - 1);
+            if (header_end == end)
+                break;
+            header_end += sizeof(HEADER_END) - 1;
+            if (!respond(connection, static_cast<size_t>(request - begin), static_cast<size_t>(header_end - begin)))
+                return false;
+            request = header_end;
+        }
+        connection.request_length = static_cast<size_t>(end - request);
+        std::memmove(connection.request, request, connection.request_length);
+
+        // A header that fills the whole buffer will never complete
+        if (connection.request_length == REQUEST_SIZE)
+            return false;
+    }
+    return true;
+}
+
+bool MetricsServer::respond(Connection &connection, size_t start, size_t end) {
+    const char *request = connection.request + start;
+    const char *request_end = connection.request + end;
+    const char *line_end = std::search(request, request_end, HEADER_END, HEADER_END + 2);
+
+    // HTTP/1.0 closes after every response unless asked not to, HTTP/1.1 keeps the connection unless asked to close
+    const bool http10 = containsIgnoringCase(request, line_end, "http/1.0");
+    connection.closing = http10 ? !containsIgnoringCase(line_end, request_end, "connection: keep-alive") :
+        containsIgnoringCase(line_end, request_end, "connection: close");
+
+    constexpr const char GET[] = "GET ";
+    constexpr const char PATH[] = "/metrics";
+    if (line_end - request < static_cast<ptrdiff_t>(sizeof(GET) - 1) ||
+        std::memcmp(request, GET, sizeof(GET) - 1) != 0)
+        return send(connection, NOT_ALLOWED_RESPONSE, sizeof(NOT_ALLOWED_RESPONSE) - 1);
+
+    const char *target = request + sizeof(GET) - 1;
+    const char *target_end = std::find(target, line_end, ' ');
+    const size_t target_length = static_cast<size_t>(target_end - target);
+    const bool metrics = target_length >= sizeof(PATH) - 1 && std::memcmp(target, PATH, sizeof(PATH) - 1) == 0 &&
+        (target_length == sizeof(PATH) - 1 || target[sizeof(PATH) - 1] == '?');
+    if (!metrics)
+        return send(connection, NOT_FOUND_RESPONSE, sizeof(NOT_FOUND_RESPONSE) - 1);
+
+    const std::string &response = page.acquire();
+    scrape_count.fetch_add(1, std::memory_order_relaxed);
+    return send(connection, response.data(), response.size());
+}
+
+bool MetricsServer::send(Connection &connection, const char *data, size_t length) {
+    // Behind a response that is still waiting, keep the order
+    if (connection.unsent_offset < connection.unsent.size()) {
+        connection.unsent.append(data, length);
+        return true;
+    }
+
+    ssize_t sent = ::send(connection.fd, data, length, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return false;
+        sent = 0;
+    }
+    connection.unsent.assign(data + sent, length - static_cast<size_t>(sent));
+    connection.unsent_offset = 0;
+    return true;
+}
+
+bool MetricsServer::flush(Connection &connection) {
+    while (connection.unsent_offset < connection.unsent.size()) {
+        const ssize_t sent = ::send(connection.fd, connection.unsent.data() + connection.unsent_offset,
+                                    connection.unsent.size() - connection.unsent_offset, MSG_NOSIGNAL);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        connection.unsent_offset += static_cast<size_t>(sent);
+        connection.last_active = std::chrono::steady_clock::now();
+    }
+    connection.unsent.clear();
+    connection.unsent_offset = 0;
+    return true;
+}
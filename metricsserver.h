@@ -0,0 +1,99 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metricspage.h"
+
+/**
+ * Serves `/metrics` from a `MetricsPage` over HTTP/1.1 on the loopback interface, for a local Prometheus to scrape.
+ *
+ * One thread polls the listening socket and every connection, all non-blocking. A scrape is answered with a single
+ * `send` of the response the sampler already rendered, nothing is formatted or locked on this thread. Connections are
+ * kept alive between scrapes unless the client asks otherwise, requests can be pipelined. Anything but `GET /metrics`
+ * gets a canned 404 or 405. Connections idle for `IDLE_TIMEOUT_MS` and requests larger than `REQUEST_SIZE` are
+ * dropped.
+ *
+ * Linux only.
+ */
+class MetricsServer {
+public:
+    /** Past the ports commonly taken by Prometheus exporters. */
+    static constexpr uint16_t DEFAULT_PORT = 9465;
+    static constexpr size_t MAX_CONNECTIONS = 64;
+    static constexpr size_t REQUEST_SIZE = 4096;
+    static constexpr int IDLE_TIMEOUT_MS = 30 * 1000;
+
+    explicit MetricsServer(MetricsPage &page);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * Listen on 127.0.0.1:`port` and start serving, 0 picks a free port (see `port`).
+     * @return false with `errno` set if the socket could not be bound.
+     */
+    bool start(uint16_t port);
+
+    /** Close every connection and join the serving thread. Safe to call when not started. */
+    void stop();
+
+    bool running() const;
+
+    /** Port listened on, 0 when not running. */
+    uint16_t port() const;
+
+    /** `/metrics` responses sent so far. */
+    uint64_t scrapes() const;
+
+private:
+    struct Connection {
+        int fd;
+        size_t request_length;
+        char request[REQUEST_SIZE];
+
+        /** Rest of a response the socket did not take at once. Owned, the page's buffer moves on. */
+        std::string unsent;
+        size_t unsent_offset;
+
+        /** Close once the response is out, the client asked for it. */
+        bool closing;
+
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    MetricsPage &page;
+    int listen_fd;
+    int wake_fd;
+    uint16_t bound_port;
+    std::atomic<uint64_t> scrape_count;
+    std::thread thread;
+
+    /** Only touched by the serving thread. */
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    void serve();
+    void accept();
+
+    /** Read and answer every complete request of `connection`. @return false once it is closed. */
+    bool receive(Connection &connection);
+
+    /** Answer the request at `[start, end)` of the connection's buffer. @return false on a send error. */
+    bool respond(Connection &connection, size_t start, size_t end);
+
+    /** Send `length` bytes, keeping what the socket does not take. @return false on error. */
+    bool send(Connection &connection, const char *data, size_t length);
+
+    /** Send what an earlier `send` kept back. @return false on error. */
+    bool flush(Connection &connection);
+};
+
+#endif // METRICSSERVER_H
@@ -1,10 +1,11 @@
 #include "procdata.h"
 
-ProcData::ProcData() {
+ProcData::ProcData(): processes{PROCESS_CACHE_SIZE} {
     pLocate = NULL;
     pServ = NULL;
     lastProc = 0;
-    lastProcHandle = NULL;
+    sampledProc = 0;
+    sampleCount = 0;
 
     HRESULT hres = CoInitializeSecurity(
         NULL,
@@ -55,8 +56,14 @@ ProcData::~ProcData() {
         pServ->Release();
     if (pLocate != NULL)
         pLocate->Release();
-    if (lastProcHandle != NULL)
-        CloseHandle(lastProcHandle);
+    processes.forEach([](DWORD, TrackedProcess &process) {
+        CloseHandle(process.handle);
+    });
+}
+
+bool ProcData::procHandleValid(HANDLE procHandle) {
+    DWORD handleStatus = WaitForSingleObject(procHandle, 0);
+    return handleStatus == WAIT_TIMEOUT;
 }
 
 bool ProcData::initSuccessful() const {
@@ -64,22 +71,46 @@ bool ProcData::initSuccessful() const {
 }
 
 HANDLE ProcData::getFgProcHandle() {
-    HWND hForeground = GetForegroundWindow();
-    DWORD procId;
-    DWORD procThreadId = GetWindowThreadProcessId(hForeground, &procId);
+    TrackedProcess *process = foreground();
+    return process != nullptr ? process->handle : NULL;
+}
 
-    if (procId == 0)
-        return NULL;
+ProcData::TrackedProcess* ProcData::foreground() {
+    HWND hForeground = GetForegroundWindow();
+    DWORD procId = 0;
+    GetWindowThreadProcessId(hForeground, &procId);
 
-    if (procId == lastProc && lastProcHandle != NULL)
-        return lastProcHandle;
+    lastProc = procId;
+    return trackProcess(procId);
+}
 
-    if (lastProcHandle != NULL)
-        CloseHandle(lastProcHandle);
+ProcData::TrackedProcess* ProcData::trackProcess(DWORD pid) {
+    if (pid == 0)
+        return nullptr;
+    if (TrackedProcess *known = processes.find(pid))
+        return known;
+
+    // SYNCHRONIZE for `procHandleValid`
+    HANDLE handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, TRUE, pid);
+    if (handle == NULL)
+        return nullptr;
+
+    TrackedProcess fresh;
+    fresh.handle = handle;
+    FILETIME creation_time, scratch_time;
+    if (GetProcessTimes(handle, &creation_time, &scratch_time, &scratch_time, &scratch_time))
+        fresh.start_time = filetimeSum(creation_time, FILETIME{0, 0});
+
+    if (const DWORD *oldest = processes.leastRecent())
+        dropProcess(*oldest);
+    return &processes.insert(pid, std::move(fresh));
+}
 
-    lastProc = procId;
-    lastProcHandle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, TRUE, procId);
-    return lastProcHandle;
+void ProcData::dropProcess(DWORD pid) {
+    if (const TrackedProcess *process = processes.peek(pid)) {
+        CloseHandle(process->handle);
+        processes.erase(pid);
+    }
 }
 
 unsigned long long ProcData::filetimeSum(FILETIME ft0, FILETIME ft1) {
@@ -110,39 +141,38 @@ std::string ProcData::getLastPathItem(LPWSTR path, DWORD size) {
      * - LPWSTR and CHAR resolve to wchar_t* and wchar_t and thus can be used with std::wstring
      */
     LPWSTR end_sentinel = path + size;
-    LPWSTR start_sentinel = end_sentinel - 1;
-    bool found_item = false;
+    LPWSTR start_sentinel = end_sentinel;
 
-
-    while (start_sentinel > path && !found_item) {
-        WCHAR ch = *start_sentinel;
-        if (ch == L'\\') {
-            found_item = true;
-        }
+    while (start_sentinel > path && *(start_sentinel - 1) != L'\\') {
+        start_sentinel--;
     }
     DWORD wchar_conversion_status = WideCharToMultiByte(
         CP_UTF8,
         0,
-        (LPCWCH) end_sentinel,
+        (LPCWCH) start_sentinel,
         -1,
         NULL,
         0,
         NULL,
         NULL
     );
+    if (wchar_conversion_status == 0)
+        return std::string("");
 
+    // The converted length counts the terminator, std::string keeps its own
     auto last_item = std::string(static_cast<size_t>(wchar_conversion_status), '\0');
 
     WideCharToMultiByte(
         CP_UTF8,
         0,
-        (LPCWCH) end_sentinel,
+        (LPCWCH) start_sentinel,
         -1,
         last_item.data(),
         wchar_conversion_status,
         NULL,
         NULL
     );
+    last_item.resize(wchar_conversion_status - 1);
 
     return last_item;
 }
@@ -152,6 +182,10 @@ unsigned long long ProcData::getTotalProcessTime() {
     if (hProc == NULL)
         return ~0x0u;
 
+    return readProcessTime(hProc);
+}
+
+unsigned long long ProcData::readProcessTime(HANDLE hProc) {
     FILETIME scratch_time;
     FILETIME kernel_time;
     FILETIME user_time;
@@ -177,13 +211,74 @@ unsigned long long ProcData::getTotalCpuTime() {
     return (time_spent - idle_in_kernel) / MICROSEC_TO_FILETIME;
 }
 
+const CpuCoreStats& ProcData::getCoreStats() const {
+    return coreStats;
+}
+
+bool ProcData::updateProcessTable(double) {
+    return false;
+}
+
+size_t ProcData::getProcessCount() const {
+    return 0;
+}
+
+const std::vector<ProcessInfo>& ProcData::getTopCpuProcesses() const {
+    return noProcesses;
+}
+
+const std::vector<ProcessInfo>& ProcData::getTopMemoryProcesses() const {
+    return noProcesses;
+}
+
+void ProcData::setCgroupSelection(const std::vector<std::string> &) {}
+
+bool ProcData::updateCgroups(double) {
+    return false;
+}
+
+const std::vector<CgroupInfo>& ProcData::getCgroups() const {
+    return noCgroups;
+}
+
+bool ProcData::updateThreads(double) {
+    return false;
+}
+
+size_t ProcData::getThreadCount() const {
+    return 0;
+}
+
+const std::vector<ThreadInfo>& ProcData::getTopThreads() const {
+    return noThreads;
+}
+
+bool ProcData::updateIo(double) {
+    return false;
+}
+
+const IoRate& ProcData::getForegroundIo() const {
+    return noIo;
+}
+
+const std::vector<IoRate>& ProcData::getWatchIo() const {
+    return noWatchIo;
+}
+
+const std::vector<DiskInfo>& ProcData::getDisks() const {
+    return noDisks;
+}
+
 unsigned long long ProcData::getFgProcessMemory() {
     HANDLE hProc = getFgProcHandle();
-    PROCESS_MEMORY_COUNTERS pc;
-
     if (hProc == NULL)
         return 0;
 
+    return readProcessMemory(hProc);
+}
+
+unsigned long long ProcData::readProcessMemory(HANDLE hProc) {
+    PROCESS_MEMORY_COUNTERS pc;
     BOOL queryRes = GetProcessMemoryInfo(hProc, &pc, sizeof(pc));
     if (queryRes == TRUE)
         return pc.WorkingSetSize;
@@ -192,80 +287,171 @@ unsigned long long ProcData::getFgProcessMemory() {
 
 std::string ProcData::getFgProcessName() {
 
-    HANDLE fgHandle = getFgProcHandle();
+    TrackedProcess *process = foreground();
 
-    if (fgHandle == NULL)
+    if (process == nullptr)
         return std::string("");
 
-    DWORD written_size = PROC_NAME_MAX_LENGTH;
-    WCHAR titleBuffer[PROC_NAME_MAX_LENGTH];
-    QueryFullProcessImageName(fgHandle, 0, titleBuffer, &written_size);
-    std::string process_name = getLastPathItem(titleBuffer, written_size);
-
-    return process_name;
+    return std::string(processName(*process));
 }
 
-bool ProcData::correctInstanceType(std::vector<WCHAR>::iterator beg, std::vector<WCHAR>::iterator end) {
-
-    const std::wstring expectedEnding = std::wstring(L"engtype_3D");
-
-    if (end - beg < 0 || end - beg < expectedEnding.size()) return false;
-    auto sentinel = end - expectedEnding.size();
+const char* ProcData::processName(TrackedProcess &process) {
+    if (process.named)
+        return process.name;
 
-    std::wstring parsedEnding = std::wstring(sentinel, end);
+    DWORD written_size = PROC_NAME_MAX_LENGTH;
+    WCHAR titleBuffer[PROC_NAME_MAX_LENGTH];
+    if (!QueryFullProcessImageName(process.handle, 0, titleBuffer, &written_size)) {
+        process.name[0] = '\0';
+        return process.name;
+    }
 
-    return expectedEnding == parsedEnding;
+    std::string process_name = getLastPathItem(titleBuffer, written_size);
+    size_t length = process_name.size() < sizeof(process.name) ? process_name.size() : sizeof(process.name) - 1;
+    memcpy(process.name, process_name.data(), length);
+    process.name[length] = '\0';
+    process.named = true;
+    return process.name;
 }
 
-bool ProcData::instanceHasPid(DWORD pid, std::vector<WCHAR>::iterator beg, std::vector<WCHAR>::iterator end) {
-    std::wstring pidString = std::to_wstring(pid);
-    const std::wstring expected_prefix = std::wstring(L"pid");
+void ProcData::sampleProcess(TrackedProcess &process) {
+    if (process.sampled_at == sampleCount)
+        return;
 
-    bool parsedPidPrefix = false;
-    auto sentinel = beg;
+    const unsigned long long time = readProcessTime(process.handle);
+    process.has_delta = process.sampled_at != 0 && process.sampled_at + 1 == sampleCount &&
+        time >= process.process_time;
+    process.time_delta = process.has_delta ? time - process.process_time : 0;
+    process.process_time = time;
+    process.memory = readProcessMemory(process.handle);
+    process.sampled_at = sampleCount;
+}
 
-    // Keep it for DRY
-    auto advanceSentinel = [&sentinel]() {
-        while (*sentinel != L'_') sentinel++;
-    };
+bool ProcData::sample(SampleFrame &frame) {
+    sampleCount++;
+    frame.cpu_time = getTotalCpuTime();
+
+    MEMORYSTATUSEX memory_status;
+    memory_status.dwLength = sizeof(memory_status);
+    bool complete = GlobalMemoryStatusEx(&memory_status) == TRUE;
+    frame.mem_total = complete ? memory_status.ullTotalPhys : 0;
+    frame.mem_available = complete ? memory_status.ullAvailPhys : 0;
+
+    TrackedProcess *process = foreground();
+    DWORD pid = process != nullptr ? lastProc : 0;
+    frame.process = process != nullptr ? process->handle : NULL;
+    frame.process_changed = pid != sampledProc;
+    sampledProc = pid;
+
+    // The GPU engine counters are not queried on Win32 yet, see `getFgProcessGpuUsage`
+    frame.process_gpu_use = 0.0;
+
+    if (process == nullptr) {
+        frame.process_time = ~0x0u;
+        frame.process_time_delta = 0;
+        frame.process_delta_valid = false;
+        frame.process_memory = 0;
+        frame.process_breakdown = MemoryBreakdown{};
+        frame.process_name[0] = '\0';
+        complete = false;
+    } else {
+        sampleProcess(*process);
+        frame.process_time = process->process_time;
+        frame.process_time_delta = process->time_delta;
+        frame.process_delta_valid = process->has_delta;
+        frame.process_memory = process->memory;
+        // The working set is all there is here, shared pages are not told apart yet
+        frame.process_breakdown = MemoryBreakdown{};
+        frame.process_breakdown.rss = process->memory;
+        memcpy(frame.process_name, processName(*process), sizeof(process->name));
+    }
 
-    // parse for "pid" first, then attempt to parse the number
-    advanceSentinel();
-    std::wstring parsed_prefix = std::wstring(beg, sentinel);
-    if (expected_prefix != parsed_prefix) return false;
-    
-    beg = sentinel + 1;
-    sentinel += 2;
-    if (sentinel >= end) return false;
-    advanceSentinel();
-    std::wstring parsedPid = std::wstring(beg, sentinel);
+    sampleWatches(frame);
+    return complete;
+}
 
-    return pidString == parsedPid;
+void ProcData::setWatchTargets(const std::vector<WatchTarget> &targets) {
+    watchList.clear();
+    for (const WatchTarget &target : targets) {
+        if (watchList.size() == WatchTarget::MAX_TARGETS)
+            break;
+        watchList.push_back(WatchState{target, 0, false, false});
+    }
 }
 
-std::vector<WCHAR> ProcData::parseGpuCounterPaths(std::vector<WCHAR> &instances) {
-    
-    // First isolate the individual instances, then check for PID and the correct ending
-    for (auto left_outer = instances.begin(); left_outer < instances.end(); left_outer++) {
-        if (*left_outer == L'\0') continue;
+void ProcData::addWatchMatch(DWORD pid, const TrackedProcess &process, WatchSample &watch) {
+    if (watch.matches == 0) {
+        watch.pid = static_cast<int32_t>(pid);
+        strncpy(watch.name, process.name, WatchSample::NAME_SIZE - 1);
+        watch.name[WatchSample::NAME_SIZE - 1] = '\0';
+    }
+    watch.matches++;
+    watch.time_delta += process.time_delta;
+    watch.memory += process.memory;
+}
 
-        auto right_inner = left_outer + 1;
-        while (*right_inner != L'\0') right_inner++;
-        
-        if ( instanceHasPid(lastProc, left_outer, right_inner) && correctInstanceType(left_outer, right_inner)) {
-            return std::vector<WCHAR>(left_outer, right_inner);
+void ProcData::sampleWatches(SampleFrame &frame) {
+    frame.watch_count = static_cast<uint32_t>(watchList.size());
+
+    for (size_t i = 0; i < watchList.size(); i++) {
+        WatchState &state = watchList[i];
+        WatchSample &watch = frame.watches[i];
+        watch = WatchSample{};
+
+        // Entries are only used up to the next lookup, which may evict them
+        switch (state.target.kind) {
+        case WatchTarget::Kind::Foreground:
+        case WatchTarget::Kind::Name: {
+            // Without a process table the foreground, resolved by `sample` already, is the only candidate
+            TrackedProcess *process = trackProcess(lastProc);
+            if (process == nullptr)
+                break;
+            if (state.target.kind == WatchTarget::Kind::Name &&
+                !matchNamePattern(state.target.pattern.c_str(), processName(*process)))
+                break;
+            sampleProcess(*process);
+            processName(*process);
+            addWatchMatch(lastProc, *process, watch);
+            break;
+        }
+        case WatchTarget::Kind::Pid: {
+            if (state.gone)
+                break;
+            const DWORD pid = static_cast<DWORD>(state.target.pid);
+            TrackedProcess *process = trackProcess(pid);
+            if (process == nullptr) {
+                state.gone = state.resolved;
+                break;
+            }
+            // The foreground is known to be alive, a watched PID is not
+            if (!procHandleValid(process->handle) || (state.resolved && process->start_time != state.start_time)) {
+                dropProcess(pid);
+                state.gone = true;
+                break;
+            }
+            state.start_time = process->start_time;
+            state.resolved = true;
+            sampleProcess(*process);
+            processName(*process);
+            addWatchMatch(pid, *process, watch);
+            break;
+        }
         }
     }
-    return std::vector<WCHAR>();
 }
-std::vector<WCHAR> ProcData::getFgGpuPath() {
-    using std::vector;
+
+std::wstring_view ProcData::parseGpuCounterPaths(const std::vector<WCHAR> &instances) {
+    gpuInstances.update(instances.data(), instances.size());
+    return gpuInstances.find(static_cast<uint32_t>(lastProc));
+}
+
+std::wstring_view ProcData::getFgGpuPath() {
     constexpr auto GPU_ENGINE_PREFIX = L"GPU Engine";
     constexpr auto GPU_ENGINE_FORMAT = L"\\GPU Engine\\(%s)\\Utilization Percentage";
 
     // Trying to avoid excessive foreground process queries
     if (lastProc == NULL) {
-        return vector<WCHAR>();
+        return {};
     }
     // Enumeration through GPU instances first
     // PdhEnumObjectItems called twice, first to get size of string, then to allocate a string with 
@@ -281,24 +467,28 @@ std::vector<WCHAR> ProcData::getFgGpuPath() {
         PERF_DETAIL_WIZARD,
         0
     );
-    auto instanceString = vector<WCHAR>(instanceSz);
-    PdhEnumObjectItemsW(
+    // The buffer keeps its capacity, only a longer enumeration than any before allocates
+    gpuInstanceBuffer.resize(instanceSz);
+    PDH_STATUS status = PdhEnumObjectItemsW(
         NULL,
         NULL,
         GPU_ENGINE_PREFIX,
         NULL,
         &counterSz,
-        instanceString.data(),
+        gpuInstanceBuffer.data(),
         &instanceSz,
         PERF_DETAIL_WIZARD,
         0
     );
-    // We assume each instance will at least begin with pid_#
-    return parseGpuCounterPaths(instanceString);
+    if (status != ERROR_SUCCESS) {
+        return {};
+    }
+    gpuInstanceBuffer.resize(instanceSz);
+    return parseGpuCounterPaths(gpuInstanceBuffer);
 }
 
 double ProcData::getFgProcessGpuUsage() {
     getFgProcHandle();
-    std::vector<WCHAR> gpuPath = getFgGpuPath();
+    std::wstring_view gpuPath = getFgGpuPath();
     return 0.0;
 }
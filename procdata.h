@@ -1,6 +1,7 @@
 #ifndef PROCDATA_H
 #define PROCDATA_H
 
+#ifdef _WIN32
 #define _WIN32_DCOM
 
 #include <windows.h>
@@ -10,17 +11,106 @@
 #include <Pdh.h>
 #include <winnt.h>
 
+#pragma comment(lib, "wbemuuid.lib")
+#else
+#include <sys/types.h>
+
+#include "drmclients.h"
+#include "procfile.h"
+#include "procwatch.h"
+#endif
+
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#pragma comment(lib, "wbemuuid.lib")
+#include "cgrouptable.h"
+#include "cpucores.h"
+#include "diskio.h"
+#include "gpuinstances.h"
+#include "lrucache.h"
+#include "meminfo.h"
+#include "proctable.h"
+#include "threadtable.h"
+#include "watchlist.h"
+
+#ifdef _WIN32
+/** Native reference to a tracked process. */
+using ProcHandle = HANDLE;
+#else
+/** On Linux a tracked process is referred to by PID, `ProcData` owns the descriptors to its procfs entries. */
+using ProcHandle = pid_t;
+#endif
+
+/**
+ * Everything `ProcData::sample` gathers in one tick. Owned by the caller and plain data,
+ * so one instance can be refilled every tick without allocating.
+ */
+struct SampleFrame {
+    /** Win32 limits image names to 256 wide characters, UTF-8 may need a little more. */
+    static constexpr unsigned NAME_SIZE = 512;
+
+    /** Tracked process the per-process fields refer to, resolved once per sample. Null (0 on Linux) if none. */
+    ProcHandle process;
+
+    /** Whether `process` differs from the one of the previous sample. */
+    bool process_changed;
+
+    /** Monotonic time of the sample in microseconds. Not filled in by `ProcData`, the `SampleSource` stamps it. */
+    int64_t time_us;
+
+    /** Bytes of physical memory. */
+    unsigned long long mem_total;
+
+    /** Bytes of physical memory available to new allocations. */
+    unsigned long long mem_available;
+
+    /** Same as `getTotalCpuTime`. */
+    unsigned long long cpu_time;
+
+    /** Same as `getTotalProcessTime`, `~0x0u` without a process. */
+    unsigned long long process_time;
+
+    /** CPU time of `process` since the previous sample in microseconds, only meaningful with `process_delta_valid`. */
+    unsigned long long process_time_delta;
+
+    /**
+     * Whether `process` was also read on the previous sample, as the foreground or as a watched target.
+     * False for a process that just came into focus without being watched, it has no baseline yet.
+     */
+    bool process_delta_valid;
+
+    /** Same as `getFgProcessMemory`. */
+    unsigned long long process_memory;
+
+    /**
+     * Memory of `process` by how it is shared. `rss` is `process_memory`, the rest is only `detailed` on Linux and is
+     * refreshed every `ProcData::BREAKDOWN_INTERVAL_US` rather than every sample, see `ProcData::sample`.
+     */
+    MemoryBreakdown process_breakdown;
+
+    /** Same as `getFgProcessGpuUsage`, busy share of the busiest GPU engine since the previous sample. */
+    double process_gpu_use;
+
+    /** Null-terminated image name of `process`, only looked up again when the process changes. */
+    char process_name[NAME_SIZE];
+
+    /** Entries of `watches` filled in, one per target passed to `ProcData::setWatchTargets`. */
+    uint32_t watch_count;
+
+    WatchSample watches[WatchTarget::MAX_TARGETS];
+};
 
 /**
  * Interface for interacting with the OS API. Where possible, any implementation code should avoid
- * using anything not defined in the Win32 API or the standard library.
+ * using anything not defined in the Win32 API (or POSIX and procfs on Linux) or the standard library.
+ * The Win32 implementation lives in procdata.cpp, the Linux one in procdata_linux.cpp.
  */
 class ProcData {
 
+#ifdef _WIN32
+
     /** Reminder: the full quad-word stored in FILETIME represents the number of 100-nanosecond units. */
     static constexpr int MICROSEC_TO_FILETIME =  10;
 
@@ -45,14 +135,335 @@ class ProcData {
     /** WMI service interface. */
     IWbemServices *pServ;
 
-    /** ID of the last process that got queried. */
+    /** ID of the process owning the foreground window at the last query. */
     DWORD lastProc;
 
-    /** Handle to the process identified by `lastProc`. */
-    HANDLE lastProcHandle;
+    /** Process reported by the previous `sample`. */
+    DWORD sampledProc;
+
+    /**
+     * Handle and counters of one process. Kept across focus changes, so coming back to a process reopens
+     * nothing and finds the counters of the previous sample to take a delta against, if it was read on it.
+     */
+    struct TrackedProcess {
+        /** Closed by `dropProcess`, the cache itself only resets the value. */
+        HANDLE handle = NULL;
+
+        /** Creation time as a FILETIME quad-word. Together with the PID it identifies the process. */
+        unsigned long long start_time = 0;
+
+        /** `sampleCount` of the sample that last read the fields below, 0 if none did. */
+        uint64_t sampled_at = 0;
+
+        /** CPU time in microseconds and working set bytes as of `sampled_at`. */
+        unsigned long long process_time = 0;
+        unsigned long long memory = 0;
+
+        /** Growth of `process_time` since the sample before `sampled_at`, if it was read on that one too. */
+        unsigned long long time_delta = 0;
+        bool has_delta = false;
+
+        /** Null-terminated image name, queried once. */
+        char name[SampleFrame::NAME_SIZE] = {};
+        bool named = false;
+    };
+
+    /** Recent foregrounds plus every watched process. */
+    static constexpr size_t PROCESS_CACHE_SIZE = 32;
+
+    /** A watch list entry and, for a `Pid` target, the process it turned out to be. */
+    struct WatchState {
+        WatchTarget target;
+
+        /** Creation time of the process first found behind `target.pid`, valid once `resolved`. */
+        unsigned long long start_time;
+        bool resolved;
+
+        /** The process behind a `Pid` target exited, its PID is not looked at again. */
+        bool gone;
+    };
+
+    /** Samples taken so far, `TrackedProcess::sampled_at` counts in these. */
+    uint64_t sampleCount;
+
+    /** Every process with an open handle, by PID. A handle keeps its PID from being reused while it is open. */
+    LruCache<DWORD, TrackedProcess> processes;
+
+    std::vector<WatchState> watchList;
+
+    /** Cached entry for `pid`, opening a handle on a miss or when the cached process exited. Null if it can't be. */
+    TrackedProcess* trackProcess(DWORD pid);
+
+    /** Close the handle of `pid` and forget its counters. */
+    void dropProcess(DWORD pid);
+
+    /** Entry of the process owning the foreground window, also updates `lastProc`. */
+    TrackedProcess* foreground();
+
+    /** Read CPU time and memory of `process` for the current sample, at most once however many targets it belongs to. */
+    void sampleProcess(TrackedProcess &process);
+
+    /** Fill `frame.watches` from the watch list, called by `sample` after the foreground. */
+    void sampleWatches(SampleFrame &frame);
+
+    /** Count `process` towards `watch`. */
+    static void addWatchMatch(DWORD pid, const TrackedProcess &process, WatchSample &watch);
+
+    /** Image name of `process`, only queried once per process. */
+    const char* processName(TrackedProcess &process);
+
+    /** Readers for an already resolved process handle. */
+    unsigned long long readProcessTime(HANDLE hProc);
+    unsigned long long readProcessMemory(HANDLE hProc);
+
+    /** Stays empty until the process table has a Win32 implementation. */
+    std::vector<ProcessInfo> noProcesses;
+
+    /** Windows has no cgroups, stays empty. */
+    std::vector<CgroupInfo> noCgroups;
+
+    /** Stays empty until threads are enumerated on Win32 too. */
+    std::vector<ThreadInfo> noThreads;
+
+    /** Stay zero and empty until I/O is read on Win32 too. */
+    IoRate noIo;
+    std::vector<IoRate> noWatchIo;
+    std::vector<DiskInfo> noDisks;
+
+    /** Last "GPU Engine" instance enumeration, reused between calls. */
+    std::vector<WCHAR> gpuInstanceBuffer;
+
+    /** Engine instances of `gpuInstanceBuffer` by PID, only rebuilt when the enumeration changes. */
+    GpuInstanceIndex gpuInstances;
+
+#else
+    /** Longest `/proc/<pid>/stat` line we expect, the comm field is capped at 16 bytes so 1 KiB is plenty. */
+    static constexpr unsigned PID_STAT_BUFFER_SIZE = 1024;
+
+    /**
+     * Room per line of the `cpu` block in `/proc/stat`: ten counters of up to 20 digits each.
+     * The buffer is sized from the configured core count and only grows if the block still does not fit.
+     */
+    static constexpr unsigned SYS_STAT_LINE_SIZE = 256;
+
+    /** `/proc/<pid>/statm` is a handful of integers. */
+    static constexpr unsigned SMALL_BUFFER_SIZE = 128;
+
+    /** The kernel caps comm at 16 bytes including the terminator. */
+    static constexpr unsigned COMM_BUFFER_SIZE = 32;
+
+    /** MemTotal, MemFree and MemAvailable are the first three lines of `/proc/meminfo`. */
+    static constexpr unsigned MEMINFO_BUFFER_SIZE = 256;
+
+    /** `/proc/<pid>/smaps_rollup` is a header and about twenty short lines. */
+    static constexpr unsigned SMAPS_BUFFER_SIZE = 2048;
+
+    /** `/proc/<pid>/io` is seven counters. */
+    static constexpr unsigned IO_BUFFER_SIZE = 256;
+
+    static constexpr unsigned long long BYTES_PER_KB = 1024;
+
+    static constexpr unsigned long long MICROSEC_PER_SEC = 1000000;
+
+    /**
+     * smaps_rollup walks every mapping of the process under its mmap lock, which takes milliseconds for a large
+     * process and holds up its page faults meanwhile. Read it at most this often instead of every sample.
+     */
+    static constexpr int64_t BREAKDOWN_INTERVAL_US = 1000000;
+
+    /** Set to true if `/proc/stat` could be opened and sysconf returned sane values. */
+    bool initSuccess;
+
+    /** USER_HZ, units of the tick counters in procfs. */
+    unsigned long long clockTicks;
+
+    /** Bytes per page, units of `/proc/<pid>/statm`. */
+    unsigned long long pageSize;
+
+    /** Process that should be reported as the "foreground" one. */
+    pid_t targetPid;
+
+    /** `targetPid` exited, nothing is reported for it until the target is set again. */
+    bool targetExited;
+
+    /** `/proc/stat`, opened once in the constructor. */
+    ProcFile sysStat;
+
+    /** `/proc/meminfo`, opened once in the constructor. */
+    ProcFile memInfo;
+
+    /** Remembers where the keys of `memInfo` are. */
+    MemInfoParser memInfoParser;
+
+    /** Monotonic time from which the next `sample` reads the foreground's memory breakdown. */
+    int64_t nextBreakdownUs;
+
+    /** Process reported by the previous `sample`. */
+    pid_t sampledProc;
+
+    /**
+     * Descriptors and counters of one process. Kept across focus changes, so coming back to a process reopens
+     * nothing and finds the counters of the previous sample to take a delta against, if it was read on it.
+     */
+    struct TrackedProcess {
+        /** `/proc/<pid>/stat`, `statm` and `comm`. */
+        ProcFile stat;
+        ProcFile statm;
+        ProcFile comm;
+
+        /** `/proc/<pid>/smaps_rollup`, opened the first time the process is in the foreground when a breakdown is due. */
+        ProcFile smaps_rollup;
+        bool smaps_opened = false;
+
+        /** Last read of `smaps_rollup`, not `detailed` before the first one or without the file. */
+        MemoryBreakdown breakdown = {};
+
+        /** `/proc/<pid>/io`, opened the first time `updateIo` reads the process. Owner or ptrace access only. */
+        ProcFile io;
+        bool io_opened = false;
+
+        /** Counters as of `ioUpdates` `io_read_at`, and the rates since the read before if that was the previous one. */
+        IoCounters io_counters = {};
+        uint64_t io_read_at = 0;
+        IoRate io_rate = {};
+
+        /** Start time in ticks since boot, read on open. Together with the PID it identifies the process. */
+        unsigned long long start_time = 0;
+
+        /** `sampleCount` of the sample that last read the fields below, 0 if none did. */
+        uint64_t sampled_at = 0;
+
+        /** CPU time in microseconds and resident bytes as of `sampled_at`. */
+        unsigned long long process_time = 0;
+        unsigned long long memory = 0;
+
+        /** Growth of `process_time` since the sample before `sampled_at`, if it was read on that one too. */
+        unsigned long long time_delta = 0;
+        bool has_delta = false;
+
+        /** Null-terminated comm, read once. */
+        char name[COMM_BUFFER_SIZE] = {};
+        bool named = false;
+    };
+
+    /** Room for a full watch list with every name target at `WatchTarget::MAX_MATCHES`, plus recent foregrounds. */
+    static constexpr size_t PROCESS_CACHE_SIZE = 96;
+
+    /** A watch list entry and, for a `Pid` target, the process it turned out to be. */
+    struct WatchState {
+        WatchTarget target;
+
+        /** Start time of the process first found behind `target.pid`, valid once `resolved`. */
+        unsigned long long start_time;
+        bool resolved;
+
+        /** The process behind a `Pid` target exited, its PID is not looked at again. */
+        bool gone;
+
+        /** Processes the last `sample` counted towards the target, for `updateIo`. */
+        int32_t matched[WatchTarget::MAX_MATCHES];
+        uint32_t matched_count;
+    };
+
+    /** Samples taken so far, `TrackedProcess::sampled_at` counts in these. */
+    uint64_t sampleCount;
+
+    /**
+     * Every process with open descriptors, by PID. Descriptors stay bound to the process they were opened for,
+     * so an entry never reads a newer process that reused its PID: reads fail instead and the entry is dropped.
+     */
+    LruCache<pid_t, TrackedProcess> processes;
+
+    std::vector<WatchState> watchList;
+
+    /** Scratch space for resolving `Name` targets. */
+    std::vector<int32_t> watchMatches;
+
+    /** Scratch space for the `cpu` block of `/proc/stat`. */
+    std::vector<char> sysStatBuffer;
+
+    /** Scratch space shared by the per-process files, they are never read at the same time. Sized for the largest. */
+    char procBuffer[SMAPS_BUFFER_SIZE];
+
+    /** Every process on the system, refreshed by `updateProcessTable`. */
+    ProcessTable processTable;
+
+    /** cgroup v2 groups, refreshed by `updateCgroups`. */
+    CgroupTable cgroupTable;
+
+    /** Threads of `targetPid`, refreshed by `updateThreads`. */
+    ThreadTable threadTable;
+
+    /** Block devices, refreshed by `updateIo`. */
+    DiskStats diskStats;
+
+    /** Calls to `updateIo` so far, `TrackedProcess::io_read_at` counts in these. */
+    uint64_t ioUpdates;
+
+    /** I/O of the foreground and of every watch list entry as of the last `updateIo`. */
+    IoRate foregroundIo;
+    std::vector<IoRate> watchIo;
+
+    /** DRM descriptors of the tracked processes, for GPU utilization. */
+    DrmClientTable gpuClients;
+
+    /** pidfd of every entry of `processes`, an exit drops the entry in `handleProcessExits`. */
+    ProcessWatcher lifetimes;
+
+    /** Scratch space for `handleProcessExits`. */
+    std::vector<int32_t> exitedPids;
+
+    /** CLOCK_MONOTONIC in microseconds, GPU utilization is measured against it. */
+    static int64_t monotonicUs();
+
+    /**
+     * Cached entry for `pid`, opening its descriptors on a miss. Opening into a full cache closes the least
+     * recently used entry. Null if the process can't be opened.
+     */
+    TrackedProcess* trackProcess(pid_t pid);
+
+    /** Open the per-process descriptors of `pid` into `process` and read its start time. */
+    bool openProcess(pid_t pid, TrackedProcess &process);
+
+    /** Close the descriptors of `pid` and forget its counters. */
+    void dropProcess(pid_t pid);
+
+    /** Entry of `targetPid`, null if there is no target or it exited. */
+    TrackedProcess* foreground();
+
+    /**
+     * Read CPU time and memory of `pid` for the current sample, at most once however many targets it belongs to.
+     * @return false if the process is gone, its entry is dropped then.
+     */
+    bool sampleProcess(pid_t pid, TrackedProcess &process);
+
+    /** Fill `frame.watches` from the watch list, called by `sample` after the foreground. */
+    void sampleWatches(SampleFrame &frame);
+
+    /** Count `process` towards `watch`. */
+    static void addWatchMatch(pid_t pid, const TrackedProcess &process, WatchSample &watch);
+
+    /** Readers for an entry's descriptors. */
+    unsigned long long readProcessTime(TrackedProcess &process);
+    unsigned long long readProcessMemory(TrackedProcess &process);
+    const char* processName(TrackedProcess &process);
+
+    /** Physical memory totals in bytes. */
+    bool readMemInfo(unsigned long long &total, unsigned long long &available);
+
+    /** Re-read the PSS, USS and swap of `process` into its `breakdown`. */
+    void readMemoryBreakdown(pid_t pid, TrackedProcess &process);
+
+    /** Re-read the I/O counters of `process` into its `io_rate`, at most once per `updateIo`. */
+    void readProcessIo(pid_t pid, TrackedProcess &process, double elapsedSeconds);
+
+#endif
+
+    /** Per-core counters and ratios, refreshed by `getTotalCpuTime`. */
+    CpuCoreStats coreStats;
 
-    
 public:
+#ifdef _WIN32
     /** Sets up program to make necessary WMI calls. Avoid creating more than one COM Object */
     ProcData();
 
@@ -71,21 +482,52 @@ public:
     /** Get the last item of a \-delimited path. */
     static std::string getLastPathItem(LPWSTR path, DWORD size);
 
-    /** Retrieves the engtype_3D instances from a large double-null separated string. */
-    std::vector<WCHAR> parseGpuCounterPaths(std::vector<WCHAR> &instanceList);
-
-    /** Check if a GPU instance path has the given PID. */
-    static bool instanceHasPid(DWORD pid, std::vector<WCHAR>::iterator beg, std::vector<WCHAR>::iterator end);
-
-    /** Check if an instance path has the correct one for GPU 3D utilization. */
-    static bool correctInstanceType(std::vector<WCHAR>::iterator beg, std::vector<WCHAR>::iterator end);
+    /**
+     * Retrieves the engtype_3D instance of the foreground process from a large double-null separated string.
+     * The string is only parsed again when it differs from the previous call's.
+     * @return View into a copy of the string, null-terminated and valid until the string changes. Empty if none.
+     */
+    std::wstring_view parseGpuCounterPaths(const std::vector<WCHAR> &instanceList);
 
-    /** Get the instance path for the foreground process. */
-    std::vector<WCHAR> getFgGpuPath();
+    /** Get the instance path for the foreground process, same lifetime as `parseGpuCounterPaths`. */
+    std::wstring_view getFgGpuPath();
 
     /** Check that the process handle hasn't timed out. */
     static bool procHandleValid(HANDLE);
-    
+#else
+    /** Opens `/proc/stat`. The tracked process defaults to this process until `setTargetPid` is called. */
+    ProcData();
+
+    ~ProcData();
+
+    ProcData(const ProcData&) = delete;
+    ProcData& operator=(const ProcData&) = delete;
+
+    /**
+     * Linux has no notion of a foreground window that works across X11, Wayland and headless machines,
+     * so the "foreground" process is whichever PID was last passed here.
+     */
+    void setTargetPid(pid_t pid);
+
+    /**
+     * Gets the PID of the tracked process, opening its procfs descriptors unless they are cached from before.
+     * @return 0 if the process could not be opened.
+     */
+    pid_t getFgProcHandle();
+
+    /**
+     * Readable when a tracked process has exited, then call `handleProcessExits`.
+     * -1 if the kernel has no pidfds, exits are then only noticed when reads of the process fail.
+     */
+    int exitDescriptor() const;
+
+    /** Drop the cached state of tracked processes that exited, does not block. */
+    void handleProcessExits();
+
+    /** Check that the process still exists. */
+    static bool procHandleValid(pid_t);
+#endif
+
     /**
      * Checks whether the instance was initialized successfully.
      * @return Returns true if no error codes were returned in the constructor.
@@ -102,6 +544,94 @@ public:
      */
     unsigned long long getTotalCpuTime();
 
+    /**
+     * Gather every per-tick metric in one pass: the tracked process is resolved once and its descriptors or handle
+     * are reused for all of its fields, and its name is only looked up when the process changes.
+     * On Linux the memory breakdown of whichever process is in the foreground is read once every
+     * `BREAKDOWN_INTERVAL_US`; in between, and for a process that came into focus since, the last read of that same
+     * process is reported, if any.
+     * Prefer this over the individual getters, which each resolve the process again.
+     * @return false if any field could not be read, the others are still filled in.
+     */
+    bool sample(SampleFrame &frame);
+
+    /**
+     * Follow `targets` on every `sample` from now on, in `SampleFrame::watches`. Only the first
+     * `WatchTarget::MAX_TARGETS` are sampled. On Linux `Name` targets are matched against the comm of every process
+     * in the last `updateProcessTable`; Win32 has no process table yet and only matches them against the foreground.
+     */
+    void setWatchTargets(const std::vector<WatchTarget> &targets);
+
+    /**
+     * Per-core utilization over the interval between the last two `getTotalCpuTime` calls.
+     * Only filled in on Linux, the Win32 backend reports zero cores.
+     */
+    const CpuCoreStats& getCoreStats() const;
+
+    /**
+     * Re-read every process on the system for the top lists.
+     * @param elapsedSeconds Time since the previous call, CPU shares are 0 when this is 0.
+     * @return false if the process table is unavailable, always the case on Win32 for now.
+     */
+    bool updateProcessTable(double elapsedSeconds);
+
+    /** Processes seen by the last `updateProcessTable`. */
+    size_t getProcessCount() const;
+
+    /** Highest CPU users of the last `updateProcessTable`, busiest first. */
+    const std::vector<ProcessInfo>& getTopCpuProcesses() const;
+
+    /** Largest resident sets of the last `updateProcessTable`, largest first. */
+    const std::vector<ProcessInfo>& getTopMemoryProcesses() const;
+
+    /**
+     * Report the cgroups at `paths` below the cgroup v2 root on every `updateCgroups` from the next one, ahead of the
+     * busiest and largest groups. See `CgroupTable::select`.
+     */
+    void setCgroupSelection(const std::vector<std::string> &paths);
+
+    /**
+     * Re-read the cgroup v2 hierarchy for the selected groups and the top lists.
+     * @param elapsedSeconds Time since the previous call, CPU shares and I/O rates are 0 when this is 0.
+     * @return false where there is no cgroup v2 hierarchy, always the case on Win32.
+     */
+    bool updateCgroups(double elapsedSeconds);
+
+    /** Groups of the last `updateCgroups`, selected ones first. See `CgroupTable::reported`. */
+    const std::vector<CgroupInfo>& getCgroups() const;
+
+    /**
+     * Re-read the CPU time of every thread of the foreground process for the busiest-thread list, see `ThreadTable`.
+     * A new foreground starts from a fresh baseline.
+     * @param elapsedSeconds Time since the previous call, CPU shares are 0 when this is 0.
+     * @return false without a foreground process, always the case on Win32 for now.
+     */
+    bool updateThreads(double elapsedSeconds);
+
+    /** Threads of the foreground process as of the last `updateThreads`. */
+    size_t getThreadCount() const;
+
+    /** Busiest threads of the foreground process as of the last `updateThreads`, busiest first. */
+    const std::vector<ThreadInfo>& getTopThreads() const;
+
+    /**
+     * Re-read the I/O counters of the foreground process, of the processes every watch list entry matched on the last
+     * `sample`, and of every block device. Kept out of `sample` so the per-tick syscall budget of the CPU and memory
+     * path stays what it is; the rates are over the interval between two calls.
+     * @param elapsedSeconds Time since the previous call, rates are 0 when this is 0.
+     * @return false if the block devices could not be read, always the case on Win32 for now.
+     */
+    bool updateIo(double elapsedSeconds);
+
+    /** I/O of the foreground process as of the last `updateIo`. Zero for a process first read by that call. */
+    const IoRate& getForegroundIo() const;
+
+    /** I/O of every watch list entry as of the last `updateIo`, summed over its processes, in watch list order. */
+    const std::vector<IoRate>& getWatchIo() const;
+
+    /** Whole block devices as of the last `updateIo`, see `DiskStats`. */
+    const std::vector<DiskInfo>& getDisks() const;
+
     /**
      * Gets the amount of memory in bytes allocated by the current foreground process.
      * @return Returns 0 on any unsuccessful `win32` call.
@@ -116,7 +646,9 @@ public:
 
     /**
      * Get the percent utilization of the GPU's 3D rendering engine by the current foreground process.
-     * @return Number in the range `[0, 1)`.
+     * On Linux this is the busiest engine class in the DRM usage stats since the previous call for the same process,
+     * 0 on the first one. The Win32 backend does not query the counter yet and reports 0.
+     * @return Number in the range `[0, 1]`.
      */
     double getFgProcessGpuUsage();
 };
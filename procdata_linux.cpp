@@ -0,0 +1,509 @@
+#include "procdata.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include <time.h>
+#include <unistd.h>
+
+ProcData::ProcData(): processes{PROCESS_CACHE_SIZE} {
+    sampledProc = 0;
+    sampleCount = 0;
+    nextBreakdownUs = 0;
+    ioUpdates = 0;
+    foregroundIo = IoRate{};
+    targetPid = getpid();
+    targetExited = false;
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    long page = sysconf(_SC_PAGESIZE);
+    clockTicks = ticks > 0 ? static_cast<unsigned long long>(ticks) : 0;
+    pageSize = page > 0 ? static_cast<unsigned long long>(page) : 0;
+
+    // One line per configured core plus the aggregate line, the rest of the file is never parsed
+    long cores = sysconf(_SC_NPROCESSORS_CONF);
+    sysStatBuffer.resize((static_cast<size_t>(cores > 0 ? cores : 1) + 1) * SYS_STAT_LINE_SIZE);
+    watchMatches.reserve(WatchTarget::MAX_MATCHES);
+
+    memInfo.open("/proc/meminfo");
+    initSuccess = sysStat.open("/proc/stat") && clockTicks > 0 && pageSize > 0;
+}
+
+ProcData::~ProcData() {
+    // Entries close their own descriptors, the watcher its pidfds
+}
+
+bool ProcData::initSuccessful() const {
+    return initSuccess;
+}
+
+void ProcData::setTargetPid(pid_t pid) {
+    targetPid = pid;
+    targetExited = false;
+}
+
+bool ProcData::openProcess(pid_t pid, TrackedProcess &process) {
+    // "/proc/" + 10 digit pid + "/smaps_rollup" fits comfortably
+    char path[64];
+
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+    if (!process.stat.open(path))
+        return false;
+
+    // Field 22, after the comm which may contain spaces and parentheses
+    long read_size = process.stat.readInto(procBuffer, PID_STAT_BUFFER_SIZE);
+    const char *cur = read_size > 0 ? static_cast<const char*>(memrchr(procBuffer, ')', read_size)) : nullptr;
+    if (cur == nullptr)
+        return false;
+    cur = ProcFile::skipFields(cur + 1, procBuffer + read_size, 19);
+    ProcFile::parseUnsigned(cur, procBuffer + read_size, process.start_time);
+
+    std::snprintf(path, sizeof(path), "/proc/%d/statm", static_cast<int>(pid));
+    process.statm.open(path);
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", static_cast<int>(pid));
+    process.comm.open(path);
+    return true;
+}
+
+ProcData::TrackedProcess* ProcData::trackProcess(pid_t pid) {
+    if (pid <= 0)
+        return nullptr;
+    if (TrackedProcess *known = processes.find(pid))
+        return known;
+
+    // Watched before opening, an exit in between still arrives as an event
+    if (!lifetimes.watch(pid) && lifetimes.isOpen())
+        return nullptr;
+
+    TrackedProcess fresh;
+    if (!openProcess(pid, fresh)) {
+        lifetimes.unwatch(pid);
+        return nullptr;
+    }
+
+    if (const pid_t *oldest = processes.leastRecent())
+        dropProcess(*oldest);
+    return &processes.insert(pid, std::move(fresh));
+}
+
+void ProcData::dropProcess(pid_t pid) {
+    if (processes.erase(pid))
+        lifetimes.unwatch(pid);
+}
+
+ProcData::TrackedProcess* ProcData::foreground() {
+    // An exited target stays gone, no point trying to reopen it every tick
+    if (targetPid <= 0 || targetExited)
+        return nullptr;
+    return trackProcess(targetPid);
+}
+
+pid_t ProcData::getFgProcHandle() {
+    return foreground() != nullptr ? targetPid : 0;
+}
+
+int ProcData::exitDescriptor() const {
+    return lifetimes.isOpen() ? lifetimes.descriptor() : -1;
+}
+
+void ProcData::handleProcessExits() {
+    exitedPids.clear();
+    lifetimes.collectExits(exitedPids);
+    for (pid_t pid : exitedPids) {
+        dropProcess(pid);
+        if (pid == targetPid)
+            targetExited = true;
+        for (WatchState &watch : watchList) {
+            if (watch.target.kind == WatchTarget::Kind::Pid && watch.target.pid == pid)
+                watch.gone = true;
+        }
+        gpuClients.forget(pid);
+    }
+}
+
+bool ProcData::procHandleValid(pid_t pid) {
+    if (pid <= 0)
+        return false;
+    // EPERM still means the process exists, we just can't signal it
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+unsigned long long ProcData::getTotalProcessTime() {
+    TrackedProcess *process = foreground();
+    if (process == nullptr)
+        return ~0x0u;
+    return readProcessTime(*process);
+}
+
+unsigned long long ProcData::readProcessTime(TrackedProcess &process) {
+    // Not schedstat: its nanoseconds only cover the main thread, stat sums every thread of the process
+    long read_size = process.stat.readInto(procBuffer, PID_STAT_BUFFER_SIZE);
+    if (read_size <= 0)
+        return ~0x0u;
+
+    const char *end = procBuffer + read_size;
+    // comm may contain spaces and parentheses, fields are only reliable after the last ')'
+    const char *cur = static_cast<const char*>(memrchr(procBuffer, ')', read_size));
+    if (cur == nullptr)
+        return ~0x0u;
+
+    // state is field 3, utime and stime are fields 14 and 15
+    cur = ProcFile::skipFields(cur + 1, end, 11);
+    unsigned long long utime = 0, stime = 0;
+    cur = ProcFile::parseUnsigned(cur, end, utime);
+    ProcFile::parseUnsigned(cur, end, stime);
+
+    return (utime + stime) * MICROSEC_PER_SEC / clockTicks;
+}
+
+unsigned long long ProcData::getTotalCpuTime() {
+    long read_size = sysStat.readInto(sysStatBuffer.data(), sysStatBuffer.size());
+    // A full buffer may have cut the cpu block short, only happens if cores were hot-added past the configured count
+    while (read_size > 0 && static_cast<size_t>(read_size) + 1 == sysStatBuffer.size()) {
+        sysStatBuffer.resize(sysStatBuffer.size() * 2);
+        read_size = sysStat.readInto(sysStatBuffer.data(), sysStatBuffer.size());
+    }
+    if (read_size <= 0 || !coreStats.parse(sysStatBuffer.data(), static_cast<size_t>(read_size)))
+        return 0;
+
+    // Same meaning as the Win32 version: kernel and user time minus idle
+    return coreStats.aggregateBusyTicks() * MICROSEC_PER_SEC / clockTicks;
+}
+
+const CpuCoreStats& ProcData::getCoreStats() const {
+    return coreStats;
+}
+
+bool ProcData::updateProcessTable(double elapsedSeconds) {
+    return processTable.refresh(elapsedSeconds);
+}
+
+size_t ProcData::getProcessCount() const {
+    return processTable.processCount();
+}
+
+const std::vector<ProcessInfo>& ProcData::getTopCpuProcesses() const {
+    return processTable.topByCpu();
+}
+
+const std::vector<ProcessInfo>& ProcData::getTopMemoryProcesses() const {
+    return processTable.topByMemory();
+}
+
+void ProcData::setCgroupSelection(const std::vector<std::string> &paths) {
+    cgroupTable.select(paths);
+}
+
+bool ProcData::updateCgroups(double elapsedSeconds) {
+    return cgroupTable.refresh(elapsedSeconds);
+}
+
+const std::vector<CgroupInfo>& ProcData::getCgroups() const {
+    return cgroupTable.reported();
+}
+
+bool ProcData::updateThreads(double elapsedSeconds) {
+    if (targetPid <= 0 || targetExited) {
+        threadTable.clear();
+        return false;
+    }
+    return threadTable.refresh(targetPid, elapsedSeconds);
+}
+
+size_t ProcData::getThreadCount() const {
+    return threadTable.threadCount();
+}
+
+const std::vector<ThreadInfo>& ProcData::getTopThreads() const {
+    return threadTable.topByCpu();
+}
+
+void ProcData::readProcessIo(pid_t pid, TrackedProcess &process, double elapsedSeconds) {
+    if (process.io_read_at == ioUpdates)
+        return;
+
+    // Tried once per process, one we may not inspect stays that way
+    if (!process.io_opened) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/%d/io", static_cast<int>(pid));
+        process.io.open(path);
+        process.io_opened = true;
+    }
+
+    IoCounters counters {};
+    long read_size = process.io.isOpen() ? process.io.readInto(procBuffer, IO_BUFFER_SIZE) : -1;
+    if (read_size <= 0 || !parseProcessIo(procBuffer, static_cast<size_t>(read_size), counters)) {
+        process.io_rate = IoRate{};
+        return;
+    }
+
+    const bool consecutive = process.io_read_at != 0 && process.io_read_at + 1 == ioUpdates;
+    process.io_rate = consecutive ? ioRate(process.io_counters, counters, elapsedSeconds) : IoRate{};
+    process.io_counters = counters;
+    process.io_read_at = ioUpdates;
+}
+
+bool ProcData::updateIo(double elapsedSeconds) {
+    ioUpdates++;
+
+    foregroundIo = IoRate{};
+    TrackedProcess *process = foreground();
+    if (process != nullptr) {
+        readProcessIo(targetPid, *process, elapsedSeconds);
+        foregroundIo = process->io_rate;
+    }
+
+    // The processes were all looked up by `sample` just before, none of them is opened here
+    for (size_t i = 0; i < watchList.size(); i++) {
+        const WatchState &state = watchList[i];
+        watchIo[i] = IoRate{};
+        for (uint32_t match = 0; match < state.matched_count; match++) {
+            TrackedProcess *matched = processes.find(state.matched[match]);
+            if (matched == nullptr)
+                continue;
+            readProcessIo(state.matched[match], *matched, elapsedSeconds);
+            addIoRate(watchIo[i], matched->io_rate);
+        }
+    }
+
+    return diskStats.refresh(elapsedSeconds);
+}
+
+const IoRate& ProcData::getForegroundIo() const {
+    return foregroundIo;
+}
+
+const std::vector<IoRate>& ProcData::getWatchIo() const {
+    return watchIo;
+}
+
+const std::vector<DiskInfo>& ProcData::getDisks() const {
+    return diskStats.disks();
+}
+
+unsigned long long ProcData::getFgProcessMemory() {
+    TrackedProcess *process = foreground();
+    if (process == nullptr)
+        return 0;
+    return readProcessMemory(*process);
+}
+
+unsigned long long ProcData::readProcessMemory(TrackedProcess &process) {
+    long read_size = process.statm.readInto(procBuffer, SMALL_BUFFER_SIZE);
+    if (read_size <= 0)
+        return 0;
+
+    // "size resident shared text lib data dt", in pages
+    const char *end = procBuffer + read_size;
+    unsigned long long size_pages = 0, resident_pages = 0;
+    const char *cur = ProcFile::parseUnsigned(procBuffer, end, size_pages);
+    ProcFile::parseUnsigned(cur, end, resident_pages);
+
+    return resident_pages * pageSize;
+}
+
+std::string ProcData::getFgProcessName() {
+    TrackedProcess *process = foreground();
+    if (process == nullptr)
+        return std::string("");
+
+    // comm is at most 15 characters, which stays within the small string buffer
+    return std::string(processName(*process));
+}
+
+const char* ProcData::processName(TrackedProcess &process) {
+    if (process.named)
+        return process.name;
+
+    long read_size = process.comm.readInto(process.name, COMM_BUFFER_SIZE - 1);
+    if (read_size <= 0) {
+        process.name[0] = '\0';
+        return process.name;
+    }
+
+    process.name[read_size] = '\0';
+    if (process.name[read_size - 1] == '\n')
+        process.name[read_size - 1] = '\0';
+    process.named = true;
+    return process.name;
+}
+
+bool ProcData::readMemInfo(unsigned long long &total, unsigned long long &available) {
+    SystemMemory memory {};
+    long read_size = memInfo.readInto(procBuffer, MEMINFO_BUFFER_SIZE);
+    const bool parsed = read_size > 0 && memInfoParser.parse(procBuffer, static_cast<size_t>(read_size), memory);
+    total = memory.total;
+    available = memory.available;
+    return parsed;
+}
+
+void ProcData::readMemoryBreakdown(pid_t pid, TrackedProcess &process) {
+    // Tried once per process, a kernel without the file or a process we may not inspect stays that way
+    if (!process.smaps_opened) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", static_cast<int>(pid));
+        process.smaps_rollup.open(path);
+        process.smaps_opened = true;
+    }
+    if (!process.smaps_rollup.isOpen())
+        return;
+
+    long read_size = process.smaps_rollup.readInto(procBuffer, SMAPS_BUFFER_SIZE);
+    MemoryBreakdown breakdown {};
+    if (read_size > 0 && parseSmapsRollup(procBuffer, static_cast<size_t>(read_size), breakdown))
+        process.breakdown = breakdown;
+}
+
+bool ProcData::sampleProcess(pid_t pid, TrackedProcess &process) {
+    if (process.sampled_at == sampleCount)
+        return true;
+
+    const unsigned long long time = readProcessTime(process);
+    if (time == ~0x0u) {
+        // Exited without an event reaching us yet, or without pidfds at all
+        dropProcess(pid);
+        return false;
+    }
+
+    process.has_delta = process.sampled_at != 0 && process.sampled_at + 1 == sampleCount &&
+        time >= process.process_time;
+    process.time_delta = process.has_delta ? time - process.process_time : 0;
+    process.process_time = time;
+    process.memory = readProcessMemory(process);
+    process.sampled_at = sampleCount;
+    return true;
+}
+
+bool ProcData::sample(SampleFrame &frame) {
+    sampleCount++;
+    frame.cpu_time = getTotalCpuTime();
+    bool complete = frame.cpu_time > 0;
+    complete = readMemInfo(frame.mem_total, frame.mem_available) && complete;
+
+    TrackedProcess *process = foreground();
+    pid_t pid = process != nullptr && sampleProcess(targetPid, *process) ? targetPid : 0;
+    frame.process = pid;
+    frame.process_changed = pid != sampledProc;
+    sampledProc = pid;
+
+    if (pid == 0) {
+        frame.process_time = ~0x0u;
+        frame.process_time_delta = 0;
+        frame.process_delta_valid = false;
+        frame.process_memory = 0;
+        frame.process_breakdown = MemoryBreakdown{};
+        frame.process_gpu_use = 0.0;
+        frame.process_name[0] = '\0';
+        complete = false;
+    } else {
+        const int64_t now_us = monotonicUs();
+        if (now_us >= nextBreakdownUs) {
+            readMemoryBreakdown(pid, *process);
+            nextBreakdownUs = now_us + BREAKDOWN_INTERVAL_US;
+        }
+
+        frame.process_time = process->process_time;
+        frame.process_time_delta = process->time_delta;
+        frame.process_delta_valid = process->has_delta;
+        frame.process_memory = process->memory;
+        frame.process_breakdown = process->breakdown;
+        frame.process_breakdown.rss = process->memory;
+        frame.process_gpu_use = gpuClients.update(pid, now_us);
+        std::strncpy(frame.process_name, processName(*process), SampleFrame::NAME_SIZE - 1);
+        frame.process_name[SampleFrame::NAME_SIZE - 1] = '\0';
+    }
+
+    sampleWatches(frame);
+    return complete;
+}
+
+void ProcData::setWatchTargets(const std::vector<WatchTarget> &targets) {
+    watchList.clear();
+    for (const WatchTarget &target : targets) {
+        if (watchList.size() == WatchTarget::MAX_TARGETS)
+            break;
+        watchList.push_back(WatchState{target, 0, false, false, {}, 0});
+    }
+    watchIo.assign(watchList.size(), IoRate{});
+}
+
+void ProcData::addWatchMatch(pid_t pid, const TrackedProcess &process, WatchSample &watch) {
+    if (watch.matches == 0) {
+        watch.pid = pid;
+        std::strncpy(watch.name, process.name, WatchSample::NAME_SIZE - 1);
+        watch.name[WatchSample::NAME_SIZE - 1] = '\0';
+    }
+    watch.matches++;
+    watch.time_delta += process.time_delta;
+    watch.memory += process.memory;
+}
+
+void ProcData::sampleWatches(SampleFrame &frame) {
+    frame.watch_count = static_cast<uint32_t>(watchList.size());
+
+    for (size_t i = 0; i < watchList.size(); i++) {
+        WatchState &state = watchList[i];
+        WatchSample &watch = frame.watches[i];
+        watch = WatchSample{};
+        state.matched_count = 0;
+
+        // Entries are only used up to the next lookup, which may evict them
+        switch (state.target.kind) {
+        case WatchTarget::Kind::Foreground: {
+            TrackedProcess *process = foreground();
+            if (process != nullptr && sampleProcess(targetPid, *process)) {
+                processName(*process);
+                addWatchMatch(targetPid, *process, watch);
+                state.matched[state.matched_count++] = targetPid;
+            }
+            break;
+        }
+        case WatchTarget::Kind::Pid: {
+            if (state.gone)
+                break;
+            TrackedProcess *process = trackProcess(state.target.pid);
+            // Reopened after the original went away, for a newer process that happens to have the same PID
+            if (process != nullptr && state.resolved && process->start_time != state.start_time)
+                process = nullptr;
+            if (process == nullptr || !sampleProcess(state.target.pid, *process)) {
+                state.gone = state.resolved || process != nullptr;
+                break;
+            }
+            state.start_time = process->start_time;
+            state.resolved = true;
+            processName(*process);
+            addWatchMatch(state.target.pid, *process, watch);
+            state.matched[state.matched_count++] = state.target.pid;
+            break;
+        }
+        case WatchTarget::Kind::Name: {
+            watchMatches.clear();
+            processTable.findByName(state.target.pattern.c_str(), WatchTarget::MAX_MATCHES, watchMatches);
+            for (int32_t match : watchMatches) {
+                TrackedProcess *process = trackProcess(match);
+                if (process != nullptr && sampleProcess(match, *process)) {
+                    processName(*process);
+                    addWatchMatch(match, *process, watch);
+                    state.matched[state.matched_count++] = match;
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+double ProcData::getFgProcessGpuUsage() {
+    pid_t pid = getFgProcHandle();
+    if (pid == 0)
+        return 0.0;
+    return gpuClients.update(pid, monotonicUs());
+}
+
+int64_t ProcData::monotonicUs() {
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,94 @@
+#include "procfile.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+/** Buffer `readAll` starts from when handed an empty one, a page. */
+constexpr size_t MIN_READ_SIZE = 4096;
+
+} // namespace
+
+ProcFile::ProcFile(): fd{-1} {}
+
+ProcFile::ProcFile(const char *path): fd{-1} {
+    open(path);
+}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+ProcFile::ProcFile(ProcFile &&other) noexcept: fd{other.fd} {
+    other.fd = -1;
+}
+
+ProcFile& ProcFile::operator=(ProcFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        fd = other.fd;
+        other.fd = -1;
+    }
+    return *this;
+}
+
+bool ProcFile::open(const char *path) {
+    close();
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
+bool ProcFile::openAt(int dirfd, const char *path) {
+    close();
+    fd = ::openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
+void ProcFile::close() {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+bool ProcFile::isOpen() const {
+    return fd >= 0;
+}
+
+int ProcFile::descriptor() const {
+    return fd;
+}
+
+long ProcFile::readInto(char *buffer, size_t size) const {
+    if (fd < 0 || size == 0)
+        return -1;
+
+    ssize_t read_size = ::pread(fd, buffer, size - 1, 0);
+    if (read_size < 0)
+        return -1;
+
+    buffer[read_size] = '\0';
+    return static_cast<long>(read_size);
+}
+
+long ProcFile::readAll(std::vector<char> &buffer) const {
+    if (fd < 0)
+        return -1;
+
+    size_t used = 0;
+    for (;;) {
+        if (used + 1 >= buffer.size())
+            buffer.resize(std::max(buffer.size() * 2, MIN_READ_SIZE));
+        ssize_t read_size = ::pread(fd, buffer.data() + used, buffer.size() - 1 - used, static_cast<off_t>(used));
+        if (read_size < 0)
+            return -1;
+        if (read_size == 0)
+            break;
+        used += static_cast<size_t>(read_size);
+    }
+
+    buffer[used] = '\0';
+    return static_cast<long>(used);
+}
@@ -0,0 +1,99 @@
+#ifndef PROCFILE_H
+#define PROCFILE_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * A procfs file that is opened once and re-read from offset 0 with `pread`.
+ * procfs regenerates the contents of a file on every read at offset 0, so a descriptor can be kept for as long as the
+ * underlying object lives and sampled without any open/close churn. None of the members allocate, except `readAll`
+ * growing the caller's buffer.
+ * The parsing helpers are header-only and portable, so text parsers built on them also compile on Windows.
+ */
+class ProcFile {
+
+    /** Underlying descriptor, -1 when closed. */
+    int fd;
+
+public:
+    ProcFile();
+
+    /** Opens `path` read-only. Check `isOpen` for the result. */
+    explicit ProcFile(const char *path);
+
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+    ProcFile(ProcFile&&) noexcept;
+    ProcFile& operator=(ProcFile&&) noexcept;
+
+    /** Open `path` read-only, closing any descriptor held previously. */
+    bool open(const char *path);
+
+    /** Open `path` relative to the directory descriptor `dirfd`, closing any descriptor held previously. */
+    bool openAt(int dirfd, const char *path);
+
+    /** Release the descriptor. Safe to call on a closed file. */
+    void close();
+
+    bool isOpen() const;
+
+    /** Raw descriptor, for callers that need `openat` or `fstat`. */
+    int descriptor() const;
+
+    /**
+     * Re-read the file from offset 0 into `buffer` and null-terminate it.
+     * @return Number of bytes read, or -1 on error with `errno` left untouched. `ESRCH` means the process is gone.
+     */
+    long readInto(char *buffer, size_t size) const;
+
+    /**
+     * Re-read the whole file from offset 0 into `buffer`, growing it as needed, and null-terminate it.
+     * One read of a seq_file like `/proc/diskstats` returns about a page however large the buffer, so this keeps
+     * reading at an advancing offset until end of file.
+     * @return Number of bytes read, or -1 on error with `errno` left untouched.
+     */
+    long readAll(std::vector<char> &buffer) const;
+
+    /** Skip spaces and tabs. */
+    static const char* skipBlanks(const char *cur, const char *end) {
+        while (cur < end && (*cur == ' ' || *cur == '\t'))
+            cur++;
+        return cur;
+    }
+
+    /** Skip `count` whitespace-separated fields. */
+    static const char* skipFields(const char *cur, const char *end, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            cur = skipBlanks(cur, end);
+            while (cur < end && *cur != ' ' && *cur != '\t' && *cur != '\n')
+                cur++;
+        }
+        return cur;
+    }
+
+    /** Advance past the next newline. */
+    static const char* nextLine(const char *cur, const char *end) {
+        while (cur < end && *cur != '\n')
+            cur++;
+        return cur < end ? cur + 1 : end;
+    }
+
+    /**
+     * Parse an unsigned decimal integer after any leading blanks.
+     * @return Position after the last digit. `out` is 0 if no digits were found.
+     */
+    static const char* parseUnsigned(const char *cur, const char *end, unsigned long long &out) {
+        cur = skipBlanks(cur, end);
+        out = 0;
+        while (cur < end && *cur >= '0' && *cur <= '9') {
+            out = out * 10 + static_cast<unsigned long long>(*cur - '0');
+            cur++;
+        }
+        return cur;
+    }
+};
+
+#endif // PROCFILE_H
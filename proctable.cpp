@@ -0,0 +1,261 @@
+#include "proctable.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "watchlist.h"
+
+namespace {
+
+/** Layout the kernel writes for `getdents64`, glibc only exposes a wrapper for it since 2.30. */
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+/** Descriptors left for everything else in the program when sizing the cache. */
+constexpr rlim_t RESERVED_FDS = 256;
+
+bool parsePid(const char *name, int32_t &pid) {
+    int32_t value = 0;
+    if (*name == '\0')
+        return false;
+    for (; *name != '\0'; name++) {
+        if (*name < '0' || *name > '9')
+            return false;
+        value = value * 10 + (*name - '0');
+    }
+    pid = value;
+    return value > 0;
+}
+
+bool moreCpu(const ProcessInfo &a, const ProcessInfo &b) {
+    return a.cpu_use != b.cpu_use ? a.cpu_use > b.cpu_use : a.pid < b.pid;
+}
+
+bool moreMemory(const ProcessInfo &a, const ProcessInfo &b) {
+    return a.rss_bytes != b.rss_bytes ? a.rss_bytes > b.rss_bytes : a.pid < b.pid;
+}
+
+/** Keep the `limit` "largest" rows under `more` in a heap whose front is the smallest of them. */
+template <typename Compare>
+void pushBounded(std::vector<ProcessInfo> &heap, size_t limit, const ProcessInfo &info, Compare more) {
+    if (limit == 0)
+        return;
+    if (heap.size() < limit) {
+        heap.push_back(info);
+        std::push_heap(heap.begin(), heap.end(), more);
+    } else if (more(info, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), more);
+        heap.back() = info;
+        std::push_heap(heap.begin(), heap.end(), more);
+    }
+}
+
+} // namespace
+
+ProcessTable::ProcessTable(const char *proc_root, size_t top_n):
+    root_fd{-1},
+    top_n{top_n},
+    fd_budget{0},
+    cached_fds{0},
+    process_count{0},
+    stat_reads{0},
+    refreshes{0},
+    clock_seconds{0.0},
+    dirent_buffer(DIRENT_BUFFER_SIZE)
+{
+    root_fd = ::open(proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    long page = sysconf(_SC_PAGESIZE);
+    clock_ticks = ticks > 0 ? static_cast<unsigned long long>(ticks) : 100;
+    page_size = page > 0 ? static_cast<unsigned long long>(page) : 4096;
+
+    // Never more than half of what the soft limit leaves, for a process started with a tight one
+    fd_budget = MAX_CACHED_FDS;
+    rlimit limit {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        fd_budget = limit.rlim_cur > RESERVED_FDS ?
+            std::min(fd_budget, static_cast<size_t>((limit.rlim_cur - RESERVED_FDS) / 2)) : 0;
+
+    top_cpu.reserve(top_n);
+    top_memory.reserve(top_n);
+}
+
+ProcessTable::~ProcessTable() {
+    // Entries close their own descriptors
+    if (root_fd >= 0)
+        ::close(root_fd);
+}
+
+bool ProcessTable::isOpen() const {
+    return root_fd >= 0;
+}
+
+bool ProcessTable::refresh(double elapsed_seconds) {
+    if (root_fd < 0 || lseek(root_fd, 0, SEEK_SET) < 0)
+        return false;
+
+    top_cpu.clear();
+    top_memory.clear();
+    cached_fds = 0;
+    process_count = 0;
+    stat_reads = 0;
+    refreshes++;
+    clock_seconds += elapsed_seconds;
+
+    for (;;) {
+        long read_size = syscall(SYS_getdents64, root_fd, dirent_buffer.data(), dirent_buffer.size());
+        if (read_size < 0) {
+            // Drop the half-built map, unseen processes keep their baseline in `previous`
+            current.clear();
+            return false;
+        }
+        if (read_size == 0)
+            break;
+
+        for (long offset = 0; offset < read_size;) {
+            const auto *entry = reinterpret_cast<const LinuxDirent64*>(dirent_buffer.data() + offset);
+            offset += entry->d_reclen;
+
+            int32_t pid;
+            if (parsePid(entry->d_name, pid))
+                sampleProcess(pid, elapsed_seconds);
+        }
+    }
+
+    // Whatever was not carried over belongs to processes that exited, clearing closes their descriptors
+    previous.clear();
+    previous.swap(current);
+
+    std::sort_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+    std::sort_heap(top_memory.begin(), top_memory.end(), moreMemory);
+    return true;
+}
+
+void ProcessTable::sampleProcess(int32_t pid, double elapsed_seconds) {
+    Entry *known = previous.find(pid);
+    if (known != nullptr && known->idle && (static_cast<uint64_t>(pid) + refreshes) % IDLE_READ_STRIDE != 0) {
+        ProcessInfo info {};
+        info.pid = pid;
+        std::memcpy(info.name, known->name, ProcessInfo::NAME_SIZE);
+        info.rss_bytes = known->rss_bytes;
+        if (known->stat.isOpen())
+            cached_fds++;
+        current.insert(pid, std::move(*known));
+        process_count++;
+        rank(info);
+        return;
+    }
+
+    Entry fresh;
+    long read_size = -1;
+    if (known != nullptr && known->stat.isOpen()) {
+        read_size = known->stat.readInto(stat_buffer, STAT_BUFFER_SIZE);
+        // ESRCH: the process behind the cached descriptor is gone and the PID was reused
+        if (read_size > 0)
+            fresh.stat = std::move(known->stat);
+    }
+
+    if (read_size <= 0) {
+        char path[32];
+        std::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+        if (!fresh.stat.openAt(root_fd, path))
+            return;
+        read_size = fresh.stat.readInto(stat_buffer, STAT_BUFFER_SIZE);
+        if (read_size <= 0)
+            return;
+        if (cached_fds >= fd_budget)
+            fresh.stat.close();
+    }
+    if (fresh.stat.isOpen())
+        cached_fds++;
+    stat_reads++;
+
+    const char *end = stat_buffer + read_size;
+    // comm may contain spaces and parentheses, fields are only reliable after the last ')'
+    const char *open_paren = static_cast<const char*>(std::memchr(stat_buffer, '(', read_size));
+    const char *close_paren = static_cast<const char*>(memrchr(stat_buffer, ')', read_size));
+    if (open_paren == nullptr || close_paren == nullptr || close_paren < open_paren)
+        return;
+
+    // state is field 3, utime and stime are 14 and 15, starttime 22 and rss 24
+    unsigned long long utime, stime, rss_pages;
+    const char *cur = ProcFile::skipFields(close_paren + 1, end, 11);
+    cur = ProcFile::parseUnsigned(cur, end, utime);
+    cur = ProcFile::parseUnsigned(cur, end, stime);
+    cur = ProcFile::skipFields(cur, end, 6);
+    cur = ProcFile::parseUnsigned(cur, end, fresh.start_time);
+    cur = ProcFile::skipFields(cur, end, 1);
+    ProcFile::parseUnsigned(cur, end, rss_pages);
+    fresh.cpu_ticks = utime + stime;
+    fresh.rss_bytes = rss_pages * page_size;
+    fresh.read_at = clock_seconds;
+
+    ProcessInfo info {};
+    info.pid = pid;
+    size_t name_length = std::min<size_t>(close_paren - open_paren - 1, ProcessInfo::NAME_SIZE - 1);
+    std::memcpy(info.name, open_paren + 1, name_length);
+    info.rss_bytes = fresh.rss_bytes;
+    std::memcpy(fresh.name, info.name, ProcessInfo::NAME_SIZE);
+
+    // An idle process was last read some refreshes ago, its CPU is averaged over all of them
+    bool same_process = known != nullptr && known->start_time == fresh.start_time;
+    const double since_read = same_process ? clock_seconds - known->read_at : 0.0;
+    if (same_process && elapsed_seconds > 0.0 && since_read > 0.0 && fresh.cpu_ticks >= known->cpu_ticks) {
+        double seconds = static_cast<double>(fresh.cpu_ticks - known->cpu_ticks) / clock_ticks;
+        info.cpu_use = static_cast<float>(seconds / since_read);
+    }
+    fresh.idle = same_process && fresh.cpu_ticks == known->cpu_ticks;
+
+    current.insert(pid, std::move(fresh));
+    process_count++;
+    rank(info);
+}
+
+void ProcessTable::rank(const ProcessInfo &info) {
+    pushBounded(top_cpu, top_n, info, moreCpu);
+    pushBounded(top_memory, top_n, info, moreMemory);
+}
+
+size_t ProcessTable::processCount() const {
+    return process_count;
+}
+
+const std::vector<ProcessInfo>& ProcessTable::topByCpu() const {
+    return top_cpu;
+}
+
+const std::vector<ProcessInfo>& ProcessTable::topByMemory() const {
+    return top_memory;
+}
+
+size_t ProcessTable::cachedDescriptors() const {
+    return cached_fds;
+}
+
+size_t ProcessTable::statReads() const {
+    return stat_reads;
+}
+
+void ProcessTable::findByName(const char *pattern, size_t limit, std::vector<int32_t> &pids) {
+    size_t found = 0;
+    previous.forEach([&](int32_t pid, Entry &entry) {
+        if (found < limit && matchNamePattern(pattern, entry.name)) {
+            pids.push_back(pid);
+            found++;
+        }
+    });
+}
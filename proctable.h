@@ -0,0 +1,170 @@
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flathashmap.h"
+#include "procfile.h"
+
+/** One row of the process table. Plain data so it can be published through a `SeqLock`. */
+struct ProcessInfo {
+    /** The kernel caps comm at 16 bytes including the terminator. */
+    static constexpr size_t NAME_SIZE = 16;
+
+    int32_t pid;
+
+    /** Null-terminated comm, truncated like the kernel does. */
+    char name[NAME_SIZE];
+
+    /** CPU time over the last interval as a fraction of one core, so it can exceed 1 for threaded processes. */
+    float cpu_use;
+
+    /** Resident set size in bytes. */
+    uint64_t rss_bytes;
+};
+
+/**
+ * Whole-system process table read from procfs.
+ * Every `refresh` lists the PIDs in `/proc` with `getdents64` on a cached directory descriptor and reads `<pid>/stat`
+ * relative to it. Per-process state lives in a flat hash map keyed by PID, and the start time in stat identifies the
+ * process behind a PID, so a reused PID starts from a fresh baseline instead of producing a bogus delta. `stat`
+ * descriptors are kept open between ticks while the descriptor budget allows it, a cached read is a single `pread`.
+ *
+ * Even that `pread` costs microseconds on real procfs, which formats the file on every read, so a refresh does not
+ * read every process: one that used CPU at its last read or is new is read every refresh, an idle one only in its
+ * slot of every `IDLE_READ_STRIDE` refreshes, staggered by PID. In between it is listed with the RSS of its last
+ * read and no CPU, and its next read averages its CPU over the whole span. Most processes of a loaded server sleep,
+ * so a refresh reads the busy ones and a slice of the rest; a PID reused between two reads of an idle process keeps
+ * the old name until its slot comes up. Listing the PIDs still costs about a microsecond each, so at tens of
+ * thousands of processes a refresh takes tens of milliseconds however few it reads.
+ *
+ * The top-N by CPU and by memory are collected with bounded heaps during the same pass, nothing is sorted
+ * beyond N entries. Linux only: the root is a parameter so tests and benchmarks can point it at a fixture tree.
+ */
+class ProcessTable {
+
+    struct Entry {
+        /** `<pid>/stat`, closed when the process goes away or the descriptor budget is exhausted. */
+        ProcFile stat;
+
+        /** Start time in ticks since boot. Together with the PID it identifies one process. */
+        unsigned long long start_time = 0;
+
+        /** utime + stime in ticks at the last read. */
+        unsigned long long cpu_ticks = 0;
+
+        /** Resident set size in bytes at the last read. */
+        uint64_t rss_bytes = 0;
+
+        /** `clock_seconds` of the last read. */
+        double read_at = 0.0;
+
+        /** Used no CPU between its last two reads, it is read in its slot only. */
+        bool idle = false;
+
+        /** Same as `ProcessInfo::name`, for `findByName`. */
+        char name[ProcessInfo::NAME_SIZE] = {};
+    };
+
+    /** `getdents64` batch size. Each entry in `/proc` takes about 24 bytes. */
+    static constexpr size_t DIRENT_BUFFER_SIZE = 64 * 1024;
+
+    /** Longest `<pid>/stat` line we expect, the comm field is capped at 16 bytes so 1 KiB is plenty. */
+    static constexpr size_t STAT_BUFFER_SIZE = 1024;
+
+    /**
+     * Most `stat` descriptors kept open. Together with `ThreadTable::MAX_CACHED_FDS` well within the usual soft limit
+     * of 1024, which is left as it is.
+     */
+    static constexpr size_t MAX_CACHED_FDS = 512;
+
+    /** Directory descriptor of the procfs root, -1 if it could not be opened. */
+    int root_fd;
+
+    size_t top_n;
+
+    /** USER_HZ and bytes per page, the units of stat. */
+    unsigned long long clock_ticks;
+    unsigned long long page_size;
+
+    /** Entries of the last refresh and the ones being built, swapped at the end of every refresh. */
+    FlatHashMap<int32_t, Entry> previous;
+    FlatHashMap<int32_t, Entry> current;
+
+    /**
+     * Descriptors that may be kept open: `MAX_CACHED_FDS`, or half of what the soft `RLIMIT_NOFILE` leaves if that is
+     * less. Processes past the budget are read with open, read, close.
+     */
+    size_t fd_budget;
+    size_t cached_fds;
+
+    size_t process_count;
+    size_t stat_reads;
+
+    /** Refreshes so far and the sum of their elapsed seconds, the time base of `Entry::read_at`. */
+    uint64_t refreshes;
+    double clock_seconds;
+
+    /** Min-heaps of the N largest so far during a refresh, sorted descending afterwards. */
+    std::vector<ProcessInfo> top_cpu;
+    std::vector<ProcessInfo> top_memory;
+
+    std::vector<char> dirent_buffer;
+    char stat_buffer[STAT_BUFFER_SIZE];
+
+    /**
+     * Read and account for one process, or carry it over from the last refresh if it is idle and not in its slot.
+     * Processes that vanished mid-refresh are skipped.
+     */
+    void sampleProcess(int32_t pid, double elapsed_seconds);
+
+    /** Add a process to the top lists. */
+    void rank(const ProcessInfo &info);
+
+public:
+    static constexpr size_t DEFAULT_TOP_N = 10;
+
+    /** An idle process is read on one of this many refreshes, so a 16th of the idle ones is read on every refresh. */
+    static constexpr uint64_t IDLE_READ_STRIDE = 16;
+
+    explicit ProcessTable(const char *proc_root = "/proc", size_t top_n = DEFAULT_TOP_N);
+    ~ProcessTable();
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    /** Whether the procfs root could be opened. */
+    bool isOpen() const;
+
+    /**
+     * Enumerate every process once and update the top lists.
+     * @param elapsed_seconds Time since the previous refresh, CPU use is 0 when this is 0.
+     * @return false if the root could not be listed. The top lists are incomplete in that case.
+     */
+    bool refresh(double elapsed_seconds);
+
+    /** Processes seen by the last refresh. */
+    size_t processCount() const;
+
+    /** Highest CPU users first. */
+    const std::vector<ProcessInfo>& topByCpu() const;
+
+    /** Largest resident sets first. */
+    const std::vector<ProcessInfo>& topByMemory() const;
+
+    /** Number of `stat` descriptors held open between refreshes. */
+    size_t cachedDescriptors() const;
+
+    /** `stat` files the last refresh read, busy processes and the idle ones whose slot it was. */
+    size_t statReads() const;
+
+    /**
+     * Append the PIDs of the last refresh whose name matches `pattern`, see `matchNamePattern`.
+     * At most `limit` of them, in no particular order. One pass over the table, nothing is read from procfs.
+     */
+    void findByName(const char *pattern, size_t limit, std::vector<int32_t> &pids);
+};
+
+#endif // PROCTABLE_H
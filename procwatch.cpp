@@ -0,0 +1,121 @@
+#include "procwatch.h"
+
+#include <cerrno>
+
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+// Same number on every architecture, older libc headers just don't know it
+#define SYS_pidfd_open 434
+#endif
+
+namespace {
+
+/** The event carries both, so an exit needs no lookup to close the right descriptor. */
+uint64_t packEvent(int32_t pid, int fd) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32 | static_cast<uint32_t>(fd);
+}
+
+} // namespace
+
+ProcessWatcher::ProcessWatcher(): unsupported{false} {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    // Probe on ourselves so `isOpen` is already meaningful before the first `watch`
+    int probe = static_cast<int>(syscall(SYS_pidfd_open, getpid(), 0));
+    if (probe >= 0)
+        ::close(probe);
+    else
+        unsupported = errno == ENOSYS;
+}
+
+ProcessWatcher::~ProcessWatcher() {
+    pidfds.forEach([](int32_t, int &fd) {
+        ::close(fd);
+    });
+    if (epoll_fd >= 0)
+        ::close(epoll_fd);
+}
+
+bool ProcessWatcher::isOpen() const {
+    return epoll_fd >= 0 && !unsupported;
+}
+
+bool ProcessWatcher::watch(int32_t pid) {
+    if (!isOpen() || pid <= 0)
+        return false;
+    if (pidfds.find(pid) != nullptr)
+        return true;
+
+    // pidfds are always close-on-exec
+    int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (fd < 0) {
+        if (errno == ENOSYS)
+            unsupported = true;
+        return false;
+    }
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = packEvent(pid, fd);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    pidfds.insert(pid, int{fd});
+    return true;
+}
+
+bool ProcessWatcher::unwatch(int32_t pid) {
+    int *fd = pidfds.find(pid);
+    if (fd == nullptr)
+        return false;
+
+    // Closing the only reference removes it from the epoll set as well
+    ::close(*fd);
+    pidfds.erase(pid);
+    return true;
+}
+
+bool ProcessWatcher::watching(int32_t pid) const {
+    return pidfds.find(pid) != nullptr;
+}
+
+size_t ProcessWatcher::watchedCount() const {
+    return pidfds.size();
+}
+
+int ProcessWatcher::descriptor() const {
+    return epoll_fd;
+}
+
+size_t ProcessWatcher::collectExits(std::vector<int32_t> &exited, int timeout_ms) {
+    if (epoll_fd < 0 || pidfds.empty())
+        return 0;
+
+    epoll_event events[EVENT_BATCH];
+    size_t collected = 0;
+    int ready;
+    do {
+        ready = epoll_wait(epoll_fd, events, EVENT_BATCH, collected == 0 ? timeout_ms : 0);
+        if (ready < 0 && errno == EINTR)
+            continue;
+
+        for (int i = 0; i < ready; i++) {
+            const int32_t pid = static_cast<int32_t>(events[i].data.u64 >> 32);
+            const int fd = static_cast<int>(events[i].data.u64 & 0xffffffffu);
+            int *watched = pidfds.find(pid);
+            // Already unwatched, or the PID was watched again under a new descriptor since
+            if (watched == nullptr || *watched != fd)
+                continue;
+            ::close(fd);
+            pidfds.erase(pid);
+            exited.push_back(pid);
+            collected++;
+        }
+    } while (ready == static_cast<int>(EVENT_BATCH) || (ready < 0 && errno == EINTR));
+    return collected;
+}
@@ -0,0 +1,71 @@
+#ifndef PROCWATCH_H
+#define PROCWATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flathashmap.h"
+
+/**
+ * Event-driven process lifetime tracking.
+ * Every watched PID gets a `pidfd_open` descriptor registered in one epoll set. A pidfd becomes readable once its
+ * process exits, so exits arrive as events on `descriptor` instead of being found by polling each PID: an idle
+ * watcher costs nothing, however many processes it watches, and a pidfd keeps referring to the same process even if
+ * its PID is reused meanwhile.
+ *
+ * Linux only, pidfds need Linux 5.3. On older kernels `isOpen` is false and every `watch` fails with nothing watched,
+ * callers fall back to noticing exits when reads fail.
+ */
+class ProcessWatcher {
+public:
+    /** Events taken from the epoll set per `epoll_wait`. */
+    static constexpr size_t EVENT_BATCH = 64;
+
+    ProcessWatcher();
+    ~ProcessWatcher();
+
+    ProcessWatcher(const ProcessWatcher&) = delete;
+    ProcessWatcher& operator=(const ProcessWatcher&) = delete;
+
+    /** Whether the epoll set exists and the kernel supports pidfds. */
+    bool isOpen() const;
+
+    /**
+     * Start watching `pid`. Watching a PID twice is a no-op.
+     * @return false if the process does not exist (any more) or pidfds are unsupported.
+     */
+    bool watch(int32_t pid);
+
+    /** Stop watching `pid`. @return false if it was not watched. */
+    bool unwatch(int32_t pid);
+
+    bool watching(int32_t pid) const;
+
+    /** Number of processes watched. */
+    size_t watchedCount() const;
+
+    /**
+     * The epoll set, readable while exits are waiting to be collected.
+     * Can be polled together with other descriptors, or registered in another epoll set.
+     */
+    int descriptor() const;
+
+    /**
+     * Append the PIDs of watched processes that exited to `exited` and stop watching them.
+     * @param timeout_ms Wait this long for the first exit, 0 returns at once and -1 waits indefinitely.
+     * @return Number of PIDs appended.
+     */
+    size_t collectExits(std::vector<int32_t> &exited, int timeout_ms = 0);
+
+private:
+    int epoll_fd;
+
+    /** pidfds don't exist on this kernel, probed in the constructor. */
+    bool unsupported;
+
+    /** pidfd of every watched PID. */
+    FlatHashMap<int32_t, int> pidfds;
+};
+
+#endif // PROCWATCH_H
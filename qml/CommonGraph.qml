@@ -4,6 +4,8 @@ import QtGraphs
 GraphsView {
     property int default_height: 150
     property int default_window_ms: -60 * 1000
+    // Newest sample time, points keep their absolute timestamps and the axis follows
+    property double now_ms: 0
 
     width: parent.width
     height: default_height
@@ -19,8 +21,8 @@ GraphsView {
     }
 
     axisX: ValueAxis {
-        min: default_window_ms
-        max: 0
+        min: now_ms + default_window_ms
+        max: now_ms
         tickInterval: (default_window_ms * -1) / 4
         gridVisible: false
         subGridVisible: false
@@ -0,0 +1,8 @@
+import QtQuick
+import QtGraphs
+
+CommonGraph {
+    property string engine_color: "#F4B183"
+    property string engine_border_color: "#E98B4E"
+
+}
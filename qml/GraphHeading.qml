@@ -1,9 +1,39 @@
 import QtQuick
 
-Text {
-    horizontalAlignment: Text.AlignHCenter
+Column {
+    property alias text: title.text
+    // Rows of one of DataMan's *Stats properties, one per window, the statistics line stays hidden while empty
+    property var stats: []
+    // Row of `stats` shown, 1 is the 10 s window
+    property int window_index: 1
+
+    readonly property var shown: stats.length > window_index ? stats[window_index] : null
+
     width: parent.width
 
-    color: "#ffffff"
-    style: Text.Outline
+    Text {
+        id: title
+        horizontalAlignment: Text.AlignHCenter
+        width: parent.width
+
+        color: "#ffffff"
+        style: Text.Outline
+    }
+
+    Text {
+        visible: shown !== null && shown.count > 0
+        horizontalAlignment: Text.AlignHCenter
+        width: parent.width
+        font.pixelSize: title.font.pixelSize * 0.8
+
+        color: "#d0d0d0"
+        style: Text.Outline
+        text: shown === null ? "" : qsTr("%1 s  min %2  avg %3  max %4  p95 %5  p99 %6")
+            .arg(shown.windowMs / 1000)
+            .arg(shown.min.toFixed(1))
+            .arg(shown.avg.toFixed(1))
+            .arg(shown.max.toFixed(1))
+            .arg(shown.p95.toFixed(1))
+            .arg(shown.p99.toFixed(1))
+    }
 }
@@ -0,0 +1,20 @@
+import QtQuick
+import QtGraphs
+
+// A line mirroring one of DataManager's histories. The history decimates to the width of the graph it is drawn in,
+// about two points per pixel, so a higher refresh rate does not grow the point count the graph has to draw.
+LineSeries {
+    id: history_line
+
+    required property var history
+    // Width of the graph the line is in, series are not items and cannot look it up themselves
+    required property real graph_width
+
+    Component.onCompleted: history.bindSeries(history_line)
+
+    Binding {
+        target: history_line.history
+        property: "PixelWidth"
+        value: history_line.graph_width
+    }
+}
@@ -0,0 +1,19 @@
+import QtQuick
+import QtGraphs
+
+CommonGraph {
+    property string disk_total_color: "#B4A7D6"
+    property string disk_total_border_color: "#8E7CC3"
+    property string read_color: "#9FC5E8"
+    property string write_color: "#F6B26B"
+    // Rates have no natural ceiling, the axis follows the largest one still in the window
+    property double scale_max: 1
+
+    axisY: ValueAxis {
+        min: 0
+        max: Math.max(1, scale_max)
+        tickInterval: Math.max(1, scale_max)
+        gridVisible: false
+        subGridVisible: false
+    }
+}
@@ -9,12 +9,8 @@ Window {
     property int default_width: 300
     property int default_height: screen.height
 
-    property var mem_used_history: []
-    property var mem_proc_history: []
-    property var cpu_used_history: []
-    property var cpu_proc_history: []
-
-    property int now_ms: Date.now()
+    // Timestamp of the newest sample, every graph slides its x axis to it instead of rewriting points
+    property double now_ms: data_manager.SampleTimeMs
 
     width: default_width
     height: default_height
@@ -25,19 +21,6 @@ Window {
 
     color: "transparent"
 
-    function turnoverArray(arr, x_negative_threshold) {
-        let oldest = arr[0];
-        if (oldest && oldest.x < x_negative_threshold) {
-            arr.shift();
-        }
-    }
-
-    function updateArrayXValues(arr) {
-        for (let datapoint of arr) {
-            datapoint.x = datapoint.timestamp_ms - main_window.now_ms;
-        }
-    }
-
     Component.onCompleted: {
         x = screen.width - width
         y = screen.height - height
@@ -47,21 +30,16 @@ Window {
         id: data_manager
     }
 
-    Connections {
-        target: data_manager
-        function onNotifyMemUsedKb() {
-            now_ms = Date.now()
-        }
-    }
-
     GraphHeading {
         id: total_mem_title
         text: qsTr("Total Memory Usage (%)")
+        stats: data_manager.MemUsedStats
         anchors.top: parent.top
     }
 
     MemoryUsage {
         id: total_mem_graph
+        now_ms: main_window.now_ms
         anchors.top: total_mem_title.bottom
 
         AreaSeries {
@@ -70,21 +48,10 @@ Window {
             borderColor: total_mem_graph.emerald_green
             color: total_mem_graph.mint_green
 
-            upperSeries: LineSeries {
+            upperSeries: HistoryLine {
                 id: mem_used_line
-                Connections {
-                    target: data_manager
-
-                    function onNotifyMemUsedKb() {
-
-                        updateArrayXValues(mem_used_history);
-                        turnoverArray(mem_used_history, total_mem_graph.default_window_ms);
-
-                        let mem_usage_percent = data_manager.MemUsedKb / data_manager.MemTotalKb * 100;
-                        mem_used_history.push({x: 0, y: mem_usage_percent, timestamp_ms: main_window.now_ms});
-                        mem_used_line.replace(mem_used_history);
-                    }
-                }
+                history: data_manager.MemUsedHistory
+                graph_width: total_mem_graph.width
             }
         }
     }
@@ -92,11 +59,13 @@ Window {
     GraphHeading {
         id: fg_mem_title
         text: qsTr("% of Used Memory reserved by Foreground");
+        stats: data_manager.MemProcStats
         anchors.top: total_mem_graph.bottom
     }
 
     MemoryUsage {
         id: fg_mem
+        now_ms: main_window.now_ms
         anchors.top: fg_mem_title.bottom
 
         AreaSeries {
@@ -104,34 +73,51 @@ Window {
 
             color: fg_mem.dirty_green
 
-            upperSeries: LineSeries {
+            upperSeries: HistoryLine {
                 id: fg_mem_line
+                history: data_manager.MemProcHistory
+                graph_width: fg_mem.width
+            }
 
-                Connections {
-                    target: data_manager
-                    function onNotifyMemProcKb() {
+        }
 
-                        updateArrayXValues(mem_proc_history);
-                        turnoverArray(mem_proc_history, fg_mem.default_window_ms);
+        // Resident and unique sets around the proportional one, empty where the breakdown is not known
+        HistoryLine {
+            id: fg_mem_rss_line
+            color: fg_mem.celadon_green
+            visible: data_manager.MemProcDetailed
+            history: data_manager.MemProcRssHistory
+            graph_width: fg_mem.width
+        }
 
-                        let mem_proc_percent = data_manager.MemProcKb / data_manager.MemUsedKb * 100;
-                        mem_proc_history.push({x: 0, y: mem_proc_percent,timestamp_ms: main_window.now_ms});
-                        fg_mem_line.replace(mem_proc_history);
-                    }
-                }
-            }
+        HistoryLine {
+            id: fg_mem_uss_line
+            color: fg_mem.dark_green
+            visible: data_manager.MemProcDetailed
+            history: data_manager.MemProcUssHistory
+            graph_width: fg_mem.width
+        }
 
+        // Swapped out on top of the resident set, against the same used memory
+        HistoryLine {
+            id: fg_mem_swap_line
+            color: fg_mem.emerald_green
+            visible: data_manager.MemProcDetailed
+            history: data_manager.MemProcSwapHistory
+            graph_width: fg_mem.width
         }
     }
 
     GraphHeading {
         id: cpu_usage_title
         text: qsTr("CPU Usage (%)")
+        stats: data_manager.CpuTotalStats
         anchors.top: fg_mem.bottom
     }
 
     CpuUsage {
         id: cpu_usage
+        now_ms: main_window.now_ms
         anchors.top: cpu_usage_title.bottom
 
         AreaSeries {
@@ -139,21 +125,10 @@ Window {
 
             color: cpu_usage.total_usage_color
 
-            upperSeries: LineSeries {
+            upperSeries: HistoryLine {
                 id: cpu_usage_line
-
-                Connections {
-                    target: data_manager
-                    function onNotifyCpuTotal() {
-
-                        updateArrayXValues(cpu_used_history);
-                        turnoverArray(cpu_used_history, cpu_usage.default_window_ms);
-
-                        let data_entry = data_manager.CpuTotalUse * 100;
-                        cpu_used_history.push({x: 0, y: data_entry, timestamp_ms: main_window.now_ms});
-                        cpu_usage_line.replace(cpu_used_history);
-                    }
-                }
+                history: data_manager.CpuTotalHistory
+                graph_width: cpu_usage.width
             }
         }
     }
@@ -162,10 +137,12 @@ Window {
         id: cpu_proc_title
         anchors.top: cpu_usage.bottom
         text: qsTr("% of CPU Usage used by Foreground")
+        stats: data_manager.CpuProcStats
     }
 
     CpuUsage {
         id: cpu_proc
+        now_ms: main_window.now_ms
         anchors.top: cpu_proc_title.bottom
 
         AreaSeries {
@@ -173,22 +150,80 @@ Window {
 
             color: cpu_usage.proc_usage_color
 
-            upperSeries: LineSeries {
+            upperSeries: HistoryLine {
                 id: cpu_proc_line
+                history: data_manager.CpuProcHistory
+                graph_width: cpu_proc.width
+            }
+        }
+    }
+
+    GraphHeading {
+        id: gpu_proc_title
+        anchors.top: cpu_proc.bottom
+        text: qsTr("GPU Usage by Foreground (%)")
+        stats: data_manager.GpuProcStats
+    }
+
+    GpuUsage {
+        id: gpu_proc
+        now_ms: main_window.now_ms
+        anchors.top: gpu_proc_title.bottom
+
+        AreaSeries {
+            id: gpu_proc_series
+
+            borderColor: gpu_proc.engine_border_color
+            color: gpu_proc.engine_color
+
+            upperSeries: HistoryLine {
+                id: gpu_proc_line
+                history: data_manager.GpuProcHistory
+                graph_width: gpu_proc.width
+            }
+        }
+    }
+
+    GraphHeading {
+        id: io_title
+        anchors.top: gpu_proc.bottom
+        text: qsTr("Disk I/O (KiB/s), Foreground %1 read  %2 written")
+            .arg(data_manager.IoReadKbps.toFixed(0))
+            .arg(data_manager.IoWriteKbps.toFixed(0))
+    }
 
-                Connections {
-                    target: data_manager
-                    function onNotifyCpuProcUse() {
+    IoUsage {
+        id: io_usage
+        now_ms: main_window.now_ms
+        scale_max: data_manager.IoPeakKbps
+        anchors.top: io_title.bottom
 
-                        updateArrayXValues(cpu_proc_history);
-                        turnoverArray(cpu_proc_history, cpu_proc.default_window_ms);
+        // Every disk together, read and written, behind the foreground's own share of it
+        AreaSeries {
+            id: disk_io_series
 
-                        let data_entry = data_manager.CpuProcUse * 100;
-                        cpu_proc_history.push({x: 0, y: data_entry, timestamp_ms: main_window.now_ms});
-                        cpu_proc_line.replace(cpu_proc_history);
-                    }
-                }
+            borderColor: io_usage.disk_total_border_color
+            color: io_usage.disk_total_color
+
+            upperSeries: HistoryLine {
+                id: disk_io_line
+                history: data_manager.DiskIoHistory
+                graph_width: io_usage.width
             }
         }
+
+        HistoryLine {
+            id: io_read_line
+            color: io_usage.read_color
+            history: data_manager.IoReadHistory
+            graph_width: io_usage.width
+        }
+
+        HistoryLine {
+            id: io_write_line
+            color: io_usage.write_color
+            history: data_manager.IoWriteHistory
+            graph_width: io_usage.width
+        }
     }
 }
@@ -0,0 +1,387 @@
+#include "replaysource.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "scheduler.h"
+
+namespace {
+
+void copyName(char *out, size_t size, const std::string &name) {
+    std::snprintf(out, size, "%s", name.c_str());
+}
+
+void appendNumber(std::string &out, unsigned long long value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.push_back(' ');
+    out.append(digits, end);
+}
+
+} // namespace
+
+ReplayPacer::ReplayPacer(ReplaySpeed speed):
+    speed{speed},
+    started{false},
+    first_time_us{0},
+    start{},
+    scheduler{nullptr}
+{
+}
+
+void ReplayPacer::setScheduler(SampleScheduler *scheduler) {
+    this->scheduler = scheduler;
+}
+
+bool ReplayPacer::waitFor(int64_t time_us) {
+    if (speed == ReplaySpeed::AsFastAsPossible)
+        return true;
+
+    if (!started) {
+        started = true;
+        first_time_us = time_us;
+        start = std::chrono::steady_clock::now();
+        return true;
+    }
+    const auto due = start + std::chrono::microseconds(time_us - first_time_us);
+    if (scheduler != nullptr)
+        return scheduler->waitUntil(due);
+    std::this_thread::sleep_until(due);
+    return true;
+}
+
+TraceSampleSource::TraceSampleSource(ReplaySpeed speed):
+    block{0},
+    row{0},
+    cpu_use_column{NO_COLUMN},
+    cpu_proc_use_column{NO_COLUMN},
+    gpu_proc_use_column{NO_COLUMN},
+    mem_total_column{NO_COLUMN},
+    mem_used_column{NO_COLUMN},
+    mem_proc_column{NO_COLUMN},
+    pacer{speed},
+    cpu_time{0.0},
+    process_time{0.0},
+    reported_process_time{0},
+    previous_time_us{0},
+    has_previous{false}
+{
+}
+
+size_t TraceSampleSource::gaugeColumn(const char *name) const {
+    size_t gauge = 0;
+    for (const auto &column : reader.columnList()) {
+        if (column.kind != TelemetryColumnKind::Gauge)
+            continue;
+        if (column.name == name)
+            return gauge;
+        gauge++;
+    }
+    return NO_COLUMN;
+}
+
+size_t TraceSampleSource::counterColumn(const char *name) const {
+    size_t counter = 0;
+    for (const auto &column : reader.columnList()) {
+        if (column.kind != TelemetryColumnKind::Counter)
+            continue;
+        if (column.name == name)
+            return counter;
+        counter++;
+    }
+    return NO_COLUMN;
+}
+
+bool TraceSampleSource::open(const std::string &path) {
+    if (!reader.open(path))
+        return false;
+
+    cpu_use_column = gaugeColumn("cpu_use");
+    cpu_proc_use_column = gaugeColumn("cpu_proc_use");
+    gpu_proc_use_column = gaugeColumn("gpu_proc_use");
+    mem_total_column = counterColumn("mem_total");
+    mem_used_column = counterColumn("mem_used");
+    mem_proc_column = counterColumn("mem_proc");
+
+    size_t separator = path.find_last_of("/\\");
+    trace_name = separator == std::string::npos ? path : path.substr(separator + 1);
+
+    block = 0;
+    row = 0;
+    rows.timestamps.clear();
+    cpu_time = 0.0;
+    process_time = 0.0;
+    reported_process_time = 0;
+    has_previous = false;
+    return true;
+}
+
+bool TraceSampleSource::sample(SampleFrame &frame) {
+    while (row >= rows.timestamps.size()) {
+        if (block >= reader.blockCount() || !reader.readBlock(block++, rows))
+            return false;
+        row = 0;
+    }
+
+    const size_t gauges = reader.gaugeCount();
+    const size_t counters = reader.counterCount();
+    auto gauge = [&](size_t column) {
+        return column == NO_COLUMN ? 0.0 : rows.gauges[row * gauges + column];
+    };
+    auto counter = [&](size_t column) {
+        return column == NO_COLUMN ? 0ull : static_cast<unsigned long long>(rows.counters[row * counters + column]);
+    };
+
+    const int64_t time_us = rows.timestamps[row];
+    if (!pacer.waitFor(time_us))
+        return false;
+
+    if (has_previous) {
+        double cpu_delta = gauge(cpu_use_column) * static_cast<double>(time_us - previous_time_us);
+        cpu_time += cpu_delta;
+        process_time += gauge(cpu_proc_use_column) * cpu_delta;
+    }
+
+    frame.time_us = time_us;
+    frame.process = ProcHandle{};
+    frame.process_changed = !has_previous;
+    frame.mem_total = counter(mem_total_column);
+    frame.mem_available = frame.mem_total - std::min(frame.mem_total, counter(mem_used_column));
+    frame.cpu_time = static_cast<unsigned long long>(std::llround(cpu_time));
+    frame.process_time = static_cast<unsigned long long>(std::llround(process_time));
+    frame.process_time_delta = frame.process_time - reported_process_time;
+    frame.process_delta_valid = has_previous;
+    reported_process_time = frame.process_time;
+    frame.process_memory = counter(mem_proc_column);
+    frame.process_breakdown = MemoryBreakdown{};
+    frame.process_breakdown.rss = frame.process_memory;
+    frame.process_gpu_use = gauge(gpu_proc_use_column);
+    frame.watch_count = 0;
+    if (!has_previous)
+        copyName(frame.process_name, sizeof(frame.process_name), trace_name);
+
+    previous_time_us = time_us;
+    has_previous = true;
+    row++;
+    return true;
+}
+
+const CpuCoreStats& TraceSampleSource::coreStats() const {
+    return no_cores;
+}
+
+bool TraceSampleSource::updateProcessTable(double) {
+    return false;
+}
+
+size_t TraceSampleSource::processCount() const {
+    return 0;
+}
+
+const std::vector<ProcessInfo>& TraceSampleSource::topCpuProcesses() const {
+    return no_processes;
+}
+
+const std::vector<ProcessInfo>& TraceSampleSource::topMemoryProcesses() const {
+    return no_processes;
+}
+
+unsigned TraceSampleSource::logicalCores() const {
+    return 1;
+}
+
+bool TraceSampleSource::selfPaced() const {
+    return true;
+}
+
+void TraceSampleSource::setScheduler(SampleScheduler *scheduler) {
+    pacer.setScheduler(scheduler);
+}
+
+std::string TraceSampleSource::name() const {
+    return trace_name;
+}
+
+SyntheticSampleSource::SyntheticSampleSource(SyntheticPattern pattern, unsigned cores,
+                                             std::chrono::milliseconds interval, uint64_t ticks,
+                                             ReplaySpeed speed, uint32_t seed):
+    pattern{pattern},
+    cores{std::max(cores, 1u)},
+    interval_us{std::chrono::duration_cast<std::chrono::microseconds>(interval).count()},
+    tick_limit{ticks},
+    tick{0},
+    pacer{speed},
+    random{seed},
+    busy(this->cores, 0),
+    idle(this->cores, 0),
+    total_busy{0},
+    process_time{0.0},
+    reported_process_time{0},
+    mean_load{0.0}
+{
+    if (interval_us <= 0)
+        interval_us = 1000;
+
+    // Aggregate plus one line per core, each at most 11 numbers of 20 digits
+    stat_text.reserve((this->cores + 1) * 256);
+    top_cpu.resize(TOP_PROCESSES);
+    top_memory.resize(TOP_PROCESSES);
+}
+
+bool SyntheticSampleSource::parsePattern(const std::string &text, SyntheticPattern &pattern) {
+    if (text == "ramp") {
+        pattern = SyntheticPattern::Ramp;
+        return true;
+    }
+    if (text == "spikes") {
+        pattern = SyntheticPattern::Spikes;
+        return true;
+    }
+    return false;
+}
+
+double SyntheticSampleSource::noise() {
+    return random() / (static_cast<double>(std::mt19937::max()) + 1.0);
+}
+
+double SyntheticSampleSource::coreLoad(unsigned core) {
+    if (pattern == SyntheticPattern::Ramp) {
+        uint64_t phase = (tick + core * RAMP_TICKS / cores) % RAMP_TICKS;
+        return static_cast<double>(phase) / (RAMP_TICKS - 1);
+    }
+
+    if (tick % SPIKE_PERIOD_TICKS < SPIKE_LENGTH_TICKS)
+        return 1.0;
+    if (core == (tick / 10) % cores)
+        return 1.0;
+    return 0.05 + 0.1 * noise();
+}
+
+void SyntheticSampleSource::renderStat() {
+    auto render_line = [this](unsigned long long user, unsigned long long idle_time) {
+        // user nice system idle iowait irq softirq steal guest guest_nice
+        appendNumber(stat_text, user);
+        appendNumber(stat_text, 0);
+        appendNumber(stat_text, 0);
+        appendNumber(stat_text, idle_time);
+        for (int field = 0; field < 6; field++)
+            appendNumber(stat_text, 0);
+        stat_text.push_back('\n');
+    };
+
+    unsigned long long total_idle = 0;
+    for (unsigned core = 0; core < cores; core++)
+        total_idle += idle[core];
+
+    stat_text.clear();
+    stat_text += "cpu ";
+    render_line(total_busy, total_idle);
+    char label[16];
+    for (unsigned core = 0; core < cores; core++) {
+        int length = std::snprintf(label, sizeof(label), "cpu%u", core);
+        stat_text.append(label, static_cast<size_t>(length));
+        render_line(busy[core], idle[core]);
+    }
+    stat_text += "intr 0\n";
+}
+
+bool SyntheticSampleSource::sample(SampleFrame &frame) {
+    if (tick_limit != 0 && tick >= tick_limit)
+        return false;
+
+    const int64_t time_us = static_cast<int64_t>(tick) * interval_us;
+    if (!pacer.waitFor(time_us))
+        return false;
+
+    unsigned long long busy_delta = 0;
+    for (unsigned core = 0; core < cores; core++) {
+        auto core_busy = static_cast<unsigned long long>(std::llround(coreLoad(core) * interval_us));
+        busy[core] += core_busy;
+        idle[core] += static_cast<unsigned long long>(interval_us) - core_busy;
+        busy_delta += core_busy;
+    }
+    total_busy += busy_delta;
+    process_time += 0.25 * busy_delta;
+    mean_load = static_cast<double>(busy_delta) / (static_cast<double>(interval_us) * cores);
+
+    renderStat();
+    stats.parse(stat_text.data(), stat_text.size());
+
+    frame.time_us = time_us;
+    frame.process = ProcHandle{};
+    frame.process_changed = tick % FOREGROUND_TICKS == 0;
+    frame.mem_total = MEM_TOTAL;
+    frame.mem_available = MEM_TOTAL - MEM_BASE - static_cast<unsigned long long>(mean_load * (8ull << 30));
+    frame.cpu_time = total_busy;
+    frame.process_time = static_cast<unsigned long long>(process_time);
+    // One foreground counter across the simulated focus changes, so every tick after the first has a delta
+    frame.process_time_delta = frame.process_time - reported_process_time;
+    frame.process_delta_valid = tick > 0;
+    reported_process_time = frame.process_time;
+    frame.process_memory = PROCESS_MEM_BASE + (tick % RAMP_TICKS) * 4096;
+    frame.process_breakdown = MemoryBreakdown{};
+    frame.process_breakdown.rss = frame.process_memory;
+    // The foreground process renders harder the busier the machine is
+    frame.process_gpu_use = std::min(1.0, 0.1 + 0.8 * mean_load);
+    frame.watch_count = 0;
+    if (frame.process_changed)
+        copyName(frame.process_name, sizeof(frame.process_name),
+                 (tick / FOREGROUND_TICKS) % 2 == 0 ? "synthetic-a" : "synthetic-b");
+
+    tick++;
+    return true;
+}
+
+const CpuCoreStats& SyntheticSampleSource::coreStats() const {
+    return stats;
+}
+
+bool SyntheticSampleSource::updateProcessTable(double) {
+    // Shares shrink down the list, the busiest process follows the overall load
+    for (size_t i = 0; i < TOP_PROCESSES; i++) {
+        ProcessInfo &cpu = top_cpu[i];
+        cpu.pid = static_cast<int32_t>(1000 + i);
+        std::snprintf(cpu.name, sizeof(cpu.name), "worker-%zu", i);
+        cpu.cpu_use = static_cast<float>(mean_load * cores / static_cast<double>(i + 2));
+        cpu.rss_bytes = PROCESS_MEM_BASE;
+
+        ProcessInfo &memory = top_memory[i];
+        memory.pid = static_cast<int32_t>(2000 + i);
+        std::snprintf(memory.name, sizeof(memory.name), "cache-%zu", i);
+        memory.cpu_use = 0.0f;
+        memory.rss_bytes = (2ull << 30) >> i;
+    }
+    return true;
+}
+
+size_t SyntheticSampleSource::processCount() const {
+    return PROCESS_COUNT;
+}
+
+const std::vector<ProcessInfo>& SyntheticSampleSource::topCpuProcesses() const {
+    return top_cpu;
+}
+
+const std::vector<ProcessInfo>& SyntheticSampleSource::topMemoryProcesses() const {
+    return top_memory;
+}
+
+unsigned SyntheticSampleSource::logicalCores() const {
+    return cores;
+}
+
+bool SyntheticSampleSource::selfPaced() const {
+    return true;
+}
+
+void SyntheticSampleSource::setScheduler(SampleScheduler *scheduler) {
+    pacer.setScheduler(scheduler);
+}
+
+std::string SyntheticSampleSource::name() const {
+    return std::string(pattern == SyntheticPattern::Ramp ? "ramp" : "spikes") + " x" + std::to_string(cores);
+}
@@ -0,0 +1,190 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "samplesource.h"
+#include "telemetryrecorder.h"
+
+enum class ReplaySpeed {
+    /** Ticks are delivered at the trace's own pace. */
+    Realtime,
+
+    /** Ticks are delivered as soon as the previous one is consumed, for load tests. */
+    AsFastAsPossible,
+};
+
+/** Holds back replayed ticks until their trace time is due, measured from the first tick. */
+class ReplayPacer {
+    ReplaySpeed speed;
+    bool started;
+    int64_t first_time_us;
+    std::chrono::steady_clock::time_point start;
+
+    /** Waited on when set, so the wait can be stopped, see `SampleSource::setScheduler`. */
+    SampleScheduler *scheduler;
+
+public:
+    explicit ReplayPacer(ReplaySpeed speed);
+
+    void setScheduler(SampleScheduler *scheduler);
+
+    /**
+     * Block until trace time `time_us` is due. Returns immediately when playing as fast as possible.
+     * @return false if the scheduler was stopped before then.
+     */
+    bool waitFor(int64_t time_us);
+};
+
+/**
+ * Plays a file written by `TelemetryRecorder` (see `DataManager::startRecording`). Columns are looked up by name,
+ * missing ones read as 0.
+ *
+ * The CPU counters are rebuilt from the recorded ratios against one logical core, so `DataManager` arrives at the
+ * recorded utilization again, to within the microsecond rounding of one tick. Per-core ratios and the process
+ * table are not part of a recording and replay as empty.
+ */
+class TraceSampleSource: public SampleSource {
+    static constexpr size_t NO_COLUMN = static_cast<size_t>(-1);
+
+    TelemetryReader reader;
+    TelemetryReader::Rows rows;
+    size_t block;
+    size_t row;
+
+    /** Positions among the gauges or the counters of the columns that are replayed. */
+    size_t cpu_use_column;
+    size_t cpu_proc_use_column;
+    size_t gpu_proc_use_column;
+    size_t mem_total_column;
+    size_t mem_used_column;
+    size_t mem_proc_column;
+
+    ReplayPacer pacer;
+    std::string trace_name;
+
+    /** Rebuilt counters, in microseconds of one core. */
+    double cpu_time;
+    double process_time;
+
+    /** `process_time` as rounded into the previous frame, deltas are taken between the rounded values. */
+    unsigned long long reported_process_time;
+    int64_t previous_time_us;
+    bool has_previous;
+
+    CpuCoreStats no_cores;
+    std::vector<ProcessInfo> no_processes;
+
+    size_t gaugeColumn(const char *name) const;
+    size_t counterColumn(const char *name) const;
+
+public:
+    explicit TraceSampleSource(ReplaySpeed speed);
+
+    /** @return false if `path` is not a readable recording. */
+    bool open(const std::string &path);
+
+    bool sample(SampleFrame &frame) override;
+    const CpuCoreStats& coreStats() const override;
+    bool updateProcessTable(double elapsed_seconds) override;
+    size_t processCount() const override;
+    const std::vector<ProcessInfo>& topCpuProcesses() const override;
+    const std::vector<ProcessInfo>& topMemoryProcesses() const override;
+    unsigned logicalCores() const override;
+    bool selfPaced() const override;
+    void setScheduler(SampleScheduler *scheduler) override;
+    std::string name() const override;
+};
+
+enum class SyntheticPattern {
+    /** Every core climbs from idle to fully busy and drops back, each a little out of phase with the last. */
+    Ramp,
+
+    /** Light noisy load with short all-core spikes and a single saturated core wandering across the cores. */
+    Spikes,
+};
+
+/**
+ * Generated load on a configurable number of cores, deterministic for a given seed.
+ * Each tick is rendered as `/proc/stat` text and goes through the real `CpuCoreStats` parser, so a run at many cores
+ * costs what a machine with that many cores would. The foreground process alternates between two names and the
+ * process table holds a fixed population whose top entries follow the load.
+ */
+class SyntheticSampleSource: public SampleSource {
+    static constexpr uint64_t RAMP_TICKS = 1000;
+    static constexpr uint64_t SPIKE_PERIOD_TICKS = 100;
+    static constexpr uint64_t SPIKE_LENGTH_TICKS = 5;
+    static constexpr uint64_t FOREGROUND_TICKS = 500;
+    static constexpr size_t PROCESS_COUNT = 300;
+    static constexpr size_t TOP_PROCESSES = 10;
+    static constexpr unsigned long long MEM_TOTAL = 16ull << 30;
+    static constexpr unsigned long long MEM_BASE = 4ull << 30;
+    static constexpr unsigned long long PROCESS_MEM_BASE = 256ull << 20;
+
+    SyntheticPattern pattern;
+    unsigned cores;
+    int64_t interval_us;
+    uint64_t tick_limit;
+    uint64_t tick;
+    ReplayPacer pacer;
+
+    /** Fixed algorithm, unlike the standard distributions, so runs match across standard libraries. */
+    std::mt19937 random;
+
+    /** Cumulative busy and idle microseconds per core, and their sum over the cores for busy. */
+    std::vector<unsigned long long> busy;
+    std::vector<unsigned long long> idle;
+    unsigned long long total_busy;
+
+    /** Cumulative foreground time, a fixed share of the busy time. */
+    double process_time;
+
+    /** `process_time` as truncated into the previous frame. */
+    unsigned long long reported_process_time;
+
+    /** Average core load of the current tick. */
+    double mean_load;
+
+    /** Scratch for the rendered `/proc/stat` block. */
+    std::string stat_text;
+    CpuCoreStats stats;
+
+    std::vector<ProcessInfo> top_cpu;
+    std::vector<ProcessInfo> top_memory;
+
+    /** Busy ratio of `core` on the current tick, `[0, 1]`. */
+    double coreLoad(unsigned core);
+
+    /** Uniform in `[0, 1)`. */
+    double noise();
+
+    void renderStat();
+
+public:
+    /**
+     * @param cores Logical cores to simulate, at least 1.
+     * @param ticks Number of ticks to play, 0 for no end.
+     */
+    SyntheticSampleSource(SyntheticPattern pattern, unsigned cores, std::chrono::milliseconds interval,
+                          uint64_t ticks, ReplaySpeed speed, uint32_t seed = 1);
+
+    /** "ramp" or "spikes". @return false for anything else. */
+    static bool parsePattern(const std::string &text, SyntheticPattern &pattern);
+
+    bool sample(SampleFrame &frame) override;
+    const CpuCoreStats& coreStats() const override;
+    bool updateProcessTable(double elapsed_seconds) override;
+    size_t processCount() const override;
+    const std::vector<ProcessInfo>& topCpuProcesses() const override;
+    const std::vector<ProcessInfo>& topMemoryProcesses() const override;
+    unsigned logicalCores() const override;
+    bool selfPaced() const override;
+    void setScheduler(SampleScheduler *scheduler) override;
+    std::string name() const override;
+};
+
+#endif // REPLAYSOURCE_H
@@ -0,0 +1,90 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Fixed-capacity FIFO. Storage is allocated once, pushes and pops are O(1) and never move other elements.
+ * Indexing is relative to the oldest element.
+ */
+template <typename T>
+class RingBuffer {
+
+    std::vector<T> slots;
+
+    /** Index of the oldest element in `slots`. */
+    size_t head;
+
+    size_t count;
+
+    size_t physical(size_t logical) const {
+        size_t index = head + logical;
+        return index >= slots.size() ? index - slots.size() : index;
+    }
+
+public:
+    explicit RingBuffer(size_t capacity = 0): slots(capacity), head{0}, count{0} {}
+
+    size_t capacity() const { return slots.size(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
+
+    /** Append at the back, overwriting the oldest element when full. */
+    void push(const T &value) {
+        if (slots.empty())
+            return;
+        if (full()) {
+            slots[head] = value;
+            head = physical(1);
+            return;
+        }
+        slots[physical(count)] = value;
+        count++;
+    }
+
+    /** Drop the oldest element. No-op when empty. */
+    void popFront() {
+        if (count == 0)
+            return;
+        head = physical(1);
+        count--;
+    }
+
+    /** Drop the newest element. No-op when empty. */
+    void popBack() {
+        if (count > 0)
+            count--;
+    }
+
+    const T& front() const { return slots[head]; }
+    const T& back() const { return slots[physical(count - 1)]; }
+
+    /** 0 is the oldest element, `size() - 1` the newest. */
+    const T& operator[](size_t index) const { return slots[physical(index)]; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    /** Grow to `capacity`, keeping every element in order. Never shrinks. */
+    void reserve(size_t capacity) {
+        if (capacity <= slots.size())
+            return;
+        std::vector<T> grown(capacity);
+        for (size_t i = 0; i < count; i++)
+            grown[i] = (*this)[i];
+        slots.swap(grown);
+        head = 0;
+    }
+
+    /** Drop every element and reallocate for a different capacity. */
+    void reset(size_t capacity) {
+        slots.assign(capacity, T{});
+        clear();
+    }
+};
+
+#endif // RINGBUFFER_H
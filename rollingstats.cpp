@@ -0,0 +1,156 @@
+#include "rollingstats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr size_t INITIAL_CAPACITY = 64;
+
+/** Push to the back of `ring`, doubling it rather than overwriting the oldest element. */
+template <typename T>
+void pushGrowing(RingBuffer<T> &ring, const T &value) {
+    if (ring.full())
+        ring.reserve(std::max(INITIAL_CAPACITY, ring.capacity() * 2));
+    ring.push(value);
+}
+
+} // namespace
+
+RollingStats::RollingStats(std::initializer_list<double> windows_ms, double lower, double upper):
+    samples{INITIAL_CAPACITY},
+    pushed{0},
+    lower{lower},
+    bucket_scale{BUCKETS / (upper - lower)}
+{
+    windows.resize(windows_ms.size());
+    size_t index = 0;
+    for (double length_ms : windows_ms) {
+        Window &window = windows[index++];
+        window.length_ms = length_ms;
+        window.min_queue.reset(INITIAL_CAPACITY);
+        window.max_queue.reset(INITIAL_CAPACITY);
+    }
+    clear();
+}
+
+void RollingStats::push(double timestamp_ms, double value) {
+    const uint64_t sequence = pushed;
+    pushGrowing(samples, Sample{timestamp_ms, value});
+    pushed++;
+
+    const size_t value_bucket = bucket(value);
+    uint64_t oldest_needed = sequence;
+    for (Window &window : windows) {
+        window.sum += value;
+        window.buckets[value_bucket]++;
+
+        // A sample hides every older one it undercuts (or overtops) for as long as it stays in the window
+        while (!window.min_queue.empty() && sample(window.min_queue.back()).value >= value)
+            window.min_queue.popBack();
+        pushGrowing(window.min_queue, sequence);
+        while (!window.max_queue.empty() && sample(window.max_queue.back()).value <= value)
+            window.max_queue.popBack();
+        pushGrowing(window.max_queue, sequence);
+
+        const double cutoff_ms = timestamp_ms - window.length_ms;
+        while (window.first < sequence && sample(window.first).timestamp_ms <= cutoff_ms) {
+            const double evicted = sample(window.first).value;
+            window.sum -= evicted;
+            window.buckets[bucket(evicted)]--;
+            if (window.min_queue.front() == window.first)
+                window.min_queue.popFront();
+            if (window.max_queue.front() == window.first)
+                window.max_queue.popFront();
+            window.first++;
+        }
+        oldest_needed = std::min(oldest_needed, window.first);
+    }
+
+    while (pushed - samples.size() < oldest_needed)
+        samples.popFront();
+}
+
+RollingSummary RollingStats::summary(size_t index) const {
+    const Window &window = windows[index];
+    RollingSummary summary {};
+    summary.window_ms = window.length_ms;
+
+    const uint64_t count = pushed - window.first;
+    if (count == 0)
+        return summary;
+
+    summary.count = static_cast<uint32_t>(count);
+    summary.min = sample(window.min_queue.front()).value;
+    summary.max = sample(window.max_queue.front()).value;
+    summary.mean = window.sum / static_cast<double>(count);
+    summary.p95 = quantile(window, count, summary.min, summary.max, 0.95);
+    summary.p99 = quantile(window, count, summary.min, summary.max, 0.99);
+    return summary;
+}
+
+size_t RollingStats::windowCount() const {
+    return windows.size();
+}
+
+void RollingStats::clear() {
+    samples.clear();
+    pushed = 0;
+    for (Window &window : windows) {
+        window.first = 0;
+        window.sum = 0.0;
+        window.min_queue.clear();
+        window.max_queue.clear();
+        std::fill(std::begin(window.buckets), std::end(window.buckets), 0u);
+    }
+}
+
+size_t RollingStats::bucket(double value) const {
+    const double scaled = (value - lower) * bucket_scale;
+    if (!(scaled > 0.0))
+        return 0;
+    return std::min(static_cast<size_t>(scaled), size_t{BUCKETS - 1});
+}
+
+double RollingStats::quantile(const Window &window, uint64_t count, double min, double max, double quantile) const {
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+
+    // Every value is at or below the bucket of the maximum, step down while enough still are without this bucket
+    size_t index = bucket(max);
+    uint64_t at_or_below = count;
+    while (index > 0 && at_or_below - window.buckets[index] >= rank) {
+        at_or_below -= window.buckets[index];
+        index--;
+    }
+
+    // The last bucket also holds everything above the range, it has no upper edge to speak of
+    if (index == BUCKETS - 1)
+        return max;
+    const double upper_edge = lower + static_cast<double>(index + 1) / bucket_scale;
+    return std::clamp(upper_edge, min, max);
+}
+
+RollingMax::RollingMax(double window_ms):
+    window_ms{window_ms},
+    queue{INITIAL_CAPACITY}
+{
+}
+
+void RollingMax::push(double timestamp_ms, double value) {
+    while (!queue.empty() && queue.back().value <= value)
+        queue.popBack();
+    pushGrowing(queue, Sample{timestamp_ms, value});
+
+    // The newest sample stays whatever the window, it is at the back
+    const double cutoff_ms = timestamp_ms - window_ms;
+    while (queue.size() > 1 && queue.front().timestamp_ms <= cutoff_ms)
+        queue.popFront();
+}
+
+double RollingMax::max() const {
+    return queue.empty() ? 0.0 : queue.front().value;
+}
+
+void RollingMax::clear() {
+    queue.clear();
+}
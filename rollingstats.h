@@ -0,0 +1,143 @@
+#ifndef ROLLINGSTATS_H
+#define ROLLINGSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "ringbuffer.h"
+
+/** Statistics of one metric over one window, all zero while the window is empty. */
+struct RollingSummary {
+    double window_ms;
+
+    /** Samples in the window. */
+    uint32_t count;
+
+    double min;
+    double max;
+    double mean;
+
+    /** Within one quantile bucket of the exact value, see `RollingStats`. */
+    double p95;
+    double p99;
+};
+
+/**
+ * Min, max, mean, p95 and p99 of one metric over several trailing windows at once, e.g. the last 1 s, 10 s and 60 s.
+ * A window holds the samples newer than its length before the newest one, so uneven sample spacing is fine.
+ *
+ * Every `push` is O(1) amortized, whatever the window lengths and however fast samples come:
+ * - min and max are the fronts of a monotonic deque per window, each sample enters and leaves them once;
+ * - the mean is a running sum, a sample is added on entry and subtracted on eviction;
+ * - the quantiles come from a histogram of `BUCKETS` linear buckets over `[lower, upper]` per window, counted up on
+ *   entry and down on eviction. `summary` walks it down from the bucket of the maximum, so p95 and p99 usually cost a
+ *   few buckets and never more than `BUCKETS`. They are reported as the upper edge of their bucket clamped to the
+ *   window's min and max, within `(upper - lower) / BUCKETS` of the exact value. Values outside the range are
+ *   counted in the first or last bucket.
+ *
+ * The samples themselves are kept once, for the longest window, in a buffer that doubles whenever it fills up while
+ * every sample in it is still needed, so it settles at the window length over the fastest interval seen.
+ *
+ * Not thread-safe.
+ */
+class RollingStats {
+public:
+    static constexpr unsigned BUCKETS = 256;
+
+    /**
+     * @param windows_ms Window lengths in milliseconds, summaries are indexed in this order.
+     * @param lower Lower end of the quantile range.
+     * @param upper Upper end of the quantile range, greater than `lower`.
+     */
+    RollingStats(std::initializer_list<double> windows_ms, double lower, double upper);
+
+    /** Add the newest sample and evict whatever fell out of each window. Timestamps must not go backwards. */
+    void push(double timestamp_ms, double value);
+
+    /** Statistics of window `index` as of the newest sample. */
+    RollingSummary summary(size_t index) const;
+
+    size_t windowCount() const;
+
+    /** Drop every sample, keeping the allocations. */
+    void clear();
+
+private:
+    struct Sample {
+        double timestamp_ms;
+        double value;
+    };
+
+    struct Window {
+        double length_ms;
+
+        /** Sequence number of the oldest sample in the window. */
+        uint64_t first;
+
+        double sum;
+
+        /** Sequence numbers of increasing values, the front is the window's minimum. */
+        RingBuffer<uint64_t> min_queue;
+
+        /** Sequence numbers of decreasing values, the front is the window's maximum. */
+        RingBuffer<uint64_t> max_queue;
+
+        uint32_t buckets[BUCKETS];
+    };
+
+    std::vector<Window> windows;
+
+    /** Every sample still in some window, oldest first. */
+    RingBuffer<Sample> samples;
+
+    /** Sequence number the next sample gets, the number of samples pushed so far. */
+    uint64_t pushed;
+
+    double lower;
+    double bucket_scale;
+
+    const Sample& sample(uint64_t sequence) const {
+        return samples[static_cast<size_t>(sequence - (pushed - samples.size()))];
+    }
+
+    size_t bucket(double value) const;
+
+    /** Smallest bucket edge at or above `quantile` of the values in `window`, clamped to its min and max. */
+    double quantile(const Window &window, uint64_t count, double min, double max, double quantile) const;
+};
+
+/**
+ * Maximum of one metric over one trailing window, for when that is all that is wanted and `RollingStats` would keep
+ * a histogram for nothing. Same window as there: the samples newer than its length before the newest one.
+ *
+ * The samples that may still become the maximum are kept in a monotonic deque, decreasing from the front, so each
+ * sample enters and leaves it once and `push` is O(1) amortized. It grows like `RollingStats` does. Not thread-safe.
+ */
+class RollingMax {
+public:
+    explicit RollingMax(double window_ms);
+
+    /** Add the newest sample and evict whatever fell out of the window. Timestamps must not go backwards. */
+    void push(double timestamp_ms, double value);
+
+    /** Maximum of the window as of the newest sample, 0 while empty. */
+    double max() const;
+
+    /** Drop every sample, keeping the allocation. */
+    void clear();
+
+private:
+    struct Sample {
+        double timestamp_ms;
+        double value;
+    };
+
+    double window_ms;
+
+    /** Samples of decreasing value, oldest first, the front is the maximum. */
+    RingBuffer<Sample> queue;
+};
+
+#endif // ROLLINGSTATS_H
@@ -0,0 +1,115 @@
+#include "samplesource.h"
+
+#include <chrono>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+LiveSampleSource::LiveSampleSource(): data_source{} {}
+
+bool LiveSampleSource::sample(SampleFrame &frame) {
+    using namespace std::chrono;
+
+    frame.time_us = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    data_source.sample(frame);
+    return true;
+}
+
+const CpuCoreStats& LiveSampleSource::coreStats() const {
+    return data_source.getCoreStats();
+}
+
+bool LiveSampleSource::updateProcessTable(double elapsed_seconds) {
+    return data_source.updateProcessTable(elapsed_seconds);
+}
+
+size_t LiveSampleSource::processCount() const {
+    return data_source.getProcessCount();
+}
+
+const std::vector<ProcessInfo>& LiveSampleSource::topCpuProcesses() const {
+    return data_source.getTopCpuProcesses();
+}
+
+const std::vector<ProcessInfo>& LiveSampleSource::topMemoryProcesses() const {
+    return data_source.getTopMemoryProcesses();
+}
+
+unsigned LiveSampleSource::logicalCores() const {
+    return 0;
+}
+
+bool LiveSampleSource::selfPaced() const {
+    return false;
+}
+
+std::string LiveSampleSource::name() const {
+    return "live";
+}
+
+int LiveSampleSource::eventDescriptor() const {
+#ifdef _WIN32
+    return -1;
+#else
+    return data_source.exitDescriptor();
+#endif
+}
+
+void LiveSampleSource::handleEvents() {
+#ifndef _WIN32
+    data_source.handleProcessExits();
+#endif
+}
+
+void LiveSampleSource::setTargetProcess(int pid) {
+#ifdef _WIN32
+    (void) pid;
+#else
+    data_source.setTargetPid(pid > 0 ? pid : getpid());
+#endif
+}
+
+void LiveSampleSource::setWatchTargets(const std::vector<WatchTarget> &targets) {
+    data_source.setWatchTargets(targets);
+}
+
+void LiveSampleSource::setCgroupSelection(const std::vector<std::string> &paths) {
+    data_source.setCgroupSelection(paths);
+}
+
+bool LiveSampleSource::updateCgroups(double elapsed_seconds) {
+    return data_source.updateCgroups(elapsed_seconds);
+}
+
+const std::vector<CgroupInfo>& LiveSampleSource::cgroups() const {
+    return data_source.getCgroups();
+}
+
+bool LiveSampleSource::updateThreads(double elapsed_seconds) {
+    return data_source.updateThreads(elapsed_seconds);
+}
+
+size_t LiveSampleSource::threadCount() const {
+    return data_source.getThreadCount();
+}
+
+const std::vector<ThreadInfo>& LiveSampleSource::topThreads() const {
+    return data_source.getTopThreads();
+}
+
+bool LiveSampleSource::updateIo(double elapsed_seconds) {
+    return data_source.updateIo(elapsed_seconds);
+}
+
+const IoRate& LiveSampleSource::foregroundIo() const {
+    return data_source.getForegroundIo();
+}
+
+const std::vector<IoRate>& LiveSampleSource::watchIo() const {
+    return data_source.getWatchIo();
+}
+
+const std::vector<DiskInfo>& LiveSampleSource::disks() const {
+    return data_source.getDisks();
+}
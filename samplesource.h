@@ -0,0 +1,162 @@
+#ifndef SAMPLESOURCE_H
+#define SAMPLESOURCE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "procdata.h"
+
+class SampleScheduler;
+
+/**
+ * Where `DataManager` gets its ticks from. The live source reads the OS through `ProcData`; replay sources play a
+ * recorded or generated trace, so the model, graphs and signal path can be driven repeatably and without the
+ * machine the trace came from.
+ */
+class SampleSource {
+public:
+    virtual ~SampleSource() = default;
+
+    /**
+     * Fill `frame` for the next tick, including `SampleFrame::time_us`.
+     * @return false once the source has nothing more to play, or its scheduler was stopped while it waited for the
+     * tick. The live source never runs out.
+     */
+    virtual bool sample(SampleFrame &frame) = 0;
+
+    /** Per-core utilization over the interval ending at the last `sample`. */
+    virtual const CpuCoreStats& coreStats() const = 0;
+
+    /** Same contracts as the process table calls of `ProcData`. */
+    virtual bool updateProcessTable(double elapsed_seconds) = 0;
+    virtual size_t processCount() const = 0;
+    virtual const std::vector<ProcessInfo>& topCpuProcesses() const = 0;
+    virtual const std::vector<ProcessInfo>& topMemoryProcesses() const = 0;
+
+    /** Logical cores `SampleFrame::cpu_time` is normalized against, 0 for the machine's own. */
+    virtual unsigned logicalCores() const = 0;
+
+    /**
+     * True if `sample` keeps its own time, waiting for the trace's tick times or not at all, so it is called back to
+     * back. False if it has to be called on the `SampleScheduler` grid.
+     */
+    virtual bool selfPaced() const = 0;
+
+    /**
+     * Scheduler a self-paced source waits on for its tick times, so `SampleScheduler::stop` ends the wait and events
+     * are handled during it. Without one it sleeps. Sources on the grid ignore it.
+     */
+    virtual void setScheduler(SampleScheduler *scheduler) {
+        (void) scheduler;
+    }
+
+    /** Short description for the UI. */
+    virtual std::string name() const = 0;
+
+    /**
+     * Descriptor that becomes readable when the source has events for `handleEvents`, -1 if it has none.
+     * The live source reports exits of the processes it tracks here.
+     */
+    virtual int eventDescriptor() const {
+        return -1;
+    }
+
+    /** Handle whatever made `eventDescriptor` readable, called from the sampling thread between ticks. */
+    virtual void handleEvents() {}
+
+    /**
+     * Report `pid` as the foreground process from the next `sample` on, 0 for the source's own choice: this process
+     * on Linux, the process of the foreground window on Win32, which always follows the window for now. Replayed
+     * traces carry their own foreground and ignore it.
+     */
+    virtual void setTargetProcess(int pid) {
+        (void) pid;
+    }
+
+    /**
+     * Follow `targets` in `SampleFrame::watches` from the next `sample` on, see `ProcData::setWatchTargets`.
+     * Replayed traces have no processes to watch and report none.
+     */
+    virtual void setWatchTargets(const std::vector<WatchTarget> &targets) {
+        (void) targets;
+    }
+
+    /** Same contracts as the cgroup calls of `ProcData`. Replayed traces have no cgroups and report none. */
+    virtual void setCgroupSelection(const std::vector<std::string> &paths) {
+        (void) paths;
+    }
+    virtual bool updateCgroups(double elapsed_seconds) {
+        (void) elapsed_seconds;
+        return false;
+    }
+    virtual const std::vector<CgroupInfo>& cgroups() const {
+        static const std::vector<CgroupInfo> none;
+        return none;
+    }
+
+    /** Same contracts as the thread calls of `ProcData`. Replayed traces have no threads and report none. */
+    virtual bool updateThreads(double elapsed_seconds) {
+        (void) elapsed_seconds;
+        return false;
+    }
+    virtual size_t threadCount() const {
+        return 0;
+    }
+    virtual const std::vector<ThreadInfo>& topThreads() const {
+        static const std::vector<ThreadInfo> none;
+        return none;
+    }
+
+    /** Same contracts as the I/O calls of `ProcData`. Replayed traces carry no I/O and report none. */
+    virtual bool updateIo(double elapsed_seconds) {
+        (void) elapsed_seconds;
+        return false;
+    }
+    virtual const IoRate& foregroundIo() const {
+        static const IoRate none {};
+        return none;
+    }
+    virtual const std::vector<IoRate>& watchIo() const {
+        static const std::vector<IoRate> none;
+        return none;
+    }
+    virtual const std::vector<DiskInfo>& disks() const {
+        static const std::vector<DiskInfo> none;
+        return none;
+    }
+};
+
+/** The OS, through `ProcData`. Stamps every frame with the monotonic clock. */
+class LiveSampleSource: public SampleSource {
+    ProcData data_source;
+
+public:
+    LiveSampleSource();
+
+    bool sample(SampleFrame &frame) override;
+    const CpuCoreStats& coreStats() const override;
+    bool updateProcessTable(double elapsed_seconds) override;
+    size_t processCount() const override;
+    const std::vector<ProcessInfo>& topCpuProcesses() const override;
+    const std::vector<ProcessInfo>& topMemoryProcesses() const override;
+    unsigned logicalCores() const override;
+    bool selfPaced() const override;
+    std::string name() const override;
+    int eventDescriptor() const override;
+    void handleEvents() override;
+    void setTargetProcess(int pid) override;
+    void setWatchTargets(const std::vector<WatchTarget> &targets) override;
+    void setCgroupSelection(const std::vector<std::string> &paths) override;
+    bool updateCgroups(double elapsed_seconds) override;
+    const std::vector<CgroupInfo>& cgroups() const override;
+    bool updateThreads(double elapsed_seconds) override;
+    size_t threadCount() const override;
+    const std::vector<ThreadInfo>& topThreads() const override;
+    bool updateIo(double elapsed_seconds) override;
+    const IoRate& foregroundIo() const override;
+    const std::vector<IoRate>& watchIo() const override;
+    const std::vector<DiskInfo>& disks() const override;
+};
+
+#endif // SAMPLESOURCE_H
@@ -0,0 +1,232 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+SampleScheduler::SampleScheduler(std::chrono::milliseconds interval):
+    interval_ms{clampInterval(interval).count()},
+    missed{0},
+    stopping{false},
+    event_fd{-1}
+{
+#ifdef __linux__
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    arm(this->interval());
+#else
+    next_deadline = std::chrono::steady_clock::now() + this->interval();
+    rearmed = false;
+#endif
+}
+
+SampleScheduler::~SampleScheduler() {
+#ifdef __linux__
+    if (timer_fd >= 0)
+        close(timer_fd);
+    if (wake_fd >= 0)
+        close(wake_fd);
+#endif
+}
+
+std::chrono::milliseconds SampleScheduler::clampInterval(std::chrono::milliseconds interval) {
+    return std::clamp(interval, MIN_INTERVAL, MAX_INTERVAL);
+}
+
+std::chrono::milliseconds SampleScheduler::interval() const {
+    return std::chrono::milliseconds(interval_ms.load(std::memory_order_relaxed));
+}
+
+uint64_t SampleScheduler::missedDeadlines() const {
+    return missed.load(std::memory_order_relaxed);
+}
+
+bool SampleScheduler::stopped() const {
+    return stopping.load(std::memory_order_acquire);
+}
+
+void SampleScheduler::setEventHandler(int fd, std::function<void()> handler) {
+    event_fd = handler ? fd : -1;
+    event_handler = std::move(handler);
+}
+
+#ifdef __linux__
+
+namespace {
+
+constexpr long NANOSEC_PER_SEC = 1000000000;
+
+} // namespace
+
+void SampleScheduler::arm(std::chrono::milliseconds interval) {
+    const long long interval_ns = std::chrono::nanoseconds(interval).count();
+
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    itimerspec spec {};
+    spec.it_interval.tv_sec = static_cast<time_t>(interval_ns / NANOSEC_PER_SEC);
+    spec.it_interval.tv_nsec = static_cast<long>(interval_ns % NANOSEC_PER_SEC);
+    spec.it_value.tv_sec = now.tv_sec + spec.it_interval.tv_sec;
+    spec.it_value.tv_nsec = now.tv_nsec + spec.it_interval.tv_nsec;
+    if (spec.it_value.tv_nsec >= NANOSEC_PER_SEC) {
+        spec.it_value.tv_sec++;
+        spec.it_value.tv_nsec -= NANOSEC_PER_SEC;
+    }
+
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void SampleScheduler::setInterval(std::chrono::milliseconds interval) {
+    interval = clampInterval(interval);
+    interval_ms.store(interval.count(), std::memory_order_relaxed);
+    // A poll already blocked on the timer sees the new expiry without being woken
+    arm(interval);
+}
+
+bool SampleScheduler::wait() {
+    if (timer_fd < 0 || wake_fd < 0)
+        return false;
+
+    // poll skips a negative descriptor, so no event source costs nothing
+    pollfd fds[3] = {
+        {timer_fd, POLLIN, 0},
+        {wake_fd, POLLIN, 0},
+        {event_fd, POLLIN, 0},
+    };
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (poll(fds, 3, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t wakeups;
+            (void) read(wake_fd, &wakeups, sizeof(wakeups));
+            continue;
+        }
+
+        if (fds[2].revents & POLLIN)
+            event_handler();
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t expirations = 0;
+            if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                continue;
+            // More than one expiration means whole periods went by while we were busy
+            if (expirations > 1)
+                missed.fetch_add(expirations - 1, std::memory_order_relaxed);
+            return !stopping.load(std::memory_order_acquire);
+        }
+    }
+    return false;
+}
+
+bool SampleScheduler::waitUntil(std::chrono::steady_clock::time_point deadline) {
+    if (wake_fd < 0)
+        return false;
+
+    pollfd fds[2] = {
+        {wake_fd, POLLIN, 0},
+        {event_fd, POLLIN, 0},
+    };
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        const long long remaining_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining_ns <= 0)
+            return true;
+
+        // ppoll rather than poll, replayed ticks can be closer together than a millisecond
+        const timespec timeout {static_cast<time_t>(remaining_ns / NANOSEC_PER_SEC),
+                                static_cast<long>(remaining_ns % NANOSEC_PER_SEC)};
+        if (ppoll(fds, 2, &timeout, nullptr) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t wakeups;
+            (void) read(wake_fd, &wakeups, sizeof(wakeups));
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN)
+            event_handler();
+    }
+    return false;
+}
+
+void SampleScheduler::stop() {
+    stopping.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    (void) write(wake_fd, &one, sizeof(one));
+}
+
+#else
+
+void SampleScheduler::setInterval(std::chrono::milliseconds interval) {
+    interval = clampInterval(interval);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        interval_ms.store(interval.count(), std::memory_order_relaxed);
+        next_deadline = std::chrono::steady_clock::now() + interval;
+        rearmed = true;
+    }
+    wake.notify_all();
+}
+
+bool SampleScheduler::wait() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        bool woken = wake.wait_until(guard, next_deadline, [this]() {
+            return stopping.load(std::memory_order_acquire) || rearmed;
+        });
+        if (woken) {
+            // Either shutting down or the deadline moved, the loop condition sorts out which
+            rearmed = false;
+            continue;
+        }
+
+        const auto period = interval();
+        const auto now = std::chrono::steady_clock::now();
+        next_deadline += period;
+        if (now >= next_deadline) {
+            auto behind = (now - next_deadline) / period + 1;
+            missed.fetch_add(static_cast<uint64_t>(behind), std::memory_order_relaxed);
+            next_deadline += behind * period;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool SampleScheduler::waitUntil(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> guard(lock);
+    return !wake.wait_until(guard, deadline, [this]() {
+        return stopping.load(std::memory_order_acquire);
+    });
+}
+
+void SampleScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping.store(true, std::memory_order_release);
+    }
+    wake.notify_all();
+}
+
+#endif
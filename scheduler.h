@@ -0,0 +1,99 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#ifndef __linux__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * Periodic wake-ups on an absolute deadline grid.
+ * Deadlines are `start + n * interval` on the monotonic clock, so the time spent sampling never stretches the period
+ * and the loop does not drift. A period that is overrun by more than a whole interval is skipped rather than run late
+ * and counted as a missed deadline.
+ *
+ * On Linux the grid is a periodic `timerfd`, whose expiration count reports missed deadlines directly. An interval
+ * change re-arms it, which a thread already polling it picks up without being woken, and an `eventfd` wakes the
+ * waiting thread for shutdown. Elsewhere a condition variable waits until the next deadline and is notified of both.
+ *
+ * One more descriptor can be waited on alongside the grid with `setEventHandler`, its handler runs on the waiting
+ * thread between deadlines. Linux only, elsewhere the handler is never called.
+ */
+class SampleScheduler {
+public:
+    static constexpr std::chrono::milliseconds MIN_INTERVAL {1};
+    static constexpr std::chrono::milliseconds MAX_INTERVAL {10 * 1000};
+
+    explicit SampleScheduler(std::chrono::milliseconds interval);
+    ~SampleScheduler();
+
+    SampleScheduler(const SampleScheduler&) = delete;
+    SampleScheduler& operator=(const SampleScheduler&) = delete;
+
+    /**
+     * Change the period, clamped to `[MIN_INTERVAL, MAX_INTERVAL]`. Safe to call from any thread.
+     * The grid restarts one new interval from now, a waiting thread picks it up immediately.
+     */
+    void setInterval(std::chrono::milliseconds interval);
+
+    std::chrono::milliseconds interval() const;
+
+    /**
+     * Block until the next deadline.
+     * @return false once `stop` has been called.
+     */
+    bool wait();
+
+    /**
+     * Block until `deadline` instead of the next grid deadline, for sources that pace themselves. Events are handled
+     * meanwhile as in `wait`, and `stop` ends it early. The grid is left as it is.
+     * @return false once `stop` has been called.
+     */
+    bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Call `handler` from `wait` and `waitUntil` whenever `fd` becomes readable, without ending the wait. `fd` -1
+     * removes it.
+     * Not synchronized, call it from the thread that calls `wait`, or before that thread starts.
+     */
+    void setEventHandler(int fd, std::function<void()> handler);
+
+    /** Wake the waiting thread and make every later `wait` return false. */
+    void stop();
+
+    /** True once `stop` has been called. */
+    bool stopped() const;
+
+    /** Deadlines that passed without a `wait` returning for them. */
+    uint64_t missedDeadlines() const;
+
+    static std::chrono::milliseconds clampInterval(std::chrono::milliseconds interval);
+
+private:
+    std::atomic<long long> interval_ms;
+    std::atomic<uint64_t> missed;
+    std::atomic<bool> stopping;
+
+    int event_fd;
+    std::function<void()> event_handler;
+
+#ifdef __linux__
+    int timer_fd;
+    int wake_fd;
+
+    /** Restart the timer one interval from now. */
+    void arm(std::chrono::milliseconds interval);
+#else
+    std::mutex lock;
+    std::condition_variable wake;
+    std::chrono::steady_clock::time_point next_deadline;
+    bool rearmed;
+#endif
+};
+
+#endif // SCHEDULER_H
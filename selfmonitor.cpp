@@ -0,0 +1,48 @@
+#include "selfmonitor.h"
+
+#include <windows.h>
+#include <Psapi.h>
+#include <TlHelp32.h>
+
+SelfMonitor::SelfMonitor() {}
+
+bool SelfMonitor::read(SelfUsage &usage) {
+    HANDLE self = GetCurrentProcess();
+
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(self, &creation, &exit, &kernel, &user))
+        return false;
+
+    PROCESS_MEMORY_COUNTERS memory;
+    if (!GetProcessMemoryInfo(self, &memory, sizeof(memory)))
+        return false;
+
+    // Win32 has no per-process thread count short of walking a snapshot of every thread on the system
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE)
+        return false;
+
+    const DWORD pid = GetCurrentProcessId();
+    uint32_t threads = 0;
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    if (Thread32First(snapshot, &entry)) {
+        do {
+            if (entry.th32OwnerProcessID == pid)
+                threads++;
+        } while (Thread32Next(snapshot, &entry));
+    }
+    CloseHandle(snapshot);
+
+    ULARGE_INTEGER kernel_time, user_time;
+    kernel_time.LowPart = kernel.dwLowDateTime;
+    kernel_time.HighPart = kernel.dwHighDateTime;
+    user_time.LowPart = user.dwLowDateTime;
+    user_time.HighPart = user.dwHighDateTime;
+
+    // FILETIME counts 100 ns units
+    usage.cpu_time_us = (kernel_time.QuadPart + user_time.QuadPart) / 10;
+    usage.rss_bytes = memory.WorkingSetSize;
+    usage.threads = threads;
+    return true;
+}
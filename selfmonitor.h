@@ -0,0 +1,56 @@
+#ifndef SELFMONITOR_H
+#define SELFMONITOR_H
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include "procfile.h"
+#endif
+
+/** What this process costs the machine at one point in time. */
+struct SelfUsage {
+    /** User and kernel time of every thread of this process so far, in microseconds. */
+    uint64_t cpu_time_us;
+
+    /** Resident set in bytes, the working set on Win32. */
+    uint64_t rss_bytes;
+
+    /** Threads currently alive in this process. */
+    uint32_t threads;
+};
+
+/**
+ * Reads the overlay's own resource usage, so its overhead can be reported next to what it measures.
+ * The Win32 implementation lives in selfmonitor.cpp, the Linux one in selfmonitor_linux.cpp.
+ */
+class SelfMonitor {
+#ifndef _WIN32
+    /** `/proc/self/stat` has CPU time, thread count and resident pages in one line. */
+    static constexpr unsigned STAT_BUFFER_SIZE = 1024;
+
+    /** `/proc/self/stat`, opened once. */
+    ProcFile selfStat;
+
+    /** USER_HZ, units of the CPU times in `/proc/self/stat`. */
+    uint64_t clockTicks;
+
+    /** Bytes per page, units of the resident set in `/proc/self/stat`. */
+    uint64_t pageSize;
+
+    char buffer[STAT_BUFFER_SIZE];
+#endif
+
+public:
+    SelfMonitor();
+
+    SelfMonitor(const SelfMonitor&) = delete;
+    SelfMonitor& operator=(const SelfMonitor&) = delete;
+
+    /**
+     * Read the current usage into `usage`. One read of `/proc/self/stat` on Linux.
+     * @return false if it could not be read, `usage` is left untouched then.
+     */
+    bool read(SelfUsage &usage);
+};
+
+#endif // SELFMONITOR_H
@@ -0,0 +1,45 @@
+#include "selfmonitor.h"
+
+#include <cstring>
+
+#include <unistd.h>
+
+SelfMonitor::SelfMonitor() {
+    long ticks = sysconf(_SC_CLK_TCK);
+    long page = sysconf(_SC_PAGESIZE);
+    clockTicks = ticks > 0 ? static_cast<uint64_t>(ticks) : 0;
+    pageSize = page > 0 ? static_cast<uint64_t>(page) : 0;
+    buffer[0] = '\0';
+
+    selfStat.open("/proc/self/stat");
+}
+
+bool SelfMonitor::read(SelfUsage &usage) {
+    if (clockTicks == 0)
+        return false;
+
+    long read_size = selfStat.readInto(buffer, STAT_BUFFER_SIZE);
+    if (read_size <= 0)
+        return false;
+
+    const char *end = buffer + read_size;
+    // comm may contain spaces and parentheses, fields are only reliable after the last ')'
+    const char *cur = static_cast<const char*>(memrchr(buffer, ')', read_size));
+    if (cur == nullptr)
+        return false;
+
+    // utime and stime are fields 14 and 15, num_threads is 20 and rss 24
+    unsigned long long utime = 0, stime = 0, threads = 0, rss_pages = 0;
+    cur = ProcFile::skipFields(cur + 1, end, 11);
+    cur = ProcFile::parseUnsigned(cur, end, utime);
+    cur = ProcFile::parseUnsigned(cur, end, stime);
+    cur = ProcFile::skipFields(cur, end, 4);
+    cur = ProcFile::parseUnsigned(cur, end, threads);
+    cur = ProcFile::skipFields(cur, end, 3);
+    ProcFile::parseUnsigned(cur, end, rss_pages);
+
+    usage.cpu_time_us = (utime + stime) * 1000000 / clockTicks;
+    usage.rss_bytes = rss_pages * pageSize;
+    usage.threads = static_cast<uint32_t>(threads);
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Single-writer, multi-reader sequence lock holding one trivially copyable value.
+ * The writer never waits and readers never block the writer, they retry if a store overlapped their copy.
+ * The payload is kept as atomic words so a concurrent copy is well defined (and ThreadSanitizer clean)
+ * instead of relying on a racy `memcpy`.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payloads are copied word by word");
+
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    /** Odd while a store is in progress. */
+    alignas(64) std::atomic<uint64_t> sequence;
+
+    std::atomic<uint64_t> words[WORD_COUNT];
+
+public:
+    SeqLock(): sequence{0} {
+        for (auto &word : words)
+            word.store(0, std::memory_order_relaxed);
+        store(T{});
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /** Publish a new value. Must only ever be called from one thread at a time. */
+    void store(const T &value) {
+        uint64_t staged[WORD_COUNT] = {};
+        std::memcpy(staged, &value, sizeof(T));
+
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+
+        // Release on every word keeps the odd sequence ordered before the payload without a standalone fence,
+        // which ThreadSanitizer cannot model. On x86 these are plain stores anyway.
+        for (size_t i = 0; i < WORD_COUNT; i++)
+            words[i].store(staged[i], std::memory_order_release);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /** Copy out the latest complete value. Lock-free, retries only while a store overlaps the copy. */
+    T load() const {
+        uint64_t staged[WORD_COUNT];
+        uint64_t before, after;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORD_COUNT; i++)
+                staged[i] = words[i].load(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, staged, sizeof(T));
+        return value;
+    }
+
+    /** Number of completed stores, including the one made by the constructor. */
+    uint64_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,145 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <getopt.h>
+#include <signal.h>
+
+#include "framering.h"
+
+/*
+ * hw_overlay_tail: print the frames hw_overlayd publishes, one line each, like `tail -f`.
+ * Polls the ring without any syscall per frame and exits once the daemon is gone.
+ */
+
+namespace {
+
+constexpr const char *DEFAULT_RING = "/hw_overlay";
+constexpr long DEFAULT_POLL_MS = 50;
+constexpr double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+struct Options {
+    std::string ring = DEFAULT_RING;
+    long poll_ms = DEFAULT_POLL_MS;
+
+    /** Start at the oldest frame the ring still holds instead of the next one. */
+    bool from_oldest = false;
+
+    /** Exit after this many frames, 0 for no limit. */
+    unsigned long count = 0;
+};
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n, --name NAME      Shared-memory ring to read (default %s)\n"
+        "  -p, --poll-ms MS     Time between polls of the ring (default %ld)\n"
+        "  -a, --all            Start with the oldest frame still held instead of the next one\n"
+        "  -c, --count N        Exit after N frames\n"
+        "  -h, --help           Show this help\n",
+        program, DEFAULT_RING, DEFAULT_POLL_MS);
+}
+
+/** @return false if the arguments are invalid or help was asked for. */
+bool parseOptions(int argc, char *argv[], Options &options) {
+    static const option long_options[] = {
+        {"name", required_argument, nullptr, 'n'},
+        {"poll-ms", required_argument, nullptr, 'p'},
+        {"all", no_argument, nullptr, 'a'},
+        {"count", required_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "n:p:ac:h", long_options, nullptr)) != -1) {
+        char *end = nullptr;
+        switch (option) {
+        case 'n':
+            options.ring = optarg;
+            break;
+        case 'p':
+            options.poll_ms = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || options.poll_ms <= 0)
+                return false;
+            break;
+        case 'a':
+            options.from_oldest = true;
+            break;
+        case 'c':
+            options.count = std::strtoul(optarg, &end, 10);
+            if (*end != '\0')
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    if (options.ring.empty() || options.ring.find('/', 1) != std::string::npos)
+        return false;
+    if (options.ring[0] != '/')
+        options.ring.insert(0, 1, '/');
+    return optind == argc;
+}
+
+/** False once the writer closed the ring or died without closing it. */
+bool writerRunning(const FrameRingReader &reader) {
+    const int pid = reader.writerPid();
+    return pid != 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+void printFrame(const MetricFrame &frame, uint64_t skipped) {
+    std::printf("%10llu %12.1f  cpu %5.1f %%  fg %5.1f %%  gpu %5.1f %%  mem %9.1f / %9.1f MiB  "
+                "cores %u/%u max %5.1f %% #%u  missed %llu",
+                static_cast<unsigned long long>(frame.tick), frame.timestamp_ms,
+                frame.cpu_use * 100.0, frame.cpu_proc_use * 100.0, frame.gpu_proc_use * 100.0,
+                static_cast<double>(frame.mem_used) / BYTES_PER_MIB, static_cast<double>(frame.mem_total) / BYTES_PER_MIB,
+                frame.cores_above_threshold, frame.core_count, frame.core_max_use * 100.0, frame.core_max_index,
+                static_cast<unsigned long long>(frame.missed_deadlines));
+    if (skipped > 0)
+        std::printf("  (%llu skipped)", static_cast<unsigned long long>(skipped));
+    std::putchar('\n');
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    FrameRingReader reader;
+    if (!reader.open(options.ring)) {
+        std::fprintf(stderr, "Could not open %s, is hw_overlayd running with the same version?\n",
+                     options.ring.c_str());
+        return 1;
+    }
+
+    uint64_t cursor = options.from_oldest ? 0 : reader.published();
+    unsigned long printed = 0;
+    MetricFrame frame;
+    while (true) {
+        uint64_t skipped = 0;
+        while (reader.next(cursor, frame, &skipped)) {
+            printFrame(frame, skipped);
+            skipped = 0;
+            if (options.count != 0 && ++printed >= options.count)
+                return 0;
+        }
+        std::fflush(stdout);
+
+        // Checked after draining, the last frames of a daemon that just stopped are still printed
+        if (!writerRunning(reader))
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.poll_ms));
+    }
+
+    std::fprintf(stderr, "%s was closed by its writer\n", options.ring.c_str());
+    return 0;
+}
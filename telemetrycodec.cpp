@@ -0,0 +1,340 @@
+#include "telemetrycodec.h"
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+unsigned leadingZeros(uint64_t value) {
+    unsigned count = 0;
+    for (uint64_t mask = 1ull << 63; mask != 0 && (value & mask) == 0; mask >>= 1)
+        count++;
+    return count;
+}
+
+unsigned trailingZeros(uint64_t value) {
+    unsigned count = 0;
+    for (uint64_t mask = 1; mask != 0 && (value & mask) == 0; mask <<= 1)
+        count++;
+    return count;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/** Sign-extend the low `count` bits. */
+int64_t signExtend(uint64_t value, unsigned count) {
+    uint64_t sign = 1ull << (count - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+/**
+ * Delta-of-delta buckets: a prefix of ones ended by a zero selects the payload width. The last bucket has no
+ * terminating zero and stores the full 64 bits.
+ */
+struct DodBucket {
+    unsigned prefix_bits;
+    uint64_t prefix;
+    unsigned value_bits;
+};
+
+constexpr DodBucket DOD_BUCKETS[] = {
+    {2, 0b10, 7},
+    {3, 0b110, 9},
+    {4, 0b1110, 12},
+};
+
+constexpr unsigned DOD_FULL_PREFIX_BITS = 4;
+constexpr uint64_t DOD_FULL_PREFIX = 0b1111;
+
+/** `leading` value before any window was written. Real counts are capped at 31. */
+constexpr unsigned NO_WINDOW = 64;
+
+bool fitsSigned(int64_t value, unsigned bits) {
+    int64_t limit = int64_t{1} << (bits - 1);
+    return value >= -limit && value < limit;
+}
+
+std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        table[i] = crc;
+    }
+    return table;
+}
+
+} // namespace
+
+BitWriter::BitWriter(std::vector<uint8_t> &out): bytes{&out}, used_bits{0} {}
+
+void BitWriter::write(uint64_t value, unsigned count) {
+    while (count > 0) {
+        if (used_bits == 0)
+            bytes->push_back(0);
+
+        unsigned room = 8 - used_bits;
+        unsigned take = count < room ? count : room;
+        uint64_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+        bytes->back() |= static_cast<uint8_t>(chunk << (room - take));
+
+        used_bits = (used_bits + take) & 7;
+        count -= take;
+    }
+}
+
+void BitWriter::writeBit(bool bit) {
+    write(bit ? 1 : 0, 1);
+}
+
+void BitWriter::reset() {
+    bytes->clear();
+    used_bits = 0;
+}
+
+BitReader::BitReader(const uint8_t *data, size_t size): data{data}, size{size}, bit_position{0} {}
+
+uint64_t BitReader::read(unsigned count) {
+    uint64_t value = 0;
+    while (count > 0) {
+        size_t byte = bit_position >> 3;
+        unsigned offset = bit_position & 7;
+        unsigned room = 8 - offset;
+        unsigned take = count < room ? count : room;
+
+        uint64_t chunk = 0;
+        if (byte < size)
+            chunk = (data[byte] >> (room - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+
+        bit_position += take;
+        count -= take;
+    }
+    return value;
+}
+
+bool BitReader::readBit() {
+    return read(1) != 0;
+}
+
+bool BitReader::overrun() const {
+    return bit_position > size * 8;
+}
+
+void writeVarint(std::vector<uint8_t> &out, int64_t value) {
+    uint64_t encoded = zigzag(value);
+    while (encoded >= 0x80) {
+        out.push_back(static_cast<uint8_t>(encoded | 0x80));
+        encoded >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(encoded));
+}
+
+const uint8_t* readVarint(const uint8_t *cur, const uint8_t *end, int64_t &value) {
+    uint64_t encoded = 0;
+    for (unsigned shift = 0; shift < 70; shift += 7) {
+        if (cur >= end)
+            return nullptr;
+        uint8_t byte = *cur++;
+        encoded |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            value = unzigzag(encoded);
+            return cur;
+        }
+    }
+    return nullptr;
+}
+
+TimestampEncoder::TimestampEncoder(std::vector<uint8_t> &out):
+    bits{out}, previous{0}, previous_delta{0}, count{0} {}
+
+void TimestampEncoder::append(int64_t timestamp) {
+    if (count++ == 0) {
+        bits.write(static_cast<uint64_t>(timestamp), 64);
+        previous = timestamp;
+        return;
+    }
+
+    int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(timestamp) - static_cast<uint64_t>(previous));
+    int64_t dod = static_cast<int64_t>(static_cast<uint64_t>(delta) - static_cast<uint64_t>(previous_delta));
+    previous = timestamp;
+    previous_delta = delta;
+
+    if (dod == 0) {
+        bits.writeBit(false);
+        return;
+    }
+    for (const auto &bucket : DOD_BUCKETS) {
+        if (fitsSigned(dod, bucket.value_bits)) {
+            bits.write(bucket.prefix, bucket.prefix_bits);
+            bits.write(static_cast<uint64_t>(dod), bucket.value_bits);
+            return;
+        }
+    }
+    bits.write(DOD_FULL_PREFIX, DOD_FULL_PREFIX_BITS);
+    bits.write(static_cast<uint64_t>(dod), 64);
+}
+
+void TimestampEncoder::reset() {
+    bits.reset();
+    previous = 0;
+    previous_delta = 0;
+    count = 0;
+}
+
+TimestampDecoder::TimestampDecoder(const uint8_t *data, size_t size):
+    bits{data, size}, previous{0}, previous_delta{0}, count{0} {}
+
+bool TimestampDecoder::next(int64_t &timestamp) {
+    if (count++ == 0) {
+        previous = static_cast<int64_t>(bits.read(64));
+        timestamp = previous;
+        return !bits.overrun();
+    }
+
+    int64_t dod = 0;
+    if (bits.readBit()) {
+        unsigned value_bits = 64;
+        for (const auto &bucket : DOD_BUCKETS) {
+            if (!bits.readBit()) {
+                value_bits = bucket.value_bits;
+                break;
+            }
+        }
+        dod = signExtend(bits.read(value_bits), value_bits);
+    }
+
+    previous_delta = static_cast<int64_t>(static_cast<uint64_t>(previous_delta) + static_cast<uint64_t>(dod));
+    previous = static_cast<int64_t>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(previous_delta));
+    timestamp = previous;
+    return !bits.overrun();
+}
+
+GaugeEncoder::GaugeEncoder(std::vector<uint8_t> &out):
+    bits{out}, previous{0}, leading{NO_WINDOW}, trailing{0}, count{0} {}
+
+void GaugeEncoder::append(double value) {
+    uint64_t current = doubleBits(value);
+    if (count++ == 0) {
+        bits.write(current, 64);
+        previous = current;
+        return;
+    }
+
+    uint64_t difference = current ^ previous;
+    previous = current;
+    if (difference == 0) {
+        bits.writeBit(false);
+        return;
+    }
+    bits.writeBit(true);
+
+    unsigned new_leading = leadingZeros(difference);
+    unsigned new_trailing = trailingZeros(difference);
+    // 5 bits for the leading zero count
+    if (new_leading > 31)
+        new_leading = 31;
+
+    // Reuse the previous window when the meaningful bits fit inside it
+    if (leading != NO_WINDOW && new_leading >= leading && new_trailing >= trailing) {
+        bits.writeBit(false);
+        bits.write(difference >> trailing, 64 - leading - trailing);
+        return;
+    }
+
+    unsigned length = 64 - new_leading - new_trailing;
+    bits.writeBit(true);
+    bits.write(new_leading, 5);
+    bits.write(length - 1, 6);
+    bits.write(difference >> new_trailing, length);
+    leading = new_leading;
+    trailing = new_trailing;
+}
+
+void GaugeEncoder::reset() {
+    bits.reset();
+    previous = 0;
+    leading = NO_WINDOW;
+    trailing = 0;
+    count = 0;
+}
+
+GaugeDecoder::GaugeDecoder(const uint8_t *data, size_t size):
+    bits{data, size}, previous{0}, leading{NO_WINDOW}, trailing{0}, count{0} {}
+
+bool GaugeDecoder::next(double &value) {
+    if (count++ == 0) {
+        previous = bits.read(64);
+        value = bitsDouble(previous);
+        return !bits.overrun();
+    }
+
+    if (bits.readBit()) {
+        if (bits.readBit()) {
+            leading = static_cast<unsigned>(bits.read(5));
+            unsigned length = static_cast<unsigned>(bits.read(6)) + 1;
+            if (leading + length > 64)
+                return false;
+            trailing = 64 - leading - length;
+        } else if (leading == NO_WINDOW) {
+            // The window can't be reused before one was written
+            return false;
+        }
+        previous ^= bits.read(64 - leading - trailing) << trailing;
+    }
+
+    value = bitsDouble(previous);
+    return !bits.overrun();
+}
+
+CounterEncoder::CounterEncoder(std::vector<uint8_t> &out): bytes{&out}, previous{0} {}
+
+void CounterEncoder::append(uint64_t value) {
+    writeVarint(*bytes, static_cast<int64_t>(value - previous));
+    previous = value;
+}
+
+void CounterEncoder::reset() {
+    bytes->clear();
+    previous = 0;
+}
+
+CounterDecoder::CounterDecoder(const uint8_t *data, size_t size): cur{data}, end{data + size}, previous{0} {}
+
+bool CounterDecoder::next(uint64_t &value) {
+    int64_t delta;
+    cur = cur != nullptr ? readVarint(cur, end, delta) : nullptr;
+    if (cur == nullptr)
+        return false;
+    previous += static_cast<uint64_t>(delta);
+    value = previous;
+    return true;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
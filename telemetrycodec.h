@@ -0,0 +1,146 @@
+#ifndef TELEMETRYCODEC_H
+#define TELEMETRYCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Column encodings of the telemetry recorder.
+ * Timestamps are delta-of-delta encoded and doubles XOR-compressed as described for Gorilla (Pelkonen et al., 2015),
+ * both at bit granularity. Integer counters are zigzag varints of their delta, byte aligned.
+ * Every encoder writes into a caller-owned byte vector that is cleared between blocks, so steady-state encoding
+ * does not allocate.
+ */
+
+/** Appends bits MSB first. The last byte is zero padded. */
+class BitWriter {
+    std::vector<uint8_t> *bytes;
+
+    /** Bits used in the last byte, 0 means a new byte must be started. */
+    unsigned used_bits;
+
+public:
+    explicit BitWriter(std::vector<uint8_t> &out);
+
+    /** Write the low `count` bits of `value`, `count` <= 64. */
+    void write(uint64_t value, unsigned count);
+
+    void writeBit(bool bit);
+
+    /** Forget everything written, keeping the storage. */
+    void reset();
+};
+
+/** Reads what `BitWriter` wrote. Reading past the end yields zero bits and sets `overrun`. */
+class BitReader {
+    const uint8_t *data;
+    size_t size;
+    size_t bit_position;
+
+public:
+    BitReader(const uint8_t *data, size_t size);
+
+    uint64_t read(unsigned count);
+    bool readBit();
+
+    /** True once a read went past the end of the data. */
+    bool overrun() const;
+};
+
+/** Zigzag varint of `value`, at most 10 bytes. */
+void writeVarint(std::vector<uint8_t> &out, int64_t value);
+
+/** @return Position after the varint, or nullptr if it runs past `end`. */
+const uint8_t* readVarint(const uint8_t *cur, const uint8_t *end, int64_t &value);
+
+/** Delta-of-delta timestamps. The first value is stored raw, the second as a plain delta. */
+class TimestampEncoder {
+    BitWriter bits;
+    int64_t previous;
+    int64_t previous_delta;
+    size_t count;
+
+public:
+    explicit TimestampEncoder(std::vector<uint8_t> &out);
+
+    void append(int64_t timestamp);
+    void reset();
+
+    /** Worst case for one value in bits. */
+    static constexpr unsigned MAX_BITS = 4 + 64;
+};
+
+class TimestampDecoder {
+    BitReader bits;
+    int64_t previous;
+    int64_t previous_delta;
+    size_t count;
+
+public:
+    TimestampDecoder(const uint8_t *data, size_t size);
+
+    /** @return false on corrupt or truncated data. */
+    bool next(int64_t &timestamp);
+};
+
+/** XOR-compressed doubles, repeated values take one bit. */
+class GaugeEncoder {
+    BitWriter bits;
+    uint64_t previous;
+    unsigned leading;
+    unsigned trailing;
+    size_t count;
+
+public:
+    explicit GaugeEncoder(std::vector<uint8_t> &out);
+
+    void append(double value);
+    void reset();
+
+    /** Worst case for one value in bits: control bits, 5 bit leading zero count, 6 bit length, 64 bit payload. */
+    static constexpr unsigned MAX_BITS = 2 + 5 + 6 + 64;
+};
+
+class GaugeDecoder {
+    BitReader bits;
+    uint64_t previous;
+    unsigned leading;
+    unsigned trailing;
+    size_t count;
+
+public:
+    GaugeDecoder(const uint8_t *data, size_t size);
+
+    bool next(double &value);
+};
+
+/** Counters as zigzag varints of the delta to the previous value, wrapping like unsigned arithmetic. */
+class CounterEncoder {
+    std::vector<uint8_t> *bytes;
+    uint64_t previous;
+
+public:
+    explicit CounterEncoder(std::vector<uint8_t> &out);
+
+    void append(uint64_t value);
+    void reset();
+
+    static constexpr unsigned MAX_BYTES = 10;
+};
+
+class CounterDecoder {
+    const uint8_t *cur;
+    const uint8_t *end;
+    uint64_t previous;
+
+public:
+    CounterDecoder(const uint8_t *data, size_t size);
+
+    bool next(uint64_t &value);
+};
+
+/** CRC-32 (IEEE), used to validate recorder blocks. */
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+#endif // TELEMETRYCODEC_H
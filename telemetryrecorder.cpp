@@ -0,0 +1,375 @@
+#include "telemetryrecorder.h"
+
+#include <cstring>
+
+using namespace telemetry_format;
+
+namespace {
+
+void put16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8)
+        out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void put64(std::vector<uint8_t> &out, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8)
+        out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void store32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint16_t get16(const uint8_t *in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t get32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--)
+        value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t get64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+        value = (value << 8) | in[i];
+    return value;
+}
+
+size_t blockHeaderSize(size_t columns) {
+    // One length for the timestamp stream plus one per column
+    return BLOCK_HEADER_SIZE + 2 * (columns + 1);
+}
+
+/** Check magic and CRC of the block at `data`. */
+bool blockValid(const uint8_t *data) {
+    if (get32(data) != BLOCK_MAGIC)
+        return false;
+    return crc32(data + 8, BLOCK_SIZE - 8) == get32(data + 4);
+}
+
+} // namespace
+
+TelemetryRecorder::TelemetryRecorder():
+    file{nullptr},
+    gauge_count{0},
+    counter_count{0},
+    timestamp_encoder{timestamp_stream},
+    current{}
+{
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    close();
+}
+
+bool TelemetryRecorder::open(const std::string &path, const std::vector<TelemetryColumn> &column_list,
+                             int64_t origin_unix_us) {
+    close();
+
+    columns = column_list;
+    gauge_count = 0;
+    counter_count = 0;
+    for (const auto &column : columns)
+        (column.kind == TelemetryColumnKind::Gauge ? gauge_count : counter_count)++;
+
+    value_streams.assign(columns.size(), {});
+    gauge_encoders.clear();
+    counter_encoders.clear();
+    for (size_t i = 0; i < gauge_count; i++)
+        gauge_encoders.emplace_back(value_streams[i]);
+    for (size_t i = 0; i < counter_count; i++)
+        counter_encoders.emplace_back(value_streams[gauge_count + i]);
+    for (auto &stream : value_streams)
+        stream.reserve(BLOCK_SIZE);
+    timestamp_stream.reserve(BLOCK_SIZE);
+    block.reserve(BLOCK_SIZE);
+    resetBlock();
+    index.clear();
+
+    // A block must at least fit its header and one worst-case row
+    if (worstCaseSize() > BLOCK_SIZE)
+        return false;
+
+    // Append mode from the first byte: every write lands at the end, even if something else touched the file
+    std::remove(path.c_str());
+    file = std::fopen(path.c_str(), "ab");
+    if (file == nullptr)
+        return false;
+
+    std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+    put32(header, VERSION);
+    put32(header, BLOCK_SIZE);
+    put64(header, static_cast<uint64_t>(origin_unix_us));
+    put32(header, static_cast<uint32_t>(columns.size()));
+    for (const auto &column : columns) {
+        header.push_back(static_cast<uint8_t>(column.kind));
+        size_t length = column.name.size() < 255 ? column.name.size() : 255;
+        header.push_back(static_cast<uint8_t>(length));
+        header.insert(header.end(), column.name.begin(), column.name.begin() + length);
+    }
+
+    if (std::fwrite(header.data(), 1, header.size(), file) != header.size() || std::fflush(file) != 0) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TelemetryRecorder::isOpen() const {
+    return file != nullptr;
+}
+
+size_t TelemetryRecorder::worstCaseSize() const {
+    // Bit streams may need one more byte than their bits suggest since rows don't end on byte boundaries
+    size_t size = blockHeaderSize(columns.size());
+    size += timestamp_stream.size() + TimestampEncoder::MAX_BITS / 8 + 1;
+    for (size_t i = 0; i < gauge_count; i++)
+        size += value_streams[i].size() + GaugeEncoder::MAX_BITS / 8 + 1;
+    for (size_t i = 0; i < counter_count; i++)
+        size += value_streams[gauge_count + i].size() + CounterEncoder::MAX_BYTES;
+    return size;
+}
+
+bool TelemetryRecorder::append(int64_t timestamp_us, const double *gauges, const uint64_t *counters) {
+    if (file == nullptr)
+        return false;
+
+    if (worstCaseSize() > BLOCK_SIZE && !writeBlock()) {
+        close();
+        return false;
+    }
+
+    if (current.rows == 0)
+        current.first_timestamp = timestamp_us;
+    current.last_timestamp = timestamp_us;
+    current.rows++;
+
+    timestamp_encoder.append(timestamp_us);
+    for (size_t i = 0; i < gauge_count; i++)
+        gauge_encoders[i].append(gauges[i]);
+    for (size_t i = 0; i < counter_count; i++)
+        counter_encoders[i].append(counters[i]);
+    return true;
+}
+
+bool TelemetryRecorder::writeBlock() {
+    if (current.rows == 0)
+        return true;
+
+    block.clear();
+    put32(block, BLOCK_MAGIC);
+    put32(block, 0);
+    put32(block, current.rows);
+    put64(block, static_cast<uint64_t>(current.first_timestamp));
+    put64(block, static_cast<uint64_t>(current.last_timestamp));
+    put16(block, static_cast<uint16_t>(timestamp_stream.size()));
+    for (const auto &stream : value_streams)
+        put16(block, static_cast<uint16_t>(stream.size()));
+
+    block.insert(block.end(), timestamp_stream.begin(), timestamp_stream.end());
+    for (const auto &stream : value_streams)
+        block.insert(block.end(), stream.begin(), stream.end());
+    block.resize(BLOCK_SIZE, 0);
+    store32(block.data() + 4, crc32(block.data() + 8, BLOCK_SIZE - 8));
+
+    bool written = std::fwrite(block.data(), 1, BLOCK_SIZE, file) == BLOCK_SIZE && std::fflush(file) == 0;
+    if (written)
+        index.push_back(current);
+    resetBlock();
+    return written;
+}
+
+void TelemetryRecorder::resetBlock() {
+    current = TelemetryBlockInfo{};
+    timestamp_encoder.reset();
+    for (auto &encoder : gauge_encoders)
+        encoder.reset();
+    for (auto &encoder : counter_encoders)
+        encoder.reset();
+}
+
+void TelemetryRecorder::close() {
+    if (file == nullptr)
+        return;
+
+    if (writeBlock()) {
+        std::vector<uint8_t> footer;
+        footer.reserve(index.size() * INDEX_ENTRY_SIZE + 8);
+        for (const auto &info : index) {
+            put64(footer, static_cast<uint64_t>(info.first_timestamp));
+            put64(footer, static_cast<uint64_t>(info.last_timestamp));
+            put32(footer, info.rows);
+        }
+        put32(footer, static_cast<uint32_t>(index.size()));
+        put32(footer, INDEX_MAGIC);
+        std::fwrite(footer.data(), 1, footer.size(), file);
+    }
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+size_t TelemetryRecorder::blockCount() const {
+    return index.size();
+}
+
+TelemetryReader::TelemetryReader(): header_size{0}, origin{0}, recovered{false} {}
+
+bool TelemetryReader::open(const std::string &path) {
+    contents.clear();
+    columns.clear();
+    index.clear();
+    recovered = false;
+
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    uint8_t chunk[64 * 1024];
+    size_t read_size;
+    while ((read_size = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        contents.insert(contents.end(), chunk, chunk + read_size);
+    std::fclose(file);
+
+    // Fixed part of the header
+    constexpr size_t FIXED_HEADER_SIZE = sizeof(FILE_MAGIC) + 4 + 4 + 8 + 4;
+    if (contents.size() < FIXED_HEADER_SIZE || std::memcmp(contents.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+        return false;
+    const uint8_t *cur = contents.data() + sizeof(FILE_MAGIC);
+    const uint8_t *end = contents.data() + contents.size();
+    if (get32(cur) != VERSION || get32(cur + 4) != BLOCK_SIZE)
+        return false;
+    origin = static_cast<int64_t>(get64(cur + 8));
+    uint32_t column_count = get32(cur + 16);
+    cur += 20;
+
+    for (uint32_t i = 0; i < column_count; i++) {
+        if (end - cur < 2)
+            return false;
+        TelemetryColumn column;
+        column.kind = static_cast<TelemetryColumnKind>(cur[0]);
+        size_t length = cur[1];
+        cur += 2;
+        if (static_cast<size_t>(end - cur) < length)
+            return false;
+        column.name.assign(reinterpret_cast<const char*>(cur), length);
+        cur += length;
+        columns.push_back(std::move(column));
+    }
+    header_size = static_cast<size_t>(cur - contents.data());
+
+    // Trust the footer only if it sits exactly after a whole number of blocks and every entry is accounted for
+    size_t after_header = contents.size() - header_size;
+    if (after_header >= 8 && get32(end - 4) == INDEX_MAGIC) {
+        size_t blocks = get32(end - 8);
+        size_t footer_size = blocks * INDEX_ENTRY_SIZE + 8;
+        if (after_header == blocks * BLOCK_SIZE + footer_size) {
+            const uint8_t *entry = end - footer_size;
+            for (size_t i = 0; i < blocks; i++, entry += INDEX_ENTRY_SIZE)
+                index.push_back({static_cast<int64_t>(get64(entry)), static_cast<int64_t>(get64(entry + 8)),
+                                 get32(entry + 16)});
+            return true;
+        }
+    }
+
+    // No usable footer: the writer died, keep every complete and intact block
+    recovered = true;
+    for (size_t offset = header_size; offset + BLOCK_SIZE <= contents.size(); offset += BLOCK_SIZE) {
+        const uint8_t *data = contents.data() + offset;
+        if (!blockValid(data))
+            break;
+        index.push_back({static_cast<int64_t>(get64(data + 12)), static_cast<int64_t>(get64(data + 20)),
+                         get32(data + 8)});
+    }
+    return true;
+}
+
+const std::vector<TelemetryColumn>& TelemetryReader::columnList() const {
+    return columns;
+}
+
+size_t TelemetryReader::gaugeCount() const {
+    size_t count = 0;
+    for (const auto &column : columns)
+        count += column.kind == TelemetryColumnKind::Gauge ? 1 : 0;
+    return count;
+}
+
+size_t TelemetryReader::counterCount() const {
+    return columns.size() - gaugeCount();
+}
+
+int64_t TelemetryReader::originUnixUs() const {
+    return origin;
+}
+
+size_t TelemetryReader::blockCount() const {
+    return index.size();
+}
+
+const TelemetryBlockInfo& TelemetryReader::blockInfo(size_t block) const {
+    return index[block];
+}
+
+bool TelemetryReader::recoveredIndex() const {
+    return recovered;
+}
+
+bool TelemetryReader::readBlock(size_t block, Rows &rows) const {
+    if (block >= index.size())
+        return false;
+
+    const uint8_t *data = contents.data() + header_size + block * BLOCK_SIZE;
+    if (!blockValid(data))
+        return false;
+
+    const size_t gauges = gaugeCount();
+    const size_t counters = columns.size() - gauges;
+    const uint32_t row_count = get32(data + 8);
+
+    // Stream extents follow the lengths in the header
+    const uint8_t *stream = data + blockHeaderSize(columns.size());
+    const uint8_t *block_end = data + BLOCK_SIZE;
+    std::vector<std::pair<const uint8_t*, size_t>> extents;
+    for (size_t i = 0; i <= columns.size(); i++) {
+        size_t length = get16(data + BLOCK_HEADER_SIZE + 2 * i);
+        if (length > static_cast<size_t>(block_end - stream))
+            return false;
+        extents.emplace_back(stream, length);
+        stream += length;
+    }
+
+    rows.timestamps.resize(row_count);
+    rows.gauges.resize(static_cast<size_t>(row_count) * gauges);
+    rows.counters.resize(static_cast<size_t>(row_count) * counters);
+
+    TimestampDecoder timestamps(extents[0].first, extents[0].second);
+    for (uint32_t row = 0; row < row_count; row++) {
+        if (!timestamps.next(rows.timestamps[row]))
+            return false;
+    }
+    for (size_t column = 0; column < gauges; column++) {
+        GaugeDecoder decoder(extents[1 + column].first, extents[1 + column].second);
+        for (uint32_t row = 0; row < row_count; row++) {
+            if (!decoder.next(rows.gauges[row * gauges + column]))
+                return false;
+        }
+    }
+    for (size_t column = 0; column < counters; column++) {
+        CounterDecoder decoder(extents[1 + gauges + column].first, extents[1 + gauges + column].second);
+        for (uint32_t row = 0; row < row_count; row++) {
+            if (!decoder.next(rows.counters[row * counters + column]))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+#ifndef TELEMETRYRECORDER_H
+#define TELEMETRYRECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "telemetrycodec.h"
+
+/**
+ * Append-only columnar telemetry files.
+ *
+ * Layout: a file header naming the columns, then fixed-size blocks, then a block index footer written on close.
+ * Each block holds the rows of a stretch of time, one compressed stream per column (see telemetrycodec.h), and a
+ * CRC so a torn write is detected. Blocks sit at a fixed stride after the header, so when the footer is missing
+ * after a crash a reader recovers the index by scanning; only the block that was still being filled is lost.
+ * All integers in the file are little endian.
+ */
+
+enum class TelemetryColumnKind: uint8_t {
+    /** Floating point sample, XOR compressed. */
+    Gauge = 0,
+
+    /** Unsigned integer, varint of the delta. */
+    Counter = 1,
+};
+
+struct TelemetryColumn {
+    std::string name;
+    TelemetryColumnKind kind;
+};
+
+namespace telemetry_format {
+    constexpr char FILE_MAGIC[8] = {'H', 'W', 'O', 'V', 'R', 'E', 'C', '1'};
+    constexpr uint32_t BLOCK_MAGIC = 0x4B424F48;   // "HOBK"
+    constexpr uint32_t INDEX_MAGIC = 0x58494F48;   // "HOIX"
+    constexpr uint32_t VERSION = 1;
+
+    /** Bytes per block including its header. A few seconds of data at a 10 ms refresh. */
+    constexpr uint32_t BLOCK_SIZE = 4096;
+
+    /** Block header: magic, crc, row count, first and last timestamp, then a 16 bit length per column. */
+    constexpr size_t BLOCK_HEADER_SIZE = 4 + 4 + 4 + 8 + 8;
+
+    /** Per index entry: first and last timestamp, row count. */
+    constexpr size_t INDEX_ENTRY_SIZE = 8 + 8 + 4;
+}
+
+/** Summary of one block, what the footer stores. */
+struct TelemetryBlockInfo {
+    int64_t first_timestamp;
+    int64_t last_timestamp;
+    uint32_t rows;
+};
+
+/**
+ * Writes telemetry rows. Rows are encoded into the block being filled in memory and the block is written with one
+ * `fwrite` + `fflush` when it is full, so the steady-state cost of a row is encoding only.
+ * Not thread-safe, the owner serializes access.
+ */
+class TelemetryRecorder {
+    std::FILE *file;
+
+    std::vector<TelemetryColumn> columns;
+    size_t gauge_count;
+    size_t counter_count;
+
+    /** Timestamp stream of the block being filled. */
+    std::vector<uint8_t> timestamp_stream;
+    TimestampEncoder timestamp_encoder;
+
+    /**
+     * Value streams of the block being filled: the gauges, then the counters, each kind in column order.
+     * Blocks store them in the same order after the timestamps. Sized once in `open`, the encoders point into it.
+     */
+    std::vector<std::vector<uint8_t>> value_streams;
+    std::vector<GaugeEncoder> gauge_encoders;
+    std::vector<CounterEncoder> counter_encoders;
+
+    /** Row count and time span of the block being filled. */
+    TelemetryBlockInfo current;
+
+    /** Everything written so far, becomes the footer. */
+    std::vector<TelemetryBlockInfo> index;
+
+    /** Scratch for assembling one block. */
+    std::vector<uint8_t> block;
+
+    /** Encoded bytes of the block being filled if a row of the worst-case size was added. */
+    size_t worstCaseSize() const;
+
+    bool writeBlock();
+    void resetBlock();
+
+public:
+    TelemetryRecorder();
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder&) = delete;
+    TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+
+    /**
+     * Replace `path` with a new file opened for appending and write the header.
+     * @param origin_unix_us Wall-clock time that timestamp 0 corresponds to, stored for readers.
+     */
+    bool open(const std::string &path, const std::vector<TelemetryColumn> &columns, int64_t origin_unix_us);
+
+    bool isOpen() const;
+
+    /**
+     * Record one row. `gauges` and `counters` hold one value per column of that kind, in column order.
+     * @return false if a full block could not be written, the file is closed in that case.
+     */
+    bool append(int64_t timestamp_us, const double *gauges, const uint64_t *counters);
+
+    /** Write the partial block and the index footer. */
+    void close();
+
+    /** Blocks written to disk so far. */
+    size_t blockCount() const;
+};
+
+/** Reads files written by `TelemetryRecorder`, also ones that lost their footer to a crash. */
+class TelemetryReader {
+    std::vector<uint8_t> contents;
+    std::vector<TelemetryColumn> columns;
+    std::vector<TelemetryBlockInfo> index;
+    size_t header_size;
+    int64_t origin;
+    bool recovered;
+
+public:
+    /** Decoded rows of one block, row-major per kind. */
+    struct Rows {
+        std::vector<int64_t> timestamps;
+        std::vector<double> gauges;
+        std::vector<uint64_t> counters;
+    };
+
+    TelemetryReader();
+
+    bool open(const std::string &path);
+
+    const std::vector<TelemetryColumn>& columnList() const;
+    size_t gaugeCount() const;
+    size_t counterCount() const;
+    int64_t originUnixUs() const;
+
+    size_t blockCount() const;
+    const TelemetryBlockInfo& blockInfo(size_t block) const;
+
+    /** True if the footer was missing or damaged and the index was rebuilt by scanning the blocks. */
+    bool recoveredIndex() const;
+
+    /** Decode every row of `block` into `rows`, replacing its contents. */
+    bool readBlock(size_t block, Rows &rows) const;
+};
+
+#endif // TELEMETRYRECORDER_H
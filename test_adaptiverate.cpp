@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "adaptiverate.h"
+
+namespace {
+
+constexpr double THRESHOLD = 0.9;
+
+RateSignal flat(double cpu_use) {
+    return RateSignal{cpu_use, cpu_use / 4, 0.0, 0.4, cpu_use};
+}
+
+/** Ticks until the interval stops growing, feeding the same signal at whatever interval was picked. */
+int ticksToSettle(AdaptiveRate &rate, const RateSignal &signal) {
+    int ticks = 0;
+    auto previous = rate.interval();
+    for (; ticks < 1000; ticks++) {
+        auto next = rate.next(signal, static_cast<double>(previous.count()), THRESHOLD);
+        if (next == previous && next == rate.config().slowest)
+            break;
+        previous = next;
+    }
+    return ticks;
+}
+
+/**
+ * A day of mostly idle machine with a busy spell now and then, measured the way the counters would: the average over
+ * the interval plus a little read noise that shrinks with longer intervals.
+ */
+class SimulatedDay {
+    struct Burst {
+        double start_ms;
+        double end_ms;
+        double level;
+    };
+
+    std::vector<Burst> bursts;
+    uint32_t noise_state = 12345;
+
+    static constexpr double IDLE = 0.03;
+
+    double noise(double interval_ms) {
+        noise_state = noise_state * 1664525u + 1013904223u;
+        const double unit = static_cast<double>(noise_state >> 8) / static_cast<double>(1u << 24) - 0.5;
+        return unit * 0.02 * std::sqrt(250.0 / interval_ms);
+    }
+
+public:
+    static constexpr double DAY_MS = 24.0 * 3600 * 1000;
+
+    SimulatedDay() {
+        // Ten seconds of work every ten minutes, at levels that vary from burst to burst
+        for (double start = 60 * 1000; start < DAY_MS; start += 10 * 60 * 1000) {
+            const double level = 0.3 + 0.05 * static_cast<double>(bursts.size() % 8);
+            bursts.push_back({start, start + 10 * 1000, level});
+        }
+    }
+
+    const std::vector<Burst>& spells() const {
+        return bursts;
+    }
+
+    /** Average utilization over `(from_ms, to_ms]`. */
+    double measure(double from_ms, double to_ms) {
+        double busy = IDLE * (to_ms - from_ms);
+        for (const Burst &burst : bursts) {
+            const double overlap = std::min(to_ms, burst.end_ms) - std::max(from_ms, burst.start_ms);
+            if (overlap > 0)
+                busy += (burst.level - IDLE) * overlap;
+        }
+        return std::clamp(busy / (to_ms - from_ms) + noise(to_ms - from_ms), 0.0, 1.0);
+    }
+};
+
+} // namespace
+
+TEST(ADAPTIVE_RATE, FlatSignalBacksOffToSlowest) {
+    AdaptiveRate rate;
+    EXPECT_EQ(rate.interval(), rate.config().fastest);
+
+    const int ticks = ticksToSettle(rate, flat(0.1));
+    EXPECT_EQ(rate.interval(), rate.config().slowest);
+    EXPECT_FALSE(rate.active());
+    // The hold, then growth by `backoff` per tick
+    EXPECT_LT(ticks, static_cast<int>(rate.config().hold_ticks) + 15);
+}
+
+TEST(ADAPTIVE_RATE, ChangeReturnsToFastestAndHolds) {
+    AdaptiveRate rate;
+    ticksToSettle(rate, flat(0.1));
+
+    const double slowest_ms = static_cast<double>(rate.config().slowest.count());
+    EXPECT_EQ(rate.next(flat(0.5), slowest_ms, THRESHOLD), rate.config().fastest);
+    EXPECT_TRUE(rate.active());
+
+    // Stays fast while the level catches up and for the hold after it
+    const double fastest_ms = static_cast<double>(rate.config().fastest.count());
+    for (unsigned tick = 0; tick < rate.config().hold_ticks; tick++)
+        EXPECT_EQ(rate.next(flat(0.5), fastest_ms, THRESHOLD), rate.config().fastest) << tick;
+
+    // Then backs off again, on the new level
+    EXPECT_GT(ticksToSettle(rate, flat(0.5)), 0);
+    EXPECT_EQ(rate.interval(), rate.config().slowest);
+}
+
+TEST(ADAPTIVE_RATE, NearThresholdStaysFast) {
+    AdaptiveRate rate;
+    RateSignal hot = flat(0.2);
+    hot.core_max_use = THRESHOLD - rate.config().margin / 2;
+
+    const double fastest_ms = static_cast<double>(rate.config().fastest.count());
+    for (int tick = 0; tick < 100; tick++)
+        EXPECT_EQ(rate.next(hot, fastest_ms, THRESHOLD), rate.config().fastest);
+    EXPECT_TRUE(rate.active());
+
+    // Once the busiest core cools down it backs off
+    EXPECT_GT(ticksToSettle(rate, flat(0.2)), 0);
+    EXPECT_EQ(rate.interval(), rate.config().slowest);
+}
+
+TEST(ADAPTIVE_RATE, ShortIntervalNoiseIsNotAChange) {
+    AdaptiveRate::Config config;
+    config.slowest = config.fastest;
+    AdaptiveRate rate(config);
+
+    // One jiffy on eight cores either way over 50 ms, about 2.5 %
+    const double fastest_ms = static_cast<double>(config.fastest.count());
+    for (unsigned tick = 0; tick <= config.hold_ticks; tick++)
+        rate.next(flat(tick % 2 == 0 ? 0.1 : 0.125), fastest_ms, THRESHOLD);
+    for (int tick = 0; tick < 100; tick++) {
+        rate.next(flat(tick % 2 == 0 ? 0.1 : 0.125), fastest_ms, THRESHOLD);
+        EXPECT_FALSE(rate.active()) << tick;
+    }
+}
+
+TEST(ADAPTIVE_RATE, LongIntervalCatchesShortBurst) {
+    AdaptiveRate rate;
+    ticksToSettle(rate, flat(0.05));
+
+    // Half a second of one extra busy core out of eight, averaged over the slowest interval
+    const double slowest_ms = static_cast<double>(rate.config().slowest.count());
+    const double burst = 0.05 + 500.0 / slowest_ms / 8;
+    EXPECT_EQ(rate.next(flat(burst), slowest_ms, THRESHOLD), rate.config().fastest);
+}
+
+TEST(ADAPTIVE_RATE, DayTakesAnOrderOfMagnitudeFewerSamples) {
+    AdaptiveRate rate;
+    SimulatedDay day;
+
+    uint64_t samples = 0;
+    double now_ms = 0.0;
+    double previous_ms = -250.0;
+    // Time of the first fast tick at or after each burst's start
+    std::vector<double> detected(day.spells().size(), -1.0);
+    size_t burst = 0;
+
+    while (now_ms < SimulatedDay::DAY_MS) {
+        const double use = day.measure(previous_ms, now_ms);
+        const auto interval = rate.next(flat(use), now_ms - previous_ms, THRESHOLD);
+        samples++;
+
+        while (burst < day.spells().size() && day.spells()[burst].end_ms < now_ms)
+            burst++;
+        if (burst < day.spells().size() && now_ms >= day.spells()[burst].start_ms && detected[burst] < 0 &&
+            interval == rate.config().fastest)
+            detected[burst] = now_ms;
+
+        previous_ms = now_ms;
+        now_ms += static_cast<double>(interval.count());
+    }
+
+    const uint64_t fixed_samples = static_cast<uint64_t>(SimulatedDay::DAY_MS / 250.0);
+    EXPECT_LT(samples * 10, fixed_samples) << "adaptive samples per day: " << samples;
+
+    // Every busy spell is picked up by the first slow tick that covers a good part of it, two intervals at worst
+    const double slowest_ms = static_cast<double>(rate.config().slowest.count());
+    for (size_t i = 0; i < detected.size(); i++) {
+        ASSERT_GE(detected[i], 0.0) << i;
+        EXPECT_LE(detected[i] - day.spells()[i].start_ms, 2 * slowest_ms) << i;
+    }
+}
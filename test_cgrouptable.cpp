@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "cgrouptable.h"
+#include "testfixture.h"
+
+// A throwaway cgroup2 lookalike: directories for groups with cpu.stat, memory.current and friends in them
+class CGROUP_TABLE: public ::testing::Test {
+protected:
+    static constexpr unsigned long long SECOND_US = 1000 * 1000;
+    static constexpr unsigned long long MIB = 1024 * 1024;
+
+    FixtureDir fixture {"test_cgrouptable"};
+    std::string root;
+
+    void SetUp() override {
+        root = fixture.path();
+        ASSERT_FALSE(root.empty());
+        writeFile("", "cgroup.controllers", "cpuset cpu io memory pids\n");
+    }
+
+    void makeGroup(const std::string &path) {
+        ASSERT_TRUE(makeDirs(root + "/" + path));
+    }
+
+    void removeGroup(const std::string &path) {
+        ASSERT_TRUE(removeTree(root + "/" + path));
+    }
+
+    void writeFile(const std::string &group, const char *file, const std::string &text) {
+        // Rewritten in place, a descriptor kept open on the file sees the new contents like it would in cgroupfs
+        ASSERT_TRUE(rewriteFile(root + "/" + (group.empty() ? "" : group + "/") + file, text, 512));
+    }
+
+    /** A group with the files every refresh reads. */
+    void writeUsage(const std::string &group, unsigned long long usage_usec, unsigned long long memory,
+                    unsigned long long throttled_usec = 0) {
+        makeGroup(group);
+        writeFile(group, "cpu.stat",
+                  "usage_usec " + std::to_string(usage_usec) + "\n" +
+                  "user_usec " + std::to_string(usage_usec / 2) + "\n" +
+                  "system_usec " + std::to_string(usage_usec / 2) + "\n" +
+                  "nr_periods 10\nnr_throttled 0\n"
+                  "throttled_usec " + std::to_string(throttled_usec) + "\n");
+        writeFile(group, "memory.current", std::to_string(memory) + "\n");
+    }
+
+    static const CgroupInfo* find(const CgroupTable &table, const char *path) {
+        for (const CgroupInfo &info : table.reported()) {
+            if (std::strcmp(info.path, path) == 0)
+                return &info;
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(CGROUP_TABLE, MissingRootIsNotAnError) {
+    CgroupTable table((root + "/missing").c_str());
+    EXPECT_FALSE(table.isOpen());
+    EXPECT_FALSE(table.refresh(1.0));
+    EXPECT_TRUE(table.reported().empty());
+}
+
+TEST_F(CGROUP_TABLE, RanksLeavesByCpuAndMemory) {
+    writeUsage("system.slice/a.service", 0, 100 * MIB);
+    writeUsage("system.slice/b.service", 0, 300 * MIB);
+    writeUsage("system.slice/c.service", 0, 200 * MIB);
+    writeUsage("user.slice/user-1000.slice", 0, 50 * MIB);
+    // Parents add up their children and are not ranked
+    writeUsage("system.slice", 0, 600 * MIB);
+
+    CgroupTable table(root.c_str(), 2);
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_EQ(table.groupCount(), 7u);
+
+    // a: one full core, c: a quarter, b idle but the largest
+    writeUsage("system.slice/a.service", SECOND_US, 100 * MIB);
+    writeUsage("system.slice/c.service", SECOND_US / 4, 200 * MIB);
+    ASSERT_TRUE(table.refresh(1.0));
+
+    const auto &reported = table.reported();
+    ASSERT_EQ(reported.size(), 3u);
+    EXPECT_STREQ(reported[0].path, "system.slice/a.service");
+    EXPECT_NEAR(reported[0].cpu_use, 1.0f, 1e-6f);
+    EXPECT_STREQ(reported[1].path, "system.slice/c.service");
+    EXPECT_NEAR(reported[1].cpu_use, 0.25f, 1e-6f);
+    // Top by memory is b then c, c is already in the list
+    EXPECT_STREQ(reported[2].path, "system.slice/b.service");
+    EXPECT_EQ(reported[2].memory_bytes, 300 * MIB);
+    EXPECT_FALSE(reported[2].selected);
+    EXPECT_EQ(find(table, "system.slice"), nullptr);
+}
+
+TEST_F(CGROUP_TABLE, SelectedGroupsComeFirstWithLimits) {
+    writeUsage("system.slice", 0, 512 * MIB, 0);
+    writeFile("system.slice", "memory.max", std::to_string(1024 * MIB) + "\n");
+    writeFile("system.slice", "cpu.max", "150000 100000\n");
+    writeUsage("system.slice/db.service", 0, 512 * MIB);
+    writeFile("system.slice/db.service", "memory.max", "max\n");
+    writeFile("system.slice/db.service", "cpu.max", "max 100000\n");
+
+    CgroupTable table(root.c_str(), 1);
+    table.select({"/system.slice/", "does/not/exist"});
+    table.refresh(0.0);
+
+    writeUsage("system.slice", SECOND_US, 512 * MIB, SECOND_US / 10);
+    table.refresh(1.0);
+
+    const auto &reported = table.reported();
+    ASSERT_EQ(reported.size(), 2u);
+    EXPECT_STREQ(reported[0].path, "system.slice");
+    EXPECT_TRUE(reported[0].selected);
+    EXPECT_NEAR(reported[0].cpu_use, 1.0f, 1e-6f);
+    EXPECT_NEAR(reported[0].cpu_limit, 1.5f, 1e-6f);
+    EXPECT_NEAR(reported[0].cpu_throttled, 0.1f, 1e-6f);
+    EXPECT_EQ(reported[0].memory_bytes, 512 * MIB);
+    EXPECT_EQ(reported[0].memory_max, 1024 * MIB);
+
+    EXPECT_STREQ(reported[1].path, "system.slice/db.service");
+    EXPECT_EQ(reported[1].memory_max, 0u);
+    EXPECT_EQ(reported[1].cpu_limit, 0.0f);
+
+    // The root can be selected as well
+    writeUsage("", 0, 0);
+    table.select({"/"});
+    table.refresh(1.0);
+    ASSERT_FALSE(table.reported().empty());
+    EXPECT_STREQ(table.reported()[0].path, "/");
+    EXPECT_TRUE(table.reported()[0].selected);
+}
+
+TEST_F(CGROUP_TABLE, MemoryBreakdownAndIoRates) {
+    writeUsage("app.slice/web.scope", 0, 64 * MIB);
+    writeFile("app.slice/web.scope", "memory.stat",
+              "anon 41943040\nfile 20971520\nkernel 1048576\nkernel_stack 65536\nsock 0\nshmem 0\n"
+              "file_mapped 1048576\nanon_thp 0\n");
+    writeFile("app.slice/web.scope", "io.stat",
+              "8:0 rbytes=1000 wbytes=2000 rios=10 wios=20 dbytes=0 dios=0\n"
+              "259:0 rbytes=3000 wbytes=0 rios=3 wios=0 dbytes=0 dios=0\n");
+
+    CgroupTable table(root.c_str());
+    table.refresh(0.0);
+    const CgroupInfo *info = find(table, "app.slice/web.scope");
+    ASSERT_NE(info, nullptr);
+    EXPECT_EQ(info->anon_bytes, 41943040u);
+    EXPECT_EQ(info->file_bytes, 20971520u);
+    EXPECT_EQ(info->io_read_rate, 0.0);
+
+    writeFile("app.slice/web.scope", "io.stat",
+              "8:0 rbytes=5000 wbytes=2000 rios=14 wios=20 dbytes=0 dios=0\n"
+              "259:0 rbytes=3000 wbytes=8000 rios=3 wios=8 dbytes=0 dios=0\n");
+    table.refresh(2.0);
+    info = find(table, "app.slice/web.scope");
+    ASSERT_NE(info, nullptr);
+    EXPECT_DOUBLE_EQ(info->io_read_rate, 2000.0);
+    EXPECT_DOUBLE_EQ(info->io_write_rate, 4000.0);
+}
+
+TEST_F(CGROUP_TABLE, NewGroupsWaitForTheRescan) {
+    writeUsage("a.scope", 0, MIB);
+
+    CgroupTable table(root.c_str());
+    table.refresh(0.0);
+    EXPECT_EQ(table.scanCount(), 1u);
+
+    writeUsage("b.scope", 0, 2 * MIB);
+    for (int tick = 0; tick < 10; tick++)
+        table.refresh(0.25);
+    EXPECT_EQ(table.scanCount(), 1u);
+    EXPECT_EQ(find(table, "b.scope"), nullptr);
+
+    // The known group keeps its baseline across the rescan
+    writeUsage("a.scope", SECOND_US * 5 / 2, MIB);
+    table.refresh(CgroupTable::RESCAN_INTERVAL_SECONDS);
+    EXPECT_EQ(table.scanCount(), 2u);
+    ASSERT_NE(find(table, "b.scope"), nullptr);
+    ASSERT_NE(find(table, "a.scope"), nullptr);
+    EXPECT_NEAR(find(table, "a.scope")->cpu_use, 0.5f, 1e-6f);
+
+    removeGroup("b.scope");
+    table.refresh(CgroupTable::RESCAN_INTERVAL_SECONDS);
+    EXPECT_EQ(find(table, "b.scope"), nullptr);
+}
+
+TEST_F(CGROUP_TABLE, RecreatedGroupStartsFresh) {
+    writeUsage("job.scope", SECOND_US, MIB);
+
+    CgroupTable table(root.c_str());
+    table.refresh(0.0);
+
+    // Same path, another directory: its counters restart and must not be taken against the old ones. The old one is
+    // moved aside rather than removed, so the new directory cannot get its inode back like on a disk filesystem
+    std::rename((root + "/job.scope").c_str(), (root + "/retired.scope").c_str());
+    writeUsage("job.scope", 100 * SECOND_US, MIB);
+    table.refresh(CgroupTable::RESCAN_INTERVAL_SECONDS);
+    ASSERT_NE(find(table, "job.scope"), nullptr);
+    EXPECT_EQ(find(table, "job.scope")->cpu_use, 0.0f);
+
+    writeUsage("job.scope", 100 * SECOND_US + SECOND_US / 2, MIB);
+    table.refresh(1.0);
+    EXPECT_NEAR(find(table, "job.scope")->cpu_use, 0.5f, 1e-6f);
+}
+
+TEST_F(CGROUP_TABLE, HybridLayoutUsesUnified) {
+    std::remove((root + "/cgroup.controllers").c_str());
+    makeGroup("memory");
+    makeGroup("unified");
+    writeFile("unified", "cgroup.controllers", "\n");
+    writeUsage("unified/init.scope", 0, 3 * MIB);
+
+    CgroupTable table(root.c_str());
+    table.refresh(0.0);
+    ASSERT_EQ(table.reported().size(), 1u);
+    EXPECT_STREQ(table.reported()[0].path, "init.scope");
+}
+
+TEST_F(CGROUP_TABLE, ParsesLimits) {
+    const char unlimited[] = "max\n";
+    const char limited[] = "1073741824\n";
+    EXPECT_EQ(CgroupTable::parseLimit(unlimited, unlimited + sizeof(unlimited) - 1), 0u);
+    EXPECT_EQ(CgroupTable::parseLimit(limited, limited + sizeof(limited) - 1), 1073741824u);
+}
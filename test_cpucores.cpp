@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cpucores.h"
+
+// Builds a /proc/stat lookalike. Every core gets the same counters scaled by `tick` plus `busy_extra` user ticks
+// on `hot_core`, followed by the lines that come after the cpu block on a real system.
+static std::string synthetic_stat(unsigned cores, unsigned long long tick, unsigned hot_core = 0,
+                                  unsigned long long busy_extra = 0) {
+    std::string text = "cpu  " + std::to_string(tick * cores) + " 0 0 " + std::to_string(tick * cores) +
+        " 0 0 0 0 0 0\n";
+    for (unsigned i = 0; i < cores; i++) {
+        unsigned long long user = tick + (i == hot_core ? busy_extra : 0);
+        unsigned long long idle = tick * 3 - (i == hot_core ? busy_extra : 0);
+        text += "cpu" + std::to_string(i) + " " + std::to_string(user) + " 0 " + std::to_string(tick) + " " +
+            std::to_string(idle) + " 0 0 0 0 0 0\n";
+    }
+    text += "intr 12345 0 0 0\nctxt 999\n";
+    return text;
+}
+
+TEST(CPU_CORES, RejectsUnexpectedText) {
+    CpuCoreStats stats;
+    std::string text = "intr 1 2 3\n";
+    EXPECT_FALSE(stats.parse(text.data(), text.size()));
+}
+
+TEST(CPU_CORES, FirstParseHasNoRatios) {
+    CpuCoreStats stats;
+    std::string text = synthetic_stat(4, 100);
+
+    ASSERT_TRUE(stats.parse(text.data(), text.size()));
+    EXPECT_EQ(stats.coreCount(), 4u);
+    EXPECT_FLOAT_EQ(stats.busy()[0], 0.0f);
+    EXPECT_EQ(stats.aggregateBusyTicks(), 400u);
+}
+
+TEST(CPU_CORES, RatiosFromDeltas) {
+    CpuCoreStats stats;
+    std::string before = synthetic_stat(8, 100);
+    std::string after = synthetic_stat(8, 200);
+
+    ASSERT_TRUE(stats.parse(before.data(), before.size()));
+    ASSERT_TRUE(stats.parse(after.data(), after.size()));
+
+    // Per core: +100 user, +100 system, +300 idle
+    for (size_t i = 0; i < stats.coreCount(); i++) {
+        EXPECT_FLOAT_EQ(stats.user()[i], 0.2f);
+        EXPECT_FLOAT_EQ(stats.system()[i], 0.2f);
+        EXPECT_FLOAT_EQ(stats.idle()[i], 0.6f);
+        EXPECT_FLOAT_EQ(stats.iowait()[i], 0.0f);
+        EXPECT_FLOAT_EQ(stats.busy()[i], 0.4f);
+    }
+}
+
+TEST(CPU_CORES, FindsSaturatedCore) {
+    CpuCoreStats stats;
+    std::string before = synthetic_stat(256, 1000, 77, 0);
+    std::string after = synthetic_stat(256, 1100, 77, 300);
+
+    ASSERT_TRUE(stats.parse(before.data(), before.size()));
+    ASSERT_TRUE(stats.parse(after.data(), after.size()));
+
+    EXPECT_EQ(stats.coreCount(), 256u);
+    EXPECT_EQ(stats.maxBusyCore(), 77u);
+    EXPECT_FLOAT_EQ(stats.maxBusy(), 1.0f);
+    EXPECT_EQ(stats.coresAbove(0.9f), 1u);
+    EXPECT_EQ(stats.coresAbove(0.4f), 256u);
+}
+
+TEST(CPU_CORES, CountersWrapAround) {
+    CpuCoreStats stats;
+    // The low 32 bits of user wrap between the two samples
+    std::string before = "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 4294967290 0 0 100 0 0 0 0 0 0\n";
+    std::string after = "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 4294967306 0 0 116 0 0 0 0 0 0\n";
+
+    ASSERT_TRUE(stats.parse(before.data(), before.size()));
+    ASSERT_TRUE(stats.parse(after.data(), after.size()));
+
+    EXPECT_FLOAT_EQ(stats.user()[0], 0.5f);
+    EXPECT_FLOAT_EQ(stats.idle()[0], 0.5f);
+}
+
+TEST(CPU_CORES, OfflineCoreReadsIdle) {
+    CpuCoreStats stats;
+    std::string before = "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 10 0 0 10 0 0 0 0 0 0\ncpu1 10 0 0 10 0 0 0 0 0 0\n";
+    std::string after = "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 20 0 0 20 0 0 0 0 0 0\n";
+
+    ASSERT_TRUE(stats.parse(before.data(), before.size()));
+    ASSERT_TRUE(stats.parse(after.data(), after.size()));
+
+    EXPECT_EQ(stats.coreCount(), 2u);
+    EXPECT_FLOAT_EQ(stats.busy()[0], 0.5f);
+    EXPECT_FLOAT_EQ(stats.busy()[1], 0.0f);
+}
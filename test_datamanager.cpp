@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <QCoreApplication>
+
+#include "datamanager.h"
+#include "replaysource.h"
+
+using namespace std::chrono_literals;
+using std::chrono::steady_clock;
+
+// DataManager queues its deliveries to the GUI thread, which needs an application object to exist
+class DATA_MANAGER: public ::testing::Test {
+protected:
+    static std::unique_ptr<QCoreApplication> app;
+
+    static void SetUpTestSuite() {
+        static int argc = 1;
+        static char name[] = "test_datamanager";
+        static char *argv[] = {name, nullptr};
+        if (QCoreApplication::instance() == nullptr)
+            app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+
+    static std::unique_ptr<SampleSource> flatOut() {
+        return std::make_unique<SyntheticSampleSource>(
+            SyntheticPattern::Spikes, 64, std::chrono::milliseconds(10), 0, ReplaySpeed::AsFastAsPossible);
+    }
+
+    /** Process GUI events for about `duration`. */
+    static void pumpFor(std::chrono::milliseconds duration) {
+        const auto end = steady_clock::now() + duration;
+        while (steady_clock::now() < end)
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+    }
+};
+
+std::unique_ptr<QCoreApplication> DATA_MANAGER::app;
+
+TEST_F(DATA_MANAGER, ShutsDownCleanlyUnderLoad) {
+    for (int round = 0; round < 20; round++) {
+        // The update thread ticks back to back, and GUI deliveries are still waiting when the manager goes
+        auto manager = std::make_unique<DataManager>(nullptr, flatOut());
+        pumpFor(std::chrono::milliseconds(round % 4));
+
+        const auto start = steady_clock::now();
+        manager.reset();
+        EXPECT_LT(steady_clock::now() - start, 1s) << round;
+
+        // Deliveries queued for the destroyed manager are dropped, not run
+        QCoreApplication::processEvents();
+    }
+}
+
+TEST_F(DATA_MANAGER, ShutsDownDuringLongWait) {
+    DataManager *manager = new DataManager(nullptr);
+    manager->setRefreshIntervalMs(10 * 1000);
+    pumpFor(20ms);
+
+    // The update thread is parked on a 10 s deadline, stopping must not wait for it
+    const auto start = steady_clock::now();
+    delete manager;
+    EXPECT_LT(steady_clock::now() - start, 1s);
+}
+
+TEST_F(DATA_MANAGER, ShutsDownDuringPacedReplay) {
+    DataManager *manager = new DataManager(nullptr, std::make_unique<SyntheticSampleSource>(
+        SyntheticPattern::Ramp, 4, std::chrono::seconds(10), 0, ReplaySpeed::Realtime));
+    pumpFor(20ms);
+
+    // The replay is holding its second tick back for 10 s, stopping must not wait for it
+    const auto start = steady_clock::now();
+    delete manager;
+    EXPECT_LT(steady_clock::now() - start, 1s);
+}
+
+TEST_F(DATA_MANAGER, BusyUiGetsOneFrameNotABacklog) {
+    DataManager manager(nullptr, flatOut());
+    pumpFor(10ms);
+
+    int deliveries = 0;
+    QObject receiver;
+    QObject::connect(&manager, &DataManager::frameReady, &receiver, [&]() {
+        deliveries++;
+    });
+
+    // The GUI thread is stuck while the update thread publishes frame after frame
+    const uint64_t first_tick = manager.snapshot().tick;
+    const quint64 coalesced = manager.CoalescedFrames();
+    std::this_thread::sleep_for(100ms);
+    ASSERT_GT(manager.snapshot().tick, first_tick + 10);
+
+    QCoreApplication::processEvents();
+    EXPECT_LE(deliveries, 2);
+    EXPECT_GT(manager.CoalescedFrames(), coalesced);
+
+    // What was delivered is a recent frame, not the one from before the stall
+    EXPECT_GT(manager.SampleTimeMs(), 0.0);
+    EXPECT_GE(manager.MemUsedHistory()->Count(), 1);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include "decimator.h"
+
+// Stand-in for a graph series, mirrored only through the deltas like HistorySeries does.
+class MirroredSeries {
+public:
+    std::deque<SeriesPoint> points;
+
+    void apply(const MinMaxDecimator::Delta &delta) {
+        ASSERT_LE(delta.removed_front + delta.removed_back, points.size());
+        points.erase(points.begin(), points.begin() + delta.removed_front);
+        points.erase(points.end() - delta.removed_back, points.end());
+        for (unsigned i = 0; i < delta.appended_count; i++)
+            points.push_back(delta.appended[i]);
+    }
+};
+
+static std::vector<SeriesPoint> collect(const MinMaxDecimator &decimator) {
+    std::vector<SeriesPoint> out;
+    decimator.forEachPoint([&out](const SeriesPoint &point) { out.push_back(point); });
+    return out;
+}
+
+TEST(DECIMATION, SparseSamplesPassThrough) {
+    // 250 ms refresh into 300 buckets of 200 ms: never more than one sample per bucket
+    MinMaxDecimator decimator(60000, 300);
+    MirroredSeries series;
+
+    for (int i = 0; i < 100; i++)
+        series.apply(decimator.append(i * 250.0, i % 7));
+
+    ASSERT_EQ(series.points.size(), 100u);
+    EXPECT_EQ(decimator.size(), 100u);
+    EXPECT_DOUBLE_EQ(series.points[42].x, 42 * 250.0);
+    EXPECT_DOUBLE_EQ(series.points[42].y, 42 % 7);
+}
+
+TEST(DECIMATION, OutputBoundedByBucketCount) {
+    constexpr unsigned buckets = 300;
+    MinMaxDecimator decimator(60000, buckets);
+    MirroredSeries series;
+
+    // 1 ms refresh for two full windows
+    for (int i = 0; i < 120000; i++) {
+        series.apply(decimator.append(i * 1.0, (i * 37) % 101));
+        ASSERT_LE(decimator.size(), 2u * (buckets + 2));
+    }
+    EXPECT_EQ(series.points.size(), decimator.size());
+    EXPECT_GT(series.points.size(), buckets);
+}
+
+TEST(DECIMATION, SingleSampleSpikeSurvives) {
+    MinMaxDecimator decimator(60000, 300);
+    MirroredSeries series;
+
+    for (int i = 0; i < 60000; i++) {
+        double value = (i == 31337) ? 100.0 : 5.0;
+        series.apply(decimator.append(i * 1.0, value));
+    }
+
+    bool found_spike = false;
+    for (const auto &point : series.points) {
+        if (point.y == 100.0 && point.x == 31337.0)
+            found_spike = true;
+    }
+    EXPECT_TRUE(found_spike);
+}
+
+TEST(DECIMATION, DeltasMatchFullOutput) {
+    MinMaxDecimator decimator(1000, 20);
+    MirroredSeries series;
+
+    for (int i = 0; i < 5000; i++) {
+        double value = (i * 7919) % 53;
+        series.apply(decimator.append(i * 3.0, value));
+    }
+
+    auto expected = collect(decimator);
+    ASSERT_EQ(series.points.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_DOUBLE_EQ(series.points[i].x, expected[i].x);
+        EXPECT_DOUBLE_EQ(series.points[i].y, expected[i].y);
+    }
+}
+
+TEST(DECIMATION, PointsStayInTimeOrder) {
+    MinMaxDecimator decimator(1000, 10);
+
+    for (int i = 0; i < 3000; i++)
+        decimator.append(i * 1.0, (i % 2) ? -i : i);
+
+    auto points = collect(decimator);
+    for (size_t i = 1; i < points.size(); i++)
+        EXPECT_LE(points[i - 1].x, points[i].x);
+    // Oldest point is at most one bucket beyond the window
+    EXPECT_GE(points.front().x, 2999.0 - 1000.0 - 2 * 100.0);
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "diskio.h"
+#include "testfixture.h"
+
+namespace {
+
+const char PROCESS_IO[] =
+    "rchar: 52428800\n"
+    "wchar: 10485760\n"
+    "syscr: 1200\n"
+    "syscw: 340\n"
+    "read_bytes: 4194304\n"
+    "write_bytes: 2097152\n"
+    "cancelled_write_bytes: 4096\n";
+
+} // namespace
+
+TEST(PROCESS_IO, ReadsStorageBytesAndSyscalls) {
+    IoCounters counters {};
+    ASSERT_TRUE(parseProcessIo(PROCESS_IO, std::strlen(PROCESS_IO), counters));
+    // Not rchar and wchar, those include reads served from the page cache
+    EXPECT_EQ(counters.read_bytes, 4194304u);
+    EXPECT_EQ(counters.write_bytes, 2097152u);
+    EXPECT_EQ(counters.read_ops, 1200u);
+    EXPECT_EQ(counters.write_ops, 340u);
+}
+
+TEST(PROCESS_IO, RejectsOtherText) {
+    IoCounters counters {};
+    const char text[] = "Name:\tbash\n";
+    EXPECT_FALSE(parseProcessIo(text, std::strlen(text), counters));
+    EXPECT_FALSE(parseProcessIo("", 0, counters));
+}
+
+TEST(PROCESS_IO, RatesOverTheInterval) {
+    const IoCounters before {1000, 2000, 10, 20};
+    const IoCounters after {3000, 2000, 14, 19};
+    const IoRate rate = ioRate(before, after, 0.5);
+    EXPECT_DOUBLE_EQ(rate.read_rate, 4000.0);
+    EXPECT_DOUBLE_EQ(rate.write_rate, 0.0);
+    EXPECT_DOUBLE_EQ(rate.read_ops, 8.0);
+    // Went backwards, the process was replaced or the counter wrapped
+    EXPECT_DOUBLE_EQ(rate.write_ops, 0.0);
+
+    const IoRate none = ioRate(before, after, 0.0);
+    EXPECT_DOUBLE_EQ(none.read_rate, 0.0);
+}
+
+// A throwaway /proc/diskstats next to a /sys/block that lists the whole disks
+class DISK_STATS: public ::testing::Test {
+protected:
+    FixtureDir fixture {"test_diskio"};
+    std::string root;
+
+    void SetUp() override {
+        root = fixture.path();
+        ASSERT_FALSE(root.empty());
+        mkdir((root + "/block").c_str(), 0755);
+    }
+
+    std::string diskstats() const {
+        return root + "/diskstats";
+    }
+
+    std::string sysBlock() const {
+        return root + "/block";
+    }
+
+    void addBlockDevice(const std::string &name) {
+        mkdir((sysBlock() + "/" + name).c_str(), 0755);
+    }
+
+    void writeDiskstats(const std::string &text) {
+        ASSERT_TRUE(writeFile(diskstats(), text));
+    }
+
+    static std::string line(int major, int minor, const std::string &name, unsigned long long reads,
+                            unsigned long long read_sectors, unsigned long long writes,
+                            unsigned long long write_sectors, unsigned long long io_ms) {
+        char text[256];
+        std::snprintf(text, sizeof(text), "%4d %7d %s %llu 0 %llu 10 %llu 0 %llu 20 0 %llu 30 0 0 0 0 0 0\n",
+                      major, minor, name.c_str(), reads, read_sectors, writes, write_sectors, io_ms);
+        return text;
+    }
+};
+
+TEST_F(DISK_STATS, MissingFileFails) {
+    DiskStats stats((root + "/missing").c_str(), sysBlock().c_str());
+    EXPECT_FALSE(stats.isOpen());
+    EXPECT_FALSE(stats.refresh(1.0));
+    EXPECT_TRUE(stats.disks().empty());
+}
+
+TEST_F(DISK_STATS, RatesOfWholeDisksOnly) {
+    addBlockDevice("sda");
+    addBlockDevice("nvme0n1");
+    addBlockDevice("loop0");
+    writeDiskstats(line(8, 0, "sda", 100, 2000, 50, 800, 1000) +
+                   line(8, 1, "sda1", 90, 1800, 40, 600, 900) +
+                   line(7, 0, "loop0", 0, 0, 0, 0, 0) +
+                   line(259, 0, "nvme0n1", 10, 80, 10, 80, 5));
+
+    DiskStats stats(diskstats().c_str(), sysBlock().c_str());
+    ASSERT_TRUE(stats.refresh(0.0));
+    // No partition and no device that never did any I/O
+    ASSERT_EQ(stats.disks().size(), 2u);
+    EXPECT_STREQ(stats.disks()[0].name, "sda");
+    EXPECT_STREQ(stats.disks()[1].name, "nvme0n1");
+    EXPECT_DOUBLE_EQ(stats.disks()[0].rate.read_rate, 0.0);
+
+    writeDiskstats(line(8, 0, "sda", 300, 6000, 60, 1800, 1500) +
+                   line(8, 1, "sda1", 280, 5600, 50, 1400, 1400) +
+                   line(7, 0, "loop0", 0, 0, 0, 0, 0) +
+                   line(259, 0, "nvme0n1", 10, 80, 10, 80, 5));
+    ASSERT_TRUE(stats.refresh(2.0));
+
+    const DiskInfo &sda = stats.disks()[0];
+    EXPECT_DOUBLE_EQ(sda.rate.read_rate, 4000.0 * 512 / 2.0);
+    EXPECT_DOUBLE_EQ(sda.rate.write_rate, 1000.0 * 512 / 2.0);
+    EXPECT_DOUBLE_EQ(sda.rate.read_ops, 100.0);
+    EXPECT_DOUBLE_EQ(sda.rate.write_ops, 5.0);
+    EXPECT_FLOAT_EQ(sda.busy, 0.25f);
+    EXPECT_DOUBLE_EQ(stats.disks()[1].rate.read_rate, 0.0);
+}
+
+TEST_F(DISK_STATS, FlagsStackedDevices) {
+    addBlockDevice("sda");
+    addBlockDevice("dm-0");
+    addBlockDevice("md0");
+    ASSERT_TRUE(makeDirs(sysBlock() + "/dm-0/slaves/sda1"));
+    // An empty slaves directory is what a plain disk has
+    ASSERT_TRUE(makeDirs(sysBlock() + "/sda/slaves"));
+    ASSERT_TRUE(makeDirs(sysBlock() + "/md0/slaves/sda"));
+    writeDiskstats(line(8, 0, "sda", 100, 2000, 50, 800, 1000) +
+                   line(8, 1, "sda1", 90, 1800, 40, 600, 900) +
+                   line(253, 0, "dm-0", 90, 1800, 40, 600, 900) +
+                   line(9, 0, "md0", 5, 40, 5, 40, 5));
+
+    DiskStats stats(diskstats().c_str(), sysBlock().c_str());
+    ASSERT_TRUE(stats.refresh(0.0));
+    ASSERT_EQ(stats.disks().size(), 3u);
+    EXPECT_STREQ(stats.disks()[0].name, "sda");
+    EXPECT_FALSE(stats.disks()[0].stacked);
+    EXPECT_STREQ(stats.disks()[1].name, "dm-0");
+    EXPECT_TRUE(stats.disks()[1].stacked);
+    EXPECT_STREQ(stats.disks()[2].name, "md0");
+    EXPECT_TRUE(stats.disks()[2].stacked);
+}
+
+TEST_F(DISK_STATS, SysfsSpellsSlashesAsBangs) {
+    addBlockDevice("cciss!c0d0");
+    writeDiskstats(line(104, 0, "cciss/c0d0", 1, 8, 1, 8, 1) + line(104, 1, "cciss/c0d0p1", 1, 8, 1, 8, 1));
+
+    DiskStats stats(diskstats().c_str(), sysBlock().c_str());
+    ASSERT_TRUE(stats.refresh(0.0));
+    ASSERT_EQ(stats.disks().size(), 1u);
+    EXPECT_STREQ(stats.disks()[0].name, "cciss/c0d0");
+}
+
+TEST_F(DISK_STATS, GrowsForManyDevices) {
+    std::string text;
+    for (int minor = 0; minor < 200; minor++) {
+        const std::string name = "vd" + std::to_string(minor);
+        addBlockDevice(name);
+        text += line(252, minor, name, 1, 8, 1, 8, 1);
+    }
+    writeDiskstats(text);
+
+    DiskStats stats(diskstats().c_str(), sysBlock().c_str());
+    ASSERT_TRUE(stats.refresh(0.0));
+    ASSERT_EQ(stats.disks().size(), DiskStats::MAX_DISKS);
+    EXPECT_STREQ(stats.disks()[0].name, "vd0");
+}
+
+// Far more than the buffer starts with, and more than one read of the real seq_file returns
+TEST_F(DISK_STATS, ReadsDisksPastTheInitialBuffer) {
+    std::string text;
+    for (int minor = 0; text.size() < 64 * 1024; minor++)
+        text += line(8, minor + 1, "sda" + std::to_string(minor + 1), 1, 8, 1, 8, 1);
+    addBlockDevice("vda");
+    text += line(252, 0, "vda", 100, 2000, 50, 800, 1000);
+    writeDiskstats(text);
+
+    DiskStats stats(diskstats().c_str(), sysBlock().c_str());
+    ASSERT_TRUE(stats.refresh(0.0));
+    ASSERT_EQ(stats.disks().size(), 1u);
+    EXPECT_STREQ(stats.disks()[0].name, "vda");
+}
+
+TEST(DISK_STATS_LIVE, ReadsThisMachine) {
+    DiskStats stats;
+    if (!stats.isOpen())
+        GTEST_SKIP() << "/proc/diskstats is not available here";
+    ASSERT_TRUE(stats.refresh(0.0));
+    ASSERT_TRUE(stats.refresh(0.1));
+    for (const DiskInfo &disk : stats.disks()) {
+        EXPECT_GT(std::strlen(disk.name), 0u);
+        EXPECT_GE(disk.busy, 0.0f);
+        EXPECT_LE(disk.busy, 1.0f);
+    }
+}
+
+// smaps runs to several pages even for a small process, and one read of it returns about one
+TEST(PROC_FILE_LIVE, ReadsSeqFileToTheEnd) {
+    ProcFile smaps("/proc/self/smaps");
+    if (!smaps.isOpen())
+        GTEST_SKIP() << "/proc/self/smaps is not available here";
+    std::vector<char> buffer;
+    const long read_size = smaps.readAll(buffer);
+    ASSERT_GT(read_size, 4 * 4096);
+    EXPECT_EQ(buffer[static_cast<size_t>(read_size) - 1], '\n');
+    EXPECT_EQ(buffer[static_cast<size_t>(read_size)], '\0');
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "drmclients.h"
+#include "testfixture.h"
+
+// A throwaway procfs lookalike with `<pid>/fdinfo/<fd>` files only, DRM clients among ordinary descriptors
+class DRM_CLIENTS: public ::testing::Test {
+protected:
+    static constexpr int64_t SECOND_US = 1000 * 1000;
+    static constexpr unsigned long long SECOND_NS = 1000ull * 1000 * 1000;
+
+    FixtureDir fixture {"test_drmclients"};
+    std::string root;
+
+    void SetUp() override {
+        root = fixture.path();
+        ASSERT_FALSE(root.empty());
+    }
+
+    std::string fdinfoPath(int pid, int fd) {
+        const std::string dir = root + "/" + std::to_string(pid) + "/fdinfo";
+        makeDirs(dir);
+        return dir + "/" + std::to_string(fd);
+    }
+
+    void writeFdinfo(int pid, int fd, const std::string &text) {
+        // Rewritten in place, a descriptor kept open on the file sees the new contents like it would in procfs
+        ASSERT_TRUE(rewriteFile(fdinfoPath(pid, fd), text, 1024));
+    }
+
+    void writeOrdinaryFd(int pid, int fd) {
+        writeFdinfo(pid, fd, "pos:\t0\nflags:\t02\nmnt_id:\t25\nino:\t1234\n");
+    }
+
+    /** fdinfo of an i915 client with a render and a video engine, the video engine has two instances. */
+    void writeDrmFd(int pid, int fd, unsigned client_id, unsigned long long render_ns, unsigned long long video_ns = 0,
+                    const char *pdev = "0000:00:02.0") {
+        writeFdinfo(pid, fd,
+                    "pos:\t0\nflags:\t02100002\nmnt_id:\t24\nino:\t1029\n"
+                    "drm-driver:\ti915\n"
+                    "drm-client-id:\t" + std::to_string(client_id) + "\n" +
+                    "drm-pdev:\t" + pdev + "\n" +
+                    "drm-total-system:\t0\n"
+                    "drm-engine-render:\t" + std::to_string(render_ns) + " ns\n" +
+                    "drm-engine-copy:\t0 ns\n"
+                    "drm-engine-video:\t" + std::to_string(video_ns) + " ns\n" +
+                    "drm-engine-capacity-video:\t2\n");
+    }
+
+    static float engineUse(const DrmClientTable &table, const char *name) {
+        for (const auto &engine : table.engines()) {
+            if (std::strcmp(engine.name, name) == 0)
+                return engine.use;
+        }
+        return -1.0f;
+    }
+};
+
+TEST_F(DRM_CLIENTS, NoGpuReadsIdle) {
+    writeOrdinaryFd(10, 0);
+    writeOrdinaryFd(10, 1);
+
+    DrmClientTable table(root.c_str());
+    EXPECT_EQ(table.update(10, 0), 0.0);
+    EXPECT_EQ(table.update(10, SECOND_US), 0.0);
+    EXPECT_EQ(table.clientCount(), 0u);
+    EXPECT_TRUE(table.engines().empty());
+
+    // Missing processes and roots are not errors either
+    EXPECT_EQ(table.update(99, 0), 0.0);
+    DrmClientTable missing((root + "/missing").c_str());
+    EXPECT_EQ(missing.update(10, 0), 0.0);
+}
+
+TEST_F(DRM_CLIENTS, UtilizationFromCounterDeltas) {
+    writeOrdinaryFd(20, 0);
+    writeDrmFd(20, 5, 7, 1000, 0);
+
+    DrmClientTable table(root.c_str());
+    EXPECT_EQ(table.update(20, 0), 0.0);
+    EXPECT_EQ(table.clientCount(), 1u);
+
+    // Render busy for half of the second, one of the two video instances fully busy
+    writeDrmFd(20, 5, 7, 1000 + SECOND_NS / 2, SECOND_NS);
+    EXPECT_NEAR(table.update(20, SECOND_US), 0.5, 1e-6);
+    EXPECT_NEAR(engineUse(table, "render"), 0.5f, 1e-6f);
+    EXPECT_NEAR(engineUse(table, "video"), 0.5f, 1e-6f);
+    EXPECT_EQ(engineUse(table, "copy"), 0.0f);
+
+    // The interval is the measured one, not a nominal tick
+    writeDrmFd(20, 5, 7, 1000 + SECOND_NS / 2 + SECOND_NS / 4, SECOND_NS);
+    EXPECT_NEAR(table.update(20, SECOND_US + SECOND_US / 4), 1.0, 1e-6);
+}
+
+TEST_F(DRM_CLIENTS, DuplicatedClientsCountOnce) {
+    writeDrmFd(30, 5, 7, 0);
+    writeDrmFd(30, 6, 7, 0);
+    // Same client id on another GPU is another client
+    writeDrmFd(30, 7, 7, 0, 0, "0000:03:00.0");
+
+    DrmClientTable table(root.c_str());
+    table.update(30, 0);
+    EXPECT_EQ(table.clientCount(), 2u);
+
+    writeDrmFd(30, 5, 7, SECOND_NS / 4);
+    writeDrmFd(30, 6, 7, SECOND_NS / 4);
+    writeDrmFd(30, 7, 7, SECOND_NS / 4, 0, "0000:03:00.0");
+    // Both GPUs' render engines add up under one name, the dup is not counted again
+    EXPECT_NEAR(table.update(30, SECOND_US), 0.5, 1e-6);
+}
+
+TEST_F(DRM_CLIENTS, KnownDescriptorsAreNotRescanned) {
+    writeOrdinaryFd(40, 0);
+    writeDrmFd(40, 5, 1, 0);
+
+    DrmClientTable table(root.c_str());
+    table.update(40, 0);
+    EXPECT_EQ(table.scanCount(), 1u);
+
+    // A new DRM descriptor within the rescan interval is not looked for
+    writeDrmFd(40, 6, 2, 0);
+    for (int tick = 1; tick <= 10; tick++) {
+        writeDrmFd(40, 5, 1, static_cast<unsigned long long>(tick) * SECOND_NS / 10);
+        EXPECT_NEAR(table.update(40, tick * SECOND_US / 10), 1.0, 1e-6);
+    }
+    EXPECT_EQ(table.scanCount(), 1u);
+    EXPECT_EQ(table.clientCount(), 1u);
+
+    // It is found by the next periodic rescan, and the known client keeps its baseline across it
+    writeDrmFd(40, 5, 1, SECOND_NS + DrmClientTable::RESCAN_INTERVAL_US * 500);
+    EXPECT_NEAR(table.update(40, SECOND_US + DrmClientTable::RESCAN_INTERVAL_US), 0.5, 1e-6);
+    EXPECT_EQ(table.scanCount(), 2u);
+    EXPECT_EQ(table.clientCount(), 2u);
+}
+
+TEST_F(DRM_CLIENTS, ClosedDescriptorTriggersRescan) {
+    writeDrmFd(50, 5, 1, 0);
+    writeDrmFd(50, 6, 2, 0);
+
+    DrmClientTable table(root.c_str());
+    table.update(50, 0);
+    EXPECT_EQ(table.clientCount(), 2u);
+
+    // fd 6 now refers to an ordinary file
+    writeOrdinaryFd(50, 6);
+    writeDrmFd(50, 5, 1, SECOND_NS / 10);
+    EXPECT_NEAR(table.update(50, SECOND_US / 10), 1.0, 1e-6);
+    EXPECT_EQ(table.scanCount(), 2u);
+    EXPECT_EQ(table.clientCount(), 1u);
+}
+
+TEST_F(DRM_CLIENTS, ProcessesKeepTheirOwnBaselines) {
+    writeDrmFd(60, 5, 1, 0);
+    writeDrmFd(61, 5, 2, 0);
+
+    DrmClientTable table(root.c_str());
+    table.update(60, 0);
+    table.update(61, 0);
+
+    writeDrmFd(60, 5, 1, SECOND_NS / 2);
+    writeDrmFd(61, 5, 2, SECOND_NS / 5);
+    EXPECT_NEAR(table.update(60, SECOND_US), 0.5, 1e-6);
+    EXPECT_NEAR(table.update(61, SECOND_US), 0.2, 1e-6);
+    EXPECT_EQ(table.scanCount(), 2u);
+}
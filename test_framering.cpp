@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "framering.h"
+
+namespace {
+
+/** A ring name no other test run uses. */
+std::string ringName(const char *test) {
+    return "/test_framering." + std::to_string(getpid()) + "." + test;
+}
+
+// Every field is derived from the tick number, so a frame mixing two publications is detectable.
+MetricFrame frameForTick(uint64_t tick) {
+    MetricFrame frame {};
+    frame.tick = tick;
+    frame.timestamp_ms = static_cast<double>(tick) * 10.0;
+    frame.mem_total = 1000000;
+    frame.mem_used = static_cast<int64_t>(tick * 3);
+    frame.cpu_use = static_cast<double>(tick) * 0.5;
+    frame.core_count = static_cast<uint32_t>(tick % 1024);
+    return frame;
+}
+
+bool frameConsistent(const MetricFrame &frame) {
+    return frame.timestamp_ms == static_cast<double>(frame.tick) * 10.0 &&
+        frame.mem_total == 1000000 &&
+        frame.mem_used == static_cast<int64_t>(frame.tick * 3) &&
+        frame.cpu_use == static_cast<double>(frame.tick) * 0.5 &&
+        frame.core_count == static_cast<uint32_t>(frame.tick % 1024);
+}
+
+} // namespace
+
+TEST(FRAME_RING, ReaderSeesPublishedFrames) {
+    const std::string name = ringName("roundtrip");
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 8));
+
+    FrameRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+    EXPECT_EQ(reader.capacity(), 8u);
+    EXPECT_TRUE(reader.writerAlive());
+    EXPECT_EQ(reader.writerPid(), getpid());
+
+    MetricFrame frame;
+    EXPECT_FALSE(reader.latest(frame));
+
+    writer.publish(frameForTick(1));
+    writer.publish(frameForTick(2));
+    ASSERT_TRUE(reader.latest(frame));
+    EXPECT_EQ(frame.tick, 2u);
+    EXPECT_TRUE(frameConsistent(frame));
+    EXPECT_EQ(reader.published(), 2u);
+}
+
+TEST(FRAME_RING, CursorReadsEveryFrameOnce) {
+    const std::string name = ringName("cursor");
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 8));
+    FrameRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+
+    uint64_t cursor = 0;
+    MetricFrame frame;
+    for (uint64_t tick = 1; tick <= 5; tick++)
+        writer.publish(frameForTick(tick));
+
+    for (uint64_t tick = 1; tick <= 5; tick++) {
+        ASSERT_TRUE(reader.next(cursor, frame));
+        EXPECT_EQ(frame.tick, tick);
+    }
+    EXPECT_FALSE(reader.next(cursor, frame));
+    EXPECT_EQ(cursor, 5u);
+
+    writer.publish(frameForTick(6));
+    ASSERT_TRUE(reader.next(cursor, frame));
+    EXPECT_EQ(frame.tick, 6u);
+}
+
+TEST(FRAME_RING, LappedReaderSkipsToOldestHeldFrame) {
+    const std::string name = ringName("lapped");
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 4));
+    FrameRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+
+    for (uint64_t tick = 1; tick <= 10; tick++)
+        writer.publish(frameForTick(tick));
+
+    uint64_t cursor = 0;
+    uint64_t skipped = 0;
+    MetricFrame frame;
+    ASSERT_TRUE(reader.next(cursor, frame, &skipped));
+    EXPECT_EQ(frame.tick, 7u);
+    EXPECT_EQ(skipped, 6u);
+
+    std::vector<uint64_t> rest;
+    while (reader.next(cursor, frame, &skipped))
+        rest.push_back(frame.tick);
+    EXPECT_EQ(rest, (std::vector<uint64_t> {8, 9, 10}));
+    EXPECT_EQ(skipped, 6u);
+}
+
+TEST(FRAME_RING, ClosedWriterIsReported) {
+    const std::string name = ringName("closed");
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 4));
+    FrameRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+    writer.publish(frameForTick(1));
+
+    writer.close();
+    EXPECT_FALSE(reader.writerAlive());
+
+    // The mapping outlives the object, frames already published stay readable
+    MetricFrame frame;
+    ASSERT_TRUE(reader.latest(frame));
+    EXPECT_EQ(frame.tick, 1u);
+
+    FrameRingReader late;
+    EXPECT_FALSE(late.open(name));
+}
+
+TEST(FRAME_RING, ReaderRejectsForeignSegment) {
+    const std::string name = ringName("foreign");
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, static_cast<off_t>(frame_ring_format::mappingSize(4))), 0);
+    void *mapped = mmap(nullptr, sizeof(frame_ring_format::Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ASSERT_NE(mapped, MAP_FAILED);
+    close(fd);
+
+    FrameRingReader reader;
+    EXPECT_FALSE(reader.open(name));
+
+    // A writer built against another MetricFrame
+    auto *header = static_cast<frame_ring_format::Header*>(mapped);
+    header->version = frame_ring_format::VERSION;
+    header->frame_size = sizeof(MetricFrame) + 8;
+    header->capacity = 4;
+    header->magic.store(frame_ring_format::MAGIC);
+    EXPECT_FALSE(reader.open(name));
+
+    header->frame_size = sizeof(MetricFrame);
+    EXPECT_TRUE(reader.open(name));
+
+    munmap(mapped, sizeof(frame_ring_format::Header));
+    shm_unlink(name.c_str());
+}
+
+TEST(FRAME_RING, WriterReplacesStaleSegment) {
+    const std::string name = ringName("stale");
+    FrameRingWriter crashed;
+    ASSERT_TRUE(crashed.open(name, 4));
+    crashed.publish(frameForTick(42));
+
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 16));
+    FrameRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+    EXPECT_EQ(reader.capacity(), 16u);
+    EXPECT_EQ(reader.published(), 0u);
+}
+
+// The writer publishes as fast as it can into a small ring, so readers are lapped and overlap stores constantly.
+// Build with -DHW_OVERLAY_SANITIZE_THREAD=ON to run this under ThreadSanitizer.
+TEST(FRAME_RING, ReadersNeverSeeTornFrames) {
+    constexpr unsigned reader_count = 3;
+    constexpr auto run_time = std::chrono::milliseconds(300);
+
+    const std::string name = ringName("torn");
+    FrameRingWriter writer;
+    ASSERT_TRUE(writer.open(name, 16));
+
+    std::atomic<bool> running {true};
+    std::atomic<unsigned> torn_frames {0};
+    std::atomic<unsigned> out_of_order {0};
+    std::atomic<unsigned long long> total_reads {0};
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < reader_count; i++) {
+        readers.emplace_back([&, i]() {
+            FrameRingReader reader;
+            if (!reader.open(name))
+                return;
+            uint64_t cursor = 0;
+            uint64_t last_tick = 0;
+            unsigned long long reads = 0;
+            MetricFrame frame;
+            while (running.load(std::memory_order_relaxed)) {
+                // Half the readers follow the cursor, the others only poll the newest frame
+                const bool read = i % 2 == 0 ? reader.next(cursor, frame) : reader.latest(frame);
+                if (!read)
+                    continue;
+                if (!frameConsistent(frame))
+                    torn_frames++;
+                if (frame.tick < last_tick)
+                    out_of_order++;
+                last_tick = frame.tick;
+                reads++;
+            }
+            total_reads += reads;
+        });
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + run_time;
+    uint64_t tick = 0;
+    while (std::chrono::steady_clock::now() < deadline)
+        writer.publish(frameForTick(++tick));
+    running = false;
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_GT(total_reads.load(), 0u);
+    EXPECT_EQ(torn_frames.load(), 0u);
+    EXPECT_EQ(out_of_order.load(), 0u);
+}
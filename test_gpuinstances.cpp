@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gpuinstances.h"
+
+namespace {
+
+/** Double-null separated list of `names`, as `PdhEnumObjectItemsW` returns it. */
+std::vector<wchar_t> instanceList(const std::vector<std::wstring> &names) {
+    std::vector<wchar_t> list;
+    for (const auto &name : names) {
+        list.insert(list.end(), name.begin(), name.end());
+        list.push_back(L'\0');
+    }
+    list.push_back(L'\0');
+    return list;
+}
+
+std::wstring engine(unsigned pid, const wchar_t *type, unsigned index = 0) {
+    return L"pid_" + std::to_wstring(pid) + L"_luid_0x00000000_0x0000D1C5_phys_0_eng_" + std::to_wstring(index) +
+        L"_engtype_" + type;
+}
+
+} // namespace
+
+TEST(GPU_INSTANCES, ParsesPid) {
+    uint32_t pid = 0;
+    EXPECT_TRUE(GpuInstanceIndex::parsePid(L"pid_1234_luid_0x0_engtype_3D", pid));
+    EXPECT_EQ(pid, 1234u);
+    EXPECT_TRUE(GpuInstanceIndex::parsePid(L"pid_7", pid));
+    EXPECT_EQ(pid, 7u);
+    EXPECT_TRUE(GpuInstanceIndex::parsePid(L"pid_4294967295_x", pid));
+    EXPECT_EQ(pid, 4294967295u);
+
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"pid_", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"pid", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"pid_12a_luid", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"pid_4294967296_luid", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"pidx12_luid", pid));
+    EXPECT_FALSE(GpuInstanceIndex::parsePid(L"luid_0x0_pid_12", pid));
+}
+
+TEST(GPU_INSTANCES, ParsesEngineType) {
+    EXPECT_EQ(GpuInstanceIndex::engineType(L"pid_1_eng_0_engtype_3D"), L"3D");
+    EXPECT_EQ(GpuInstanceIndex::engineType(L"pid_1_eng_0_engtype_VideoDecode"), L"VideoDecode");
+    EXPECT_EQ(GpuInstanceIndex::engineType(L"pid_1_eng_0_engtype_"), L"");
+    EXPECT_EQ(GpuInstanceIndex::engineType(L"pid_1_eng_0"), L"");
+    // Only the full marker counts, not an "engtype" inside another field
+    EXPECT_EQ(GpuInstanceIndex::engineType(L"engtype_3D"), L"");
+}
+
+TEST(GPU_INSTANCES, FindsTheEngineOfAProcess) {
+    const auto list = instanceList({
+        engine(100, L"Copy"),
+        engine(100, L"3D", 1),
+        engine(200, L"3D"),
+        engine(1000, L"VideoDecode"),
+        engine(10, L"3D"),
+    });
+
+    GpuInstanceIndex index;
+    EXPECT_TRUE(index.update(list.data(), list.size()));
+    EXPECT_EQ(index.instanceCount(), 5u);
+    EXPECT_EQ(index.processCount(), 4u);
+    EXPECT_EQ(index.engineCount(100), 2u);
+    EXPECT_EQ(index.engineCount(300), 0u);
+
+    EXPECT_EQ(index.find(100), engine(100, L"3D", 1));
+    EXPECT_EQ(index.find(200), engine(200, L"3D"));
+    EXPECT_EQ(index.find(100, L"Copy"), engine(100, L"Copy"));
+    // A PID that is a prefix of another one does not match it
+    EXPECT_TRUE(index.find(1000).empty());
+    EXPECT_EQ(index.find(1000, L"VideoDecode"), engine(1000, L"VideoDecode"));
+    EXPECT_EQ(index.find(10), engine(10, L"3D"));
+    EXPECT_TRUE(index.find(300).empty());
+
+    // Views are null-terminated, ready for a counter path
+    std::wstring_view found = index.find(200);
+    EXPECT_EQ(found.data()[found.size()], L'\0');
+}
+
+TEST(GPU_INSTANCES, RebuildsOnlyWhenTheListChanges) {
+    auto list = instanceList({engine(1, L"3D"), engine(2, L"3D")});
+
+    GpuInstanceIndex index;
+    EXPECT_TRUE(index.update(list.data(), list.size()));
+    EXPECT_FALSE(index.update(list.data(), list.size()));
+
+    // The index holds its own copy, the caller may reuse its buffer
+    std::vector<wchar_t> copy = list;
+    list.assign(list.size(), L'x');
+    EXPECT_EQ(index.find(1), engine(1, L"3D"));
+    EXPECT_FALSE(index.update(copy.data(), copy.size()));
+
+    auto changed = instanceList({engine(3, L"3D")});
+    EXPECT_TRUE(index.update(changed.data(), changed.size()));
+    EXPECT_TRUE(index.find(1).empty());
+    EXPECT_EQ(index.find(3), engine(3, L"3D"));
+    EXPECT_EQ(index.instanceCount(), 1u);
+}
+
+TEST(GPU_INSTANCES, StaysInsideMalformedBuffers) {
+    GpuInstanceIndex index;
+
+    // No terminator at all, the last name ends at the buffer
+    std::wstring unterminated = engine(5, L"3D");
+    EXPECT_TRUE(index.update(unterminated.data(), unterminated.size()));
+    EXPECT_EQ(index.find(5), unterminated);
+
+    // Names without a PID or without an underscore after it are skipped
+    const auto list = instanceList({L"pid", L"pid_", L"_Total", L"pid_9", engine(6, L"3D")});
+    EXPECT_TRUE(index.update(list.data(), list.size()));
+    EXPECT_EQ(index.instanceCount(), 2u);
+    EXPECT_EQ(index.engineCount(9), 1u);
+    EXPECT_TRUE(index.find(9).empty());
+    EXPECT_EQ(index.find(6), engine(6, L"3D"));
+
+    // Anything after the double null is not part of the list
+    auto trailing = instanceList({engine(7, L"3D")});
+    const std::wstring garbage = engine(8, L"3D");
+    trailing.insert(trailing.end(), garbage.begin(), garbage.end());
+    EXPECT_TRUE(index.update(trailing.data(), trailing.size()));
+    EXPECT_TRUE(index.find(8).empty());
+
+    EXPECT_TRUE(index.update(nullptr, 0));
+    EXPECT_EQ(index.instanceCount(), 0u);
+    EXPECT_TRUE(index.find(7).empty());
+}
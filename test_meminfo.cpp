@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "meminfo.h"
+
+namespace {
+
+/** Head of a real /proc/meminfo, values padded to eight digits as the kernel prints them. */
+std::string memInfo(unsigned long long total_kb, unsigned long long free_kb, unsigned long long available_kb) {
+    char text[512];
+    std::snprintf(text, sizeof(text),
+        "MemTotal:       %8llu kB\n"
+        "MemFree:        %8llu kB\n"
+        "MemAvailable:   %8llu kB\n"
+        "Buffers:          123456 kB\n"
+        "Cached:          4567890 kB\n",
+        total_kb, free_kb, available_kb);
+    return text;
+}
+
+const char SMAPS_ROLLUP[] =
+    "55d4c8a2e000-7ffd1b5f3000 ---p 00000000 00:00 0                          [rollup]\n"
+    "Rss:              204800 kB\n"
+    "Pss:              150000 kB\n"
+    "Pss_Dirty:         90000 kB\n"
+    "Pss_Anon:          80000 kB\n"
+    "Pss_File:          60000 kB\n"
+    "Pss_Shmem:         10000 kB\n"
+    "Shared_Clean:      70000 kB\n"
+    "Shared_Dirty:      14800 kB\n"
+    "Private_Clean:     20000 kB\n"
+    "Private_Dirty:    100000 kB\n"
+    "Referenced:       200000 kB\n"
+    "Anonymous:         90000 kB\n"
+    "LazyFree:              0 kB\n"
+    "AnonHugePages:         0 kB\n"
+    "ShmemPmdMapped:        0 kB\n"
+    "FilePmdMapped:         0 kB\n"
+    "Shared_Hugetlb:        0 kB\n"
+    "Private_Hugetlb:       0 kB\n"
+    "Swap:               4096 kB\n"
+    "SwapPss:            2048 kB\n"
+    "Locked:                0 kB\n";
+
+} // namespace
+
+TEST(MEMINFO, ReadsTotalAndAvailable) {
+    MemInfoParser parser;
+    const std::string text = memInfo(16000000, 2000000, 9000000);
+    SystemMemory memory {};
+    ASSERT_TRUE(parser.parse(text.data(), text.size(), memory));
+    EXPECT_EQ(memory.total, 16000000ull * 1024);
+    EXPECT_EQ(memory.available, 9000000ull * 1024);
+}
+
+TEST(MEMINFO, ScansOnceWhileTheLayoutHolds) {
+    MemInfoParser parser;
+    SystemMemory memory {};
+    for (unsigned long long available_kb = 1000000; available_kb < 1100000; available_kb += 1000) {
+        const std::string text = memInfo(16000000, 500000, available_kb);
+        ASSERT_TRUE(parser.parse(text.data(), text.size(), memory));
+        EXPECT_EQ(memory.available, available_kb * 1024);
+    }
+    EXPECT_EQ(parser.scans(), 1u);
+}
+
+TEST(MEMINFO, RelearnsWhenAValueOutgrowsItsPadding) {
+    MemInfoParser parser;
+    SystemMemory memory {};
+    std::string text = memInfo(16000000, 2000000, 9000000);
+    ASSERT_TRUE(parser.parse(text.data(), text.size(), memory));
+
+    // Nine digits push MemFree's line, and every key after it, one byte further
+    text = memInfo(160000000, 120000000, 130000000);
+    ASSERT_TRUE(parser.parse(text.data(), text.size(), memory));
+    EXPECT_EQ(memory.total, 160000000ull * 1024);
+    EXPECT_EQ(memory.available, 130000000ull * 1024);
+    EXPECT_EQ(parser.scans(), 2u);
+}
+
+TEST(MEMINFO, FallsBackToMemFreeOnOldKernels) {
+    MemInfoParser parser;
+    const char text[] =
+        "MemTotal:        8000000 kB\n"
+        "MemFree:         3000000 kB\n"
+        "Buffers:          100000 kB\n";
+    SystemMemory memory {};
+    ASSERT_TRUE(parser.parse(text, std::strlen(text), memory));
+    EXPECT_EQ(memory.available, 3000000ull * 1024);
+    ASSERT_TRUE(parser.parse(text, std::strlen(text), memory));
+    EXPECT_EQ(parser.scans(), 1u);
+}
+
+TEST(MEMINFO, RejectsTextWithoutTotal) {
+    MemInfoParser parser;
+    const char text[] = "Buffers:          100000 kB\n";
+    SystemMemory memory {};
+    EXPECT_FALSE(parser.parse(text, std::strlen(text), memory));
+    EXPECT_EQ(memory.total, 0u);
+}
+
+TEST(MEMINFO, ParsesSmapsRollup) {
+    MemoryBreakdown breakdown {};
+    ASSERT_TRUE(parseSmapsRollup(SMAPS_ROLLUP, std::strlen(SMAPS_ROLLUP), breakdown));
+    EXPECT_TRUE(breakdown.detailed);
+    EXPECT_EQ(breakdown.rss, 204800ull * 1024);
+    EXPECT_EQ(breakdown.pss, 150000ull * 1024);
+    // Private_Clean plus Private_Dirty, not the Pss_* lines that share the prefix
+    EXPECT_EQ(breakdown.uss, 120000ull * 1024);
+    EXPECT_EQ(breakdown.swap, 4096ull * 1024);
+}
+
+TEST(MEMINFO, SmapsRollupWithoutRssFails) {
+    MemoryBreakdown breakdown {};
+    const char text[] = "Pss:  100 kB\n";
+    EXPECT_FALSE(parseSmapsRollup(text, std::strlen(text), breakdown));
+    EXPECT_FALSE(parseSmapsRollup("", 0, breakdown));
+}
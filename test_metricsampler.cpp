@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "metricsampler.h"
+#include "replaysource.h"
+
+namespace {
+
+constexpr unsigned CORES = 8;
+constexpr std::chrono::milliseconds INTERVAL {100};
+
+SyntheticSampleSource synthetic(uint64_t ticks = 0) {
+    return SyntheticSampleSource(SyntheticPattern::Ramp, CORES, INTERVAL, ticks, ReplaySpeed::AsFastAsPossible);
+}
+
+} // namespace
+
+TEST(METRIC_SAMPLER, FirstTickHasNoUtilization) {
+    SyntheticSampleSource source = synthetic();
+    MetricSampler sampler(&source, 2);
+    EXPECT_EQ(sampler.logicalCores(), CORES);
+
+    ASSERT_TRUE(sampler.sample());
+    MetricFrame frame;
+    sampler.derive(frame, 0.9f, 3);
+
+    EXPECT_EQ(frame.tick, 1u);
+    EXPECT_EQ(frame.timestamp_ms, 0.0);
+    EXPECT_EQ(frame.elapsed_ms, 0.0);
+    EXPECT_EQ(frame.missed_deadlines, 3u);
+    EXPECT_EQ(frame.cpu_use, 0.0);
+    EXPECT_EQ(frame.cpu_proc_use, 0.0);
+    EXPECT_GT(frame.mem_total, 0);
+    EXPECT_GT(frame.mem_used, 0);
+}
+
+TEST(METRIC_SAMPLER, UtilizationIsNormalizedBySourceCores) {
+    SyntheticSampleSource source = synthetic();
+    MetricSampler sampler(&source, 2);
+    MetricFrame frame;
+
+    for (int tick = 0; tick < 300; tick++) {
+        ASSERT_TRUE(sampler.sample());
+        sampler.derive(frame, 0.5f, 0);
+    }
+
+    EXPECT_EQ(frame.tick, 300u);
+    EXPECT_DOUBLE_EQ(frame.elapsed_ms, static_cast<double>(INTERVAL.count()));
+    EXPECT_DOUBLE_EQ(frame.timestamp_ms, 299.0 * INTERVAL.count());
+    EXPECT_GT(frame.cpu_use, 0.0);
+    EXPECT_LE(frame.cpu_use, 1.0);
+    // The synthetic foreground always gets a quarter of the busy time
+    EXPECT_NEAR(frame.cpu_proc_use, 0.25, 0.01);
+}
+
+TEST(METRIC_SAMPLER, CoreSummaryFollowsThreshold) {
+    SyntheticSampleSource source = synthetic();
+    MetricSampler sampler(&source, 2);
+    MetricFrame frame;
+
+    ASSERT_TRUE(sampler.sample());
+    sampler.derive(frame, 0.0f, 0);
+    ASSERT_TRUE(sampler.sample());
+    sampler.derive(frame, 0.0f, 0);
+
+    EXPECT_EQ(frame.core_count, CORES);
+    EXPECT_EQ(frame.cores_above_threshold, CORES);
+    EXPECT_LT(frame.core_max_index, CORES);
+
+    const CoreFrame &cores = sampler.coreFrame();
+    EXPECT_EQ(cores.tick, frame.tick);
+    EXPECT_EQ(cores.count, CORES);
+    EXPECT_FLOAT_EQ(cores.busy[frame.core_max_index], static_cast<float>(frame.core_max_use));
+}
+
+TEST(METRIC_SAMPLER, SwitchContinuesTimelineWithFreshBaseline) {
+    SyntheticSampleSource first = synthetic();
+    SyntheticSampleSource second = synthetic();
+    MetricSampler sampler(&first, 2);
+    MetricFrame frame;
+
+    for (int tick = 0; tick < 5; tick++) {
+        ASSERT_TRUE(sampler.sample());
+        sampler.derive(frame, 0.5f, 0);
+    }
+
+    sampler.setSource(&second, frame.timestamp_ms + INTERVAL.count());
+    EXPECT_EQ(sampler.currentSource(), &second);
+    ASSERT_TRUE(sampler.sample());
+    sampler.derive(frame, 0.5f, 0);
+
+    EXPECT_EQ(frame.tick, 6u);
+    EXPECT_DOUBLE_EQ(frame.timestamp_ms, 5.0 * INTERVAL.count());
+    EXPECT_EQ(frame.elapsed_ms, 0.0);
+    EXPECT_EQ(frame.cpu_use, 0.0);
+}
+
+TEST(METRIC_SAMPLER, ExhaustedSourceEndsSampling) {
+    SyntheticSampleSource source = synthetic(2);
+    MetricSampler sampler(&source, 2);
+
+    EXPECT_TRUE(sampler.sample());
+    EXPECT_TRUE(sampler.sample());
+    EXPECT_FALSE(sampler.sample());
+}
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "metricspage.h"
+
+namespace {
+
+MetricFrame frameForTick(uint64_t tick) {
+    MetricFrame frame {};
+    frame.tick = tick;
+    frame.elapsed_ms = 250.0;
+    frame.mem_total = 16ll << 30;
+    frame.mem_used = 4ll << 30;
+    frame.mem_proc = 256ll << 20;
+    frame.cpu_use = 0.5;
+    frame.cpu_proc_use = 0.25;
+    frame.cores_above_threshold = 1;
+    return frame;
+}
+
+/** Body of a complete response, empty if the Content-Length header does not match it. */
+std::string checkedBody(const std::string &response) {
+    const size_t header_end = response.find("\r\n\r\n");
+    const size_t length_at = response.find("Content-Length: ");
+    if (header_end == std::string::npos || length_at == std::string::npos)
+        return {};
+    const size_t length = std::stoul(response.substr(length_at + std::strlen("Content-Length: ")));
+    const std::string body = response.substr(header_end + 4);
+    return body.size() == length ? body : std::string{};
+}
+
+} // namespace
+
+TEST(METRICS_PAGE, UnavailableBeforeFirstRender) {
+    MetricsPage page;
+    const std::string &response = page.acquire();
+    EXPECT_EQ(response.rfind("HTTP/1.1 503", 0), 0u);
+    EXPECT_FALSE(checkedBody(response).empty());
+    EXPECT_EQ(page.renders(), 0u);
+}
+
+TEST(METRICS_PAGE, RendersSystemAndForegroundMetrics) {
+    const MetricFrame frame = frameForTick(7);
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.foreground_name = "game.exe";
+
+    MetricsPage page;
+    page.render(snapshot);
+    const std::string &response = page.acquire();
+    ASSERT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+
+    const std::string body = checkedBody(response);
+    EXPECT_NE(body.find("# TYPE hw_overlay_ticks_total counter\nhw_overlay_ticks_total 7\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_cpu_usage_ratio 0.5\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_memory_total_bytes 17179869184\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_cpu_share_ratio 0.25\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_memory_bytes 268435456\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_info{name=\"game.exe\"} 1\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_sample_interval_seconds 0.25\n"), std::string::npos);
+
+    // Collectors that are off leave no empty families behind, nor does a foreground without a memory breakdown
+    EXPECT_EQ(body.find("hw_overlay_foreground_memory_breakdown_bytes"), std::string::npos);
+    EXPECT_EQ(body.find("hw_overlay_core_usage_ratio"), std::string::npos);
+    EXPECT_EQ(body.find("hw_overlay_cgroup"), std::string::npos);
+    EXPECT_EQ(body.find("hw_overlay_watch"), std::string::npos);
+    EXPECT_EQ(body.find("thread"), std::string::npos);
+    EXPECT_EQ(body.find("_io_"), std::string::npos);
+}
+
+TEST(METRICS_PAGE, RendersActiveCollectorsWithLabels) {
+    const MetricFrame frame = frameForTick(1);
+    CoreFrame cores {};
+    cores.count = 2;
+    cores.busy[0] = 0.5f;
+    cores.busy[1] = 1.0f;
+    ProcessFrame processes {};
+    processes.process_count = 120;
+    processes.top_cpu_count = 1;
+    processes.top_cpu[0] = ProcessInfo{42, "make", 1.5f, 1024};
+    WatchFrame watches {};
+    watches.count = 1;
+    watches.watches[0].matches = 3;
+    watches.watches[0].pid = 99;
+    std::strcpy(watches.watches[0].name, "nginx");
+    watches.watches[0].mem_bytes = 4096;
+    CgroupFrame cgroups {};
+    cgroups.count = 1;
+    std::strcpy(cgroups.groups[0].path, "/system.slice/db.service");
+    cgroups.groups[0].memory_bytes = 8192;
+
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.cores = &cores;
+    snapshot.processes = &processes;
+    snapshot.watches = &watches;
+    snapshot.cgroups = &cgroups;
+
+    std::string body;
+    MetricsPage::renderBody(snapshot, body);
+    EXPECT_NE(body.find("\nhw_overlay_core_usage_ratio{core=\"1\"} 1\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_processes 120\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_top_process_cpu_usage_ratio{pid=\"42\",name=\"make\"} 1.5\n"),
+              std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_watch_resident_bytes{watch=\"0\",name=\"nginx\"} 4096\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_watch_processes{watch=\"0\",name=\"nginx\"} 3\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_cgroup_memory_bytes{path=\"/system.slice/db.service\"} 8192\n"),
+              std::string::npos);
+}
+
+TEST(METRICS_PAGE, RendersForegroundMemoryBreakdown) {
+    MetricFrame frame = frameForTick(1);
+    frame.mem_proc_detailed = true;
+    frame.mem_proc_rss = 300;
+    frame.mem_proc_uss = 100;
+    frame.mem_proc_swap = 50;
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+
+    std::string body;
+    MetricsPage::renderBody(snapshot, body);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_memory_breakdown_bytes{kind=\"rss\"} 300\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_memory_breakdown_bytes{kind=\"pss\"} 268435456\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_memory_breakdown_bytes{kind=\"uss\"} 100\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_memory_breakdown_bytes{kind=\"swap\"} 50\n"), std::string::npos);
+}
+
+TEST(METRICS_PAGE, RendersForegroundThreads) {
+    const MetricFrame frame = frameForTick(1);
+    ThreadFrame threads {};
+    threads.thread_count = 12;
+    threads.hot_threshold = 0.9f;
+    threads.hot_count = 1;
+    threads.top_count = 2;
+    threads.top[0] = ThreadInfo{101, "render", 0.95f};
+    threads.top[1] = ThreadInfo{102, "audio", 0.25f};
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.threads = &threads;
+
+    std::string body;
+    MetricsPage::renderBody(snapshot, body);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_threads 12\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_hot_threads 1\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_top_thread_cpu_usage_ratio{tid=\"101\",name=\"render\"} 0.949999988\n"),
+              std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_top_thread_cpu_usage_ratio{tid=\"102\",name=\"audio\"} 0.25\n"),
+              std::string::npos);
+}
+
+TEST(METRICS_PAGE, RendersStorageIo) {
+    const MetricFrame frame = frameForTick(1);
+    IoFrame io {};
+    io.tick = 1;
+    io.foreground = IoRate{2048.0, 512.0, 4.0, 2.0};
+    io.disk_count = 2;
+    std::strcpy(io.disks[0].name, "nvme0n1");
+    io.disks[0].rate = IoRate{1e6, 0.0, 100.0, 0.0};
+    io.disks[0].busy = 0.5f;
+    std::strcpy(io.disks[1].name, "dm-0");
+    io.disks[1].rate = IoRate{1e6, 0.0, 100.0, 0.0};
+    io.disks[1].stacked = true;
+    WatchFrame watches {};
+    watches.count = 1;
+    std::strcpy(watches.watches[0].name, "postgres");
+    watches.watches[0].io_write_rate = 4096.0;
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.watches = &watches;
+    snapshot.io = &io;
+
+    std::string body;
+    MetricsPage::renderBody(snapshot, body);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_io_bytes_per_second{direction=\"read\"} 2048\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_foreground_io_operations_per_second{direction=\"write\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_disk_io_bytes_per_second{disk=\"nvme0n1\",stacked=\"false\",direction=\"read\"} "
+                        "1000000\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_disk_io_operations_per_second{disk=\"dm-0\",stacked=\"true\",direction=\"read\"} "
+                        "100\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_disk_busy_ratio{disk=\"nvme0n1\",stacked=\"false\"} 0.5\n"), std::string::npos);
+    EXPECT_NE(body.find("\nhw_overlay_watch_io_bytes_per_second{watch=\"0\",name=\"postgres\",direction=\"write\"} "
+                        "4096\n"), std::string::npos);
+}
+
+TEST(METRICS_PAGE, EscapesLabelValues) {
+    const MetricFrame frame = frameForTick(1);
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    snapshot.foreground_name = "a\"b\\c\nd";
+
+    std::string body;
+    MetricsPage::renderBody(snapshot, body);
+    EXPECT_NE(body.find("hw_overlay_foreground_info{name=\"a\\\"b\\\\c\\nd\"} 1\n"), std::string::npos);
+}
+
+TEST(METRICS_PAGE, AcquireReturnsNewestRender) {
+    MetricsPage page;
+    MetricsSnapshot snapshot;
+    for (uint64_t tick = 1; tick <= 5; tick++) {
+        const MetricFrame frame = frameForTick(tick);
+        snapshot.frame = &frame;
+        page.render(snapshot);
+    }
+    EXPECT_NE(page.acquire().find("\nhw_overlay_ticks_total 5\n"), std::string::npos);
+
+    // Without a new render the reader keeps its buffer
+    EXPECT_NE(page.acquire().find("\nhw_overlay_ticks_total 5\n"), std::string::npos);
+    EXPECT_EQ(page.renders(), 5u);
+}
+
+// The sampler renders as fast as it can while the server thread acquires, every response must be whole and newer
+// than or equal to the previous one. Build with -DHW_OVERLAY_SANITIZE_THREAD=ON to run this under ThreadSanitizer.
+TEST(METRICS_PAGE, ReaderNeverSeesTornResponses) {
+    MetricsPage page;
+    std::atomic<bool> running {true};
+
+    std::thread sampler([&]() {
+        CoreFrame cores {};
+        cores.count = 64;
+        MetricsSnapshot snapshot;
+        snapshot.cores = &cores;
+        uint64_t tick = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            const MetricFrame frame = frameForTick(++tick);
+            snapshot.frame = &frame;
+            page.render(snapshot);
+        }
+    });
+
+    unsigned torn = 0;
+    unsigned out_of_order = 0;
+    uint64_t last_tick = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < deadline) {
+        const std::string &response = page.acquire();
+        if (response.rfind("HTTP/1.1 503", 0) == 0)
+            continue;
+        const std::string body = checkedBody(response);
+        const size_t at = body.find("\nhw_overlay_ticks_total ");
+        if (body.empty() || at == std::string::npos) {
+            torn++;
+            continue;
+        }
+        const uint64_t tick = std::stoull(body.substr(at + std::strlen("\nhw_overlay_ticks_total ")));
+        if (tick < last_tick)
+            out_of_order++;
+        last_tick = tick;
+    }
+    running = false;
+    sampler.join();
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(out_of_order, 0u);
+    EXPECT_GT(last_tick, 0u);
+}
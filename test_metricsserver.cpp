@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "metricsserver.h"
+
+namespace {
+
+/** A blocking loopback client that reads one response per request by its Content-Length. */
+class Client {
+    int fd;
+    std::string buffered;
+
+public:
+    explicit Client(uint16_t port): fd{socket(AF_INET, SOCK_STREAM, 0)} {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    ~Client() {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    bool connected() const {
+        return fd >= 0;
+    }
+
+    bool send(const std::string &request) {
+        return ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+    }
+
+    /** The next complete response, empty if the connection ended first. */
+    std::string response() {
+        while (true) {
+            const size_t header_end = buffered.find("\r\n\r\n");
+            if (header_end != std::string::npos) {
+                const size_t length_at = buffered.find("Content-Length: ");
+                const size_t length = length_at < header_end ?
+                    std::stoul(buffered.substr(length_at + std::strlen("Content-Length: "))) : 0;
+                const size_t total = header_end + 4 + length;
+                if (buffered.size() >= total) {
+                    std::string response = buffered.substr(0, total);
+                    buffered.erase(0, total);
+                    return response;
+                }
+            }
+            char chunk[4096];
+            const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0)
+                return {};
+            buffered.append(chunk, static_cast<size_t>(received));
+        }
+    }
+
+    /** True once the server closed the connection, a reset included: unread request bytes make the close one. */
+    bool closedByServer() {
+        char byte;
+        return recv(fd, &byte, 1, 0) <= 0;
+    }
+};
+
+const std::string SCRAPE = "GET /metrics HTTP/1.1\r\nHost: localhost\r\nAccept: text/plain\r\n\r\n";
+
+void renderTick(MetricsPage &page, uint64_t tick) {
+    MetricFrame frame {};
+    frame.tick = tick;
+    frame.cpu_use = 0.5;
+    MetricsSnapshot snapshot;
+    snapshot.frame = &frame;
+    page.render(snapshot);
+}
+
+} // namespace
+
+TEST(METRICS_SERVER, ServesRenderedPage) {
+    MetricsPage page;
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+    ASSERT_NE(server.port(), 0);
+
+    Client client(server.port());
+    ASSERT_TRUE(client.connected());
+    ASSERT_TRUE(client.send(SCRAPE));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 503", 0), 0u);
+
+    renderTick(page, 3);
+    ASSERT_TRUE(client.send(SCRAPE));
+    const std::string response = client.response();
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_NE(response.find("\nhw_overlay_ticks_total 3\n"), std::string::npos);
+    EXPECT_EQ(server.scrapes(), 2u);
+}
+
+TEST(METRICS_SERVER, RejectsOtherRequests) {
+    MetricsPage page;
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+
+    Client client(server.port());
+    ASSERT_TRUE(client.send("GET / HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 404", 0), 0u);
+    ASSERT_TRUE(client.send("GET /metricsfoo HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 404", 0), 0u);
+    ASSERT_TRUE(client.send("POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n"));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 405", 0), 0u);
+    ASSERT_TRUE(client.send("GET /metrics?name[]=x HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 503", 0), 0u);
+    EXPECT_EQ(server.scrapes(), 1u);
+}
+
+TEST(METRICS_SERVER, AnswersPipelinedRequestsInOrder) {
+    MetricsPage page;
+    renderTick(page, 1);
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+
+    Client client(server.port());
+    ASSERT_TRUE(client.send(SCRAPE + "GET /nope HTTP/1.1\r\n\r\n" + SCRAPE));
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 200", 0), 0u);
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(client.response().rfind("HTTP/1.1 200", 0), 0u);
+}
+
+TEST(METRICS_SERVER, ClosesWhenAsked) {
+    MetricsPage page;
+    renderTick(page, 1);
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+
+    Client http11(server.port());
+    ASSERT_TRUE(http11.send("GET /metrics HTTP/1.1\r\nConnection: Close\r\n\r\n"));
+    EXPECT_FALSE(http11.response().empty());
+    EXPECT_TRUE(http11.closedByServer());
+
+    Client http10(server.port());
+    ASSERT_TRUE(http10.send("GET /metrics HTTP/1.0\r\n\r\n"));
+    EXPECT_FALSE(http10.response().empty());
+    EXPECT_TRUE(http10.closedByServer());
+}
+
+TEST(METRICS_SERVER, DropsOversizedRequest) {
+    MetricsPage page;
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+
+    Client client(server.port());
+    ASSERT_TRUE(client.send("GET /metrics HTTP/1.1\r\nX-Padding: " + std::string(MetricsServer::REQUEST_SIZE, 'x')));
+    EXPECT_TRUE(client.closedByServer());
+}
+
+// Local load test: several scrapers on kept-alive connections and one on fresh connections, while the sampler renders
+// at a 1 ms refresh. Every scrape must get a whole 200 and the server must keep well above hundreds per second.
+TEST(METRICS_SERVER, KeepsUpWithConcurrentScrapers) {
+    constexpr unsigned scraper_count = 4;
+    constexpr unsigned scrapes_per_scraper = 500;
+
+    MetricsPage page;
+    renderTick(page, 1);
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+
+    std::atomic<bool> running {true};
+    std::thread sampler([&]() {
+        uint64_t tick = 1;
+        while (running.load(std::memory_order_relaxed)) {
+            renderTick(page, ++tick);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::atomic<unsigned> failures {0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> scrapers;
+    for (unsigned i = 0; i < scraper_count; i++) {
+        scrapers.emplace_back([&, i]() {
+            const bool reconnect = i == 0;
+            std::unique_ptr<Client> client;
+            for (unsigned scrape = 0; scrape < scrapes_per_scraper; scrape++) {
+                if (!client || reconnect)
+                    client = std::make_unique<Client>(server.port());
+                if (!client->send(SCRAPE) || client->response().rfind("HTTP/1.1 200 OK", 0) != 0)
+                    failures++;
+            }
+        });
+    }
+    for (auto &scraper : scrapers)
+        scraper.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    running = false;
+    sampler.join();
+
+    EXPECT_EQ(failures.load(), 0u);
+    EXPECT_EQ(server.scrapes(), scraper_count * scrapes_per_scraper);
+    EXPECT_GT(scraper_count * scrapes_per_scraper / seconds, 500.0);
+}
+
+TEST(METRICS_SERVER, StopClosesConnections) {
+    MetricsPage page;
+    MetricsServer server(page);
+    ASSERT_TRUE(server.start(0));
+    Client client(server.port());
+    ASSERT_TRUE(client.connected());
+
+    server.stop();
+    EXPECT_FALSE(server.running());
+    EXPECT_EQ(server.port(), 0);
+    EXPECT_TRUE(client.closedByServer());
+}
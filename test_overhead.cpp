@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "latencyhistogram.h"
+#include "selfmonitor.h"
+
+TEST(LATENCY_HISTOGRAM, EmptyReportsZero) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+    EXPECT_EQ(histogram.percentile(0.5), 0u);
+    EXPECT_EQ(histogram.percentile(0.99), 0u);
+}
+
+TEST(LATENCY_HISTOGRAM, BucketsCoverTheRangeWithoutGaps) {
+    EXPECT_EQ(LatencyHistogram::bucketIndex(0), 0u);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::MAX_VALUE_NS), LatencyHistogram::BUCKET_COUNT - 1);
+    EXPECT_EQ(LatencyHistogram::bucketUpperBound(LatencyHistogram::BUCKET_COUNT - 1), LatencyHistogram::MAX_VALUE_NS);
+
+    for (size_t i = 1; i < LatencyHistogram::BUCKET_COUNT; i++) {
+        const uint64_t lower = LatencyHistogram::bucketUpperBound(i - 1) + 1;
+        const uint64_t upper = LatencyHistogram::bucketUpperBound(i);
+        ASSERT_LE(lower, upper) << "bucket " << i;
+        ASSERT_EQ(LatencyHistogram::bucketIndex(lower), i);
+        ASSERT_EQ(LatencyHistogram::bucketIndex(upper), i);
+        // Bucket width stays within the advertised relative precision
+        ASSERT_LE(upper - lower, lower / LatencyHistogram::SUB_BUCKETS) << "bucket " << i;
+    }
+}
+
+TEST(LATENCY_HISTOGRAM, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 50; value++)
+        histogram.record(value);
+
+    EXPECT_EQ(histogram.count(), 50u);
+    EXPECT_EQ(histogram.max(), 50u);
+    EXPECT_EQ(histogram.percentile(0.5), 25u);
+    EXPECT_EQ(histogram.percentile(1.0), 50u);
+    EXPECT_EQ(histogram.percentile(0.0), 1u);
+}
+
+TEST(LATENCY_HISTOGRAM, PercentilesWithinPrecision) {
+    LatencyHistogram histogram;
+    std::mt19937_64 random(3);
+    std::lognormal_distribution<double> latency(10.0, 1.5);
+
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 100000; i++) {
+        values.push_back(static_cast<uint64_t>(latency(random)) + 1);
+        histogram.record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = static_cast<double>(values[static_cast<size_t>(quantile * values.size()) - 1]);
+        const double reported = static_cast<double>(histogram.percentile(quantile));
+        EXPECT_GE(reported, exact) << "p" << quantile * 100;
+        EXPECT_LE(reported, exact * (1.0 + 1.0 / LatencyHistogram::SUB_BUCKETS)) << "p" << quantile * 100;
+    }
+    EXPECT_EQ(histogram.max(), values.back());
+    EXPECT_EQ(histogram.percentile(1.0), values.back());
+}
+
+TEST(LATENCY_HISTOGRAM, HugeValuesAreClamped) {
+    LatencyHistogram histogram;
+    histogram.record(~uint64_t{0});
+    EXPECT_EQ(histogram.max(), LatencyHistogram::MAX_VALUE_NS);
+    EXPECT_EQ(histogram.percentile(0.5), LatencyHistogram::MAX_VALUE_NS);
+}
+
+TEST(LATENCY_HISTOGRAM, ReadersRunBesideTheWriter) {
+    LatencyHistogram histogram;
+    constexpr uint64_t RECORDS = 200000;
+    std::atomic<bool> done {false};
+
+    std::thread writer([&] {
+        for (uint64_t i = 0; i < RECORDS; i++)
+            histogram.record(1000 + i % 1000);
+        done = true;
+    });
+
+    // Whatever a reader catches mid-write is still a plausible report
+    uint64_t last_count = 0;
+    while (!done) {
+        const uint64_t count = histogram.count();
+        EXPECT_GE(count, last_count);
+        last_count = count;
+        const uint64_t median = histogram.percentile(0.5);
+        if (median != 0) {
+            EXPECT_GE(median, 1000u);
+            EXPECT_LE(median, 2047u);
+        }
+    }
+    writer.join();
+
+    EXPECT_EQ(histogram.count(), RECORDS);
+    EXPECT_EQ(histogram.max(), 1999u);
+}
+
+#ifndef _WIN32
+TEST(SELF_MONITOR, ReadsThisProcess) {
+    SelfMonitor monitor;
+    SelfUsage before {};
+    ASSERT_TRUE(monitor.read(before));
+    EXPECT_GT(before.rss_bytes, 0u);
+    EXPECT_EQ(before.threads, 1u);
+
+    // Burn some CPU on a second thread, both show up
+    std::atomic<bool> stop {false};
+    std::thread spinner([&] {
+        while (!stop) {}
+    });
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100)) {}
+
+    SelfUsage during {};
+    ASSERT_TRUE(monitor.read(during));
+    stop = true;
+    spinner.join();
+
+    EXPECT_EQ(during.threads, 2u);
+    EXPECT_GE(during.cpu_time_us, before.cpu_time_us + 50000);
+}
+#endif
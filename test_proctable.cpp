@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "proctable.h"
+#include "testfixture.h"
+
+// A throwaway procfs lookalike, only `<pid>/stat` and a few non-PID entries
+class PROCESS_TABLE: public ::testing::Test {
+protected:
+    FixtureDir fixture {"test_proctable"};
+    std::string root;
+
+    void SetUp() override {
+        root = fixture.path();
+        ASSERT_FALSE(root.empty());
+        mkdir((root + "/self").c_str(), 0755);
+        ASSERT_TRUE(writeFile(root + "/stat", "cpu  1 2 3 4\n"));
+    }
+
+    void writeProcess(int pid, const std::string &name, unsigned long long cpu_ticks, unsigned long long start_time,
+                      unsigned long long rss_pages) {
+        std::string dir = root + "/" + std::to_string(pid);
+        mkdir(dir.c_str(), 0755);
+        ASSERT_TRUE(writeFile(dir + "/stat", std::to_string(pid) + " (" + name + ") S 1 1 1 0 -1 4194560 0 0 0 0 " +
+                              std::to_string(cpu_ticks) + " 0 0 0 20 0 1 0 " + std::to_string(start_time) + " 1000 " +
+                              std::to_string(rss_pages) + " 0 0 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n"));
+    }
+
+    void removeProcess(int pid) {
+        ASSERT_TRUE(removeTree(root + "/" + std::to_string(pid)));
+    }
+
+    static double ticksPerSecond() {
+        return static_cast<double>(sysconf(_SC_CLK_TCK));
+    }
+};
+
+TEST_F(PROCESS_TABLE, MissingRootFails) {
+    ProcessTable table((root + "/missing").c_str());
+    EXPECT_FALSE(table.isOpen());
+    EXPECT_FALSE(table.refresh(1.0));
+}
+
+TEST_F(PROCESS_TABLE, ListsOnlyPidEntries) {
+    writeProcess(1, "init", 0, 1, 10);
+    writeProcess(42, "worker", 0, 5, 20);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_EQ(table.processCount(), 2u);
+    ASSERT_EQ(table.topByMemory().size(), 2u);
+    EXPECT_EQ(table.topByMemory()[0].pid, 42);
+    EXPECT_STREQ(table.topByMemory()[0].name, "worker");
+    EXPECT_EQ(table.topByMemory()[0].rss_bytes, 20u * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+}
+
+TEST_F(PROCESS_TABLE, CpuFromTickDeltas) {
+    const auto ticks = static_cast<unsigned long long>(ticksPerSecond());
+    writeProcess(10, "idle", 0, 1, 1);
+    writeProcess(11, "busy", 0, 1, 1);
+    writeProcess(12, "half", 0, 1, 1);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+
+    writeProcess(11, "busy", ticks * 2, 1, 1);
+    writeProcess(12, "half", ticks / 2, 1, 1);
+    ASSERT_TRUE(table.refresh(1.0));
+
+    const auto &top = table.topByCpu();
+    ASSERT_EQ(top.size(), 3u);
+    EXPECT_EQ(top[0].pid, 11);
+    EXPECT_NEAR(top[0].cpu_use, 2.0f, 1e-3);
+    EXPECT_EQ(top[1].pid, 12);
+    EXPECT_NEAR(top[1].cpu_use, 0.5f, 1e-2);
+    EXPECT_EQ(top[2].pid, 10);
+}
+
+// A new process on a reused PID has its own, lower tick counter. That must not turn into a delta.
+TEST_F(PROCESS_TABLE, ReusedPidStartsFresh) {
+    const auto ticks = static_cast<unsigned long long>(ticksPerSecond());
+    writeProcess(7, "old", ticks * 100, 1, 1);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+
+    writeProcess(7, "new", ticks * 150, 900, 1);
+    ASSERT_TRUE(table.refresh(1.0));
+    EXPECT_STREQ(table.topByCpu()[0].name, "new");
+    EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+
+    writeProcess(7, "new", ticks * 151, 900, 1);
+    ASSERT_TRUE(table.refresh(1.0));
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 1.0f, 1e-3);
+}
+
+TEST_F(PROCESS_TABLE, ExitedProcessesAreDropped) {
+    writeProcess(3, "a", 0, 1, 1);
+    writeProcess(4, "b", 0, 1, 1);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_EQ(table.cachedDescriptors(), 2u);
+
+    removeProcess(3);
+    ASSERT_TRUE(table.refresh(1.0));
+    EXPECT_EQ(table.processCount(), 1u);
+    ASSERT_EQ(table.topByCpu().size(), 1u);
+    EXPECT_EQ(table.topByCpu()[0].pid, 4);
+}
+
+// Listed on every refresh, but only read again in its slot, with the CPU of all the refreshes it went unread
+TEST_F(PROCESS_TABLE, IdleProcessesAreReadInTheirSlot) {
+    const auto ticks = static_cast<unsigned long long>(ticksPerSecond());
+    writeProcess(30, "sleeper", 0, 1, 8);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+    ASSERT_TRUE(table.refresh(1.0));
+    EXPECT_EQ(table.statReads(), 1u);
+
+    writeProcess(30, "sleeper", ticks * 4, 1, 8);
+    uint64_t unread = 0;
+    do {
+        ASSERT_TRUE(table.refresh(1.0));
+        ASSERT_EQ(table.processCount(), 1u);
+        EXPECT_EQ(table.topByMemory()[0].rss_bytes, 8u * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+        if (table.statReads() == 0) {
+            EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+        }
+    } while (table.statReads() == 0 && ++unread < ProcessTable::IDLE_READ_STRIDE);
+
+    ASSERT_LT(unread, ProcessTable::IDLE_READ_STRIDE);
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 4.0f / static_cast<float>(unread + 1), 1e-3);
+
+    // Busy now, so read on every refresh until it goes idle again
+    writeProcess(30, "sleeper", ticks * 5, 1, 8);
+    ASSERT_TRUE(table.refresh(1.0));
+    EXPECT_EQ(table.statReads(), 1u);
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 1.0f, 1e-3);
+}
+
+TEST_F(PROCESS_TABLE, TopListsAreBounded) {
+    for (int pid = 100; pid < 200; pid++)
+        writeProcess(pid, "p" + std::to_string(pid), 0, 1, static_cast<unsigned long long>(pid));
+
+    ProcessTable table(root.c_str(), 5);
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_EQ(table.processCount(), 100u);
+
+    const auto &top = table.topByMemory();
+    ASSERT_EQ(top.size(), 5u);
+    for (int i = 0; i < 5; i++)
+        EXPECT_EQ(top[i].pid, 199 - i);
+}
+
+TEST_F(PROCESS_TABLE, NameWithParentheses) {
+    writeProcess(5, "a) (b", 0, 1, 1);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+    EXPECT_STREQ(table.topByCpu()[0].name, "a) (b");
+}
+
+TEST_F(PROCESS_TABLE, FindsProcessesByName) {
+    writeProcess(20, "firefox", 0, 1, 1);
+    writeProcess(21, "Web Content", 0, 1, 1);
+    writeProcess(22, "Web Content", 0, 1, 1);
+    writeProcess(23, "WebExtensions", 0, 1, 1);
+
+    ProcessTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(0.0));
+
+    std::vector<int32_t> pids;
+    table.findByName("web content", 8, pids);
+    std::sort(pids.begin(), pids.end());
+    EXPECT_EQ(pids, (std::vector<int32_t>{21, 22}));
+
+    pids.clear();
+    table.findByName("Web*", 2, pids);
+    EXPECT_EQ(pids.size(), 2u);
+
+    pids.clear();
+    table.findByName("chrome", 8, pids);
+    EXPECT_TRUE(pids.empty());
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "flathashmap.h"
+#include "procwatch.h"
+
+namespace {
+
+/** A child blocked until its end of `hold` is closed, or until it is killed. */
+pid_t spawnHeld(int hold[2]) {
+    pid_t child = fork();
+    if (child == 0) {
+        char byte;
+        close(hold[1]);
+        (void) read(hold[0], &byte, 1);
+        _exit(0);
+    }
+    return child;
+}
+
+} // namespace
+
+TEST(FLAT_HASH_MAP, EraseKeepsProbeRunsReachable) {
+    FlatHashMap<int32_t, int> map;
+    for (int32_t key = 1; key <= 1000; key++)
+        map.insert(key, int{key * 2});
+
+    // Every other key, so the holes land in the middle of probe runs
+    for (int32_t key = 1; key <= 1000; key += 2)
+        EXPECT_TRUE(map.erase(key));
+    EXPECT_FALSE(map.erase(1));
+    EXPECT_FALSE(map.erase(5000));
+    EXPECT_EQ(map.size(), 500u);
+
+    for (int32_t key = 1; key <= 1000; key++) {
+        const int *value = map.find(key);
+        if (key % 2 == 1) {
+            EXPECT_EQ(value, nullptr) << key;
+        } else {
+            ASSERT_NE(value, nullptr) << key;
+            EXPECT_EQ(*value, key * 2);
+        }
+    }
+
+    map.insert(1, 7);
+    ASSERT_NE(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(1), 7);
+}
+
+TEST(PROCESS_WATCHER, ReportsExitAsEvent) {
+    ProcessWatcher watcher;
+    if (!watcher.isOpen())
+        GTEST_SKIP() << "pidfds are not supported here";
+
+    int hold[2];
+    ASSERT_EQ(pipe(hold), 0);
+    pid_t child = spawnHeld(hold);
+    ASSERT_GT(child, 0);
+    close(hold[0]);
+
+    EXPECT_TRUE(watcher.watch(child));
+    EXPECT_TRUE(watcher.watch(child));
+    EXPECT_EQ(watcher.watchedCount(), 1u);
+
+    // Alive: nothing to collect, and no waiting for it either
+    std::vector<int32_t> exited;
+    EXPECT_EQ(watcher.collectExits(exited), 0u);
+
+    close(hold[1]);
+    EXPECT_EQ(watcher.collectExits(exited, 5000), 1u);
+    ASSERT_EQ(exited.size(), 1u);
+    EXPECT_EQ(exited[0], child);
+    EXPECT_FALSE(watcher.watching(child));
+    EXPECT_EQ(watcher.watchedCount(), 0u);
+
+    // Exited but not reaped yet is still gone
+    EXPECT_TRUE(watcher.watch(child));
+    EXPECT_EQ(watcher.collectExits(exited, 5000), 1u);
+    waitpid(child, nullptr, 0);
+
+    EXPECT_FALSE(watcher.watch(child));
+    EXPECT_FALSE(watcher.watch(0));
+}
+
+TEST(PROCESS_WATCHER, UnwatchedExitsAreNotReported) {
+    ProcessWatcher watcher;
+    if (!watcher.isOpen())
+        GTEST_SKIP() << "pidfds are not supported here";
+
+    int hold[2];
+    ASSERT_EQ(pipe(hold), 0);
+    pid_t child = spawnHeld(hold);
+    ASSERT_GT(child, 0);
+    close(hold[0]);
+
+    ASSERT_TRUE(watcher.watch(child));
+    EXPECT_TRUE(watcher.unwatch(child));
+    EXPECT_FALSE(watcher.unwatch(child));
+
+    close(hold[1]);
+    waitpid(child, nullptr, 0);
+    std::vector<int32_t> exited;
+    EXPECT_EQ(watcher.collectExits(exited, 50), 0u);
+    EXPECT_TRUE(exited.empty());
+}
+
+TEST(PROCESS_WATCHER, ManyProcessesMoreThanOneBatch) {
+    ProcessWatcher watcher;
+    if (!watcher.isOpen())
+        GTEST_SKIP() << "pidfds are not supported here";
+
+    constexpr int CHILDREN = 3 * ProcessWatcher::EVENT_BATCH + 5;
+    int hold[2];
+    ASSERT_EQ(pipe(hold), 0);
+
+    std::vector<int32_t> children;
+    for (int i = 0; i < CHILDREN; i++) {
+        pid_t child = spawnHeld(hold);
+        ASSERT_GT(child, 0);
+        children.push_back(child);
+        ASSERT_TRUE(watcher.watch(child));
+    }
+    close(hold[0]);
+    EXPECT_EQ(watcher.watchedCount(), static_cast<size_t>(CHILDREN));
+
+    // Every child is released at once, all exits arrive and each is reported once
+    close(hold[1]);
+    for (int32_t child : children)
+        waitpid(child, nullptr, 0);
+
+    std::vector<int32_t> exited;
+    while (exited.size() < children.size() && watcher.collectExits(exited, 5000) > 0) {}
+    std::sort(exited.begin(), exited.end());
+    std::sort(children.begin(), children.end());
+    EXPECT_EQ(exited, children);
+    EXPECT_EQ(watcher.watchedCount(), 0u);
+}
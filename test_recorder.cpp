@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "telemetrycodec.h"
+#include "telemetryrecorder.h"
+
+namespace {
+
+const std::vector<TelemetryColumn> COLUMNS = {
+    {"cpu_use", TelemetryColumnKind::Gauge},
+    {"mem_used", TelemetryColumnKind::Counter},
+    {"cpu_proc_use", TelemetryColumnKind::Gauge},
+    {"missed_deadlines", TelemetryColumnKind::Counter},
+};
+
+struct Row {
+    int64_t timestamp;
+    double gauges[2];
+    uint64_t counters[2];
+};
+
+// 10 ms ticks with a little jitter, a noisy CPU load, slowly moving memory
+std::vector<Row> syntheticRows(size_t count) {
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<int> jitter(-40, 40);
+    std::uniform_real_distribution<double> noise(0.0, 0.05);
+
+    std::vector<Row> rows(count);
+    uint64_t mem = 8ull << 30;
+    for (size_t i = 0; i < count; i++) {
+        rows[i].timestamp = static_cast<int64_t>(i) * 10000 + jitter(random);
+        rows[i].gauges[0] = 0.25 + noise(random);
+        rows[i].gauges[1] = i % 100 < 50 ? 0.01 : 0.02;
+        mem += (random() % 16) * 4096;
+        rows[i].counters[0] = mem;
+        rows[i].counters[1] = i / 1000;
+    }
+    return rows;
+}
+
+std::string tempPath(const char *name) {
+    return std::string("/tmp/") + name + "." + std::to_string(std::random_device{}()) + ".hwrec";
+}
+
+std::vector<Row> readAll(const TelemetryReader &reader) {
+    std::vector<Row> rows;
+    TelemetryReader::Rows block;
+    for (size_t b = 0; b < reader.blockCount(); b++) {
+        EXPECT_TRUE(reader.readBlock(b, block));
+        for (size_t r = 0; r < block.timestamps.size(); r++) {
+            Row row {};
+            row.timestamp = block.timestamps[r];
+            row.gauges[0] = block.gauges[r * 2];
+            row.gauges[1] = block.gauges[r * 2 + 1];
+            row.counters[0] = block.counters[r * 2];
+            row.counters[1] = block.counters[r * 2 + 1];
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+void expectRowsEqual(const std::vector<Row> &expected, const std::vector<Row> &actual, size_t count) {
+    ASSERT_GE(actual.size(), count);
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(actual[i].timestamp, expected[i].timestamp) << "row " << i;
+        ASSERT_EQ(actual[i].gauges[0], expected[i].gauges[0]) << "row " << i;
+        ASSERT_EQ(actual[i].gauges[1], expected[i].gauges[1]) << "row " << i;
+        ASSERT_EQ(actual[i].counters[0], expected[i].counters[0]) << "row " << i;
+        ASSERT_EQ(actual[i].counters[1], expected[i].counters[1]) << "row " << i;
+    }
+}
+
+} // namespace
+
+TEST(TELEMETRY_CODEC, TimestampsRoundTrip) {
+    const std::vector<int64_t> values = {
+        -5, 0, 10000, 20000, 30001, 39990, 1ll << 40, -(1ll << 50), std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min(), 0, 100, 300, 2100,
+    };
+    std::vector<uint8_t> bytes;
+    TimestampEncoder encoder(bytes);
+    for (int64_t value : values)
+        encoder.append(value);
+
+    TimestampDecoder decoder(bytes.data(), bytes.size());
+    for (int64_t value : values) {
+        int64_t decoded;
+        ASSERT_TRUE(decoder.next(decoded));
+        EXPECT_EQ(decoded, value);
+    }
+}
+
+TEST(TELEMETRY_CODEC, RegularTimestampsTakeOneBit) {
+    std::vector<uint8_t> bytes;
+    TimestampEncoder encoder(bytes);
+    for (int64_t i = 0; i < 802; i++)
+        encoder.append(i * 10000);
+
+    // 64 bits raw, one full delta, then a zero bit per value
+    EXPECT_LE(bytes.size(), (64 + 68 + 800) / 8 + 1);
+}
+
+TEST(TELEMETRY_CODEC, GaugesRoundTripBitExact) {
+    const std::vector<double> values = {
+        0.0, 0.0, 0.25, 0.2500001, -1.5, 1e300, std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::infinity(), -0.0, 12.5, 12.5, 12.75,
+    };
+    std::vector<uint8_t> bytes;
+    GaugeEncoder encoder(bytes);
+    for (double value : values)
+        encoder.append(value);
+
+    GaugeDecoder decoder(bytes.data(), bytes.size());
+    for (double value : values) {
+        double decoded;
+        ASSERT_TRUE(decoder.next(decoded));
+        if (std::isnan(value)) {
+            EXPECT_TRUE(std::isnan(decoded));
+        } else {
+            EXPECT_EQ(decoded, value);
+            EXPECT_EQ(std::signbit(decoded), std::signbit(value));
+        }
+    }
+}
+
+TEST(TELEMETRY_CODEC, CountersWrapAround) {
+    const std::vector<uint64_t> values = {0, 5, 3, ~0ull, 0, 1ull << 63, 12345678901234ull};
+    std::vector<uint8_t> bytes;
+    CounterEncoder encoder(bytes);
+    for (uint64_t value : values)
+        encoder.append(value);
+
+    CounterDecoder decoder(bytes.data(), bytes.size());
+    for (uint64_t value : values) {
+        uint64_t decoded;
+        ASSERT_TRUE(decoder.next(decoded));
+        EXPECT_EQ(decoded, value);
+    }
+    uint64_t extra;
+    EXPECT_FALSE(decoder.next(extra));
+}
+
+TEST(TELEMETRY_RECORDER, RoundTripWithFooter) {
+    const auto rows = syntheticRows(20000);
+    const std::string path = tempPath("roundtrip");
+
+    TelemetryRecorder recorder;
+    ASSERT_TRUE(recorder.open(path, COLUMNS, 1700000000000000));
+    for (const auto &row : rows)
+        ASSERT_TRUE(recorder.append(row.timestamp, row.gauges, row.counters));
+    recorder.close();
+
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.recoveredIndex());
+    EXPECT_EQ(reader.originUnixUs(), 1700000000000000);
+    ASSERT_EQ(reader.columnList().size(), COLUMNS.size());
+    EXPECT_EQ(reader.columnList()[2].name, "cpu_proc_use");
+    EXPECT_EQ(reader.gaugeCount(), 2u);
+
+    const auto decoded = readAll(reader);
+    ASSERT_EQ(decoded.size(), rows.size());
+    expectRowsEqual(rows, decoded, rows.size());
+
+    // Bytes per sample per metric, timestamps included in the metrics' share
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    std::fseek(file, 0, SEEK_END);
+    double bytes_per_value = static_cast<double>(std::ftell(file)) / (rows.size() * COLUMNS.size());
+    std::fclose(file);
+    std::remove(path.c_str());
+    EXPECT_LT(bytes_per_value, 4.0);
+}
+
+// Copy the file while the recorder is still running, as if the process died right there
+TEST(TELEMETRY_RECORDER, CrashLosesAtMostOneBlock) {
+    const auto rows = syntheticRows(5000);
+    const std::string path = tempPath("crash");
+    const std::string crashed = path + ".crashed";
+
+    TelemetryRecorder recorder;
+    ASSERT_TRUE(recorder.open(path, COLUMNS, 0));
+    for (const auto &row : rows)
+        ASSERT_TRUE(recorder.append(row.timestamp, row.gauges, row.counters));
+    ASSERT_GT(recorder.blockCount(), 2u);
+
+    std::FILE *in = std::fopen(path.c_str(), "rb");
+    std::FILE *out = std::fopen(crashed.c_str(), "wb");
+    char buffer[4096];
+    size_t read_size;
+    while ((read_size = std::fread(buffer, 1, sizeof(buffer), in)) > 0)
+        std::fwrite(buffer, 1, read_size, out);
+    // A torn write of the next block
+    std::fwrite(buffer, 1, 1000, out);
+    std::fclose(in);
+    std::fclose(out);
+    recorder.close();
+
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(crashed));
+    EXPECT_TRUE(reader.recoveredIndex());
+    EXPECT_EQ(reader.blockCount(), recorder.blockCount() - 1);
+
+    const auto decoded = readAll(reader);
+    expectRowsEqual(rows, decoded, decoded.size());
+    size_t lost = rows.size() - decoded.size();
+    EXPECT_LE(lost, reader.blockInfo(0).rows * 2);
+
+    std::remove(path.c_str());
+    std::remove(crashed.c_str());
+}
+
+TEST(TELEMETRY_RECORDER, CorruptBlockEndsRecovery) {
+    const auto rows = syntheticRows(3000);
+    const std::string path = tempPath("corrupt");
+
+    TelemetryRecorder recorder;
+    ASSERT_TRUE(recorder.open(path, COLUMNS, 0));
+    for (const auto &row : rows)
+        recorder.append(row.timestamp, row.gauges, row.counters);
+    recorder.close();
+    ASSERT_GE(recorder.blockCount(), 3u);
+
+    // Flip a byte in the second block and drop the footer
+    TelemetryReader intact;
+    ASSERT_TRUE(intact.open(path));
+    std::vector<char> contents;
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    char buffer[4096];
+    size_t read_size;
+    while ((read_size = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        contents.insert(contents.end(), buffer, buffer + read_size);
+    std::fclose(file);
+
+    size_t footer = contents.size() - intact.blockCount() * telemetry_format::INDEX_ENTRY_SIZE - 8;
+    size_t second_block = footer - (intact.blockCount() - 1) * telemetry_format::BLOCK_SIZE;
+    contents[second_block + 100] ^= 0x5A;
+    file = std::fopen(path.c_str(), "wb");
+    std::fwrite(contents.data(), 1, footer, file);
+    std::fclose(file);
+
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_TRUE(reader.recoveredIndex());
+    EXPECT_EQ(reader.blockCount(), 1u);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "replaysource.h"
+
+namespace {
+
+constexpr auto INTERVAL = std::chrono::milliseconds(10);
+constexpr double INTERVAL_US = 10000.0;
+
+std::vector<SampleFrame> play(SampleSource &source, size_t ticks) {
+    std::vector<SampleFrame> frames;
+    SampleFrame frame {};
+    while (frames.size() < ticks && source.sample(frame))
+        frames.push_back(frame);
+    return frames;
+}
+
+std::string tempPath(const char *name) {
+    return std::string("/tmp/") + name + "." + std::to_string(std::random_device{}()) + ".hwrec";
+}
+
+// Column layout of DataManager::telemetryColumns, in a shuffled order with one column left out
+const std::vector<TelemetryColumn> RECORDED_COLUMNS = {
+    {"mem_used", TelemetryColumnKind::Counter},
+    {"cpu_use", TelemetryColumnKind::Gauge},
+    {"mem_total", TelemetryColumnKind::Counter},
+    {"cpu_proc_use", TelemetryColumnKind::Gauge},
+    {"elapsed_ms", TelemetryColumnKind::Gauge},
+};
+
+struct RecordedTick {
+    int64_t timestamp_us;
+    double cpu_use;
+    double cpu_proc_use;
+    uint64_t mem_used;
+    uint64_t mem_total;
+};
+
+std::vector<RecordedTick> writeTrace(const std::string &path, size_t ticks) {
+    std::vector<RecordedTick> recorded;
+    TelemetryRecorder recorder;
+    EXPECT_TRUE(recorder.open(path, RECORDED_COLUMNS, 0));
+    for (size_t i = 0; i < ticks; i++) {
+        RecordedTick tick {};
+        tick.timestamp_us = static_cast<int64_t>(i) * 10000 + (i % 3) * 7;
+        tick.cpu_use = 0.1 + 0.8 * static_cast<double>(i % 17) / 16;
+        tick.cpu_proc_use = 0.5 * static_cast<double>(i % 5) / 4;
+        tick.mem_used = (4ull << 30) + i * 4096;
+        tick.mem_total = 16ull << 30;
+        recorded.push_back(tick);
+
+        const double gauges[] = {tick.cpu_use, tick.cpu_proc_use, 10.0};
+        const uint64_t counters[] = {tick.mem_used, tick.mem_total};
+        recorder.append(tick.timestamp_us, gauges, counters);
+    }
+    recorder.close();
+    return recorded;
+}
+
+} // namespace
+
+TEST(SYNTHETIC_SOURCE, SameSeedSameTrace) {
+    SyntheticSampleSource first(SyntheticPattern::Spikes, 16, INTERVAL, 0, ReplaySpeed::AsFastAsPossible, 7);
+    SyntheticSampleSource second(SyntheticPattern::Spikes, 16, INTERVAL, 0, ReplaySpeed::AsFastAsPossible, 7);
+    SyntheticSampleSource other(SyntheticPattern::Spikes, 16, INTERVAL, 0, ReplaySpeed::AsFastAsPossible, 8);
+
+    auto a = play(first, 600);
+    auto b = play(second, 600);
+    auto c = play(other, 600);
+    ASSERT_EQ(a.size(), 600u);
+    ASSERT_EQ(b.size(), 600u);
+
+    bool differs = false;
+    for (size_t i = 0; i < a.size(); i++) {
+        EXPECT_EQ(a[i].time_us, b[i].time_us);
+        EXPECT_EQ(a[i].cpu_time, b[i].cpu_time);
+        EXPECT_EQ(a[i].process_time, b[i].process_time);
+        EXPECT_EQ(a[i].mem_available, b[i].mem_available);
+        EXPECT_EQ(a[i].process_changed, b[i].process_changed);
+        differs |= a[i].cpu_time != c[i].cpu_time;
+    }
+    EXPECT_TRUE(differs);
+
+    // The foreground process switches on a fixed schedule
+    EXPECT_TRUE(a[0].process_changed);
+    EXPECT_STREQ(a[0].process_name, "synthetic-a");
+    EXPECT_TRUE(a[500].process_changed);
+    EXPECT_STREQ(a[500].process_name, "synthetic-b");
+}
+
+TEST(SYNTHETIC_SOURCE, ManyCoresGoThroughTheParser) {
+    SyntheticSampleSource source(SyntheticPattern::Ramp, 256, INTERVAL, 0, ReplaySpeed::AsFastAsPossible);
+    EXPECT_EQ(source.logicalCores(), 256u);
+
+    SampleFrame previous {};
+    SampleFrame frame {};
+    ASSERT_TRUE(source.sample(previous));
+    ASSERT_TRUE(source.sample(frame));
+
+    const CpuCoreStats &stats = source.coreStats();
+    ASSERT_EQ(stats.coreCount(), 256u);
+
+    // The aggregate counters agree with the per-core ratios the parser computed
+    double mean = 0.0;
+    for (size_t core = 0; core < stats.coreCount(); core++)
+        mean += stats.busy()[core];
+    mean /= stats.coreCount();
+    double aggregate = (frame.cpu_time - previous.cpu_time) / (INTERVAL_US * 256);
+    EXPECT_NEAR(aggregate, mean, 1e-3);
+
+    // Cores are spread over the whole ramp
+    EXPECT_GT(stats.maxBusy(), 0.99f);
+    EXPECT_GT(stats.coresAbove(0.5f), 100u);
+    EXPECT_LT(stats.coresAbove(0.5f), 156u);
+}
+
+TEST(SYNTHETIC_SOURCE, SpikesSaturateEveryCore) {
+    SyntheticSampleSource source(SyntheticPattern::Spikes, 32, INTERVAL, 0, ReplaySpeed::AsFastAsPossible);
+    auto frames = play(source, 102);
+    ASSERT_EQ(frames.size(), 102u);
+
+    // Ticks 100 and 101 are inside the second spike
+    EXPECT_EQ(source.coreStats().coresAbove(0.99f), 32u);
+    double spike = (frames[101].cpu_time - frames[100].cpu_time) / (INTERVAL_US * 32);
+    double quiet = (frames[51].cpu_time - frames[50].cpu_time) / (INTERVAL_US * 32);
+    EXPECT_NEAR(spike, 1.0, 1e-6);
+    EXPECT_LT(quiet, 0.2);
+
+    ASSERT_TRUE(source.updateProcessTable(0.01));
+    EXPECT_EQ(source.topCpuProcesses().size(), 10u);
+    EXPECT_GE(source.topCpuProcesses()[0].cpu_use, source.topCpuProcesses()[1].cpu_use);
+}
+
+TEST(SYNTHETIC_SOURCE, StopsAtTheTickLimit) {
+    SyntheticSampleSource source(SyntheticPattern::Ramp, 4, INTERVAL, 25, ReplaySpeed::AsFastAsPossible);
+    EXPECT_EQ(play(source, 100).size(), 25u);
+
+    SampleFrame frame {};
+    EXPECT_FALSE(source.sample(frame));
+}
+
+TEST(TRACE_SOURCE, ReplaysRecordedValues) {
+    const std::string path = tempPath("replay");
+    const auto recorded = writeTrace(path, 1500);
+
+    TraceSampleSource source(ReplaySpeed::AsFastAsPossible);
+    ASSERT_TRUE(source.open(path));
+    EXPECT_EQ(source.logicalCores(), 1u);
+    EXPECT_EQ(source.name(), path.substr(5));
+
+    auto frames = play(source, 2000);
+    ASSERT_EQ(frames.size(), recorded.size());
+    EXPECT_STREQ(frames[0].process_name, source.name().c_str());
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        EXPECT_EQ(frames[i].time_us, recorded[i].timestamp_us);
+        EXPECT_EQ(frames[i].mem_total, recorded[i].mem_total);
+        EXPECT_EQ(frames[i].mem_total - frames[i].mem_available, recorded[i].mem_used);
+        // Not recorded
+        EXPECT_EQ(frames[i].process_memory, 0u);
+    }
+
+    // What DataManager computes from the rebuilt counters is the recorded utilization
+    for (size_t i = 1; i < frames.size(); i++) {
+        double elapsed_us = static_cast<double>(frames[i].time_us - frames[i - 1].time_us);
+        double cpu_diff = static_cast<double>(frames[i].cpu_time - frames[i - 1].cpu_time);
+        double proc_diff = static_cast<double>(frames[i].process_time - frames[i - 1].process_time);
+        EXPECT_NEAR(cpu_diff / elapsed_us, recorded[i].cpu_use, 2e-4) << "tick " << i;
+        if (cpu_diff > 0) {
+            EXPECT_NEAR(proc_diff / cpu_diff, recorded[i].cpu_proc_use, 2e-3) << "tick " << i;
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TRACE_SOURCE, RealtimeKeepsTheRecordedPace) {
+    const std::string path = tempPath("pace");
+    writeTrace(path, 6);
+
+    TraceSampleSource source(ReplaySpeed::Realtime);
+    ASSERT_TRUE(source.open(path));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(play(source, 6).size(), 6u);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::microseconds(50000));
+    std::remove(path.c_str());
+}
+
+TEST(TRACE_SOURCE, RejectsOtherFiles) {
+    const std::string path = tempPath("garbage");
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    std::fputs("not a recording", file);
+    std::fclose(file);
+
+    TraceSampleSource source(ReplaySpeed::AsFastAsPossible);
+    EXPECT_FALSE(source.open(path));
+    EXPECT_FALSE(source.open(path + ".missing"));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "rollingstats.h"
+
+namespace {
+
+struct Point {
+    double timestamp_ms;
+    double value;
+};
+
+/** The same statistics straight from every sample newer than `window_ms` before the last one. */
+RollingSummary bruteForce(const std::vector<Point> &points, double window_ms) {
+    std::vector<double> values;
+    const double cutoff_ms = points.back().timestamp_ms - window_ms;
+    for (const Point &point : points) {
+        if (point.timestamp_ms > cutoff_ms || &point == &points.back())
+            values.push_back(point.value);
+    }
+    std::sort(values.begin(), values.end());
+
+    RollingSummary summary {};
+    summary.window_ms = window_ms;
+    summary.count = static_cast<uint32_t>(values.size());
+    summary.min = values.front();
+    summary.max = values.back();
+    double sum = 0.0;
+    for (double value : values)
+        sum += value;
+    summary.mean = sum / values.size();
+    summary.p95 = values[static_cast<size_t>(std::ceil(0.95 * values.size())) - 1];
+    summary.p99 = values[static_cast<size_t>(std::ceil(0.99 * values.size())) - 1];
+    return summary;
+}
+
+} // namespace
+
+TEST(ROLLING_STATS, EmptyWindowsReportZero) {
+    RollingStats stats({1000.0, 10000.0}, 0.0, 100.0);
+    ASSERT_EQ(stats.windowCount(), 2u);
+
+    const RollingSummary summary = stats.summary(1);
+    EXPECT_EQ(summary.window_ms, 10000.0);
+    EXPECT_EQ(summary.count, 0u);
+    EXPECT_EQ(summary.max, 0.0);
+    EXPECT_EQ(summary.p99, 0.0);
+}
+
+TEST(ROLLING_STATS, WindowsEvictIndependently) {
+    RollingStats stats({1000.0, 3000.0}, 0.0, 100.0);
+    // One sample every 500 ms, the peak at 0 ms leaves the short window long before the long one
+    stats.push(0.0, 90.0);
+    for (int tick = 1; tick <= 4; tick++)
+        stats.push(tick * 500.0, 10.0 * tick);
+
+    const RollingSummary short_window = stats.summary(0);
+    EXPECT_EQ(short_window.count, 2u);
+    EXPECT_DOUBLE_EQ(short_window.min, 30.0);
+    EXPECT_DOUBLE_EQ(short_window.max, 40.0);
+    EXPECT_DOUBLE_EQ(short_window.mean, 35.0);
+
+    const RollingSummary long_window = stats.summary(1);
+    EXPECT_EQ(long_window.count, 5u);
+    EXPECT_DOUBLE_EQ(long_window.min, 10.0);
+    EXPECT_DOUBLE_EQ(long_window.max, 90.0);
+    EXPECT_DOUBLE_EQ(long_window.mean, 38.0);
+    EXPECT_DOUBLE_EQ(long_window.p99, 90.0);
+}
+
+TEST(ROLLING_STATS, QuantilesWithinOneBucket) {
+    RollingStats stats({60000.0}, 0.0, 100.0);
+    for (int i = 1; i <= 1000; i++)
+        stats.push(i, i / 10.0);
+
+    const double bucket_width = 100.0 / RollingStats::BUCKETS;
+    const RollingSummary summary = stats.summary(0);
+    EXPECT_NEAR(summary.p95, 95.0, bucket_width);
+    EXPECT_NEAR(summary.p99, 99.0, bucket_width);
+    EXPECT_GE(summary.p95, 95.0);
+    EXPECT_LE(summary.p99, summary.max);
+}
+
+TEST(ROLLING_STATS, OutOfRangeValuesKeepExactExtremes) {
+    RollingStats stats({1000.0}, 0.0, 1.0);
+    stats.push(0.0, -5.0);
+    stats.push(1.0, 7.0);
+
+    const RollingSummary summary = stats.summary(0);
+    EXPECT_DOUBLE_EQ(summary.min, -5.0);
+    EXPECT_DOUBLE_EQ(summary.max, 7.0);
+    EXPECT_DOUBLE_EQ(summary.p99, 7.0);
+}
+
+TEST(ROLLING_STATS, ClearForgetsSamples) {
+    RollingStats stats({1000.0}, 0.0, 100.0);
+    stats.push(0.0, 80.0);
+    stats.clear();
+    stats.push(5000.0, 20.0);
+
+    const RollingSummary summary = stats.summary(0);
+    EXPECT_EQ(summary.count, 1u);
+    EXPECT_DOUBLE_EQ(summary.max, 20.0);
+}
+
+// Uneven spacing, bursts faster than the initial capacity and the interval changing under the windows must all match
+// a recount from scratch
+TEST(ROLLING_STATS, MatchesBruteForceOnIrregularSamples) {
+    const double windows_ms[] = {50.0, 400.0, 2000.0};
+    RollingStats stats({windows_ms[0], windows_ms[1], windows_ms[2]}, 0.0, 100.0);
+    const double bucket_width = 100.0 / RollingStats::BUCKETS;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> value(0.0, 100.0);
+    std::uniform_real_distribution<double> gap(0.0, 20.0);
+    std::vector<Point> points;
+    double now_ms = 0.0;
+
+    for (int i = 0; i < 5000; i++) {
+        // Every so often a burst of samples at the same instant
+        now_ms += i % 500 < 50 ? 0.0 : gap(random);
+        points.push_back({now_ms, value(random)});
+        stats.push(now_ms, points.back().value);
+        if (i % 97 != 0)
+            continue;
+
+        for (size_t window = 0; window < 3; window++) {
+            const RollingSummary expected = bruteForce(points, windows_ms[window]);
+            const RollingSummary actual = stats.summary(window);
+            ASSERT_EQ(actual.count, expected.count) << "tick " << i << " window " << window;
+            EXPECT_DOUBLE_EQ(actual.min, expected.min);
+            EXPECT_DOUBLE_EQ(actual.max, expected.max);
+            EXPECT_NEAR(actual.mean, expected.mean, 1e-9);
+            EXPECT_NEAR(actual.p95, expected.p95, bucket_width);
+            EXPECT_NEAR(actual.p99, expected.p99, bucket_width);
+        }
+    }
+}
+
+TEST(ROLLING_MAX, MatchesRollingStats) {
+    const double window_ms = 400.0;
+    RollingMax peak(window_ms);
+    RollingStats stats({window_ms}, 0.0, 1.0);
+    EXPECT_EQ(peak.max(), 0.0);
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> value(0.0, 1e9);
+    std::uniform_real_distribution<double> gap(0.0, 50.0);
+    double now_ms = 0.0;
+    for (int i = 0; i < 5000; i++) {
+        now_ms += i % 300 < 30 ? 0.0 : gap(random);
+        const double sample = value(random);
+        peak.push(now_ms, sample);
+        stats.push(now_ms, sample);
+        ASSERT_DOUBLE_EQ(peak.max(), stats.summary(0).max) << "tick " << i;
+    }
+
+    peak.clear();
+    EXPECT_EQ(peak.max(), 0.0);
+    peak.push(now_ms, 5.0);
+    peak.push(now_ms + window_ms, 1.0);
+    EXPECT_EQ(peak.max(), 1.0);
+}
@@ -0,0 +1,396 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "procdata.h"
+
+/*
+ * Counts the syscalls of one DataManager tick, before and after ProcData::sample.
+ * The work runs in a forked child traced with ptrace, counting starts and stops at a getppid marker so the setup
+ * (constructing ProcData, opening descriptors, a first warm-up tick) is not included.
+ */
+
+namespace {
+
+constexpr int TICKS = 10;
+
+/** @return Syscalls made by `work` in a traced child, or -1 if the child could not be traced. */
+long countSyscalls(const std::function<void(ProcData&)> &work) {
+    pid_t child = fork();
+    if (child < 0)
+        return -1;
+
+    if (child == 0) {
+        ProcData data_source;
+        work(data_source);
+
+        if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) != 0)
+            _exit(1);
+        raise(SIGSTOP);
+
+        syscall(SYS_getppid);
+        for (int i = 0; i < TICKS; i++)
+            work(data_source);
+        syscall(SYS_getppid);
+        _exit(0);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFSTOPPED(status))
+        return -1;
+    ptrace(PTRACE_SETOPTIONS, child, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+    long count = 0;
+    int markers = 0;
+    for (;;) {
+        if (ptrace(PTRACE_SYSCALL, child, nullptr, nullptr) != 0 || waitpid(child, &status, 0) < 0)
+            return -1;
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            break;
+        if (!WIFSTOPPED(status) || WSTOPSIG(status) != (SIGTRAP | 0x80))
+            continue;
+
+        __ptrace_syscall_info info {};
+        if (ptrace(PTRACE_GET_SYSCALL_INFO, child, sizeof(info), &info) <= 0)
+            return -1;
+        if (info.op != PTRACE_SYSCALL_INFO_ENTRY)
+            continue;
+
+        if (info.entry.nr == SYS_getppid)
+            markers++;
+        else if (markers == 1)
+            count++;
+    }
+    return markers == 2 ? count : -1;
+}
+
+/** What `hwinfo::Memory` did every tick: a fresh std::ifstream over /proc/meminfo. */
+unsigned long long legacyAvailableMemory() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    unsigned long long value = 0;
+    while (meminfo >> key >> value) {
+        if (key == "MemAvailable:")
+            return value;
+        meminfo.ignore(64, '\n');
+    }
+    return 0;
+}
+
+/** Fork a child that burns CPU until killed. */
+pid_t spawnSpinner() {
+    pid_t child = fork();
+    if (child == 0) {
+        for (volatile unsigned long spin = 0;; spin++) {}
+    }
+    return child;
+}
+
+/** Keep the calling thread busy for `duration` of wall time. */
+void spin(std::chrono::milliseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    volatile unsigned long long spins = 0;
+    while (std::chrono::steady_clock::now() < end)
+        spins = spins + 1;
+}
+
+} // namespace
+
+TEST(SAMPLE, FillsEveryField) {
+    ProcData data_source;
+    SampleFrame frame {};
+    // Process time counts in clock ticks, a freshly started test may not have used one yet
+    spin(std::chrono::milliseconds(50));
+
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_EQ(frame.process, getpid());
+    EXPECT_TRUE(frame.process_changed);
+    EXPECT_GT(frame.mem_total, 0u);
+    EXPECT_GT(frame.mem_available, 0u);
+    EXPECT_GT(frame.cpu_time, 0u);
+    EXPECT_GT(frame.process_time, 0u);
+    EXPECT_GT(frame.process_memory, 0u);
+    EXPECT_EQ(std::string(frame.process_name), data_source.getFgProcessName());
+
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_FALSE(frame.process_changed);
+}
+
+// Every thread counts towards the process, not only the main one
+TEST(SAMPLE, ProcessTimeSumsAllThreads) {
+    constexpr int SPINNERS = 3;
+    const auto duration = std::chrono::milliseconds(300);
+
+    ProcData data_source;
+    SampleFrame frame {};
+    ASSERT_TRUE(data_source.sample(frame));
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> spinners;
+    for (int i = 0; i < SPINNERS; i++)
+        spinners.emplace_back(spin, duration);
+    for (std::thread &spinner : spinners)
+        spinner.join();
+
+    ASSERT_TRUE(data_source.sample(frame));
+    const auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    ASSERT_TRUE(frame.process_delta_valid);
+    // The main thread only waits, on its own it would account for next to nothing. Generous, a loaded machine may not
+    // give every spinner a whole core.
+    const unsigned busy_cores = std::max(1u, std::min<unsigned>(SPINNERS, std::thread::hardware_concurrency()));
+    EXPECT_GT(static_cast<double>(frame.process_time_delta), 0.5 * busy_cores * static_cast<double>(elapsed_us));
+}
+
+TEST(SAMPLE, ReadsMemoryBreakdown) {
+    ProcData data_source;
+    SampleFrame frame {};
+    ASSERT_TRUE(data_source.sample(frame));
+    if (!frame.process_breakdown.detailed)
+        GTEST_SKIP() << "smaps_rollup is not available here";
+
+    const MemoryBreakdown &breakdown = frame.process_breakdown;
+    EXPECT_EQ(breakdown.rss, frame.process_memory);
+    EXPECT_GT(breakdown.pss, 0u);
+    EXPECT_GT(breakdown.uss, 0u);
+    EXPECT_LE(breakdown.uss, breakdown.pss);
+
+    // Not read again until the interval is up, the next sample reports the same numbers
+    std::vector<char> ballast(32 << 20, 1);
+    ASSERT_TRUE(data_source.sample(frame));
+    EXPECT_EQ(frame.process_breakdown.pss, breakdown.pss);
+    EXPECT_EQ(frame.process_breakdown.uss, breakdown.uss);
+    EXPECT_EQ(ballast[ballast.size() / 2], 1);
+}
+
+TEST(SAMPLE, TargetExitDropsProcessState) {
+    ProcData data_source;
+    if (data_source.exitDescriptor() < 0)
+        GTEST_SKIP() << "pidfds are not supported here";
+
+    int hold[2];
+    ASSERT_EQ(pipe(hold), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        char byte;
+        close(hold[1]);
+        (void) read(hold[0], &byte, 1);
+        _exit(0);
+    }
+    close(hold[0]);
+
+    SampleFrame frame {};
+    data_source.setTargetPid(child);
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_EQ(frame.process, child);
+
+    close(hold[1]);
+    pollfd exit_event {data_source.exitDescriptor(), POLLIN, 0};
+    ASSERT_EQ(poll(&exit_event, 1, 5000), 1);
+    data_source.handleProcessExits();
+
+    // Dropped on the event, not found out by a failing read; the still unreaped PID is not reopened either
+    EXPECT_EQ(data_source.getFgProcHandle(), 0);
+    EXPECT_FALSE(data_source.sample(frame));
+    EXPECT_EQ(frame.process, 0);
+    waitpid(child, nullptr, 0);
+
+    data_source.setTargetPid(getpid());
+    EXPECT_EQ(data_source.getFgProcHandle(), getpid());
+}
+
+TEST(SAMPLE, FocusSwitchBetweenWatchedProcessesKeepsDeltas) {
+    using namespace std::chrono;
+
+    pid_t spinner = spawnSpinner();
+    ASSERT_GT(spinner, 0);
+
+    ProcData data_source;
+    data_source.setWatchTargets({WatchTarget::byPid(spinner), WatchTarget::byPid(getpid())});
+    SampleFrame frame {};
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_FALSE(frame.process_delta_valid);
+
+    // Focus moves to the spinner, which was read on the previous sample as one of the watched targets
+    std::this_thread::sleep_for(50ms);
+    data_source.setTargetPid(spinner);
+    const auto start = steady_clock::now();
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_TRUE(frame.process_changed);
+    EXPECT_TRUE(frame.process_delta_valid);
+    EXPECT_GT(frame.process_time_delta, 0u);
+    ASSERT_EQ(frame.watch_count, 2u);
+    EXPECT_EQ(frame.watches[0].pid, spinner);
+    EXPECT_EQ(frame.watches[0].time_delta, frame.process_time_delta);
+
+    // Back and forth, every switch has its delta against the previous sample and no more than a core's worth of it
+    auto previous = start;
+    for (int tick = 0; tick < 4; tick++) {
+        std::this_thread::sleep_for(20ms);
+        data_source.setTargetPid(tick % 2 == 0 ? getpid() : spinner);
+        const auto before = steady_clock::now();
+        EXPECT_TRUE(data_source.sample(frame));
+        const auto after = steady_clock::now();
+        EXPECT_TRUE(frame.process_delta_valid) << tick;
+        const auto wall_us = static_cast<unsigned long long>(duration_cast<microseconds>(after - previous).count());
+        EXPECT_LE(frame.watches[0].time_delta, wall_us) << tick;
+        previous = before;
+    }
+
+    kill(spinner, SIGKILL);
+    waitpid(spinner, nullptr, 0);
+}
+
+TEST(SAMPLE, FocusOnUnwatchedProcessStartsWithoutDelta) {
+    ProcData data_source;
+    SampleFrame frame {};
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_TRUE(frame.process_delta_valid);
+
+    // Nothing read the parent on the previous sample, there is nothing to take a delta against
+    data_source.setTargetPid(getppid());
+    if (!data_source.sample(frame) || frame.process != getppid())
+        GTEST_SKIP() << "the parent process is not readable here";
+    EXPECT_FALSE(frame.process_delta_valid);
+    EXPECT_EQ(frame.process_time_delta, 0u);
+    EXPECT_TRUE(data_source.sample(frame));
+    EXPECT_TRUE(frame.process_delta_valid);
+}
+
+TEST(SAMPLE, WatchesByName) {
+    ProcData data_source;
+    SampleFrame frame {};
+    data_source.setWatchTargets({WatchTarget::byName("test_sampl?"), WatchTarget::byName("no-such-process*")});
+
+    // Names resolve against the process table of the previous refresh
+    ASSERT_TRUE(data_source.updateProcessTable(0.0));
+    data_source.sample(frame);
+    ASSERT_EQ(frame.watch_count, 2u);
+    EXPECT_GE(frame.watches[0].matches, 1u);
+    EXPECT_STREQ(frame.watches[0].name, "test_sample");
+    EXPECT_GT(frame.watches[0].memory, 0u);
+    EXPECT_EQ(frame.watches[1].matches, 0u);
+}
+
+TEST(SAMPLE, ReadsIoOfForegroundAndWatches) {
+    if (access("/proc/self/io", R_OK) != 0)
+        GTEST_SKIP() << "no I/O accounting here";
+
+    ProcData data_source;
+    SampleFrame frame {};
+    data_source.setWatchTargets({WatchTarget::byPid(getpid())});
+    ASSERT_TRUE(data_source.sample(frame));
+    data_source.updateIo(0.0);
+    EXPECT_EQ(data_source.getForegroundIo().read_ops, 0.0);
+    ASSERT_EQ(data_source.getWatchIo().size(), 1u);
+
+    // Read system calls count towards the operations whether or not they reach a disk
+    constexpr int READS = 100;
+    int zero = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(zero, 0);
+    char byte;
+    for (int i = 0; i < READS; i++)
+        ASSERT_EQ(read(zero, &byte, 1), 1);
+    close(zero);
+
+    ASSERT_TRUE(data_source.sample(frame));
+    data_source.updateIo(1.0);
+    EXPECT_GE(data_source.getForegroundIo().read_ops, READS);
+    EXPECT_GE(data_source.getWatchIo()[0].read_ops, READS);
+}
+
+TEST(SAMPLE, WatchedPidEndsWithItsProcess) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+
+    ProcData data_source;
+    SampleFrame frame {};
+    data_source.setWatchTargets({WatchTarget::byPid(child)});
+    data_source.sample(frame);
+    EXPECT_EQ(frame.watches[0].matches, 1u);
+
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    if (data_source.exitDescriptor() >= 0) {
+        pollfd exit_event {data_source.exitDescriptor(), POLLIN, 0};
+        ASSERT_EQ(poll(&exit_event, 1, 5000), 1);
+        data_source.handleProcessExits();
+    }
+
+    // Gone for good, whether it was the event or the failing read that said so
+    data_source.sample(frame);
+    data_source.sample(frame);
+    EXPECT_EQ(frame.watches[0].matches, 0u);
+    EXPECT_EQ(frame.watches[0].pid, 0);
+}
+
+TEST(SAMPLE, FocusSwitchBetweenWatchedProcessesReopensNothing) {
+    const pid_t parent = getpid();
+    bool warm = false;
+    pid_t self = 0;
+    int tick = 0;
+
+    // Toggle the target between the test process and the traced child, both watched
+    long switching = countSyscalls([&](ProcData &data_source) {
+        if (!warm) {
+            self = getpid();
+            data_source.setWatchTargets({WatchTarget::byPid(parent), WatchTarget::byPid(self)});
+            SampleFrame frame;
+            data_source.setTargetPid(parent);
+            data_source.sample(frame);
+            warm = true;
+        }
+        data_source.setTargetPid(tick++ % 2 == 0 ? self : parent);
+        SampleFrame frame;
+        data_source.sample(frame);
+    });
+    if (switching < 0)
+        GTEST_SKIP() << "ptrace is not permitted here";
+
+    // /proc/stat, /proc/meminfo, and stat and statm of both processes; reopening would be eight more at least
+    EXPECT_LE(switching, 6 * TICKS) << "syscalls per switching tick: " << static_cast<double>(switching) / TICKS;
+}
+
+TEST(SAMPLE, FewerSyscallsPerTick) {
+    // The calls DataManager::update used to make
+    long legacy = countSyscalls([](ProcData &data_source) {
+        legacyAvailableMemory();
+        data_source.getFgProcessMemory();
+        data_source.getTotalCpuTime();
+        data_source.getTotalProcessTime();
+        data_source.getFgProcHandle();
+    });
+
+    long batched = countSyscalls([](ProcData &data_source) {
+        SampleFrame frame;
+        data_source.sample(frame);
+    });
+
+    if (legacy < 0 || batched < 0)
+        GTEST_SKIP() << "ptrace is not permitted here";
+
+    // One pread each for /proc/stat, /proc/meminfo, stat and statm, comm is only read when the process changes
+    EXPECT_LE(batched, 4 * TICKS) << "syscalls per tick: " << static_cast<double>(batched) / TICKS;
+    EXPECT_LT(batched, legacy);
+}
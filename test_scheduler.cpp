@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "scheduler.h"
+
+using namespace std::chrono_literals;
+using std::chrono::steady_clock;
+
+TEST(SCHEDULER, ClampsInterval) {
+    EXPECT_EQ(SampleScheduler::clampInterval(0ms), SampleScheduler::MIN_INTERVAL);
+    EXPECT_EQ(SampleScheduler::clampInterval(1h), SampleScheduler::MAX_INTERVAL);
+    EXPECT_EQ(SampleScheduler::clampInterval(250ms), 250ms);
+}
+
+// The old sleep_for loop took interval + work per period, deadlines on a grid only take the interval.
+TEST(SCHEDULER, WorkDoesNotStretchThePeriod) {
+    constexpr int periods = 40;
+    SampleScheduler scheduler(10ms);
+
+    auto start = steady_clock::now();
+    for (int i = 0; i < periods; i++) {
+        ASSERT_TRUE(scheduler.wait());
+        std::this_thread::sleep_for(4ms);
+    }
+    auto elapsed = steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, periods * 10ms + 60ms);
+    EXPECT_GE(elapsed, periods * 10ms - 10ms);
+    EXPECT_EQ(scheduler.missedDeadlines(), 0u);
+}
+
+TEST(SCHEDULER, ReportsMissedDeadlines) {
+    SampleScheduler scheduler(5ms);
+
+    ASSERT_TRUE(scheduler.wait());
+    std::this_thread::sleep_for(33ms);
+    ASSERT_TRUE(scheduler.wait());
+
+    EXPECT_GE(scheduler.missedDeadlines(), 4u);
+}
+
+TEST(SCHEDULER, IntervalChangesAtRuntime) {
+    SampleScheduler scheduler(SampleScheduler::MAX_INTERVAL);
+
+    std::thread changer([&scheduler]() {
+        std::this_thread::sleep_for(20ms);
+        scheduler.setInterval(5ms);
+    });
+
+    auto start = steady_clock::now();
+    ASSERT_TRUE(scheduler.wait());
+    changer.join();
+
+    EXPECT_LT(steady_clock::now() - start, 1s);
+    EXPECT_EQ(scheduler.interval(), 5ms);
+}
+
+TEST(SCHEDULER, StopWakesWaiter) {
+    SampleScheduler scheduler(SampleScheduler::MAX_INTERVAL);
+
+    std::thread stopper([&scheduler]() {
+        std::this_thread::sleep_for(20ms);
+        scheduler.stop();
+    });
+
+    auto start = steady_clock::now();
+    EXPECT_FALSE(scheduler.wait());
+    stopper.join();
+
+    EXPECT_LT(steady_clock::now() - start, 1s);
+    EXPECT_FALSE(scheduler.wait());
+}
+
+TEST(SCHEDULER, WaitUntilReturnsAtTheDeadline) {
+    SampleScheduler scheduler(SampleScheduler::MAX_INTERVAL);
+
+    auto start = steady_clock::now();
+    EXPECT_TRUE(scheduler.waitUntil(start + 20ms));
+    EXPECT_GE(steady_clock::now() - start, 20ms);
+    EXPECT_LT(steady_clock::now() - start, 1s);
+    EXPECT_TRUE(scheduler.waitUntil(start));
+}
+
+TEST(SCHEDULER, StopEndsWaitUntil) {
+    SampleScheduler scheduler(10ms);
+
+    std::thread stopper([&scheduler]() {
+        std::this_thread::sleep_for(20ms);
+        scheduler.stop();
+    });
+
+    auto start = steady_clock::now();
+    EXPECT_FALSE(scheduler.waitUntil(start + 1h));
+    stopper.join();
+
+    EXPECT_LT(steady_clock::now() - start, 1s);
+    EXPECT_FALSE(scheduler.waitUntil(start + 1h));
+}
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+TEST(SCHEDULER, EventsRunBetweenDeadlines) {
+    SampleScheduler scheduler(200ms);
+    int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASSERT_GE(event_fd, 0);
+
+    int handled = 0;
+    scheduler.setEventHandler(event_fd, [&]() {
+        uint64_t events;
+        (void) read(event_fd, &events, sizeof(events));
+        handled++;
+    });
+
+    std::thread signaller([event_fd]() {
+        std::this_thread::sleep_for(20ms);
+        uint64_t one = 1;
+        (void) write(event_fd, &one, sizeof(one));
+    });
+
+    // The event is handled inside the wait, which still returns on the deadline and not before
+    auto start = steady_clock::now();
+    EXPECT_TRUE(scheduler.wait());
+    signaller.join();
+    EXPECT_EQ(handled, 1);
+    EXPECT_GE(steady_clock::now() - start, 150ms);
+
+    scheduler.setEventHandler(-1, nullptr);
+    close(event_fd);
+    EXPECT_TRUE(scheduler.wait());
+}
+#endif
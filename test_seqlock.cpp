@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "metricframe.h"
+#include "seqlock.h"
+
+// Every field is derived from the tick number, so a frame mixing two ticks is detectable.
+static MetricFrame frame_for_tick(uint64_t tick) {
+    MetricFrame frame {};
+    frame.tick = tick;
+    frame.mem_total = 1000000;
+    frame.mem_used = static_cast<int64_t>(tick * 3);
+    frame.mem_proc = static_cast<int64_t>(tick * 2);
+    frame.cpu_use = static_cast<double>(tick) * 0.5;
+    frame.cpu_proc_use = static_cast<double>(tick) * 0.25;
+    return frame;
+}
+
+static bool frame_consistent(const MetricFrame &frame) {
+    return frame.mem_total == 1000000 &&
+        frame.mem_used == static_cast<int64_t>(frame.tick * 3) &&
+        frame.mem_proc == static_cast<int64_t>(frame.tick * 2) &&
+        frame.cpu_use == static_cast<double>(frame.tick) * 0.5 &&
+        frame.cpu_proc_use == static_cast<double>(frame.tick) * 0.25;
+}
+
+TEST(FRAME_PUBLICATION, StartsWithEmptyFrame) {
+    SeqLock<MetricFrame> frames;
+    MetricFrame frame = frames.load();
+
+    EXPECT_EQ(frame.tick, 0u);
+    EXPECT_EQ(frame.mem_used, 0);
+    EXPECT_EQ(frames.version(), 1u);
+}
+
+TEST(FRAME_PUBLICATION, LoadReturnsLastStore) {
+    SeqLock<MetricFrame> frames;
+    frames.store(frame_for_tick(7));
+    frames.store(frame_for_tick(8));
+
+    MetricFrame frame = frames.load();
+    EXPECT_EQ(frame.tick, 8u);
+    EXPECT_TRUE(frame_consistent(frame));
+}
+
+// Mirrors DataManager at a 1 ms refresh: one sampler publishing while several "QML" readers poll as fast as they can.
+// Build with -DHW_OVERLAY_SANITIZE_THREAD=ON to run this under ThreadSanitizer.
+TEST(FRAME_PUBLICATION, ReadersNeverSeeTornFrames) {
+    constexpr unsigned reader_count = 4;
+    constexpr auto run_time = std::chrono::milliseconds(300);
+
+    SeqLock<MetricFrame> frames;
+    std::atomic<bool> running {true};
+    std::atomic<unsigned> torn_frames {0};
+    std::atomic<unsigned> out_of_order {0};
+    std::atomic<unsigned long long> total_reads {0};
+
+    std::thread sampler([&]() {
+        uint64_t tick = 0;
+        auto deadline = std::chrono::steady_clock::now();
+        while (running.load(std::memory_order_relaxed)) {
+            frames.store(frame_for_tick(++tick));
+            deadline += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(deadline);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < reader_count; i++) {
+        readers.emplace_back([&]() {
+            uint64_t last_tick = 0;
+            unsigned long long reads = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                MetricFrame frame = frames.load();
+                if (!frame_consistent(frame))
+                    torn_frames++;
+                if (frame.tick < last_tick)
+                    out_of_order++;
+                last_tick = frame.tick;
+                reads++;
+            }
+            total_reads += reads;
+        });
+    }
+
+    std::this_thread::sleep_for(run_time);
+    running = false;
+    sampler.join();
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(torn_frames.load(), 0u);
+    EXPECT_EQ(out_of_order.load(), 0u);
+    EXPECT_GT(frames.load().tick, 10u);
+    EXPECT_GT(total_reads.load(), 0u);
+}
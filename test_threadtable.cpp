@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "testfixture.h"
+#include "threadtable.h"
+
+// A throwaway procfs lookalike with one process, its `stat` and a `task` directory of threads
+class THREAD_TABLE: public ::testing::Test {
+protected:
+    static constexpr int PID = 500;
+    static constexpr unsigned long long NS_PER_SEC = 1000000000;
+
+    FixtureDir fixture {"test_threadtable"};
+    std::string root;
+
+    void SetUp() override {
+        root = fixture.path();
+        ASSERT_FALSE(root.empty());
+        ASSERT_TRUE(makeDirs(taskDir()));
+    }
+
+    std::string taskDir() const {
+        return root + "/" + std::to_string(PID) + "/task";
+    }
+
+    static std::string statLine(int pid, const std::string &name, unsigned long long cpu_ticks, int threads) {
+        return std::to_string(pid) + " (" + name + ") S 1 1 1 0 -1 4194560 0 0 0 0 " + std::to_string(cpu_ticks) +
+            " 0 0 0 20 0 " + std::to_string(threads) + " 0 100 1000 10 0 0 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n";
+    }
+
+    /** The whole process, the table only looks at its CPU ticks and thread count. */
+    void writeProcess(unsigned long long cpu_ticks, int threads) {
+        ASSERT_TRUE(writeFile(root + "/" + std::to_string(PID) + "/stat", statLine(PID, "server", cpu_ticks, threads)));
+    }
+
+    void writeThread(int tid, const std::string &name, unsigned long long run_ns) {
+        std::string dir = taskDir() + "/" + std::to_string(tid);
+        mkdir(dir.c_str(), 0755);
+        ASSERT_TRUE(writeFile(dir + "/schedstat", std::to_string(run_ns) + " 0 1\n"));
+        ASSERT_TRUE(writeFile(dir + "/comm", name + "\n"));
+    }
+
+    void removeThread(int tid) {
+        ASSERT_TRUE(removeTree(taskDir() + "/" + std::to_string(tid)));
+    }
+};
+
+TEST_F(THREAD_TABLE, MissingProcessFails) {
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.isOpen());
+    EXPECT_FALSE(table.refresh(PID + 1, 1.0));
+    EXPECT_EQ(table.threadCount(), 0u);
+    EXPECT_TRUE(table.topByCpu().empty());
+}
+
+TEST_F(THREAD_TABLE, CpuFromRunTimeDeltas) {
+    writeProcess(0, 3);
+    writeThread(PID, "server", 0);
+    writeThread(501, "worker-1", 0);
+    writeThread(502, "gc", 0);
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+    EXPECT_EQ(table.threadCount(), 3u);
+    ASSERT_EQ(table.topByCpu().size(), 3u);
+    EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+
+    writeProcess(125, 3);
+    writeThread(501, "worker-1", NS_PER_SEC);
+    writeThread(502, "gc", NS_PER_SEC / 4);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+
+    const auto &top = table.topByCpu();
+    ASSERT_EQ(top.size(), 3u);
+    EXPECT_EQ(top[0].tid, 501);
+    EXPECT_STREQ(top[0].name, "worker-1");
+    EXPECT_NEAR(top[0].cpu_use, 1.0f, 1e-6);
+    EXPECT_EQ(top[1].tid, 502);
+    EXPECT_STREQ(top[1].name, "gc");
+    EXPECT_NEAR(top[1].cpu_use, 0.25f, 1e-6);
+    EXPECT_EQ(top[2].tid, PID);
+    EXPECT_EQ(table.threadReads(), 3u);
+}
+
+TEST_F(THREAD_TABLE, KeepsOnlyTheTopN) {
+    writeProcess(0, 20);
+    for (int tid = 1; tid <= 20; tid++)
+        writeThread(tid, "pool", 0);
+
+    ThreadTable table(root.c_str(), 5);
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+
+    writeProcess(100, 20);
+    for (int tid = 1; tid <= 20; tid++)
+        writeThread(tid, "pool", static_cast<unsigned long long>(tid) * 1000000);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+
+    EXPECT_EQ(table.threadCount(), 20u);
+    ASSERT_EQ(table.topByCpu().size(), 5u);
+    EXPECT_EQ(table.topByCpu()[0].tid, 20);
+    EXPECT_EQ(table.topByCpu()[4].tid, 16);
+}
+
+// No tick of CPU time and no thread count change: nothing to read, the previous list stands
+TEST_F(THREAD_TABLE, IdleProcessSkipsTheThreads) {
+    writeProcess(0, 2);
+    writeThread(501, "a", 0);
+    writeThread(502, "b", 0);
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+    writeProcess(10, 2);
+    writeThread(501, "a", NS_PER_SEC / 10);
+    ASSERT_TRUE(table.refresh(PID, 0.1));
+    EXPECT_EQ(table.threadReads(), 2u);
+
+    ASSERT_TRUE(table.refresh(PID, 0.1));
+    EXPECT_EQ(table.threadReads(), 0u);
+    EXPECT_EQ(table.topByCpu()[0].tid, 501);
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 1.0f, 1e-5);
+
+    // The skipped refresh counts towards the span of the next pass
+    writeProcess(20, 2);
+    writeThread(501, "a", NS_PER_SEC / 10 + NS_PER_SEC / 10);
+    ASSERT_TRUE(table.refresh(PID, 0.1));
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 0.5f, 1e-5);
+}
+
+TEST_F(THREAD_TABLE, FollowsThreadsStartingAndExiting) {
+    writeProcess(0, 2);
+    writeThread(501, "a", 0);
+    writeThread(502, "b", 0);
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+
+    writeProcess(50, 3);
+    writeThread(503, "c", NS_PER_SEC);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+    EXPECT_EQ(table.threadCount(), 3u);
+    // No baseline for a thread first seen this pass
+    EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+
+    removeThread(502);
+    writeProcess(150, 2);
+    writeThread(503, "c", NS_PER_SEC * 2);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+    EXPECT_EQ(table.threadCount(), 2u);
+    EXPECT_EQ(table.topByCpu()[0].tid, 503);
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 1.0f, 1e-6);
+    for (const ThreadInfo &thread : table.topByCpu())
+        EXPECT_NE(thread.tid, 502);
+}
+
+TEST_F(THREAD_TABLE, PicksUpRenamedThreads) {
+    writeProcess(0, 1);
+    writeThread(501, "java", 0);
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+    EXPECT_STREQ(table.topByCpu()[0].name, "java");
+
+    writeProcess(1, 1);
+    writeThread(501, "C2 CompilerThre", NS_PER_SEC / 100);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+    EXPECT_STREQ(table.topByCpu()[0].name, "C2 CompilerThre");
+}
+
+// Kernels without CONFIG_SCHED_INFO only have the tick counters of `stat`
+TEST_F(THREAD_TABLE, FallsBackToStatTicks) {
+    const auto ticks = static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+    std::string dir = taskDir() + "/501";
+    mkdir(dir.c_str(), 0755);
+    writeProcess(0, 1);
+    ASSERT_TRUE(writeFile(dir + "/stat", statLine(501, "worker", 0, 1)));
+    ASSERT_TRUE(writeFile(dir + "/comm", "worker\n"));
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+
+    writeProcess(ticks / 2, 1);
+    ASSERT_TRUE(writeFile(dir + "/stat", statLine(501, "worker", ticks / 2, 1)));
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+    EXPECT_NEAR(table.topByCpu()[0].cpu_use, 0.5f, 1e-2);
+}
+
+TEST_F(THREAD_TABLE, AnotherPidStartsOver) {
+    writeProcess(0, 1);
+    writeThread(501, "a", 0);
+
+    ThreadTable table(root.c_str());
+    ASSERT_TRUE(table.refresh(PID, 0.0));
+    EXPECT_EQ(table.threadCount(), 1u);
+
+    EXPECT_FALSE(table.refresh(PID + 1, 1.0));
+    EXPECT_EQ(table.threadCount(), 0u);
+    EXPECT_EQ(table.cachedDescriptors(), 0u);
+
+    writeProcess(100, 1);
+    writeThread(501, "a", NS_PER_SEC);
+    ASSERT_TRUE(table.refresh(PID, 1.0));
+    EXPECT_FLOAT_EQ(table.topByCpu()[0].cpu_use, 0.0f);
+}
+
+TEST(THREAD_TABLE_LIVE, FindsTheBusyThreadOfThisProcess) {
+    std::atomic<bool> stop {false};
+    std::thread spinner([&stop] {
+        pthread_setname_np(pthread_self(), "spinner");
+        volatile unsigned long long spins = 0;
+        while (!stop.load(std::memory_order_relaxed))
+            spins = spins + 1;
+    });
+
+    ThreadTable table;
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(table.refresh(getpid(), 0.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(table.refresh(getpid(), elapsed.count()));
+    stop.store(true);
+    spinner.join();
+
+    EXPECT_GE(table.threadCount(), 2u);
+    ASSERT_FALSE(table.topByCpu().empty());
+    EXPECT_STREQ(table.topByCpu()[0].name, "spinner");
+    // Generous, a loaded machine may not give the spinner a whole core
+    EXPECT_GT(table.topByCpu()[0].cpu_use, 0.2f);
+    EXPECT_LE(table.topByCpu()[0].cpu_use, 1.05f);
+}
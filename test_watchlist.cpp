@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lrucache.h"
+#include "watchlist.h"
+
+namespace {
+
+/** Stands in for a cached descriptor: counts how many instances are alive. */
+struct Resource {
+    std::shared_ptr<int> alive;
+};
+
+std::vector<int> keysByRecency(LruCache<int, int> &cache) {
+    std::vector<int> keys;
+    cache.forEach([&](int key, int) {
+        keys.push_back(key);
+    });
+    return keys;
+}
+
+} // namespace
+
+TEST(LRU_CACHE, EvictsLeastRecentlyUsed) {
+    LruCache<int, int> cache(3);
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    cache.insert(3, 30);
+    EXPECT_TRUE(cache.full());
+    ASSERT_NE(cache.leastRecent(), nullptr);
+    EXPECT_EQ(*cache.leastRecent(), 1);
+
+    // A lookup makes 1 the most recent, so 2 goes next
+    ASSERT_NE(cache.find(1), nullptr);
+    EXPECT_EQ(*cache.leastRecent(), 2);
+    cache.insert(4, 40);
+
+    EXPECT_EQ(cache.size(), 3u);
+    EXPECT_EQ(cache.find(2), nullptr);
+    EXPECT_EQ(*cache.find(1), 10);
+    EXPECT_EQ(keysByRecency(cache), (std::vector<int>{1, 4, 3}));
+}
+
+TEST(LRU_CACHE, PeekKeepsOrder) {
+    LruCache<int, int> cache(2);
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    ASSERT_NE(cache.peek(1), nullptr);
+    EXPECT_EQ(*cache.leastRecent(), 1);
+}
+
+TEST(LRU_CACHE, InsertOverwritesInPlace) {
+    LruCache<int, int> cache(2);
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    cache.insert(1, 11);
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(*cache.find(1), 11);
+    EXPECT_EQ(*cache.find(2), 20);
+}
+
+TEST(LRU_CACHE, EraseFreesTheNode) {
+    LruCache<int, int> cache(2);
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    EXPECT_TRUE(cache.erase(1));
+    EXPECT_FALSE(cache.erase(1));
+    EXPECT_FALSE(cache.full());
+    EXPECT_EQ(cache.leastRecent(), nullptr);
+
+    // The freed node is reused, nothing is evicted
+    cache.insert(3, 30);
+    EXPECT_EQ(*cache.find(2), 20);
+    EXPECT_EQ(*cache.find(3), 30);
+    EXPECT_EQ(keysByRecency(cache), (std::vector<int>{3, 2}));
+}
+
+TEST(LRU_CACHE, ReleasesValuesRightAway) {
+    auto counter = std::make_shared<int>(0);
+    LruCache<int, Resource> cache(2);
+    cache.insert(1, Resource{counter});
+    cache.insert(2, Resource{counter});
+    EXPECT_EQ(counter.use_count(), 3);
+
+    cache.insert(3, Resource{counter});
+    EXPECT_EQ(counter.use_count(), 3);
+    cache.erase(2);
+    EXPECT_EQ(counter.use_count(), 2);
+    cache.clear();
+    EXPECT_EQ(counter.use_count(), 1);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(LRU_CACHE, ChurnStaysConsistent) {
+    LruCache<int, int> cache(16);
+    for (int i = 0; i < 10000; i++) {
+        const int key = (i * 7919) % 40;
+        if (i % 5 == 0)
+            cache.erase(key);
+        else if (int *value = cache.find(key))
+            EXPECT_EQ(*value, key * 3);
+        else
+            cache.insert(key, key * 3);
+        ASSERT_LE(cache.size(), 16u);
+    }
+    EXPECT_EQ(keysByRecency(cache).size(), cache.size());
+}
+
+TEST(WATCH_LIST, NamePatterns) {
+    EXPECT_TRUE(matchNamePattern("firefox", "firefox"));
+    EXPECT_TRUE(matchNamePattern("FireFox.EXE", "firefox.exe"));
+    EXPECT_FALSE(matchNamePattern("firefox", "firefox-bin"));
+    EXPECT_TRUE(matchNamePattern("firefox*", "firefox-bin"));
+    EXPECT_TRUE(matchNamePattern("*", ""));
+    EXPECT_TRUE(matchNamePattern("*fox*", "firefox-bin"));
+    EXPECT_TRUE(matchNamePattern("Web?Content", "Web Content"));
+    EXPECT_FALSE(matchNamePattern("?", ""));
+    EXPECT_TRUE(matchNamePattern("a*b*c", "aXbYbZc"));
+    EXPECT_FALSE(matchNamePattern("a*b*c", "aXbYbZ"));
+    EXPECT_FALSE(matchNamePattern("", "x"));
+}
+
+TEST(WATCH_LIST, Labels) {
+    EXPECT_EQ(WatchTarget::byPid(42).label(), "pid 42");
+    EXPECT_EQ(WatchTarget::byName("chrom*").label(), "chrom*");
+    EXPECT_EQ(WatchTarget::foreground().label(), "foreground");
+}
@@ -0,0 +1,73 @@
+#include "testfixture.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/** Descriptors `nftw` may hold open, one per directory level. */
+constexpr int MAX_OPEN_DIRS = 16;
+
+int removeEntry(const char *path, const struct stat *, int type, FTW *) {
+    return type == FTW_DP ? rmdir(path) : unlink(path);
+}
+
+} // namespace
+
+FixtureDir::FixtureDir(const char *name) {
+    std::string pattern = std::string("/tmp/") + name + ".XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    if (mkdtemp(buffer.data()) != nullptr)
+        root = buffer.data();
+}
+
+FixtureDir::~FixtureDir() {
+    if (!root.empty())
+        removeTree(root);
+}
+
+const std::string& FixtureDir::path() const {
+    return root;
+}
+
+bool makeDirs(const std::string &path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        const std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (slash == std::string::npos)
+            return true;
+    }
+}
+
+bool removeTree(const std::string &path) {
+    // Children before their directory, and links are entries of their own rather than what they point at
+    return nftw(path.c_str(), removeEntry, MAX_OPEN_DIRS, FTW_DEPTH | FTW_PHYS) == 0;
+}
+
+bool writeFile(const std::string &path, const std::string &text) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+    const bool written = std::fputs(text.c_str(), file) >= 0;
+    return std::fclose(file) == 0 && written;
+}
+
+bool rewriteFile(const std::string &path, const std::string &text, size_t size) {
+    FILE *file = std::fopen(path.c_str(), "r+");
+    if (file == nullptr)
+        file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+    bool written = std::fputs(text.c_str(), file) >= 0;
+    for (size_t i = text.size(); i < size && written; i++)
+        written = std::fputc('\n', file) != EOF;
+    return std::fclose(file) == 0 && written;
+}
@@ -0,0 +1,41 @@
+#ifndef TESTFIXTURE_H
+#define TESTFIXTURE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * A temporary directory for the procfs, sysfs and cgroupfs lookalikes that tests and benchmarks point the tables at,
+ * `/tmp/<name>.XXXXXX`, removed again with everything below it on destruction. Linux only.
+ */
+class FixtureDir {
+    std::string root;
+
+public:
+    explicit FixtureDir(const char *name);
+    ~FixtureDir();
+
+    FixtureDir(const FixtureDir&) = delete;
+    FixtureDir& operator=(const FixtureDir&) = delete;
+
+    /** Empty if the directory could not be created. */
+    const std::string& path() const;
+};
+
+/** Create `path` and whatever parents it is missing, like `mkdir -p`. */
+bool makeDirs(const std::string &path);
+
+/** Remove `path` and everything below it, like `rm -rf`. Symbolic links are removed, never followed. */
+bool removeTree(const std::string &path);
+
+/** Replace the contents of `path` with `text`, creating it if needed. */
+bool writeFile(const std::string &path, const std::string &text);
+
+/**
+ * Write `text` over the start of `path` without truncating it, padded with newlines to `size` bytes. A descriptor kept
+ * open on the file then sees the new contents as it would on procfs or cgroupfs, and a shorter text leaves no stale
+ * tail behind. `text` must fit in `size`.
+ */
+bool rewriteFile(const std::string &path, const std::string &text, size_t size);
+
+#endif // TESTFIXTURE_H
@@ -0,0 +1,359 @@
+#include "threadtable.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+/** Layout the kernel writes for `getdents64`, glibc only exposes a wrapper for it since 2.30. */
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+/** Descriptors left for everything else in the program when sizing the cache, same as `ProcessTable`. */
+constexpr rlim_t RESERVED_FDS = 256;
+
+/**
+ * Longest run of refreshes skipped as idle. `<pid>/stat` counts in USER_HZ ticks, so a process using less than a tick
+ * between two refreshes looks idle; a full pass at least this often keeps the list from holding on to stale values.
+ */
+constexpr double MAX_IDLE_SECONDS = 1.0;
+
+bool parseTid(const char *name, int32_t &tid) {
+    int32_t value = 0;
+    if (*name == '\0')
+        return false;
+    for (; *name != '\0'; name++) {
+        if (*name < '0' || *name > '9')
+            return false;
+        value = value * 10 + (*name - '0');
+    }
+    tid = value;
+    return value > 0;
+}
+
+bool moreCpu(const ThreadInfo &a, const ThreadInfo &b) {
+    return a.cpu_use != b.cpu_use ? a.cpu_use > b.cpu_use : a.tid < b.tid;
+}
+
+/** Position after the comm of a `stat` line, where the fields become reliable. Null if there is none. */
+const char* afterComm(const char *text, long size) {
+    const char *close_paren = static_cast<const char*>(memrchr(text, ')', static_cast<size_t>(size)));
+    return close_paren != nullptr ? close_paren + 1 : nullptr;
+}
+
+} // namespace
+
+ThreadTable::ThreadTable(const char *proc_root, size_t top_n):
+    root_fd{-1},
+    task_fd{-1},
+    pid{0},
+    process_ticks{0},
+    process_threads{0},
+    has_baseline{false},
+    pending_seconds{0.0},
+    top_n{top_n},
+    fd_budget{0},
+    cached_fds{0},
+    thread_reads{0},
+    dirent_buffer(DIRENT_BUFFER_SIZE)
+{
+    root_fd = ::open(proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    clock_ticks = ticks > 0 ? static_cast<unsigned long long>(ticks) : 100;
+
+    // Never more than a quarter of what the soft limit leaves, `ProcessTable` takes up to half
+    fd_budget = MAX_CACHED_FDS;
+    rlimit limit {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        fd_budget = limit.rlim_cur > RESERVED_FDS ?
+            std::min(fd_budget, static_cast<size_t>((limit.rlim_cur - RESERVED_FDS) / 4)) : 0;
+
+    top_cpu.reserve(top_n);
+}
+
+ThreadTable::~ThreadTable() {
+    // Entries close their own descriptors
+    if (task_fd >= 0)
+        ::close(task_fd);
+    if (root_fd >= 0)
+        ::close(root_fd);
+}
+
+bool ThreadTable::isOpen() const {
+    return root_fd >= 0;
+}
+
+void ThreadTable::clear() {
+    if (task_fd >= 0)
+        ::close(task_fd);
+    task_fd = -1;
+    pid = 0;
+    process_stat.close();
+    process_ticks = 0;
+    process_threads = 0;
+    has_baseline = false;
+    pending_seconds = 0.0;
+    previous.clear();
+    current.clear();
+    cached_fds = 0;
+    thread_reads = 0;
+    top_cpu.clear();
+}
+
+bool ThreadTable::follow(int32_t new_pid) {
+    clear();
+    if (root_fd < 0 || new_pid <= 0)
+        return false;
+
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d/task", static_cast<int>(new_pid));
+    task_fd = ::openat(root_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    std::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(new_pid));
+    if (task_fd < 0 || !process_stat.openAt(root_fd, path))
+        return false;
+    pid = new_pid;
+    return true;
+}
+
+bool ThreadTable::readProcess(unsigned long long &ticks, unsigned long long &threads) {
+    long read_size = process_stat.readInto(read_buffer, STAT_BUFFER_SIZE);
+    if (read_size <= 0)
+        return false;
+    const char *end = read_buffer + read_size;
+    const char *cur = afterComm(read_buffer, read_size);
+    if (cur == nullptr)
+        return false;
+
+    // state is field 3, utime and stime are 14 and 15, num_threads 20
+    unsigned long long utime = 0, stime = 0;
+    cur = ProcFile::skipFields(cur, end, 11);
+    cur = ProcFile::parseUnsigned(cur, end, utime);
+    cur = ProcFile::parseUnsigned(cur, end, stime);
+    cur = ProcFile::skipFields(cur, end, 4);
+    ProcFile::parseUnsigned(cur, end, threads);
+    ticks = utime + stime;
+    return true;
+}
+
+bool ThreadTable::readThread(int32_t tid, Entry &entry, unsigned long long &run_ns) {
+    long read_size = -1;
+    if (entry.counters.isOpen()) {
+        read_size = entry.counters.readInto(read_buffer, STAT_BUFFER_SIZE);
+    } else {
+        char path[32];
+        std::snprintf(path, sizeof(path), entry.ticks ? "%d/stat" : "%d/schedstat", static_cast<int>(tid));
+        ProcFile once;
+        if (once.openAt(task_fd, path))
+            read_size = once.readInto(read_buffer, STAT_BUFFER_SIZE);
+    }
+    // ESRCH: the thread behind the descriptor exited, its TID may belong to a newer one by now
+    if (read_size <= 0)
+        return false;
+    thread_reads++;
+
+    const char *end = read_buffer + read_size;
+    if (!entry.ticks) {
+        // "run_ns wait_ns timeslices"
+        ProcFile::parseUnsigned(read_buffer, end, run_ns);
+        return true;
+    }
+
+    const char *cur = afterComm(read_buffer, read_size);
+    if (cur == nullptr)
+        return false;
+    unsigned long long utime = 0, stime = 0;
+    cur = ProcFile::skipFields(cur, end, 11);
+    cur = ProcFile::parseUnsigned(cur, end, utime);
+    ProcFile::parseUnsigned(cur, end, stime);
+    run_ns = (utime + stime) * NANOSEC_PER_SEC / clock_ticks;
+    return true;
+}
+
+void ThreadTable::addThread(int32_t tid) {
+    char path[32];
+    Entry fresh;
+    std::snprintf(path, sizeof(path), "%d/schedstat", static_cast<int>(tid));
+    if (!fresh.counters.openAt(task_fd, path)) {
+        std::snprintf(path, sizeof(path), "%d/stat", static_cast<int>(tid));
+        if (!fresh.counters.openAt(task_fd, path))
+            return;
+        fresh.ticks = true;
+    }
+
+    unsigned long long run_ns = 0;
+    if (!readThread(tid, fresh, run_ns))
+        return;
+    fresh.run_ns = run_ns;
+    if (cached_fds >= fd_budget)
+        fresh.counters.close();
+    else
+        cached_fds++;
+
+    current.insert(tid, std::move(fresh));
+    rankThread(tid, 0.0f);
+}
+
+bool ThreadTable::listThreads() {
+    if (lseek(task_fd, 0, SEEK_SET) < 0)
+        return false;
+
+    for (;;) {
+        long read_size = syscall(SYS_getdents64, task_fd, dirent_buffer.data(), dirent_buffer.size());
+        if (read_size < 0)
+            return false;
+        if (read_size == 0)
+            return true;
+
+        for (long offset = 0; offset < read_size;) {
+            const auto *entry = reinterpret_cast<const LinuxDirent64*>(dirent_buffer.data() + offset);
+            offset += entry->d_reclen;
+
+            int32_t tid;
+            if (!parseTid(entry->d_name, tid) || current.find(tid) != nullptr)
+                continue;
+            Entry *known = previous.find(tid);
+            if (known == nullptr || !carryThread(tid, *known))
+                addThread(tid);
+        }
+    }
+}
+
+bool ThreadTable::carryThread(int32_t tid, Entry &entry) {
+    unsigned long long run_ns = 0;
+    if (!readThread(tid, entry, run_ns))
+        return false;
+
+    float cpu_use = 0.0f;
+    if (has_baseline && pending_seconds > 0.0 && run_ns >= entry.run_ns)
+        cpu_use = static_cast<float>(static_cast<double>(run_ns - entry.run_ns) / NANOSEC_PER_SEC / pending_seconds);
+    entry.run_ns = run_ns;
+    cached_fds += (entry.counters.isOpen() ? 1 : 0) + (entry.comm.isOpen() ? 1 : 0);
+
+    current.insert(tid, std::move(entry));
+    rankThread(tid, cpu_use);
+    return true;
+}
+
+void ThreadTable::rankThread(int32_t tid, float cpu_use) {
+    if (top_n == 0)
+        return;
+    ThreadInfo info {};
+    info.tid = tid;
+    info.cpu_use = cpu_use;
+    if (top_cpu.size() < top_n) {
+        top_cpu.push_back(info);
+        std::push_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+    } else if (moreCpu(info, top_cpu.front())) {
+        std::pop_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+        top_cpu.back() = info;
+        std::push_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+    }
+}
+
+void ThreadTable::nameTopThreads() {
+    for (ThreadInfo &thread : top_cpu) {
+        Entry *entry = previous.find(thread.tid);
+        if (entry == nullptr)
+            continue;
+
+        // Runtimes name a thread right after starting it, so comm is read again on every pass rather than once
+        bool keep = true;
+        if (!entry->comm.isOpen()) {
+            char path[32];
+            std::snprintf(path, sizeof(path), "%d/comm", static_cast<int>(thread.tid));
+            keep = entry->comm.openAt(task_fd, path) && cached_fds < fd_budget;
+            if (keep)
+                cached_fds++;
+        }
+        long read_size = entry->comm.readInto(read_buffer, ThreadInfo::NAME_SIZE);
+        if (read_size > 0) {
+            const size_t length = read_buffer[read_size - 1] == '\n' ? read_size - 1 : read_size;
+            std::memcpy(entry->name, read_buffer, length);
+            entry->name[length] = '\0';
+        }
+        if (!keep)
+            entry->comm.close();
+        std::memcpy(thread.name, entry->name, ThreadInfo::NAME_SIZE);
+    }
+}
+
+bool ThreadTable::refresh(int32_t new_pid, double elapsed_seconds) {
+    if (new_pid != pid && !follow(new_pid)) {
+        clear();
+        return false;
+    }
+
+    unsigned long long ticks = 0, threads = 0;
+    if (!readProcess(ticks, threads)) {
+        // The process exited, a later refresh for the same PID follows whatever runs under it then
+        clear();
+        return false;
+    }
+    thread_reads = 0;
+    pending_seconds += elapsed_seconds;
+
+    // Nothing ran and nothing started or exited, every thread still has the counters of the last pass
+    if (has_baseline && ticks == process_ticks && threads == process_threads && pending_seconds < MAX_IDLE_SECONDS)
+        return true;
+
+    top_cpu.clear();
+    cached_fds = 0;
+
+    // With the same threads as last time every one is read through its own descriptor, no listing needed. A failed
+    // read means one exited, and possibly another one started in its place.
+    bool relist = !has_baseline || threads != process_threads;
+    if (!relist) {
+        previous.forEach([&](int32_t tid, Entry &entry) {
+            if (!carryThread(tid, entry))
+                relist = true;
+        });
+    }
+
+    // Otherwise the listing decides which threads there are, only the new ones are opened
+    if (relist && !listThreads()) {
+        current.clear();
+        clear();
+        return false;
+    }
+
+    // Whatever was not carried over belongs to threads that exited, clearing closes their descriptors
+    previous.clear();
+    previous.swap(current);
+
+    std::sort_heap(top_cpu.begin(), top_cpu.end(), moreCpu);
+    nameTopThreads();
+
+    process_ticks = ticks;
+    process_threads = threads;
+    has_baseline = true;
+    pending_seconds = 0.0;
+    return true;
+}
+
+size_t ThreadTable::threadCount() const {
+    return previous.size();
+}
+
+const std::vector<ThreadInfo>& ThreadTable::topByCpu() const {
+    return top_cpu;
+}
+
+size_t ThreadTable::cachedDescriptors() const {
+    return cached_fds;
+}
+
+size_t ThreadTable::threadReads() const {
+    return thread_reads;
+}
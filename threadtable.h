@@ -0,0 +1,178 @@
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flathashmap.h"
+#include "procfile.h"
+
+/** One thread of the process a `ThreadTable` follows. Plain data so it can be published through a `SeqLock`. */
+struct ThreadInfo {
+    /** The kernel caps comm at 16 bytes including the terminator. */
+    static constexpr size_t NAME_SIZE = 16;
+
+    int32_t tid;
+
+    /** Null-terminated comm of the thread, which runtimes usually set per thread pool. */
+    char name[NAME_SIZE];
+
+    /** CPU time over the last interval as a fraction of one core, a single thread tops out at 1. */
+    float cpu_use;
+};
+
+/**
+ * CPU use of every thread of one process, read from `<pid>/task/<tid>/schedstat` below a procfs root.
+ * Built for processes with thousands of threads, so a `refresh` only does what changed since the last one:
+ * - every thread keeps a cached descriptor and its previous run time in a flat hash map keyed by TID, a steady-state
+ *   read is one `pread` of a file the kernel formats from three counters;
+ * - the task directory is only listed again when the thread count in `<pid>/stat` moved or a cached read failed,
+ *   then threads no longer listed are dropped and only the TIDs not known yet are opened. A descriptor stays bound
+ *   to the thread it was opened for, so an exited thread fails its read rather than handing over to a newer one on
+ *   the same TID;
+ * - if the process used no CPU at all since the last pass, which `<pid>/stat` tells in one read, no thread is read;
+ * - comm is only read for the threads that make the top list, through a descriptor opened the first time they do.
+ *
+ * Linux only: the root is a parameter so tests and benchmarks can point it at a fixture tree. Kernels without
+ * CONFIG_SCHED_INFO have no schedstat, threads are read from their USER_HZ counters in `stat` instead.
+ */
+class ThreadTable {
+
+    struct Entry {
+        /** `task/<tid>/schedstat`, or `stat` without it. Closed past the descriptor budget. */
+        ProcFile counters;
+
+        /** `task/<tid>/comm`, opened once the thread makes the top list. */
+        ProcFile comm;
+
+        /** `counters` is `stat`, its times are in ticks rather than nanoseconds. */
+        bool ticks = false;
+
+        /** Run time in nanoseconds as of the last pass that read this thread. */
+        unsigned long long run_ns = 0;
+
+        /** Read on the last pass that put the thread in the top list. */
+        char name[ThreadInfo::NAME_SIZE] = {};
+    };
+
+    /** `getdents64` batch size, room for a few thousand TIDs per call. */
+    static constexpr size_t DIRENT_BUFFER_SIZE = 64 * 1024;
+
+    /** Longest `stat` line we expect, the comm field is capped at 16 bytes so 1 KiB is plenty. */
+    static constexpr size_t STAT_BUFFER_SIZE = 1024;
+
+    /** Most thread descriptors kept open, half of `ProcessTable::MAX_CACHED_FDS`. */
+    static constexpr size_t MAX_CACHED_FDS = 256;
+
+    static constexpr unsigned long long NANOSEC_PER_SEC = 1000000000;
+
+    /** Directory descriptors of the procfs root and of `<pid>/task`, -1 if not open. */
+    int root_fd;
+    int task_fd;
+
+    /** Process followed, 0 if none. */
+    int32_t pid;
+
+    /** `<pid>/stat`, for the thread count and the CPU time of the whole process. */
+    ProcFile process_stat;
+
+    /** utime + stime of the process and its thread count as of the last pass. */
+    unsigned long long process_ticks;
+    unsigned long long process_threads;
+
+    /** Whether the entries hold counters to take deltas against. */
+    bool has_baseline;
+
+    /** Time the deltas of the next pass span, refreshes skipped as idle add to it. */
+    double pending_seconds;
+
+    size_t top_n;
+
+    /** USER_HZ, units of `stat`. */
+    unsigned long long clock_ticks;
+
+    /** Entries of the last pass and the ones being built, swapped at the end of every pass. */
+    FlatHashMap<int32_t, Entry> previous;
+    FlatHashMap<int32_t, Entry> current;
+
+    /**
+     * Descriptors that may be kept open: `MAX_CACHED_FDS`, or a quarter of what the soft `RLIMIT_NOFILE` leaves if that
+     * is less. Threads past the budget are read with open, read, close.
+     */
+    size_t fd_budget;
+    size_t cached_fds;
+
+    /** Threads whose counters the last refresh read, 0 if it found the process idle. */
+    size_t thread_reads;
+
+    /** Min-heap of the N busiest so far during a pass, sorted descending afterwards. */
+    std::vector<ThreadInfo> top_cpu;
+
+    std::vector<char> dirent_buffer;
+    char read_buffer[STAT_BUFFER_SIZE];
+
+    /** Start following `new_pid`, dropping every entry of the previous process. */
+    bool follow(int32_t new_pid);
+
+    /** Read utime + stime and the thread count of the process. */
+    bool readProcess(unsigned long long &ticks, unsigned long long &threads);
+
+    /** Run time of one thread in nanoseconds through its cached descriptor, or by path past the budget. */
+    bool readThread(int32_t tid, Entry &entry, unsigned long long &run_ns);
+
+    /** Open the counters of a thread first seen in the listing, without a delta for this pass. */
+    void addThread(int32_t tid);
+
+    /**
+     * Read a thread known from the last pass and move it over to `current` with its CPU use.
+     * @return false if it could not be read, `entry` stays in `previous` then.
+     */
+    bool carryThread(int32_t tid, Entry &entry);
+
+    /** List `<pid>/task`, carrying over the TIDs known from the last pass and adding the others. */
+    bool listThreads();
+
+    /** Account for one thread of this pass in the top list. */
+    void rankThread(int32_t tid, float cpu_use);
+
+    /** Fill in the names of the top list from the comm of each thread. */
+    void nameTopThreads();
+
+public:
+    static constexpr size_t DEFAULT_TOP_N = 10;
+
+    explicit ThreadTable(const char *proc_root = "/proc", size_t top_n = DEFAULT_TOP_N);
+    ~ThreadTable();
+
+    ThreadTable(const ThreadTable&) = delete;
+    ThreadTable& operator=(const ThreadTable&) = delete;
+
+    /** Whether the procfs root could be opened. */
+    bool isOpen() const;
+
+    /**
+     * Update the top list for the threads of `pid`. A different `pid` than on the previous call starts over, its
+     * first refresh only takes a baseline. A refresh that finds the process idle keeps the list of the last pass.
+     * @param elapsed_seconds Time since the previous refresh, CPU use is 0 when it is 0.
+     * @return false if `pid` could not be read, the table is empty then.
+     */
+    bool refresh(int32_t pid, double elapsed_seconds);
+
+    /** Forget the process followed, closing every descriptor. */
+    void clear();
+
+    /** Threads of the process as of the last refresh. */
+    size_t threadCount() const;
+
+    /** Busiest threads first. */
+    const std::vector<ThreadInfo>& topByCpu() const;
+
+    /** Descriptors held open between refreshes, thread counters and comm. */
+    size_t cachedDescriptors() const;
+
+    /** Threads read by the last refresh, 0 if the process was idle and none had to be. */
+    size_t threadReads() const;
+};
+
+#endif // THREADTABLE_H
@@ -0,0 +1,55 @@
+#include "watchlist.h"
+
+#include <utility>
+
+namespace {
+
+char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace
+
+WatchTarget WatchTarget::byPid(int32_t pid) {
+    return WatchTarget{Kind::Pid, pid, std::string()};
+}
+
+WatchTarget WatchTarget::byName(std::string pattern) {
+    return WatchTarget{Kind::Name, 0, std::move(pattern)};
+}
+
+WatchTarget WatchTarget::foreground() {
+    return WatchTarget{Kind::Foreground, 0, std::string()};
+}
+
+std::string WatchTarget::label() const {
+    switch (kind) {
+    case Kind::Pid: return "pid " + std::to_string(pid);
+    case Kind::Name: return pattern;
+    case Kind::Foreground: return "foreground";
+    }
+    return std::string();
+}
+
+bool matchNamePattern(const char *pattern, const char *name) {
+    // Greedy with one backtrack point: on a mismatch the last `*` takes one more character
+    const char *star = nullptr;
+    const char *resume = nullptr;
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (*pattern != '\0' && (*pattern == '?' || lowerAscii(*pattern) == lowerAscii(*name))) {
+            pattern++;
+            name++;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*')
+        pattern++;
+    return *pattern == '\0';
+}
@@ -0,0 +1,66 @@
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <cstdint>
+#include <string>
+
+/** One entry of the watch list: a process, or a set of them, followed every tick next to the foreground. */
+struct WatchTarget {
+    /** Targets beyond this are not sampled, `SampleFrame` and `WatchFrame` have room for this many. */
+    static constexpr unsigned MAX_TARGETS = 8;
+
+    /** Processes a `Name` target follows at most, the first ones the process table lists. */
+    static constexpr unsigned MAX_MATCHES = 8;
+
+    enum class Kind {
+        /** One process, identified by PID and the start time it had when first seen. */
+        Pid,
+        /** Every process whose name matches `pattern`, see `matchNamePattern`. */
+        Name,
+        /** Whatever process is in the foreground at the time. */
+        Foreground,
+    };
+
+    Kind kind;
+    int32_t pid;
+    std::string pattern;
+
+    static WatchTarget byPid(int32_t pid);
+    static WatchTarget byName(std::string pattern);
+    static WatchTarget foreground();
+
+    /** Short description for the UI: the PID, the pattern, or "foreground". */
+    std::string label() const;
+};
+
+/** What one `WatchTarget` did since the previous sample. Plain data, filled into `SampleFrame` every tick. */
+struct WatchSample {
+    /** Long enough for a Win32 image name of a usual length, longer ones are truncated. */
+    static constexpr unsigned NAME_SIZE = 64;
+
+    /** Processes that made up the target this tick, 0 if none is running. */
+    uint32_t matches;
+
+    /** First of them, 0 if none. */
+    int32_t pid;
+
+    /** Null-terminated name of `pid`. */
+    char name[NAME_SIZE];
+
+    /**
+     * CPU time of every match since the previous sample, in microseconds.
+     * A process that was not read on the previous sample as well only counts from the next one.
+     */
+    unsigned long long time_delta;
+
+    /** Resident bytes of every match. */
+    unsigned long long memory;
+};
+
+/**
+ * Shell-style match of a process name: `*` stands for any run of characters, `?` for one, and letters match
+ * regardless of case since Win32 image names are case insensitive. The whole name has to match.
+ */
+bool matchNamePattern(const char *pattern, const char *name);
+
+#endif // WATCHLIST_H